@@ -33,6 +33,17 @@
 #define NUM_VEC_PROC 2
 #define C2_CACHE_SIZE (NUM_VEC_PROC * VEC_SIZE * 6) + (NUM_VEC_PROC * VEC_SIZE)
 
+/* Hydro schemes listing the particle fields their force interactions need
+ * in the cache (hydro_cache_force_fields(), see hydro_part.h) can use the
+ * vectorised force loops. The vectorised density loops are limited to the
+ * schemes using the Gadget-2 density sums. */
+#if defined(WITH_VECTORIZATION) && defined(hydro_cache_force_fields)
+#define WITH_HYDRO_FORCE_VECTORIZATION
+#if defined(GADGET2_SPH) || defined(SPHENIX_SPH)
+#define WITH_HYDRO_DENSITY_VECTORIZATION
+#endif
+#endif
+
 #ifdef WITH_VECTORIZATION
 /* Cache struct to hold a local copy of a cells' particle
  * properties required for density/force calculations.*/
@@ -71,15 +82,20 @@ struct cache {
   /* Particle smoothing length gradient. */
   float *restrict grad_h SWIFT_CACHE_ALIGN;
 
-  /* Pressure over density squared. */
-  float *restrict pOrho2 SWIFT_CACHE_ALIGN;
-
   /* Balsara switch. */
   float *restrict balsara SWIFT_CACHE_ALIGN;
 
   /* Particle sound speed. */
   float *restrict soundspeed SWIFT_CACHE_ALIGN;
 
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
+  /* Scheme-specific properties used by the force loops. */
+#define CACHE_DECLARE_FIELD(name, value, pad) \
+  float *restrict name SWIFT_CACHE_ALIGN;
+  hydro_cache_force_fields(CACHE_DECLARE_FIELD)
+#undef CACHE_DECLARE_FIELD
+#endif
+
   /* Cache size. */
   int count;
 };
@@ -113,6 +129,41 @@ struct c2_cache {
   float vzq[C2_CACHE_SIZE] SWIFT_CACHE_ALIGN;
 };
 
+/**
+ * @brief Read the scheme-specific force properties of a particle into the
+ * cache.
+ *
+ * @param c The #cache.
+ * @param i The index in the cache.
+ * @param p The #part to read from.
+ */
+__attribute__((always_inline)) INLINE void cache_read_force_fields(
+    struct cache *restrict c, const int i, const struct part *restrict p) {
+
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
+#define CACHE_READ_FIELD(name, value, pad) c->name[i] = (value);
+  hydro_cache_force_fields(CACHE_READ_FIELD)
+#undef CACHE_READ_FIELD
+#endif
+}
+
+/**
+ * @brief Pad the scheme-specific force properties of a cache entry that does
+ * not correspond to an active particle.
+ *
+ * @param c The #cache.
+ * @param i The index in the cache.
+ */
+__attribute__((always_inline)) INLINE void cache_pad_force_fields(
+    struct cache *restrict c, const int i) {
+
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
+#define CACHE_PAD_FIELD(name, value, pad) c->name[i] = (pad);
+  hydro_cache_force_fields(CACHE_PAD_FIELD)
+#undef CACHE_PAD_FIELD
+#endif
+}
+
 /**
  * @brief Allocate memory and initialise cache.
  *
@@ -143,9 +194,13 @@ __attribute__((always_inline)) INLINE void cache_init(struct cache *c,
     free(c->max_index);
     free(c->rho);
     free(c->grad_h);
-    free(c->pOrho2);
     free(c->balsara);
     free(c->soundspeed);
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
+#define CACHE_FREE_FIELD(name, value, pad) free(c->name);
+    hydro_cache_force_fields(CACHE_FREE_FIELD)
+#undef CACHE_FREE_FIELD
+#endif
   }
 
   error += posix_memalign((void **)&c->x, SWIFT_CACHE_ALIGNMENT, sizeBytes);
@@ -161,12 +216,16 @@ __attribute__((always_inline)) INLINE void cache_init(struct cache *c,
   error += posix_memalign((void **)&c->rho, SWIFT_CACHE_ALIGNMENT, sizeBytes);
   error +=
       posix_memalign((void **)&c->grad_h, SWIFT_CACHE_ALIGNMENT, sizeBytes);
-  error +=
-      posix_memalign((void **)&c->pOrho2, SWIFT_CACHE_ALIGNMENT, sizeBytes);
   error +=
       posix_memalign((void **)&c->balsara, SWIFT_CACHE_ALIGNMENT, sizeBytes);
   error +=
       posix_memalign((void **)&c->soundspeed, SWIFT_CACHE_ALIGNMENT, sizeBytes);
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
+#define CACHE_ALLOC_FIELD(name, value, pad) \
+  error += posix_memalign((void **)&c->name, SWIFT_CACHE_ALIGNMENT, sizeBytes);
+  hydro_cache_force_fields(CACHE_ALLOC_FIELD)
+#undef CACHE_ALLOC_FIELD
+#endif
 
   if (error != 0)
     error("Couldn't allocate cache, no. of particles: %d", (int)count);
@@ -184,7 +243,7 @@ __attribute__((always_inline)) INLINE int cache_read_particles(
     const struct cell *restrict const ci,
     struct cache *restrict const ci_cache) {
 
-#if defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
 
   /* Let the compiler know that the data is aligned and create pointers to the
    * arrays inside the cache. */
@@ -265,7 +324,7 @@ __attribute__((always_inline)) INLINE int cache_read_particles_subset_self(
     const struct cell *restrict const ci,
     struct cache *restrict const ci_cache) {
 
-#if defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
 
   /* Let the compiler know that the data is aligned and create pointers to the
    * arrays inside the cache. */
@@ -348,7 +407,7 @@ __attribute__((always_inline)) INLINE void cache_read_particles_subset_pair(
     const struct sort_entry *restrict sort_i, int *first_pi, int *last_pi,
     const double *loc, const int flipped) {
 
-#if defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
 
   /* Let the compiler know that the data is aligned and create pointers to the
    * arrays inside the cache. */
@@ -495,7 +554,7 @@ __attribute__((always_inline)) INLINE int cache_read_force_particles(
     const struct cell *restrict const ci,
     struct cache *restrict const ci_cache) {
 
-#if defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
 
   /* Let the compiler know that the data is aligned and create pointers to the
    * arrays inside the cache. */
@@ -510,8 +569,6 @@ __attribute__((always_inline)) INLINE int cache_read_force_particles(
   swift_declare_aligned_ptr(float, rho, ci_cache->rho, SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, grad_h, ci_cache->grad_h,
                             SWIFT_CACHE_ALIGNMENT);
-  swift_declare_aligned_ptr(float, pOrho2, ci_cache->pOrho2,
-                            SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, balsara, ci_cache->balsara,
                             SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, soundspeed, ci_cache->soundspeed,
@@ -536,11 +593,15 @@ __attribute__((always_inline)) INLINE int cache_read_force_particles(
       y[i] = pos_padded[1];
       z[i] = pos_padded[2];
       h[i] = h_padded;
+      m[i] = 1.f;
+      vx[i] = 1.f;
+      vy[i] = 1.f;
+      vz[i] = 1.f;
       rho[i] = 1.f;
       grad_h[i] = 1.f;
-      pOrho2[i] = 1.f;
       balsara[i] = 1.f;
       soundspeed[i] = 1.f;
+      cache_pad_force_fields(ci_cache, i);
 
       continue;
     }
@@ -555,9 +616,9 @@ __attribute__((always_inline)) INLINE int cache_read_force_particles(
     vz[i] = parts[i].v[2];
     rho[i] = parts[i].rho;
     grad_h[i] = parts[i].force.f;
-    pOrho2[i] = parts[i].force.P_over_rho2;
     balsara[i] = parts[i].force.balsara;
     soundspeed[i] = parts[i].force.soundspeed;
+    cache_read_force_fields(ci_cache, i, &parts[i]);
   }
 
   /* Pad cache if there is a serial remainder. */
@@ -573,11 +634,15 @@ __attribute__((always_inline)) INLINE int cache_read_force_particles(
       y[i] = pos_padded[1];
       z[i] = pos_padded[2];
       h[i] = h_padded;
+      m[i] = 1.f;
+      vx[i] = 1.f;
+      vy[i] = 1.f;
+      vz[i] = 1.f;
       rho[i] = 1.f;
       grad_h[i] = 1.f;
-      pOrho2[i] = 1.f;
       balsara[i] = 1.f;
       soundspeed[i] = 1.f;
+      cache_pad_force_fields(ci_cache, i);
     }
   }
 
@@ -689,7 +754,7 @@ __attribute__((always_inline)) INLINE void cache_read_two_partial_cells_sorted(
     vx[i] = parts_i[idx].v[0];
     vy[i] = parts_i[idx].v[1];
     vz[i] = parts_i[idx].v[2];
-#ifdef GADGET2_SPH
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
     m[i] = parts_i[idx].mass;
 #endif
   }
@@ -791,7 +856,7 @@ __attribute__((always_inline)) INLINE void cache_read_two_partial_cells_sorted(
     vxj[i] = parts_j[idx].v[0];
     vyj[i] = parts_j[idx].v[1];
     vzj[i] = parts_j[idx].v[2];
-#ifdef GADGET2_SPH
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
     mj[i] = parts_j[idx].mass;
 #endif
   }
@@ -909,8 +974,6 @@ cache_read_two_partial_cells_sorted_force(
   swift_declare_aligned_ptr(float, rho, ci_cache->rho, SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, grad_h, ci_cache->grad_h,
                             SWIFT_CACHE_ALIGNMENT);
-  swift_declare_aligned_ptr(float, pOrho2, ci_cache->pOrho2,
-                            SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, balsara, ci_cache->balsara,
                             SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, soundspeed, ci_cache->soundspeed,
@@ -941,9 +1004,9 @@ cache_read_two_partial_cells_sorted_force(
       vz[i] = 1.f;
       rho[i] = 1.f;
       grad_h[i] = 1.f;
-      pOrho2[i] = 1.f;
       balsara[i] = 1.f;
       soundspeed[i] = 1.f;
+      cache_pad_force_fields(ci_cache, i);
 
       continue;
     }
@@ -955,13 +1018,13 @@ cache_read_two_partial_cells_sorted_force(
     vx[i] = parts_i[idx].v[0];
     vy[i] = parts_i[idx].v[1];
     vz[i] = parts_i[idx].v[2];
-#ifdef GADGET2_SPH
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
     m[i] = parts_i[idx].mass;
     rho[i] = parts_i[idx].rho;
     grad_h[i] = parts_i[idx].force.f;
-    pOrho2[i] = parts_i[idx].force.P_over_rho2;
     balsara[i] = parts_i[idx].force.balsara;
     soundspeed[i] = parts_i[idx].force.soundspeed;
+    cache_read_force_fields(ci_cache, i, &parts_i[idx]);
 #endif
   }
 
@@ -980,9 +1043,9 @@ cache_read_two_partial_cells_sorted_force(
     vz[i] = 1.f;
     rho[i] = 1.f;
     grad_h[i] = 1.f;
-    pOrho2[i] = 1.f;
     balsara[i] = 1.f;
     soundspeed[i] = 1.f;
+    cache_pad_force_fields(ci_cache, i);
   }
 
   /* Let the compiler know that the data is aligned and create pointers to the
@@ -998,8 +1061,6 @@ cache_read_two_partial_cells_sorted_force(
   swift_declare_aligned_ptr(float, rhoj, cj_cache->rho, SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, grad_hj, cj_cache->grad_h,
                             SWIFT_CACHE_ALIGNMENT);
-  swift_declare_aligned_ptr(float, pOrho2j, cj_cache->pOrho2,
-                            SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, balsaraj, cj_cache->balsara,
                             SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, soundspeedj, cj_cache->soundspeed,
@@ -1025,9 +1086,9 @@ cache_read_two_partial_cells_sorted_force(
       vzj[i] = 1.f;
       rhoj[i] = 1.f;
       grad_hj[i] = 1.f;
-      pOrho2j[i] = 1.f;
       balsaraj[i] = 1.f;
       soundspeedj[i] = 1.f;
+      cache_pad_force_fields(cj_cache, i);
 
       continue;
     }
@@ -1039,13 +1100,13 @@ cache_read_two_partial_cells_sorted_force(
     vxj[i] = parts_j[idx].v[0];
     vyj[i] = parts_j[idx].v[1];
     vzj[i] = parts_j[idx].v[2];
-#ifdef GADGET2_SPH
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
     mj[i] = parts_j[idx].mass;
     rhoj[i] = parts_j[idx].rho;
     grad_hj[i] = parts_j[idx].force.f;
-    pOrho2j[i] = parts_j[idx].force.P_over_rho2;
     balsaraj[i] = parts_j[idx].force.balsara;
     soundspeedj[i] = parts_j[idx].force.soundspeed;
+    cache_read_force_fields(cj_cache, i, &parts_j[idx]);
 #endif
   }
 
@@ -1063,9 +1124,9 @@ cache_read_two_partial_cells_sorted_force(
     vzj[i] = 1.f;
     rhoj[i] = 1.f;
     grad_hj[i] = 1.f;
-    pOrho2j[i] = 1.f;
     balsaraj[i] = 1.f;
     soundspeedj[i] = 1.f;
+    cache_pad_force_fields(cj_cache, i);
   }
 }
 
@@ -1087,9 +1148,13 @@ static INLINE void cache_clean(struct cache *c) {
     free(c->max_index);
     free(c->rho);
     free(c->grad_h);
-    free(c->pOrho2);
     free(c->balsara);
     free(c->soundspeed);
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
+#define CACHE_FREE_FIELD(name, value, pad) free(c->name);
+    hydro_cache_force_fields(CACHE_FREE_FIELD)
+#undef CACHE_FREE_FIELD
+#endif
   }
   c->count = 0;
 }
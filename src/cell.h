@@ -533,6 +533,20 @@ void cell_pack_bpart_swallow(const struct cell *c,
                              struct black_holes_bpart_data *data);
 void cell_unpack_bpart_swallow(struct cell *c,
                                const struct black_holes_bpart_data *data);
+#ifdef hydro_mpi_rho_fields
+void cell_pack_part_rho(const struct cell *c, struct part_rho_payload *data);
+void cell_unpack_part_rho(struct cell *c, const struct part_rho_payload *data);
+#endif
+#ifdef hydro_mpi_gradient_fields
+void cell_pack_part_gradient(const struct cell *c,
+                             struct part_gradient_payload *data);
+void cell_unpack_part_gradient(struct cell *c,
+                               const struct part_gradient_payload *data);
+#endif
+void cell_pack_gpart_foreign(const struct cell *c,
+                             struct gpart_foreign_payload *data);
+void cell_unpack_gpart_foreign(struct cell *c,
+                               const struct gpart_foreign_payload *data);
 int cell_pack_tags(const struct cell *c, int *tags);
 int cell_unpack_tags(const int *tags, struct cell *c);
 int cell_pack_end_step(const struct cell *c, struct pcell_step *pcell);
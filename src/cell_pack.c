@@ -22,6 +22,9 @@
 /* Config parameters. */
 #include <config.h>
 
+/* Standard headers. */
+#include <string.h>
+
 /* This object's header. */
 #include "cell.h"
 
@@ -184,6 +187,142 @@ void cell_unpack_bpart_swallow(struct cell *c,
   }
 }
 
+/* Copy a field between a #part and its payload. */
+#define PART_PAYLOAD_PACK_FIELD(name, member) \
+  memcpy(&data[i].name, &parts[i].member, sizeof(data[i].name));
+#define PART_PAYLOAD_UNPACK_FIELD(name, member) \
+  memcpy(&parts[i].member, &data[i].name, sizeof(data[i].name));
+
+#ifdef hydro_mpi_rho_fields
+/**
+ * @brief Pack the fields of the #part of a cell sent by the rho
+ * communications.
+ *
+ * @param c The #cell.
+ * @param data The array of #part_rho_payload to fill.
+ */
+void cell_pack_part_rho(const struct cell *c, struct part_rho_payload *data) {
+
+  const size_t count = c->hydro.count;
+  const struct part *parts = c->hydro.parts;
+
+  for (size_t i = 0; i < count; ++i) {
+    hydro_mpi_rho_fields(PART_PAYLOAD_PACK_FIELD)
+  }
+}
+
+/**
+ * @brief Unpack the fields of the #part of a cell received by the rho
+ * communications.
+ *
+ * @param c The #cell.
+ * @param data The array of #part_rho_payload to read from.
+ */
+void cell_unpack_part_rho(struct cell *c, const struct part_rho_payload *data) {
+
+  const size_t count = c->hydro.count;
+  struct part *parts = c->hydro.parts;
+
+  for (size_t i = 0; i < count; ++i) {
+    hydro_mpi_rho_fields(PART_PAYLOAD_UNPACK_FIELD)
+  }
+}
+#endif
+
+#ifdef hydro_mpi_gradient_fields
+/**
+ * @brief Pack the fields of the #part of a cell sent by the gradient
+ * communications.
+ *
+ * @param c The #cell.
+ * @param data The array of #part_gradient_payload to fill.
+ */
+void cell_pack_part_gradient(const struct cell *c,
+                             struct part_gradient_payload *data) {
+
+  const size_t count = c->hydro.count;
+  const struct part *parts = c->hydro.parts;
+
+  for (size_t i = 0; i < count; ++i) {
+    hydro_mpi_gradient_fields(PART_PAYLOAD_PACK_FIELD)
+  }
+}
+
+/**
+ * @brief Unpack the fields of the #part of a cell received by the gradient
+ * communications.
+ *
+ * @param c The #cell.
+ * @param data The array of #part_gradient_payload to read from.
+ */
+void cell_unpack_part_gradient(struct cell *c,
+                               const struct part_gradient_payload *data) {
+
+  const size_t count = c->hydro.count;
+  struct part *parts = c->hydro.parts;
+
+  for (size_t i = 0; i < count; ++i) {
+    hydro_mpi_gradient_fields(PART_PAYLOAD_UNPACK_FIELD)
+  }
+}
+#endif
+
+/**
+ * @brief Pack the #gpart of a cell for the encoded gpart communications.
+ *
+ * @param c The #cell.
+ * @param data The array of #gpart_foreign_payload to fill.
+ */
+void cell_pack_gpart_foreign(const struct cell *c,
+                             struct gpart_foreign_payload *data) {
+
+  const size_t count = c->grav.count;
+  const struct gpart *parts = c->grav.parts;
+  const double centre[3] = {c->loc[0] + 0.5 * c->width[0],
+                            c->loc[1] + 0.5 * c->width[1],
+                            c->loc[2] + 0.5 * c->width[2]};
+
+  for (size_t i = 0; i < count; ++i) {
+    data[i].dx[0] = (float)(parts[i].x[0] - centre[0]);
+    data[i].dx[1] = (float)(parts[i].x[1] - centre[1]);
+    data[i].dx[2] = (float)(parts[i].x[2] - centre[2]);
+    gravity_mpi_pp_fields(PART_PAYLOAD_PACK_FIELD)
+#ifdef SWIFT_DEBUG_CHECKS
+    data[i].ti_drift = parts[i].ti_drift;
+#endif
+  }
+}
+
+/**
+ * @brief Unpack the #gpart of a cell received by the encoded gpart
+ * communications.
+ *
+ * Only the position and the fields used by the interactions with foreign
+ * particles are set.
+ *
+ * @param c The #cell.
+ * @param data The array of #gpart_foreign_payload to read from.
+ */
+void cell_unpack_gpart_foreign(struct cell *c,
+                               const struct gpart_foreign_payload *data) {
+
+  const size_t count = c->grav.count;
+  struct gpart *parts = c->grav.parts;
+  const double centre[3] = {c->loc[0] + 0.5 * c->width[0],
+                            c->loc[1] + 0.5 * c->width[1],
+                            c->loc[2] + 0.5 * c->width[2]};
+
+  for (size_t i = 0; i < count; ++i) {
+    parts[i].x[0] = centre[0] + data[i].dx[0];
+    parts[i].x[1] = centre[1] + data[i].dx[1];
+    parts[i].x[2] = centre[2] + data[i].dx[2];
+    gravity_mpi_pp_fields(PART_PAYLOAD_UNPACK_FIELD)
+#ifdef SWIFT_DEBUG_CHECKS
+    parts[i].ti_drift = data[i].ti_drift;
+#endif
+  }
+}
+
 /**
  * @brief Unpack the data of a given cell and its sub-cells.
  *
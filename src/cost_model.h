@@ -0,0 +1,152 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_COST_MODEL_H
+#define SWIFT_COST_MODEL_H
+
+/* Config parameters. */
+#include <config.h>
+
+/* Local headers. */
+#include "inline.h"
+#include "task.h"
+
+/**
+ * @brief Task costs learned online from the measured run times.
+ *
+ * The scheduler estimates the cost of a task from the number of particles it
+ * acts on (see scheduler_task_cost_estimate()). For each type and sub-type of
+ * task, we fit the ratio between the measured ticks and that estimate, using
+ * sums decaying over the steps so that the model follows the evolution of
+ * the run. The corrected costs are then all in ticks, which makes tasks of
+ * different types comparable.
+ */
+struct cost_model {
+
+  /*! Decayed sums of the measured ticks of the sampled tasks. */
+  double ticks[task_type_count][task_subtype_count];
+
+  /*! Decayed sums of the cost estimates of the sampled tasks. */
+  double estimate[task_type_count][task_subtype_count];
+
+  /*! Sums over all the task types, used for the types without samples. */
+  double total_ticks, total_estimate;
+
+  /*! Is the model in use? */
+  int enabled;
+
+  /*! Maximal number of tasks sampled per step. */
+  int max_samples;
+
+  /*! Factor by which the sums decay at each sampled step. */
+  float decay;
+};
+
+/**
+ * @brief Initialise an empty #cost_model.
+ *
+ * @param m The #cost_model.
+ * @param enabled Is the model in use?
+ * @param max_samples Maximal number of tasks sampled per step.
+ * @param decay Factor by which the sums decay at each step.
+ */
+__attribute__((always_inline)) INLINE static void cost_model_init(
+    struct cost_model *m, const int enabled, const int max_samples,
+    const float decay) {
+
+  bzero(m, sizeof(struct cost_model));
+  m->enabled = enabled;
+  m->max_samples = max_samples;
+  m->decay = decay;
+}
+
+/**
+ * @brief Age the sums of a #cost_model before adding the samples of a step.
+ *
+ * @param m The #cost_model.
+ */
+__attribute__((always_inline)) INLINE static void cost_model_decay(
+    struct cost_model *m) {
+
+  const double decay = m->decay;
+  for (int j = 0; j < task_type_count; j++) {
+    for (int k = 0; k < task_subtype_count; k++) {
+      m->ticks[j][k] *= decay;
+      m->estimate[j][k] *= decay;
+    }
+  }
+  m->total_ticks *= decay;
+  m->total_estimate *= decay;
+}
+
+/**
+ * @brief Add the measured cost of a task to a #cost_model.
+ *
+ * @param m The #cost_model.
+ * @param type The type of the task.
+ * @param subtype The sub-type of the task.
+ * @param estimate The estimated cost of the task.
+ * @param measured The measured run time of the task, in ticks.
+ */
+__attribute__((always_inline)) INLINE static void cost_model_add_sample(
+    struct cost_model *m, const enum task_types type,
+    const enum task_subtypes subtype, const float estimate,
+    const ticks measured) {
+
+  m->ticks[type][subtype] += (double)measured;
+  m->estimate[type][subtype] += estimate;
+  m->total_ticks += (double)measured;
+  m->total_estimate += estimate;
+}
+
+/**
+ * @brief Does a #cost_model have enough samples to be used?
+ *
+ * @param m The #cost_model.
+ */
+__attribute__((always_inline)) INLINE static int cost_model_is_trained(
+    const struct cost_model *m) {
+  return m->enabled && m->total_estimate > 0.;
+}
+
+/**
+ * @brief Correct the estimated cost of a task using a #cost_model.
+ *
+ * Types of tasks without samples (e.g. communications, whose run time is
+ * not representative) use the average ratio over all the tasks.
+ *
+ * @param m The #cost_model.
+ * @param type The type of the task.
+ * @param subtype The sub-type of the task.
+ * @param estimate The estimated cost of the task.
+ * @return The corrected cost in ticks, or the estimate if the model is not
+ * trained yet.
+ */
+__attribute__((always_inline)) INLINE static float cost_model_cost(
+    const struct cost_model *m, const enum task_types type,
+    const enum task_subtypes subtype, const float estimate) {
+
+  if (!cost_model_is_trained(m)) return estimate;
+
+  if (m->estimate[type][subtype] > 0.)
+    return estimate * (m->ticks[type][subtype] / m->estimate[type][subtype]);
+  else
+    return estimate * (m->total_ticks / m->total_estimate);
+}
+
+#endif /* SWIFT_COST_MODEL_H */
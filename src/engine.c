@@ -73,6 +73,7 @@
 #include "forcing.h"
 #include "gravity.h"
 #include "gravity_cache.h"
+#include "gravity_m2l_cache.h"
 #include "hydro.h"
 #include "lightcone/lightcone.h"
 #include "lightcone/lightcone_array.h"
@@ -793,6 +794,10 @@ void engine_allocate_foreign_particles(struct engine *e, const int fof) {
 
   tic = getticks();
 
+  /* The buffers may move: release the one-sided windows exposing them. This
+   * is collective, so done whether or not this rank re-allocates. */
+  scheduler_mpi_rma_free(&e->sched);
+
   /* Allocate space for the foreign particles we will receive */
   size_t old_size_parts_foreign = s->size_parts_foreign;
   if (!fof && count_parts_in > s->size_parts_foreign) {
@@ -926,6 +931,15 @@ void engine_allocate_foreign_particles(struct engine *e, const int fof) {
     message("Recursively linking foreign arrays took %.3f %s.",
             clocks_from_ticks(getticks() - tic), clocks_getunit());
 
+  /* Expose the new buffers to the one-sided communications. */
+  if (e->sched.mpi_rma) {
+    tic = getticks();
+    scheduler_mpi_rma_register(&e->sched);
+    if (e->verbose)
+      message("Registering the one-sided windows took %.3f %s.",
+              clocks_from_ticks(getticks() - tic), clocks_getunit());
+  }
+
 #else
   error("SWIFT was not compiled with MPI support.");
 #endif
@@ -1219,6 +1233,13 @@ void engine_rebuild(struct engine *e, const int repartitioned,
   /* Re-build the space. */
   space_rebuild(e->s, repartitioned, e->verbose);
 
+  /* Re-build the range of the long-range gravity tasks if the grid changed */
+  if (e->policy & engine_policy_self_gravity)
+    space_regrid_gravity_offsets(e->s, e->mesh->r_cut_max, e->verbose);
+
+  /* Give the top-level cells a home NUMA node. */
+  scheduler_numa_bind_cells(&e->sched, e->verbose);
+
   /* Report the number of cells and memory */
   if (e->verbose)
     message(
@@ -1526,8 +1547,10 @@ int engine_prepare(struct engine *e) {
   }
 #endif
 
-  /* Re-rank the tasks every now and then. XXX this never executes. */
-  if (e->tasks_age % engine_tasksreweight == 1) {
+  /* Re-weight the tasks every now and then, using the costs learned since
+   * they were built. */
+  if (e->sched.cost_model.enabled &&
+      e->tasks_age % engine_tasksreweight == 1) {
     scheduler_reweight(&e->sched, e->verbose);
   }
   e->tasks_age += 1;
@@ -2722,9 +2745,13 @@ int engine_step(struct engine *e) {
 
   /* Start all the tasks. */
   TIMER_TIC;
+  const ticks tic_launch = getticks();
   engine_launch(e, "tasks");
   TIMER_TOC(timer_runners);
 
+  /* Learn from the run times of the tasks. */
+  scheduler_sample_task_costs(&e->sched, tic_launch, e->step);
+
   /* Now record the CPU times used by the tasks. */
 #ifdef WITH_MPI
   double end_usertime = 0.0;
@@ -3725,6 +3752,7 @@ void engine_clean(struct engine *e, const int fof, const int restart) {
 #endif
     gravity_cache_clean(&e->runners[k].ci_gravity_cache);
     gravity_cache_clean(&e->runners[k].cj_gravity_cache);
+    gravity_m2l_cache_clean(&e->runners[k].m2l_cache);
   }
   swift_free("runners", e->runners);
   free(e->snapshot_units);
@@ -113,7 +113,7 @@ enum engine_step_properties {
 
 /* Some constants */
 #define engine_maxproxies 64
-#define engine_tasksreweight 1
+#define engine_tasksreweight 10
 #define engine_parts_size_grow 1.05
 #define engine_redistribute_alloc_margin_default 1.2
 #define engine_rebuild_link_alloc_margin 1.2
@@ -590,6 +590,12 @@ struct engine {
   /* Number of Lustre OSTs on the system to use as rank-based striping offset */
   int restart_lustre_OST_count;
 
+  /* Whether to write the restart files in a background thread. */
+  int restart_async;
+
+  /* zlib compression level of the asynchronous restart files (0 for none). */
+  int restart_compression;
+
   /* Do we free the foreign data before writing restart files? */
   int free_foreign_when_dumping_restart;
 
@@ -24,6 +24,7 @@
 
 /* System includes. */
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -835,6 +836,19 @@ void engine_config(int restart, int fof, struct engine *e,
     e->restart_lustre_OST_count =
         parser_get_opt_param_int(params, "Restarts:lustre_OST_count", 0);
 
+    /* Whether to write the restarts in the background, compressed or not. */
+    e->restart_async = parser_get_opt_param_int(params, "Restarts:async", 0);
+    e->restart_compression =
+        parser_get_opt_param_int(params, "Restarts:compression", 0);
+    if (e->restart_compression < 0 || e->restart_compression > 9)
+      error("Restarts:compression must be between 0 and 9.");
+    if (e->restart_compression > 0 && !e->restart_async)
+      error("Compressed restart files require Restarts:async to be set.");
+#ifndef HAVE_ZLIB
+    if (e->restart_compression > 0)
+      error("SWIFT was not compiled with zlib, cannot compress restart files.");
+#endif
+
     /* Hours between restart dumps. Can be changed on restart. */
     float dhours =
         parser_get_opt_param_float(params, "Restarts:delta_hours", 5.0f);
@@ -909,9 +923,22 @@ void engine_config(int restart, int fof, struct engine *e,
   e->links_per_tasks =
       parser_get_opt_param_float(params, "Scheduler:links_per_tasks", 25.);
 
+  /* Type of task queues: binary heaps or work-stealing deques. */
+  char queue_type[PARSER_MAX_LINE_SIZE];
+  parser_get_opt_param_string(params, "Scheduler:queue_type", queue_type,
+                              "heap");
+  unsigned int sched_flags = (e->policy & scheduler_flag_steal);
+  if (strcmp(queue_type, "deque") == 0) {
+    sched_flags |= scheduler_flag_deque;
+    if (e->nodeID == 0) message("Using work-stealing deques for task queues.");
+  } else if (strcmp(queue_type, "heap") != 0) {
+    error("Invalid value for Scheduler:queue_type '%s', must be heap or deque",
+          queue_type);
+  }
+
   /* Init the scheduler. */
-  scheduler_init(&e->sched, e->s, maxtasks, nr_queues,
-                 (e->policy & scheduler_flag_steal), e->nodeID, &e->threadpool);
+  scheduler_init(&e->sched, e->s, maxtasks, nr_queues, sched_flags, e->nodeID,
+                 &e->threadpool);
 
   /* Maximum size of MPI task messages, in KB, that should not be buffered,
    * that is sent using MPI_Issend, not MPI_Isend. 4Mb by default. Can be
@@ -920,6 +947,57 @@ void engine_config(int restart, int fof, struct engine *e,
   e->sched.mpi_message_limit =
       parser_get_opt_param_int(params, "Scheduler:mpi_message_limit", 4) * 1024;
 
+  /* Coalesce the messages of the halo exchanges with each rank into one per
+   * rank and phase? */
+  e->sched.mpi_aggregate =
+      parser_get_opt_param_int(params, "Scheduler:mpi_aggregate", 0);
+
+  /* Send only the position, relative to the cell, and the fields used by the
+   * gravity interactions of the foreign gparts? */
+  e->sched.mpi_gpart_encode =
+      parser_get_opt_param_int(params, "Scheduler:mpi_gpart_encode", 0);
+
+  /* Exchange the foreign particles through MPI-3 one-sided windows rather
+   * than with tagged send/recv pairs? */
+  e->sched.mpi_rma = parser_get_opt_param_int(params, "Scheduler:mpi_rma", 0);
+#ifndef WITH_MPI
+  if (e->sched.mpi_rma) error("SWIFT was not compiled with MPI support.");
+#endif
+
+  /* Follow the requests of the send and recv tasks with a dedicated thread
+   * that only queues the tasks once their data has landed? */
+  if (parser_get_opt_param_int(params, "Scheduler:mpi_progress_thread", 0)) {
+#ifdef WITH_MPI
+    scheduler_mpi_progress_start(&e->sched);
+#else
+    error("SWIFT was not compiled with MPI support.");
+#endif
+  }
+
+  /* Learn the task costs from their measured run times? The model uses at
+   * most cost_model_samples tasks per step and forgets older steps at the
+   * rate given by cost_model_decay. */
+  cost_model_init(
+      &e->sched.cost_model,
+      parser_get_opt_param_int(params, "Scheduler:cost_model", 1),
+      parser_get_opt_param_int(params, "Scheduler:cost_model_samples", 10000),
+      parser_get_opt_param_float(params, "Scheduler:cost_model_decay", 0.9f));
+  if (e->sched.cost_model.max_samples <= 0)
+    error("Scheduler:cost_model_samples must be positive.");
+  if (e->sched.cost_model.decay <= 0.f || e->sched.cost_model.decay > 1.f)
+    error("Scheduler:cost_model_decay must be in ]0, 1].");
+
+  /* Latency and bandwidth of the network, used to estimate the delays of the
+   * communication tasks when ranking the tasks along the critical path. */
+  const double cpufreq = (double)clocks_get_cpufreq();
+  e->sched.mpi_latency =
+      parser_get_opt_param_float(params, "Scheduler:mpi_latency_us", 2.f) *
+      1e-6 * cpufreq;
+  e->sched.mpi_ticks_per_byte =
+      cpufreq / (parser_get_opt_param_float(
+                     params, "Scheduler:mpi_bandwidth_MBps", 10000.f) *
+                 1e6);
+
   if (restart) {
 
     /* Overwrite the constants for the scheduler */
@@ -1019,8 +1097,12 @@ void engine_config(int restart, int fof, struct engine *e,
     /* Allocate particle caches. */
     e->runners[k].ci_gravity_cache.count = 0;
     e->runners[k].cj_gravity_cache.count = 0;
+    e->runners[k].ci_gravity_cache.memoise = 0;
+    e->runners[k].cj_gravity_cache.memoise = 0;
     gravity_cache_init(&e->runners[k].ci_gravity_cache, space_splitsize);
     gravity_cache_init(&e->runners[k].cj_gravity_cache, space_splitsize);
+    e->runners[k].m2l_cache.count = 0;
+    gravity_m2l_cache_init(&e->runners[k].m2l_cache, 256);
 #ifdef WITH_VECTORIZATION
     e->runners[k].ci_cache.count = 0;
     e->runners[k].cj_cache.count = 0;
@@ -1038,6 +1120,38 @@ void engine_config(int restart, int fof, struct engine *e,
     }
   }
 
+  /* Make the scheduler aware of the NUMA layout of the queues? */
+  if (parser_get_opt_param_int(params, "Scheduler:numa_aware", 0)) {
+#if defined(HAVE_SETAFFINITY) && defined(HAVE_LIBNUMA) && defined(_GNU_SOURCE)
+    if (with_aff &&
+        (e->policy & engine_policy_setaffinity) == engine_policy_setaffinity &&
+        numa_available() >= 0) {
+
+      /* Each queue lives on the node of the first runner pinned to it. */
+      int *queue_nodes = (int *)malloc(nr_queues * sizeof(int));
+      if (queue_nodes == NULL) error("Failed to allocate queue NUMA nodes.");
+      for (int k = 0; k < nr_queues; k++) queue_nodes[k] = -1;
+      for (int k = 0; k < e->nr_threads; k++) {
+        const int qid = e->runners[k].qid;
+        if (queue_nodes[qid] < 0)
+          queue_nodes[qid] = numa_node_of_cpu(e->runners[k].cpuid);
+      }
+
+      scheduler_numa_init(
+          &e->sched, queue_nodes,
+          parser_get_opt_param_int(params, "Scheduler:numa_local_steal_fails",
+                                   4),
+          verbose);
+      free(queue_nodes);
+    } else if (nodeID == 0) {
+      message("NUMA-aware scheduling needs pinned runners, not used.");
+    }
+#else
+    if (nodeID == 0)
+      message("SWIFT was not compiled with libnuma, not NUMA-aware.");
+#endif
+  }
+
 #ifdef WITH_CSDS
   if ((e->policy & engine_policy_csds) && !restart) {
     /* Write the particle csds header */
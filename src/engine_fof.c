@@ -167,8 +167,13 @@ void engine_fof(struct engine *e, const int dump_results,
   if (e->verbose) engine_print_task_counts(e);
 
   /* Perform local FOF tasks for linkable particles. */
+  const ticks tic_link = getticks();
   engine_launch(e, "fof");
 
+  if (e->verbose)
+    message("Local FOF linking took (FOF SCALING): %.3f %s.",
+            clocks_from_ticks(getticks() - tic_link), clocks_getunit());
+
   /* Compute group sizes (only of local fragments with MPI) */
   fof_compute_local_sizes(e->fof_properties, e->s);
 
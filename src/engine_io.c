@@ -208,6 +208,10 @@ int engine_dump_restarts(struct engine *e, const int drifted_all,
         message("Writing restart files");
       }
 
+      /* Wait for the previous dump to be on disk before removing its
+       * backup. */
+      restart_write_wait();
+
       /* Clean out the previous saved files, if found. Do this now as we are
        * MPI synchronized. */
       restart_remove_previous(e->restart_file);
@@ -43,6 +43,8 @@
 #include "hashmap.h"
 #include "memuse.h"
 #include "proxy.h"
+#include "runner.h"
+#include "sort_part.h"
 #include "threadpool.h"
 #include "tools.h"
 #include "tracers.h"
@@ -53,7 +55,6 @@
 
 /* Constants. */
 #define UNION_BY_SIZE_OVER_MPI (1)
-#define FOF_COMPRESS_PATHS_MIN_LENGTH (2)
 
 /* The FoF policy we are running */
 int current_fof_linking_type;
@@ -154,6 +155,20 @@ void fof_init(struct fof_props *props, struct swift_params *params,
   props->group_id_offset = parser_get_opt_param_int(
       params, "FOF:group_id_offset", fof_props_default_group_id_offset);
 
+  /* Read how to merge the group fragments across MPI ranks */
+  char foreign_merging[PARSER_MAX_LINE_SIZE];
+  parser_get_opt_param_string(params, "FOF:foreign_merging", foreign_merging,
+                              "allgather");
+  if (strcmp(foreign_merging, "allgather") == 0)
+    props->foreign_merging = fof_foreign_merging_allgather;
+  else if (strcmp(foreign_merging, "neighbours") == 0)
+    props->foreign_merging = fof_foreign_merging_neighbours;
+  else
+    error(
+        "Invalid value for FOF:foreign_merging '%s', must be allgather or "
+        "neighbours",
+        foreign_merging);
+
   /* Read the linking length ratio to the mean inter-particle separation. */
   props->l_x_ratio =
       parser_get_opt_param_double(params, "FOF:linking_length_ratio", -1.);
@@ -714,7 +729,11 @@ __attribute__((always_inline)) INLINE static int gpart_is_ignorable(
  *
  * We follow the group_index array until reaching the root of the group.
  *
- * Also performs path compression if the path is long.
+ * Also performs path halving on the way: every other element visited is made
+ * to point to its grand-parent. Roots are only ever linked to roots of lower
+ * index, so the grand-parent is always a valid ancestor and a failed update
+ * (another thread changed the element first) can safely be ignored. No lock
+ * is ever taken.
  *
  * @param i The index of the particle.
  * @param group_index Array of group root indices.
@@ -722,56 +741,29 @@ __attribute__((always_inline)) INLINE static int gpart_is_ignorable(
 __attribute__((always_inline)) INLINE static size_t fof_find(
     const size_t i, size_t *group_index) {
 
-  size_t root = i;
-  int tree_depth = 0;
-
-  while (root != group_index[root]) {
-#ifdef PATH_HALVING
-    atomic_cas(&group_index[root], group_index[root],
-               group_index[group_index[root]]);
-#endif
-    root = group_index[root];
-    tree_depth++;
-  }
-
-  /* Only perform path compression on trees with a depth of
-   * FOF_COMPRESS_PATHS_MIN_LENGTH or higher. */
-  if (tree_depth >= FOF_COMPRESS_PATHS_MIN_LENGTH)
-    atomic_cas(&group_index[i], group_index[i], root);
+  size_t node = i;
 
-  return root;
-}
+  while (1) {
 
-/**
- * @brief Atomically update the root of a group
- *
- * @param address The address of the value to update.
- * @param y The new value to write.
- *
- * @return 1 If successful, 0 otherwise.
- */
-__attribute__((always_inline)) INLINE static int atomic_update_root(
-    volatile size_t *address, const size_t y) {
-
-  size_t *size_t_ptr = (size_t *)address;
+    const size_t parent = group_index[node];
+    if (parent == node) return node;
 
-  size_t old_val = *address;
-  size_t test_val = old_val;
-  size_t new_val = y;
+    const size_t grand_parent = group_index[parent];
+    if (grand_parent == parent) return parent;
 
-  /* atomic_cas returns old_val if *size_t_ptr has not changed since being
-   * read.*/
-  old_val = atomic_cas(size_t_ptr, test_val, new_val);
-
-  if (test_val == old_val)
-    return 1;
-  else
-    return 0;
+    /* Skip one level for the next search */
+    atomic_cas(&group_index[node], parent, grand_parent);
+    node = grand_parent;
+  }
 }
 
 /**
  * @brief Unifies two groups by setting them to the same root.
  *
+ * The root with the larger index is linked to the one with the smaller
+ * index. The link is only made if the former is still a root when we write
+ * to it, otherwise we start again from the new roots.
+ *
  * @param root_i The root of the first group. Will be updated.
  * @param root_j The root of the second group.
  * @param group_index The list of group roots.
@@ -780,36 +772,73 @@ __attribute__((always_inline)) INLINE static void fof_union(
     size_t *restrict root_i, const size_t root_j,
     size_t *restrict group_index) {
 
-  int result = 0;
+  size_t root_a = *root_i;
+  size_t root_b = root_j;
 
   /* Loop until the root can be set to a new value. */
-  do {
-    size_t root_i_new = fof_find(*root_i, group_index);
-    const size_t root_j_new = fof_find(root_j, group_index);
+  while (1) {
+
+    root_a = fof_find(root_a, group_index);
+    root_b = fof_find(root_b, group_index);
 
     /* Skip particles in the same group. */
-    if (root_i_new == root_j_new) return;
+    if (root_a == root_b) {
+      *root_i = root_a;
+      return;
+    }
 
-    /* If the root ID of pj is lower than pi's root ID set pi's root to point to
-     * pj's. Otherwise set pj's root to point to pi's.*/
-    if (root_j_new < root_i_new) {
+    const size_t root_low = min(root_a, root_b);
+    const size_t root_high = max(root_a, root_b);
 
-      /* Updates the root and checks that its value has not been changed since
-       * being read. */
-      result = atomic_update_root(&group_index[root_i_new], root_j_new);
+    /* Link the roots if the high one has not been linked since being read */
+    if (atomic_cas(&group_index[root_high], root_high, root_low) ==
+        root_high) {
+      *root_i = root_low;
+      return;
+    }
+  }
+}
 
-      /* Update root_i on the fly. */
-      *root_i = root_j_new;
-    } else {
+/**
+ * @brief Finds the root of a particle in the private union-find array of a
+ * single cell.
+ *
+ * Same as fof_find() with path halving but without atomics as the array is
+ * only accessed by one thread.
+ *
+ * @param i The index of the particle in the cell.
+ * @param cell_index The array of local roots.
+ */
+__attribute__((always_inline)) INLINE static int fof_cell_find(
+    const int i, int *cell_index) {
 
-      /* Updates the root and checks that its value has not been changed since
-       * being read. */
-      result = atomic_update_root(&group_index[root_j_new], root_i_new);
+  int node = i;
 
-      /* Update root_i on the fly. */
-      *root_i = root_i_new;
-    }
-  } while (result != 1);
+  while (node != cell_index[node]) {
+    cell_index[node] = cell_index[cell_index[node]];
+    node = cell_index[node];
+  }
+
+  return node;
+}
+
+/**
+ * @brief Unifies two groups in the private union-find array of a single
+ * cell.
+ *
+ * @param root_i The root of the first group. Will be updated.
+ * @param root_j The root of the second group.
+ * @param cell_index The array of local roots.
+ */
+__attribute__((always_inline)) INLINE static void fof_cell_union(
+    int *root_i, const int root_j, int *cell_index) {
+
+  if (root_j < *root_i) {
+    cell_index[*root_i] = root_j;
+    *root_i = root_j;
+  } else {
+    cell_index[root_j] = *root_i;
+  }
 }
 
 /**
@@ -961,9 +990,67 @@ __attribute__((always_inline)) INLINE static void fof_compute_send_recv_offsets(
 
 #endif /* WITH_MPI */
 
+/**
+ * @brief Construct the list of the linkable particles of a cell sorted by
+ * their position projected along a given axis.
+ *
+ * The positions are taken relative to a reference point close to the cell
+ * such that the projections keep their precision once stored as floats.
+ *
+ * @param gparts The #gpart of the cell.
+ * @param count The number of #gpart in the cell.
+ * @param ref The reference point to subtract from the positions.
+ * @param axis The (unit) axis to project the positions on.
+ * @param sort (return) The sorted list of particles.
+ * @return The number of particles in the list.
+ */
+static int fof_sort_linkable_gparts(const struct gpart *gparts,
+                                    const size_t count, const double ref[3],
+                                    const double axis[3],
+                                    struct sort_entry *sort) {
+
+  int num = 0;
+  for (size_t i = 0; i < count; i++) {
+
+    const struct gpart *gp = &gparts[i];
+
+    /* Ignore inhibited particles */
+    if (gp->time_bin >= time_bin_inhibited) continue;
+
+    /* Check whether we ignore this particle type altogether */
+    if (gpart_is_ignorable(gp)) continue;
+
+    /* Only the particles of the linking kind can form links */
+    if (!gpart_is_linkable(gp)) continue;
+
+#ifdef SWIFT_DEBUG_CHECKS
+    if (gp->ti_drift != ti_current)
+      error("Running FOF on an un-drifted particle!");
+#endif
+
+    sort[num].d = (gp->x[0] - ref[0]) * axis[0] +
+                  (gp->x[1] - ref[1]) * axis[1] +
+                  (gp->x[2] - ref[2]) * axis[2];
+    sort[num].i = (int)i;
+    num++;
+  }
+
+  runner_do_sort_ascending(sort, num);
+
+  return num;
+}
+
 /**
  * @brief Perform a FOF search using union-find on a given leaf-cell
  *
+ * The links between the particles of the cell are first found using a
+ * private union-find array. Only the resulting groups are then merged into
+ * the global group_index, such that the shared roots are only touched
+ * once per particle rather than once per link.
+ *
+ * The particles are sorted along the x axis first, such that each particle
+ * only checks the ones within one linking length of it along that axis.
+ *
  * @param props The properties fof the FOF scheme.
  * @param l_x2 The square of the FOF linking length.
  * @param space_gparts The start of the #gpart array in the #space structure.
@@ -983,63 +1070,55 @@ void fof_search_self_cell(const struct fof_props *props, const double l_x2,
   /* Index of particles in the global group list */
   size_t *const group_index = props->group_index;
 
-  /* Make a list of particle offsets into the global gparts array. */
-  size_t *const offset = group_index + (ptrdiff_t)(gparts - space_gparts);
+  /* Index of the first particle of the cell in the global group list. */
+  const size_t first = (size_t)(gparts - space_gparts);
 
 #ifdef SWIFT_DEBUG_CHECKS
   if (c->nodeID != engine_rank)
     error("Performing self FOF search on foreign cell.");
 #endif
 
+  /* Private union-find array for the links within this cell */
+  int *cell_index = (int *)malloc(count * sizeof(int));
+  if (cell_index == NULL && count > 0)
+    error("Failed to allocate the local FOF index array.");
+  for (size_t i = 0; i < count; i++) cell_index[i] = (int)i;
+
+  /* Sort the particles along the x axis. Only the particles within one
+   * linking length along that axis are then candidates for a link. */
+  struct sort_entry *sort =
+      (struct sort_entry *)malloc(count * sizeof(struct sort_entry));
+  if (sort == NULL && count > 0)
+    error("Failed to allocate the FOF sorting array.");
+  const double axis[3] = {1., 0., 0.};
+  const int num = fof_sort_linkable_gparts(gparts, count, c->loc, axis, sort);
+
+  /* Width of the search window (slightly enlarged to be safe against
+   * round-off in the projections) */
+  const float l_x = 1.0001f * sqrtf(l_x2);
+
   /* Loop over particles and find which particles belong in the same group. */
-  for (size_t i = 0; i < count; i++) {
+  for (int a = 0; a < num; a++) {
 
+    const int i = sort[a].i;
     const struct gpart *pi = &gparts[i];
 
-    /* Ignore inhibited particles */
-    if (pi->time_bin >= time_bin_inhibited) continue;
-
-    /* Check whether we ignore this particle type altogether */
-    if (gpart_is_ignorable(pi)) continue;
-
-#ifdef SWIFT_DEBUG_CHECKS
-    if (pi->ti_drift != ti_current)
-      error("Running FOF on an un-drifted particle!");
-#endif
-
     const double pix = pi->x[0];
     const double piy = pi->x[1];
     const double piz = pi->x[2];
 
     /* Find the root of pi. */
-    size_t root_i = fof_find(offset[i], group_index);
+    int root_i = fof_cell_find(i, cell_index);
 
-    /* Get the nature of the linking */
-    const int is_link_i = gpart_is_linkable(pi);
-
-    for (size_t j = i + 1; j < count; j++) {
+    /* Loop over the particles ahead of pi and within reach */
+    const float d_max = sort[a].d + l_x;
+    for (int b = a + 1; b < num && sort[b].d <= d_max; b++) {
 
+      const int j = sort[b].i;
       const struct gpart *pj = &gparts[j];
 
-      /* Ignore inhibited particles */
-      if (pj->time_bin >= time_bin_inhibited) continue;
-
-      /* Check whether we ignore this particle type altogether */
-      if (gpart_is_ignorable(pj)) continue;
-
-      /* Get the nature of the linking */
-      const int is_link_j = gpart_is_linkable(pj);
-
-      /* Both particles must be of the linking kind */
-      if (!(is_link_i && is_link_j)) continue;
-
-#ifdef SWIFT_DEBUG_CHECKS
-      if (pj->ti_drift != ti_current)
-        error("Running FOF on an un-drifted particle!");
-#endif
-
       /* Find the root of pj. */
-      const size_t root_j = fof_find(offset[j], group_index);
+      const int root_j = fof_cell_find(j, cell_index);
 
       /* Skip particles in the same group. */
       if (root_i == root_j) continue;
@@ -1060,15 +1139,33 @@ void fof_search_self_cell(const struct fof_props *props, const double l_x2,
       if (r2 < l_x2) {
 
         /* Merge the groups` */
-        fof_union(&root_i, root_j, group_index);
+        fof_cell_union(&root_i, root_j, cell_index);
       }
     }
   }
+
+  free(sort);
+
+  /* Now merge the groups found in this cell into the global list */
+  for (size_t i = 0; i < count; i++) {
+
+    const int root = fof_cell_find((int)i, cell_index);
+    if (root == (int)i) continue;
+
+    size_t root_i = first + i;
+    fof_union(&root_i, first + root, group_index);
+  }
+
+  free(cell_index);
 }
 
 /**
  * @brief Perform a FOF search using union-find between two cells
  *
+ * The particles of both cells are sorted along the axis joining the cells
+ * and each particle of ci only checks the particles of cj that are within
+ * one linking length of it along that axis.
+ *
  * @param props The properties fof the FOF scheme.
  * @param dim The dimension of the simulation volume.
  * @param l_x2 The square of the FOF linking length.
@@ -1119,22 +1216,42 @@ void fof_search_pair_cells(const struct fof_props *props, const double dim[3],
     diff[k] += shift[k];
   }
 
+  /* Project the particles along the axis joining the cell centres, using the
+   * (shifted) corner of ci as reference point. Only the particles within one
+   * linking length of each other along that axis are candidates for a
+   * link. */
+  double axis[3], norm2 = 0.;
+  for (int k = 0; k < 3; k++) {
+    axis[k] = diff[k] + 0.5 * (cj->width[k] - ci->width[k]);
+    norm2 += axis[k] * axis[k];
+  }
+  const double norm_inv = 1. / sqrt(norm2);
+  for (int k = 0; k < 3; k++) axis[k] *= norm_inv;
+
+  const double ref_i[3] = {ci->loc[0], ci->loc[1], ci->loc[2]};
+  const double ref_j[3] = {ci->loc[0] - shift[0], ci->loc[1] - shift[1],
+                           ci->loc[2] - shift[2]};
+
+  struct sort_entry *sort_i = (struct sort_entry *)malloc(
+      (count_i + count_j) * sizeof(struct sort_entry));
+  if (sort_i == NULL) error("Failed to allocate the FOF sorting array.");
+  struct sort_entry *sort_j = sort_i + count_i;
+  const int num_i =
+      fof_sort_linkable_gparts(gparts_i, count_i, ref_i, axis, sort_i);
+  const int num_j =
+      fof_sort_linkable_gparts(gparts_j, count_j, ref_j, axis, sort_j);
+
+  /* Width of the search window (slightly enlarged to be safe against
+   * round-off in the projections) */
+  const float l_x = 1.0001f * sqrtf(l_x2);
+
   /* Loop over particles and find which particles belong in the same group. */
-  for (size_t i = 0; i < count_i; i++) {
+  int b_start = 0;
+  for (int a = 0; a < num_i; a++) {
 
+    const int i = sort_i[a].i;
     const struct gpart *restrict pi = &gparts_i[i];
 
-    /* Ignore inhibited particles */
-    if (pi->time_bin >= time_bin_inhibited) continue;
-
-    /* Check whether we ignore this particle type altogether */
-    if (gpart_is_ignorable(pi)) continue;
-
-#ifdef SWIFT_DEBUG_CHECKS
-    if (pi->ti_drift != ti_current)
-      error("Running FOF on an un-drifted particle!");
-#endif
-
     const double pix = pi->x[0] - shift[0];
     const double piy = pi->x[1] - shift[1];
     const double piz = pi->x[2] - shift[2];
@@ -1142,30 +1259,17 @@ void fof_search_pair_cells(const struct fof_props *props, const double dim[3],
     /* Find the root of pi. */
     size_t root_i = fof_find(offset_i[i], group_index);
 
-    /* Get the nature of the linking */
-    const int is_link_i = gpart_is_linkable(pi);
+    /* Range of pj within reach of pi along the axis. As pi moves forward, so
+     * does the start of the range. */
+    const float d_min = sort_i[a].d - l_x;
+    const float d_max = sort_i[a].d + l_x;
+    while (b_start < num_j && sort_j[b_start].d < d_min) b_start++;
 
-    for (size_t j = 0; j < count_j; j++) {
+    for (int b = b_start; b < num_j && sort_j[b].d <= d_max; b++) {
 
+      const int j = sort_j[b].i;
       const struct gpart *restrict pj = &gparts_j[j];
 
-      /* Ignore inhibited particles */
-      if (pj->time_bin >= time_bin_inhibited) continue;
-
-      /* Check whether we ignore this particle type altogether */
-      if (gpart_is_ignorable(pj)) continue;
-
-      /* Get the nature of the linking */
-      const int is_link_j = gpart_is_linkable(pj);
-
-      /* At least one of the particles has to be of linking type */
-      if (!(is_link_i && is_link_j)) continue;
-
-#ifdef SWIFT_DEBUG_CHECKS
-      if (pj->ti_drift != ti_current)
-        error("Running FOF on an un-drifted particle!");
-#endif
-
       /* Find the root of pj. */
       const size_t root_j = fof_find(offset_j[j], group_index);
 
@@ -1193,6 +1297,8 @@ void fof_search_pair_cells(const struct fof_props *props, const double dim[3],
       }
     }
   }
+
+  free(sort_i);
 }
 
 #ifdef WITH_MPI
@@ -3327,8 +3433,12 @@ void fof_search_foreign_cells(struct fof_props *props, const struct space *s) {
 
   tic = getticks();
 
-  /* Perform send and receive tasks. */
+  /* Perform send and receive tasks. FOF needs the full foreign particles,
+   * not just what the gravity interactions use. */
+  const int mpi_gpart_encode = e->sched.mpi_gpart_encode;
+  e->sched.mpi_gpart_encode = 0;
   engine_launch(e, "fof comms");
+  e->sched.mpi_gpart_encode = mpi_gpart_encode;
 
   if (verbose)
     message("MPI send/recv comms took: %.3f %s.",
@@ -3616,6 +3726,388 @@ void fof_finalise_attachables(struct fof_props *props, const struct space *s) {
             clocks_from_ticks(getticks() - tic_total), clocks_getunit());
 }
 
+#ifdef WITH_MPI
+
+/**
+ * @brief Find the rank holding a given particle.
+ *
+ * @param index The global index of the particle.
+ * @param first_on_node The global index of the first particle of each rank.
+ * @param nr_nodes The number of ranks.
+ */
+static int fof_find_node(const size_t index, const size_t *first_on_node,
+                         const int nr_nodes) {
+
+  /* Last rank starting at or before the index. Any empty rank in-between
+   * starts at the same index as the next one so is never picked. */
+  int low = 0, high = nr_nodes - 1;
+  while (low < high) {
+    const int mid = (low + high + 1) / 2;
+    if (first_on_node[mid] <= index)
+      low = mid;
+    else
+      high = mid - 1;
+  }
+
+  return low;
+}
+
+/**
+ * @brief Process all the group fragments spanning more than one rank to link
+ * them, only talking to the ranks we have links with.
+ *
+ * Every fragment starts labelled with its own root ID. The fragments
+ * connected through the links known to this rank all take the smallest label
+ * of their set, which is then sent along the links to the ranks holding the
+ * other ends. This is repeated until no label changes anywhere. The final
+ * label, the smallest root ID of the whole group, becomes the new root of
+ * each fragment.
+ *
+ * The two ranks holding the ends of a link do not necessarily both find it,
+ * as the separations are computed in single precision with a periodic shift
+ * on each side. Every link is hence first sent to the rank holding its other
+ * end, which adds it reversed to its own list, such that the labels travel
+ * both ways along all the links.
+ *
+ * Unlike the gathering of all the links on all the ranks, the memory and
+ * communication volume only depend on the links of each rank. The number of
+ * rounds is set by the number of ranks a group spans.
+ *
+ * @param props The properties fof the FOF scheme.
+ * @param s The #space we work with.
+ */
+static void fof_link_foreign_fragments_neighbours(struct fof_props *props,
+                                                  const struct space *s) {
+
+  const struct engine *e = s->e;
+  const int verbose = e->verbose;
+  const int nr_nodes = e->nr_nodes;
+  const size_t nr_gparts = s->nr_gparts;
+  size_t *restrict group_index = props->group_index;
+  size_t *restrict group_size = props->group_size;
+  const int own_link_count = props->group_link_count;
+  const struct fof_mpi *own_links = props->group_links;
+
+  const ticks tic_total = getticks();
+  ticks tic = getticks();
+
+  /* Our own communicator, such that the label messages cannot be confused
+   * with any other traffic. */
+  MPI_Comm comm;
+  if (MPI_Comm_dup(MPI_COMM_WORLD, &comm) != MPI_SUCCESS)
+    error("Failed to duplicate the MPI communicator.");
+
+  /* Determine range of global indexes (i.e. particles) on each node */
+  size_t *num_on_node = (size_t *)malloc(nr_nodes * sizeof(size_t));
+  MPI_Allgather(&nr_gparts, sizeof(size_t), MPI_BYTE, num_on_node,
+                sizeof(size_t), MPI_BYTE, comm);
+  size_t *first_on_node = (size_t *)malloc(nr_nodes * sizeof(size_t));
+  first_on_node[0] = 0;
+  for (int i = 1; i < nr_nodes; i++)
+    first_on_node[i] = first_on_node[i - 1] + num_on_node[i - 1];
+
+  /* Send each of our links to the rank holding its foreign end... */
+  int *link_sendcount = (int *)calloc(nr_nodes, sizeof(int));
+  for (int k = 0; k < own_link_count; k++)
+    link_sendcount[fof_find_node(own_links[k].group_j, first_on_node,
+                                 nr_nodes)]++;
+
+  int *link_recvcount = NULL, *link_sendoffset = NULL, *link_recvoffset = NULL;
+  size_t link_nrecv = 0;
+  fof_compute_send_recv_offsets(nr_nodes, link_sendcount, &link_recvcount,
+                                &link_sendoffset, &link_recvoffset,
+                                &link_nrecv);
+
+  struct fof_mpi *link_send = (struct fof_mpi *)swift_malloc(
+      "fof_link_send", own_link_count * sizeof(struct fof_mpi));
+  int *link_fill = (int *)malloc(nr_nodes * sizeof(int));
+  memcpy(link_fill, link_sendoffset, nr_nodes * sizeof(int));
+  for (int k = 0; k < own_link_count; k++)
+    link_send[link_fill[fof_find_node(own_links[k].group_j, first_on_node,
+                                      nr_nodes)]++] = own_links[k];
+  free(link_fill);
+
+  /* ... and add the links received, reversed, to our own. */
+  const size_t all_link_count = own_link_count + link_nrecv;
+  struct fof_mpi *group_links = (struct fof_mpi *)swift_malloc(
+      "fof_all_group_links", all_link_count * sizeof(struct fof_mpi));
+  if ((own_link_count > 0 && link_send == NULL) ||
+      (all_link_count > 0 && group_links == NULL))
+    error("Error while allocating memory for the symmetric list of links");
+  MPI_Alltoallv(link_send, link_sendcount, link_sendoffset, fof_mpi_type,
+                &group_links[own_link_count], link_recvcount, link_recvoffset,
+                fof_mpi_type, comm);
+  memcpy(group_links, own_links, own_link_count * sizeof(struct fof_mpi));
+  for (size_t k = own_link_count; k < all_link_count; k++) {
+    const struct fof_mpi remote = group_links[k];
+#ifdef SWIFT_DEBUG_CHECKS
+    if (!is_local(remote.group_j, nr_gparts))
+      error("Received a link to a foreign group!");
+#endif
+    group_links[k].group_i = remote.group_j;
+    group_links[k].group_i_size = group_size[remote.group_j - node_offset];
+    group_links[k].group_j = remote.group_i;
+    group_links[k].group_j_size = remote.group_i_size;
+  }
+  const int group_link_count = (int)all_link_count;
+  swift_free("fof_link_send", link_send);
+  free(link_sendcount);
+  free(link_recvcount);
+  free(link_sendoffset);
+  free(link_recvoffset);
+
+  /* Give a slot to every group appearing in our links: the local fragments
+   * first, then the foreign ones. */
+  const size_t max_groups = 2 * (size_t)group_link_count;
+  size_t *group_id = (size_t *)malloc(max_groups * sizeof(size_t));
+  size_t *fragment_size = (size_t *)malloc(max_groups * sizeof(size_t));
+  size_t *group_label = (size_t *)malloc(max_groups * sizeof(size_t));
+  size_t *link_index = (size_t *)malloc(max_groups * sizeof(size_t));
+  if (max_groups > 0 && (group_id == NULL || fragment_size == NULL ||
+                         group_label == NULL || link_index == NULL))
+    error("Error while allocating memory for the group fragment lists");
+
+  hashmap_t map;
+  hashmap_init(&map);
+
+  size_t num_groups = 0, num_local = 0;
+  for (int foreign = 0; foreign < 2; foreign++) {
+    for (int k = 0; k < group_link_count; k++) {
+
+      const size_t id =
+          foreign ? group_links[k].group_j : group_links[k].group_i;
+
+      int created_new_element = 0;
+      hashmap_value_t *slot = hashmap_get_new(&map, id, &created_new_element);
+      if (slot == NULL) error("Couldn't find key (%zu) or create new one.", id);
+
+      if (created_new_element) {
+        slot->value_st = num_groups;
+        group_id[num_groups] = id;
+        fragment_size[num_groups] = foreign ? 0 : group_links[k].group_i_size;
+        group_label[num_groups] = id;
+        link_index[num_groups] = num_groups;
+        num_groups++;
+      }
+    }
+    if (!foreign) num_local = num_groups;
+  }
+
+  /* Connect the groups linked on this rank. The root of each set is its
+   * smallest slot, hence always a local fragment. */
+  for (int k = 0; k < group_link_count; k++) {
+
+    const size_t root_i = fof_find(
+        hashmap_find_group_offset(group_links[k].group_i, &map), link_index);
+    const size_t root_j = fof_find(
+        hashmap_find_group_offset(group_links[k].group_j, &map), link_index);
+
+    if (root_i < root_j)
+      link_index[root_j] = root_i;
+    else if (root_j < root_i)
+      link_index[root_i] = root_j;
+  }
+
+  /* Sort the foreign groups by the rank they live on */
+  const size_t num_foreign = num_groups - num_local;
+  int *sendcount = (int *)calloc(nr_nodes, sizeof(int));
+  int *node_of_slot = (int *)malloc(num_foreign * sizeof(int));
+  for (size_t i = 0; i < num_foreign; i++) {
+    node_of_slot[i] =
+        fof_find_node(group_id[num_local + i], first_on_node, nr_nodes);
+    sendcount[node_of_slot[i]]++;
+  }
+
+  int *recvcount = NULL, *sendoffset = NULL, *recvoffset = NULL;
+  size_t nrecv = 0;
+  fof_compute_send_recv_offsets(nr_nodes, sendcount, &recvcount, &sendoffset,
+                                &recvoffset, &nrecv);
+
+  size_t *send_slot = (size_t *)malloc(num_foreign * sizeof(size_t));
+  int *fill = (int *)malloc(nr_nodes * sizeof(int));
+  memcpy(fill, sendoffset, nr_nodes * sizeof(int));
+  for (size_t i = 0; i < num_foreign; i++)
+    send_slot[fill[node_of_slot[i]]++] = num_local + i;
+  free(fill);
+  free(node_of_slot);
+
+  struct fof_final_index *label_send = (struct fof_final_index *)swift_malloc(
+      "fof_label_send", num_foreign * sizeof(struct fof_final_index));
+  struct fof_final_index *label_recv = (struct fof_final_index *)swift_malloc(
+      "fof_label_recv", nrecv * sizeof(struct fof_final_index));
+  MPI_Request *requests =
+      (MPI_Request *)malloc(2 * nr_nodes * sizeof(MPI_Request));
+
+  if (verbose)
+    message("Setting up the fragment lists took: %.3f %s.",
+            clocks_from_ticks(getticks() - tic), clocks_getunit());
+
+  tic = getticks();
+
+  /* Propagate the smallest labels until nothing changes any more */
+  int num_rounds = 0;
+  int changed_anywhere = 1;
+  while (changed_anywhere) {
+
+    int changed = 0;
+
+    /* Smallest label of each set of connected groups, kept at its root */
+    for (size_t i = 0; i < num_local; i++) {
+      const size_t root = fof_find(i, link_index);
+      if (group_label[i] < group_label[root]) {
+        group_label[root] = group_label[i];
+        changed = 1;
+      }
+    }
+    for (size_t i = 0; i < num_local; i++) {
+      const size_t root = fof_find(i, link_index);
+      if (group_label[root] < group_label[i]) {
+        group_label[i] = group_label[root];
+        changed = 1;
+      }
+    }
+
+    /* Tell the ranks holding the foreign groups about their new label */
+    for (size_t i = 0; i < num_foreign; i++) {
+      const size_t slot = send_slot[i];
+      label_send[i].local_root = group_id[slot];
+      label_send[i].global_root = group_label[fof_find(slot, link_index)];
+    }
+
+    int num_requests = 0;
+    for (int i = 0; i < nr_nodes; i++) {
+      if (recvcount[i] > 0)
+        MPI_Irecv(&label_recv[recvoffset[i]], recvcount[i],
+                  fof_final_index_type, i, 0, comm, &requests[num_requests++]);
+      if (sendcount[i] > 0)
+        MPI_Isend(&label_send[sendoffset[i]], sendcount[i],
+                  fof_final_index_type, i, 0, comm, &requests[num_requests++]);
+    }
+    if (MPI_Waitall(num_requests, requests, MPI_STATUSES_IGNORE) !=
+        MPI_SUCCESS)
+      error("Failed to exchange the FOF group labels.");
+
+    /* And receive the labels of our own fragments */
+    for (size_t i = 0; i < nrecv; i++) {
+      const size_t slot =
+          hashmap_find_group_offset(label_recv[i].local_root, &map);
+#ifdef SWIFT_DEBUG_CHECKS
+      if (slot >= num_local) error("Received the label of a foreign group!");
+#endif
+      if (label_recv[i].global_root < group_label[slot]) {
+        group_label[slot] = label_recv[i].global_root;
+        changed = 1;
+      }
+    }
+
+    MPI_Allreduce(&changed, &changed_anywhere, 1, MPI_INT, MPI_MAX, comm);
+    num_rounds++;
+  }
+
+  if (verbose)
+    message("Label propagation took %d rounds and %.3f %s.", num_rounds,
+            clocks_from_ticks(getticks() - tic), clocks_getunit());
+
+  tic = getticks();
+
+  /* Re-root the fragments and move their size to the new root, which may
+   * live on another rank. */
+  int *size_sendcount = (int *)calloc(nr_nodes, sizeof(int));
+  for (size_t i = 0; i < num_local; i++) {
+    const size_t new_root = group_label[i];
+    if (new_root != group_id[i] && !is_local(new_root, nr_gparts))
+      size_sendcount[fof_find_node(new_root, first_on_node, nr_nodes)]++;
+  }
+
+  int *size_recvcount = NULL, *size_sendoffset = NULL, *size_recvoffset = NULL;
+  size_t size_nrecv = 0;
+  fof_compute_send_recv_offsets(nr_nodes, size_sendcount, &size_recvcount,
+                                &size_sendoffset, &size_recvoffset,
+                                &size_nrecv);
+
+  size_t size_nsend = 0;
+  for (int i = 0; i < nr_nodes; i++) size_nsend += size_sendcount[i];
+
+  /* We re-use the link structure: group_i is the new root and group_i_size
+   * the size of the fragment group_j joining it. */
+  struct fof_mpi *size_send = (struct fof_mpi *)swift_malloc(
+      "fof_size_send", size_nsend * sizeof(struct fof_mpi));
+  struct fof_mpi *size_recv = (struct fof_mpi *)swift_malloc(
+      "fof_size_recv", size_nrecv * sizeof(struct fof_mpi));
+
+  int *size_fill = (int *)malloc(nr_nodes * sizeof(int));
+  memcpy(size_fill, size_sendoffset, nr_nodes * sizeof(int));
+  for (size_t i = 0; i < num_local; i++) {
+
+    const size_t old_root = group_id[i];
+    const size_t new_root = group_label[i];
+    if (new_root == old_root) continue;
+
+    group_index[old_root - node_offset] = new_root;
+    group_size[old_root - node_offset] -= fragment_size[i];
+
+    if (is_local(new_root, nr_gparts)) {
+      group_size[new_root - node_offset] += fragment_size[i];
+    } else {
+      const int node = fof_find_node(new_root, first_on_node, nr_nodes);
+      struct fof_mpi *msg = &size_send[size_fill[node]++];
+      msg->group_i = new_root;
+      msg->group_i_size = fragment_size[i];
+      msg->group_j = old_root;
+      msg->group_j_size = 0;
+    }
+  }
+  free(size_fill);
+
+  MPI_Alltoallv(size_send, size_sendcount, size_sendoffset, fof_mpi_type,
+                size_recv, size_recvcount, size_recvoffset, fof_mpi_type, comm);
+
+  for (size_t i = 0; i < size_nrecv; i++) {
+#ifdef SWIFT_DEBUG_CHECKS
+    if (!is_local(size_recv[i].group_i, nr_gparts))
+      error("Received the size of a fragment of a foreign group!");
+#endif
+    group_size[size_recv[i].group_i - node_offset] += size_recv[i].group_i_size;
+  }
+
+  if (verbose)
+    message("Updating groups locally took: %.3f %s.",
+            clocks_from_ticks(getticks() - tic), clocks_getunit());
+
+  /* Clean up memory. */
+  hashmap_free(&map);
+  free(num_on_node);
+  free(first_on_node);
+  free(group_id);
+  free(fragment_size);
+  free(group_label);
+  free(link_index);
+  free(send_slot);
+  free(requests);
+  free(sendcount);
+  free(recvcount);
+  free(sendoffset);
+  free(recvoffset);
+  free(size_sendcount);
+  free(size_recvcount);
+  free(size_sendoffset);
+  free(size_recvoffset);
+  swift_free("fof_label_send", label_send);
+  swift_free("fof_label_recv", label_recv);
+  swift_free("fof_size_send", size_send);
+  swift_free("fof_size_recv", size_recv);
+  swift_free("fof_all_group_links", group_links);
+  swift_free("fof_group_links", props->group_links);
+  props->group_links = NULL;
+  MPI_Comm_free(&comm);
+
+  if (verbose)
+    message("link_foreign_fragmens() took (FOF SCALING): %.3f %s.",
+            clocks_from_ticks(getticks() - tic_total), clocks_getunit());
+}
+
+#endif /* WITH_MPI */
+
 /**
  * @brief Process all the group fragments spanning more than
  * one rank to link them.
@@ -3637,6 +4129,12 @@ void fof_link_foreign_fragments(struct fof_props *props,
   /* Abort if only one node */
   if (e->nr_nodes == 1) return;
 
+  /* Are we only exchanging labels with the neighbouring ranks? */
+  if (props->foreign_merging == fof_foreign_merging_neighbours) {
+    fof_link_foreign_fragments_neighbours(props, s);
+    return;
+  }
+
   const size_t nr_gparts = s->nr_gparts;
   size_t *restrict group_index = props->group_index;
   size_t *restrict group_size = props->group_size;
@@ -27,6 +27,14 @@
 #include "parser.h"
 #include "part_type.h"
 
+/**
+ * @brief Strategies to merge the group fragments found on different ranks.
+ */
+enum fof_foreign_merging {
+  fof_foreign_merging_allgather,  /*!< Gather all the links on all ranks */
+  fof_foreign_merging_neighbours, /*!< Exchange labels with linked ranks */
+};
+
 /* Avoid cyclic inclusions */
 struct cell;
 struct gpart;
@@ -75,6 +83,9 @@ struct fof_props {
   /*! The types of particles to use for attaching */
   int fof_attach_types[swift_type_count];
 
+  /*! How to merge the group fragments found on different ranks */
+  enum fof_foreign_merging foreign_merging;
+
   /* ------------  Group properties ----------------- */
 
   /*! Number of groups */
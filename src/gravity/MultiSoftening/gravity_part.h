@@ -121,4 +121,12 @@ struct gpart {
 #endif
 };
 
+/* Fields of the #gpart, besides its position, used by the interactions with
+ * foreign particles. They are the only ones sent by the encoded gpart
+ * communications (see part.h). */
+#define gravity_mpi_pp_fields(FIELD) \
+  FIELD(mass, mass)                  \
+  FIELD(epsilon, epsilon)            \
+  FIELD(time_bin, time_bin)
+
 #endif /* SWIFT_MULTI_SOFTENING_GRAVITY_PART_H */
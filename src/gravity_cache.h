@@ -28,6 +28,7 @@
 #include "error.h"
 #include "gravity.h"
 #include "multipole_accept.h"
+#include "timeline.h"
 #include "vector.h"
 
 /**
@@ -72,8 +73,64 @@ struct gravity_cache {
 
   /*! Cache size */
   int count;
+
+  /*! #gpart array the input fields were last filled from (NULL if none). */
+  const struct gpart *filled_gparts;
+
+  /*! Drift time of the #gpart when the input fields were last filled. */
+  integertime_t filled_ti_drift;
+
+  /*! Shift applied to the positions when the input fields were last filled. */
+  double filled_shift[3];
+
+  /*! Number of #gpart read when the input fields were last filled. */
+  int filled_gcount;
+
+  /*! Largest active bin used when the input fields were last filled. */
+  timebin_t filled_max_active_bin;
+
+  /*! Can the input fields be re-used across populate calls? Only set for the
+   * duration of a gravity task, as the #gpart can change in-between. */
+  int memoise;
 };
 
+/**
+ * @brief Forget the content of the input fields of a #gravity_cache.
+ *
+ * The next call to one of the populate functions will then read the #gpart
+ * again.
+ *
+ * @param c The #gravity_cache to invalidate.
+ */
+INLINE static void gravity_cache_invalidate(struct gravity_cache *c) {
+  c->filled_gparts = NULL;
+}
+
+/**
+ * @brief Let a #gravity_cache re-use its input fields across populate calls.
+ *
+ * The #gpart of the cells met by a gravity task are not modified by anything
+ * else while the task runs. This is not true in-between tasks (drift, kick,
+ * receives, ...) so the re-use must be limited to a single task by calling
+ * gravity_cache_memoise_end() once it is done.
+ *
+ * @param c The #gravity_cache.
+ */
+INLINE static void gravity_cache_memoise_begin(struct gravity_cache *c) {
+  gravity_cache_invalidate(c);
+  c->memoise = 1;
+}
+
+/**
+ * @brief Stop re-using the input fields of a #gravity_cache and forget them.
+ *
+ * @param c The #gravity_cache.
+ */
+INLINE static void gravity_cache_memoise_end(struct gravity_cache *c) {
+  c->memoise = 0;
+  gravity_cache_invalidate(c);
+}
+
 /**
  * @brief Frees the memory allocated in a #gravity_cache
  *
@@ -95,6 +152,7 @@ static INLINE void gravity_cache_clean(struct gravity_cache *c) {
     swift_free("gravity_cache", c->use_mpole);
   }
   c->count = 0;
+  gravity_cache_invalidate(c);
 }
 
 /**
@@ -145,6 +203,7 @@ static INLINE void gravity_cache_init(struct gravity_cache *c,
   if (e != 0) error("Couldn't allocate gravity cache, size: %d", padded_count);
 
   c->count = padded_count;
+  gravity_cache_invalidate(c);
 }
 
 /**
@@ -177,32 +236,30 @@ INLINE static void gravity_cache_zero_output(struct gravity_cache *c,
 }
 
 /**
- * @brief Fills a #gravity_cache structure with some #gpart and shift them.
+ * @brief Fills the input fields (positions, softening, mass and activity) of
+ * a #gravity_cache with some #gpart and shift them.
  *
- * Also checks whether the #gpart can use a M2P interaction instead of the
- * more expensive P2P.
+ * A leaf cell typically takes part in many P-P interactions within a gravity
+ * task and its #gpart do not change in-between. If re-use was enabled with
+ * gravity_cache_memoise_begin() and the cache already holds the same #gpart,
+ * drifted to the same time, with the same shift and time-bin selection, the
+ * content is re-used rather than converted again from the double-precision
+ * positions.
  *
  * @param max_active_bin The largest active bin in the current time-step.
- * @param allow_mpole Are we allowing the use of multipoles?
- * @param periodic Are we using periodic BCs ?
- * @param dim The size of the simulation volume along each dimension.
  * @param c The #gravity_cache to fill.
  * @param gparts The #gpart array to read from.
  * @param gcount The number of particles to read.
  * @param gcount_padded The number of particle to read padded to the next
  * multiple of the vector length.
  * @param shift A shift to apply to all the particles.
- * @param CoM The position of the multipole.
- * @param multipole The mulipole to check for.
  * @param cell The cell we play with (to get reasonable padding positions).
  * @param grav_props The global gravity properties.
  */
-INLINE static void gravity_cache_populate(
-    const timebin_t max_active_bin, const int allow_mpole, const int periodic,
-    const float dim[3], struct gravity_cache *c,
+INLINE static void gravity_cache_populate_input(
+    const timebin_t max_active_bin, struct gravity_cache *c,
     const struct gpart *restrict gparts, const int gcount,
-    const int gcount_padded, const double shift[3], const float CoM[3],
-    const struct gravity_tensors *multipole, const struct cell *cell,
+    const int gcount_padded, const double shift[3], const struct cell *cell,
     const struct gravity_props *grav_props) {
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -214,6 +271,14 @@ INLINE static void gravity_cache_populate(
   /* Do we need to grow the cache? */
   if (c->count < gcount_padded) gravity_cache_init(c, gcount_padded + VEC_SIZE);
 
+  /* Is the cache already holding exactly these particles? */
+  if (c->memoise && c->filled_gparts == gparts && c->filled_gcount == gcount &&
+      c->filled_ti_drift == cell->grav.ti_old_part &&
+      c->filled_max_active_bin == max_active_bin &&
+      c->filled_shift[0] == shift[0] && c->filled_shift[1] == shift[1] &&
+      c->filled_shift[2] == shift[2])
+    return;
+
   /* Make the compiler understand we are in happy vectorization land */
   swift_declare_aligned_ptr(float, x, c->x, SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, y, c->y, SWIFT_CACHE_ALIGNMENT);
@@ -221,8 +286,6 @@ INLINE static void gravity_cache_populate(
   swift_declare_aligned_ptr(float, epsilon, c->epsilon, SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, m, c->m, SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(int, active, c->active, SWIFT_CACHE_ALIGNMENT);
-  swift_declare_aligned_ptr(int, use_mpole, c->use_mpole,
-                            SWIFT_CACHE_ALIGNMENT);
   swift_assume_size(gcount_padded, VEC_SIZE);
 
   /* Fill the input caches */
@@ -250,29 +313,8 @@ INLINE static void gravity_cache_populate(
       m[i] = gparts[i].mass;
       active[i] = (int)(gparts[i].time_bin <= max_active_bin);
     }
-
-    /* Distance to the CoM of the other cell. */
-    float dx = x[i] - CoM[0];
-    float dy = y[i] - CoM[1];
-    float dz = z[i] - CoM[2];
-
-    /* Apply periodic BC */
-    if (periodic) {
-      dx = nearestf(dx, dim[0]);
-      dy = nearestf(dy, dim[1]);
-      dz = nearestf(dz, dim[2]);
-    }
-    const float r2 = dx * dx + dy * dy + dz * dz;
-
-    /* Check whether we can use the multipole instead of P-P */
-    use_mpole[i] = allow_mpole && gravity_M2P_accept(grav_props, &gparts[i],
-                                                     multipole, r2, periodic);
   }
 
-#ifdef SWIFT_DEBUG_CHECKS
-  if (gcount_padded < gcount) error("Padded counter smaller than counter");
-#endif
-
   /* Particles used for padding should get impossible positions
    * that have a reasonable magnitude. We use the cell width for this */
   const float pos_padded[3] = {-2.f * (float)cell->width[0],
@@ -288,93 +330,112 @@ INLINE static void gravity_cache_populate(
     epsilon[i] = eps_padded;
     m[i] = 0.f;
     active[i] = 0;
-    use_mpole[i] = 0;
   }
 
-  /* Zero the output as well */
-  gravity_cache_zero_output(c, gcount_padded);
+  /* Remember what we just read */
+  c->filled_gparts = gparts;
+  c->filled_gcount = gcount;
+  c->filled_ti_drift = cell->grav.ti_old_part;
+  c->filled_max_active_bin = max_active_bin;
+  c->filled_shift[0] = shift[0];
+  c->filled_shift[1] = shift[1];
+  c->filled_shift[2] = shift[2];
 }
 
 /**
  * @brief Fills a #gravity_cache structure with some #gpart and shift them.
  *
+ * Also checks whether the #gpart can use a M2P interaction instead of the
+ * more expensive P2P.
+ *
  * @param max_active_bin The largest active bin in the current time-step.
+ * @param allow_mpole Are we allowing the use of multipoles?
+ * @param periodic Are we using periodic BCs ?
+ * @param dim The size of the simulation volume along each dimension.
  * @param c The #gravity_cache to fill.
  * @param gparts The #gpart array to read from.
  * @param gcount The number of particles to read.
  * @param gcount_padded The number of particle to read padded to the next
  * multiple of the vector length.
  * @param shift A shift to apply to all the particles.
+ * @param CoM The position of the multipole.
+ * @param multipole The mulipole to check for.
  * @param cell The cell we play with (to get reasonable padding positions).
  * @param grav_props The global gravity properties.
  */
-INLINE static void gravity_cache_populate_no_mpole(
-    const timebin_t max_active_bin, struct gravity_cache *c,
+INLINE static void gravity_cache_populate(
+    const timebin_t max_active_bin, const int allow_mpole, const int periodic,
+    const float dim[3], struct gravity_cache *c,
     const struct gpart *restrict gparts, const int gcount,
-    const int gcount_padded, const double shift[3], const struct cell *cell,
+    const int gcount_padded, const double shift[3], const float CoM[3],
+    const struct gravity_tensors *multipole, const struct cell *cell,
     const struct gravity_props *grav_props) {
 
-#ifdef SWIFT_DEBUG_CHECKS
-  if (gcount_padded < gcount) error("Invalid padded cache size. Too small.");
-  if (gcount_padded % VEC_SIZE != 0)
-    error("Padded gravity cache size invalid. Not a multiple of SIMD length.");
-#endif
-
-  /* Do we need to grow the cache? */
-  if (c->count < gcount_padded) gravity_cache_init(c, gcount_padded + VEC_SIZE);
+  /* Start with the fields that only depend on the particles themselves */
+  gravity_cache_populate_input(max_active_bin, c, gparts, gcount,
+                               gcount_padded, shift, cell, grav_props);
 
   /* Make the compiler understand we are in happy vectorization land */
   swift_declare_aligned_ptr(float, x, c->x, SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, y, c->y, SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, z, c->z, SWIFT_CACHE_ALIGNMENT);
-  swift_declare_aligned_ptr(float, epsilon, c->epsilon, SWIFT_CACHE_ALIGNMENT);
-  swift_declare_aligned_ptr(float, m, c->m, SWIFT_CACHE_ALIGNMENT);
-  swift_declare_aligned_ptr(int, active, c->active, SWIFT_CACHE_ALIGNMENT);
+  swift_declare_aligned_ptr(int, use_mpole, c->use_mpole,
+                            SWIFT_CACHE_ALIGNMENT);
   swift_assume_size(gcount_padded, VEC_SIZE);
 
-  /* Fill the input caches */
+  /* Now check which particles can use the multipole of the other cell */
+#if !defined(SWIFT_DEBUG_CHECKS) && _OPENMP >= 201307
+#pragma omp simd
+#endif
   for (int i = 0; i < gcount; ++i) {
-    x[i] = (float)(gparts[i].x[0] - shift[0]);
-    y[i] = (float)(gparts[i].x[1] - shift[1]);
-    z[i] = (float)(gparts[i].x[2] - shift[2]);
-    epsilon[i] = gravity_get_softening(&gparts[i], grav_props);
 
-#ifdef SWIFT_DEBUG_CHECKS
-    if (gparts[i].time_bin == time_bin_not_created) {
-      error("Found an extra gpart in the gravity cache");
-    }
-#endif
+    /* Distance to the CoM of the other cell. */
+    float dx = x[i] - CoM[0];
+    float dy = y[i] - CoM[1];
+    float dz = z[i] - CoM[2];
 
-    /* Make a dummy particle out of the inhibted ones */
-    if (gparts[i].time_bin == time_bin_inhibited) {
-      m[i] = 0.f;
-      active[i] = 0;
-    } else {
-      m[i] = gparts[i].mass;
-      active[i] = (int)(gparts[i].time_bin <= max_active_bin);
+    /* Apply periodic BC */
+    if (periodic) {
+      dx = nearestf(dx, dim[0]);
+      dy = nearestf(dy, dim[1]);
+      dz = nearestf(dz, dim[2]);
     }
+    const float r2 = dx * dx + dy * dy + dz * dz;
+
+    /* Check whether we can use the multipole instead of P-P */
+    use_mpole[i] = allow_mpole && gravity_M2P_accept(grav_props, &gparts[i],
+                                                     multipole, r2, periodic);
   }
 
-#ifdef SWIFT_DEBUG_CHECKS
-  if (gcount_padded < gcount) error("Padded counter smaller than counter");
-#endif
+  /* Pad the caches */
+  for (int i = gcount; i < gcount_padded; ++i) use_mpole[i] = 0;
 
-  /* Particles used for padding should get impossible positions
-   * that have a reasonable magnitude. We use the cell width for this */
-  const float pos_padded[3] = {-2.f * (float)cell->width[0],
-                               -2.f * (float)cell->width[1],
-                               -2.f * (float)cell->width[2]};
-  const float eps_padded = epsilon[0];
+  /* Zero the output as well */
+  gravity_cache_zero_output(c, gcount_padded);
+}
 
-  /* Pad the caches */
-  for (int i = gcount; i < gcount_padded; ++i) {
-    x[i] = pos_padded[0];
-    y[i] = pos_padded[1];
-    z[i] = pos_padded[2];
-    epsilon[i] = eps_padded;
-    m[i] = 0.f;
-    active[i] = 0;
-  }
+/**
+ * @brief Fills a #gravity_cache structure with some #gpart and shift them.
+ *
+ * @param max_active_bin The largest active bin in the current time-step.
+ * @param c The #gravity_cache to fill.
+ * @param gparts The #gpart array to read from.
+ * @param gcount The number of particles to read.
+ * @param gcount_padded The number of particle to read padded to the next
+ * multiple of the vector length.
+ * @param shift A shift to apply to all the particles.
+ * @param cell The cell we play with (to get reasonable padding positions).
+ * @param grav_props The global gravity properties.
+ */
+INLINE static void gravity_cache_populate_no_mpole(
+    const timebin_t max_active_bin, struct gravity_cache *c,
+    const struct gpart *restrict gparts, const int gcount,
+    const int gcount_padded, const double shift[3], const struct cell *cell,
+    const struct gravity_props *grav_props) {
+
+  /* Fill the input caches */
+  gravity_cache_populate_input(max_active_bin, c, gparts, gcount,
+                               gcount_padded, shift, cell, grav_props);
 
   /* Zero the output as well */
   gravity_cache_zero_output(c, gcount_padded);
@@ -413,6 +474,9 @@ INLINE static void gravity_cache_populate_all_mpole(
   /* Do we need to grow the cache? */
   if (c->count < gcount_padded) gravity_cache_init(c, gcount_padded + VEC_SIZE);
 
+  /* We are about to over-write the input fields */
+  gravity_cache_invalidate(c);
+
   /* Make the compiler understand we are in happy vectorization land */
   swift_declare_aligned_ptr(float, x, c->x, SWIFT_CACHE_ALIGNMENT);
   swift_declare_aligned_ptr(float, y, c->y, SWIFT_CACHE_ALIGNMENT);
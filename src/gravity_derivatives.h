@@ -200,25 +200,13 @@ potential_derivatives_flip_signs(struct potential_derivatives_M2L *pot) {
 }
 
 /**
- * @brief Compute all the relevent derivatives of the softened and truncated
- * gravitational potential for the M2L kernel.
+ * @brief Structure containing the radial part of the derivatives of the
+ * potential required for the M2L kernel.
  *
- * @param r_x x-component of distance vector
- * @param r_y y-component of distance vector
- * @param r_z z-component of distance vector
- * @param r2 Square norm of distance vector
- * @param r_inv Inverse norm of distance vector
- * @param eps Softening length.
- * @param periodic Is the calculation periodic ?
- * @param r_s_inv Inverse of the long-range gravity mesh smoothing length.
- * @param pot (return) The structure containing all the derivatives.
+ * Dt_n is the term multiplying the powers of r_i / r in the derivatives of
+ * order n - 1.
  */
-__attribute__((always_inline, nonnull)) INLINE static void
-potential_derivatives_compute_M2L(const float r_x, const float r_y,
-                                  const float r_z, const float r2,
-                                  const float r_inv, const float eps,
-                                  const int periodic, const float r_s_inv,
-                                  struct potential_derivatives_M2L *pot) {
+struct potential_derivatives_M2L_radial {
 
   float Dt_1;
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 0
@@ -236,129 +224,195 @@ potential_derivatives_compute_M2L(const float r_x, const float r_y,
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 4
   float Dt_6;
 #endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 5
+#error "Missing implementation for order >5"
+#endif
+};
 
-  /* Softened case */
-  if (r2 < eps * eps) {
+/**
+ * @brief Compute the radial part of the derivatives of the softened
+ * gravitational potential for the M2L kernel.
+ *
+ * @param r Norm of distance vector
+ * @param eps Softening length.
+ * @param Dt (return) The radial terms.
+ */
+__attribute__((always_inline, nonnull)) INLINE static void
+potential_derivatives_M2L_radial_softened(
+    const float r, const float eps,
+    struct potential_derivatives_M2L_radial *Dt) {
 
-    const float eps_inv = 1.f / eps;
-    const float r = r2 * r_inv;
-    const float u = r * eps_inv;
+  const float eps_inv = 1.f / eps;
+  const float u = r * eps_inv;
 
-    Dt_1 = eps_inv * D_soft_1(u);
+  Dt->Dt_1 = eps_inv * D_soft_1(u);
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 0
-    const float eps_inv2 = eps_inv * eps_inv;
-    Dt_2 = eps_inv2 * D_soft_2(u);
+  const float eps_inv2 = eps_inv * eps_inv;
+  Dt->Dt_2 = eps_inv2 * D_soft_2(u);
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 1
-    const float eps_inv3 = eps_inv2 * eps_inv;
-    Dt_3 = eps_inv3 * D_soft_3(u);
+  const float eps_inv3 = eps_inv2 * eps_inv;
+  Dt->Dt_3 = eps_inv3 * D_soft_3(u);
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 2
-    const float eps_inv4 = eps_inv3 * eps_inv;
-    Dt_4 = eps_inv4 * D_soft_4(u);
+  const float eps_inv4 = eps_inv3 * eps_inv;
+  Dt->Dt_4 = eps_inv4 * D_soft_4(u);
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 3
-    const float eps_inv5 = eps_inv4 * eps_inv;
-    Dt_5 = eps_inv5 * D_soft_5(u);
+  const float eps_inv5 = eps_inv4 * eps_inv;
+  Dt->Dt_5 = eps_inv5 * D_soft_5(u);
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 4
-    const float eps_inv6 = eps_inv5 * eps_inv;
-    Dt_6 = eps_inv6 * D_soft_6(u);
+  const float eps_inv6 = eps_inv5 * eps_inv;
+  Dt->Dt_6 = eps_inv6 * D_soft_6(u);
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 5
 #error "Missing implementation for order >5"
 #endif
+}
 
-    /* Un-truncated un-softened case (Newtonian potential) */
-  } else if (!periodic) {
+/**
+ * @brief Compute the radial part of the derivatives of the un-truncated
+ * un-softened (Newtonian) gravitational potential for the M2L kernel.
+ *
+ * @param r_inv Inverse norm of distance vector
+ * @param Dt (return) The radial terms.
+ */
+__attribute__((always_inline, nonnull)) INLINE static void
+potential_derivatives_M2L_radial_newtonian(
+    const float r_inv, struct potential_derivatives_M2L_radial *Dt) {
 
-    Dt_1 = r_inv; /* 1 / r */
-#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
-    Dt_2 = -1.f * Dt_1 * r_inv; /* -1 / r^2 */
+  Dt->Dt_1 = r_inv; /* 1 / r */
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+  Dt->Dt_2 = -1.f * Dt->Dt_1 * r_inv; /* -1 / r^2 */
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 1
-    Dt_3 = -3.f * Dt_2 * r_inv; /* 3 / r^3 */
+  Dt->Dt_3 = -3.f * Dt->Dt_2 * r_inv; /* 3 / r^3 */
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 2
-    Dt_4 = -5.f * Dt_3 * r_inv; /* -15 / r^4 */
+  Dt->Dt_4 = -5.f * Dt->Dt_3 * r_inv; /* -15 / r^4 */
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 3
-    Dt_5 = -7.f * Dt_4 * r_inv; /* 105 / r^5 */
+  Dt->Dt_5 = -7.f * Dt->Dt_4 * r_inv; /* 105 / r^5 */
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 4
-    Dt_6 = -9.f * Dt_5 * r_inv; /* -945 / r^6 */
+  Dt->Dt_6 = -9.f * Dt->Dt_5 * r_inv; /* -945 / r^6 */
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 5
 #error "Missing implementation for order >5"
 #endif
+}
 
-    /* Truncated case (long-range) */
-  } else {
+/**
+ * @brief Compute the radial part of the derivatives of the truncated
+ * (long-range) gravitational potential for the M2L kernel.
+ *
+ * @param r Norm of distance vector
+ * @param r_inv Inverse norm of distance vector
+ * @param r_s_inv Inverse of the long-range gravity mesh smoothing length.
+ * @param Dt (return) The radial terms.
+ */
+__attribute__((always_inline, nonnull)) INLINE static void
+potential_derivatives_M2L_radial_truncated(
+    const float r, const float r_inv, const float r_s_inv,
+    struct potential_derivatives_M2L_radial *Dt) {
 
-    /* Get the derivatives of the truncated potential */
-    const float r = r2 * r_inv;
-    struct chi_derivatives derivs;
-    kernel_long_grav_derivatives(r, r_s_inv, &derivs);
+  /* Get the derivatives of the truncated potential */
+  struct chi_derivatives derivs;
+  kernel_long_grav_derivatives(r, r_s_inv, &derivs);
 
-    Dt_1 = derivs.chi_0 * r_inv;
+  Dt->Dt_1 = derivs.chi_0 * r_inv;
 
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 0
 
-    /* -chi^0 r_i^2 + chi^1 r_i^1 */
-    Dt_2 = derivs.chi_1 - derivs.chi_0 * r_inv;
-    Dt_2 = Dt_2 * r_inv;
+  /* -chi^0 r_i^2 + chi^1 r_i^1 */
+  float Dt_2 = derivs.chi_1 - derivs.chi_0 * r_inv;
+  Dt->Dt_2 = Dt_2 * r_inv;
 
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 1
 
-    /* 3chi^0 r_i^3 - 3 chi^1 r_i^2 + chi^2 r_i^1 */
-    Dt_3 = derivs.chi_0 * r_inv - derivs.chi_1;
-    Dt_3 = Dt_3 * 3.f;
-    Dt_3 = Dt_3 * r_inv + derivs.chi_2;
-    Dt_3 = Dt_3 * r_inv;
+  /* 3chi^0 r_i^3 - 3 chi^1 r_i^2 + chi^2 r_i^1 */
+  float Dt_3 = derivs.chi_0 * r_inv - derivs.chi_1;
+  Dt_3 = Dt_3 * 3.f;
+  Dt_3 = Dt_3 * r_inv + derivs.chi_2;
+  Dt->Dt_3 = Dt_3 * r_inv;
 
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 2
 
-    /* -15chi^0 r_i^4 + 15 chi^1 r_i^3 - 6 chi^2 r_i^2  + chi^3 r_i^1 */
-    Dt_4 = -derivs.chi_0 * r_inv + derivs.chi_1;
-    Dt_4 = Dt_4 * 15.f;
-    Dt_4 = Dt_4 * r_inv - 6.f * derivs.chi_2;
-    Dt_4 = Dt_4 * r_inv + derivs.chi_3;
-    Dt_4 = Dt_4 * r_inv;
+  /* -15chi^0 r_i^4 + 15 chi^1 r_i^3 - 6 chi^2 r_i^2  + chi^3 r_i^1 */
+  float Dt_4 = -derivs.chi_0 * r_inv + derivs.chi_1;
+  Dt_4 = Dt_4 * 15.f;
+  Dt_4 = Dt_4 * r_inv - 6.f * derivs.chi_2;
+  Dt_4 = Dt_4 * r_inv + derivs.chi_3;
+  Dt->Dt_4 = Dt_4 * r_inv;
 
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 3
 
-    /* 105chi^0 r_i^5 - 105 chi^1 r_i^4 + 45 chi^2 r_i^3 - 10 chi^3 r_i^2 +
-     * chi^4 r_i^1 */
-    Dt_5 = derivs.chi_0 * r_inv - derivs.chi_1;
-    Dt_5 = Dt_5 * 105.f;
-    Dt_5 = Dt_5 * r_inv + 45.f * derivs.chi_2;
-    Dt_5 = Dt_5 * r_inv - 10.f * derivs.chi_3;
-    Dt_5 = Dt_5 * r_inv + derivs.chi_4;
-    Dt_5 = Dt_5 * r_inv;
+  /* 105chi^0 r_i^5 - 105 chi^1 r_i^4 + 45 chi^2 r_i^3 - 10 chi^3 r_i^2 +
+   * chi^4 r_i^1 */
+  float Dt_5 = derivs.chi_0 * r_inv - derivs.chi_1;
+  Dt_5 = Dt_5 * 105.f;
+  Dt_5 = Dt_5 * r_inv + 45.f * derivs.chi_2;
+  Dt_5 = Dt_5 * r_inv - 10.f * derivs.chi_3;
+  Dt_5 = Dt_5 * r_inv + derivs.chi_4;
+  Dt->Dt_5 = Dt_5 * r_inv;
 
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 4
 
-    /* -945chi^0 r_i^6 + 945 chi^1 r_i^5 - 420 chi^2 r_i^4 + 105 chi^3 r_i^3 -
-     * 15 chi^4 r_i^2 + chi^5 r_i^1 */
-    Dt_6 = -derivs.chi_0 * r_inv + derivs.chi_1;
-    Dt_6 = Dt_6 * 945.f;
-    Dt_6 = Dt_6 * r_inv - 420.f * derivs.chi_2;
-    Dt_6 = Dt_6 * r_inv + 105.f * derivs.chi_3;
-    Dt_6 = Dt_6 * r_inv - 15.f * derivs.chi_4;
-    Dt_6 = Dt_6 * r_inv + derivs.chi_5;
-    Dt_6 = Dt_6 * r_inv;
+  /* -945chi^0 r_i^6 + 945 chi^1 r_i^5 - 420 chi^2 r_i^4 + 105 chi^3 r_i^3 -
+   * 15 chi^4 r_i^2 + chi^5 r_i^1 */
+  float Dt_6 = -derivs.chi_0 * r_inv + derivs.chi_1;
+  Dt_6 = Dt_6 * 945.f;
+  Dt_6 = Dt_6 * r_inv - 420.f * derivs.chi_2;
+  Dt_6 = Dt_6 * r_inv + 105.f * derivs.chi_3;
+  Dt_6 = Dt_6 * r_inv - 15.f * derivs.chi_4;
+  Dt_6 = Dt_6 * r_inv + derivs.chi_5;
+  Dt->Dt_6 = Dt_6 * r_inv;
 
 #endif
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 5
 #error "Missing implementation for order >5"
 #endif
-  }
+}
 
-  /* Alright, let's get the full terms */
+/**
+ * @brief Combine the radial part of the derivatives with the direction of the
+ * distance vector to get all the derivatives of the potential for the M2L
+ * kernel.
+ *
+ * @param r_x x-component of distance vector
+ * @param r_y y-component of distance vector
+ * @param r_z z-component of distance vector
+ * @param r_inv Inverse norm of distance vector
+ * @param Dt The radial terms.
+ * @param pot (return) The structure containing all the derivatives.
+ */
+__attribute__((always_inline, nonnull)) INLINE static void
+potential_derivatives_M2L_tensors(
+    const float r_x, const float r_y, const float r_z, const float r_inv,
+    const struct potential_derivatives_M2L_radial *Dt,
+    struct potential_derivatives_M2L *pot) {
+
+  const float Dt_1 = Dt->Dt_1;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+  float Dt_2 = Dt->Dt_2;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+  float Dt_3 = Dt->Dt_3;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+  float Dt_4 = Dt->Dt_4;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+  float Dt_5 = Dt->Dt_5;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+  const float Dt_6 = Dt->Dt_6;
+#endif
 
   /* Compute some powers of (r_x / r), (r_y / r) and (r_z / r) */
 #if SELF_GRAVITY_MULTIPOLE_ORDER > 0
@@ -390,7 +444,7 @@ potential_derivatives_compute_M2L(const float r_x, const float r_y,
   /* Get the 0th order term */
   pot->D_000 = Dt_1;
 
-#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
   /* 1st order derivatives */
   pot->D_100 = rx_r * Dt_2;
   pot->D_010 = ry_r * Dt_2;
@@ -495,6 +549,47 @@ potential_derivatives_compute_M2L(const float r_x, const float r_y,
 #endif
 }
 
+/**
+ * @brief Compute all the relevent derivatives of the softened and truncated
+ * gravitational potential for the M2L kernel.
+ *
+ * @param r_x x-component of distance vector
+ * @param r_y y-component of distance vector
+ * @param r_z z-component of distance vector
+ * @param r2 Square norm of distance vector
+ * @param r_inv Inverse norm of distance vector
+ * @param eps Softening length.
+ * @param periodic Is the calculation periodic ?
+ * @param r_s_inv Inverse of the long-range gravity mesh smoothing length.
+ * @param pot (return) The structure containing all the derivatives.
+ */
+__attribute__((always_inline, nonnull)) INLINE static void
+potential_derivatives_compute_M2L(const float r_x, const float r_y,
+                                  const float r_z, const float r2,
+                                  const float r_inv, const float eps,
+                                  const int periodic, const float r_s_inv,
+                                  struct potential_derivatives_M2L *pot) {
+
+  struct potential_derivatives_M2L_radial Dt;
+
+  /* Softened case */
+  if (r2 < eps * eps) {
+    potential_derivatives_M2L_radial_softened(r2 * r_inv, eps, &Dt);
+
+    /* Un-truncated un-softened case (Newtonian potential) */
+  } else if (!periodic) {
+    potential_derivatives_M2L_radial_newtonian(r_inv, &Dt);
+
+    /* Truncated case (long-range) */
+  } else {
+    potential_derivatives_M2L_radial_truncated(r2 * r_inv, r_inv, r_s_inv,
+                                               &Dt);
+  }
+
+  /* Alright, let's get the full terms */
+  potential_derivatives_M2L_tensors(r_x, r_y, r_z, r_inv, &Dt, pot);
+}
+
 /**
  * @brief Compute all the relevent derivatives of the softened and truncated
  * gravitational potential for the M2P kernel.
@@ -0,0 +1,1185 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2016 Matthieu Schaller (schaller@strw.leidenuniv.nl)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_GRAVITY_M2L_CACHE_H
+#define SWIFT_GRAVITY_M2L_CACHE_H
+
+/* Config parameters. */
+#include <config.h>
+
+/* Local headers */
+#include "accumulate.h"
+#include "align.h"
+#include "error.h"
+#include "gravity_derivatives.h"
+#include "inline.h"
+#include "memuse.h"
+#include "minmax.h"
+#include "multipole.h"
+#include "periodic.h"
+#include "vector.h"
+
+/**
+ * @brief A SoA list of the multipoles interacting with a single field tensor.
+ *
+ * This is used to vectorize the M2L interactions by applying all the
+ * multipoles that act on one cell in a single call rather than one cell
+ * pair at a time. Besides the multipole terms, the list holds the
+ * separation vectors and softening lengths of the interactions as well as
+ * some scratch space for the derivatives of the potential.
+ *
+ * Note that the first order multipole terms are not stored as they are
+ * always 0 (we expand around the centre of mass).
+ */
+struct gravity_m2l_cache {
+
+  /*! x component of the distance between the field tensor and multipole. */
+  float *restrict dx;
+
+  /*! y component of the distance between the field tensor and multipole. */
+  float *restrict dy;
+
+  /*! z component of the distance between the field tensor and multipole. */
+  float *restrict dz;
+
+  /*! Softening length of the interactions. */
+  float *restrict eps;
+
+  /*! 0th order multipole and derivative terms */
+  float *restrict M_000;
+  float *restrict D_000;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+
+  /*! 1st order multipole and derivative terms */
+  float *restrict D_001;
+  float *restrict D_010;
+  float *restrict D_100;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+
+  /*! 2nd order multipole and derivative terms */
+  float *restrict M_002;
+  float *restrict M_011;
+  float *restrict M_020;
+  float *restrict M_101;
+  float *restrict M_110;
+  float *restrict M_200;
+  float *restrict D_002;
+  float *restrict D_011;
+  float *restrict D_020;
+  float *restrict D_101;
+  float *restrict D_110;
+  float *restrict D_200;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+
+  /*! 3rd order multipole and derivative terms */
+  float *restrict M_003;
+  float *restrict M_012;
+  float *restrict M_021;
+  float *restrict M_030;
+  float *restrict M_102;
+  float *restrict M_111;
+  float *restrict M_120;
+  float *restrict M_201;
+  float *restrict M_210;
+  float *restrict M_300;
+  float *restrict D_003;
+  float *restrict D_012;
+  float *restrict D_021;
+  float *restrict D_030;
+  float *restrict D_102;
+  float *restrict D_111;
+  float *restrict D_120;
+  float *restrict D_201;
+  float *restrict D_210;
+  float *restrict D_300;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+
+  /*! 4th order multipole and derivative terms */
+  float *restrict M_004;
+  float *restrict M_013;
+  float *restrict M_022;
+  float *restrict M_031;
+  float *restrict M_040;
+  float *restrict M_103;
+  float *restrict M_112;
+  float *restrict M_121;
+  float *restrict M_130;
+  float *restrict M_202;
+  float *restrict M_211;
+  float *restrict M_220;
+  float *restrict M_301;
+  float *restrict M_310;
+  float *restrict M_400;
+  float *restrict D_004;
+  float *restrict D_013;
+  float *restrict D_022;
+  float *restrict D_031;
+  float *restrict D_040;
+  float *restrict D_103;
+  float *restrict D_112;
+  float *restrict D_121;
+  float *restrict D_130;
+  float *restrict D_202;
+  float *restrict D_211;
+  float *restrict D_220;
+  float *restrict D_301;
+  float *restrict D_310;
+  float *restrict D_400;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+
+  /*! 5th order multipole and derivative terms */
+  float *restrict M_005;
+  float *restrict M_014;
+  float *restrict M_023;
+  float *restrict M_032;
+  float *restrict M_041;
+  float *restrict M_050;
+  float *restrict M_104;
+  float *restrict M_113;
+  float *restrict M_122;
+  float *restrict M_131;
+  float *restrict M_140;
+  float *restrict M_203;
+  float *restrict M_212;
+  float *restrict M_221;
+  float *restrict M_230;
+  float *restrict M_302;
+  float *restrict M_311;
+  float *restrict M_320;
+  float *restrict M_401;
+  float *restrict M_410;
+  float *restrict M_500;
+  float *restrict D_005;
+  float *restrict D_014;
+  float *restrict D_023;
+  float *restrict D_032;
+  float *restrict D_041;
+  float *restrict D_050;
+  float *restrict D_104;
+  float *restrict D_113;
+  float *restrict D_122;
+  float *restrict D_131;
+  float *restrict D_140;
+  float *restrict D_203;
+  float *restrict D_212;
+  float *restrict D_221;
+  float *restrict D_230;
+  float *restrict D_302;
+  float *restrict D_311;
+  float *restrict D_320;
+  float *restrict D_401;
+  float *restrict D_410;
+  float *restrict D_500;
+#endif
+
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+  /*! Total number of #gpart in the multipoles of the list. */
+  long long num_gpart;
+#endif
+
+  /*! Number of multipoles currently in the list. */
+  int nr_mpoles;
+
+  /*! Cache size */
+  int count;
+
+  /*! The memory block all the arrays point into. */
+  float *data;
+};
+
+/**
+ * @brief Frees the memory allocated in a #gravity_m2l_cache
+ *
+ * @param c The #gravity_m2l_cache to free.
+ */
+static INLINE void gravity_m2l_cache_clean(struct gravity_m2l_cache *c) {
+
+  if (c->count > 0) swift_free("gravity_m2l_cache", c->data);
+  c->data = NULL;
+  c->count = 0;
+  c->nr_mpoles = 0;
+}
+
+/**
+ * @brief Allocates memory for the multipole lists used in the batched M2L
+ * interactions.
+ *
+ * The cache is padded for the vector size and all its arrays are aligned
+ * properly.
+ *
+ * @param c The #gravity_m2l_cache to allocate.
+ * @param count The number of multipoles to allocate for.
+ */
+static INLINE void gravity_m2l_cache_init(struct gravity_m2l_cache *c,
+                                          const int count) {
+
+  /* Number of terms in the multipoles and derivatives */
+  const int p = SELF_GRAVITY_MULTIPOLE_ORDER;
+  const int num_terms = (p + 1) * (p + 2) * (p + 3) / 6;
+  const int num_arrays = 4 + 2 * num_terms - (p > 0 ? 3 : 0);
+
+  /* Size of the cache (keeping every array aligned) */
+  const int align = max(VEC_SIZE, SWIFT_CACHE_ALIGNMENT / (int)sizeof(float));
+  const int padded_count = count - (count % align) + align;
+  const size_t sizeBytes = (size_t)num_arrays * padded_count * sizeof(float);
+
+  /* Delete old stuff if any */
+  gravity_m2l_cache_clean(c);
+
+  if (swift_memalign("gravity_m2l_cache", (void **)&c->data,
+                     SWIFT_CACHE_ALIGNMENT, sizeBytes) != 0)
+    error("Couldn't allocate gravity M2L cache, size: %d", padded_count);
+
+  /* Point the arrays to their section of the memory block */
+  float *data = c->data;
+  int n = 0;
+  c->dx = data + (n++) * padded_count;
+  c->dy = data + (n++) * padded_count;
+  c->dz = data + (n++) * padded_count;
+  c->eps = data + (n++) * padded_count;
+
+  c->M_000 = data + (n++) * padded_count;
+  c->D_000 = data + (n++) * padded_count;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+  c->D_001 = data + (n++) * padded_count;
+  c->D_010 = data + (n++) * padded_count;
+  c->D_100 = data + (n++) * padded_count;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+  c->M_002 = data + (n++) * padded_count;
+  c->M_011 = data + (n++) * padded_count;
+  c->M_020 = data + (n++) * padded_count;
+  c->M_101 = data + (n++) * padded_count;
+  c->M_110 = data + (n++) * padded_count;
+  c->M_200 = data + (n++) * padded_count;
+  c->D_002 = data + (n++) * padded_count;
+  c->D_011 = data + (n++) * padded_count;
+  c->D_020 = data + (n++) * padded_count;
+  c->D_101 = data + (n++) * padded_count;
+  c->D_110 = data + (n++) * padded_count;
+  c->D_200 = data + (n++) * padded_count;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+  c->M_003 = data + (n++) * padded_count;
+  c->M_012 = data + (n++) * padded_count;
+  c->M_021 = data + (n++) * padded_count;
+  c->M_030 = data + (n++) * padded_count;
+  c->M_102 = data + (n++) * padded_count;
+  c->M_111 = data + (n++) * padded_count;
+  c->M_120 = data + (n++) * padded_count;
+  c->M_201 = data + (n++) * padded_count;
+  c->M_210 = data + (n++) * padded_count;
+  c->M_300 = data + (n++) * padded_count;
+  c->D_003 = data + (n++) * padded_count;
+  c->D_012 = data + (n++) * padded_count;
+  c->D_021 = data + (n++) * padded_count;
+  c->D_030 = data + (n++) * padded_count;
+  c->D_102 = data + (n++) * padded_count;
+  c->D_111 = data + (n++) * padded_count;
+  c->D_120 = data + (n++) * padded_count;
+  c->D_201 = data + (n++) * padded_count;
+  c->D_210 = data + (n++) * padded_count;
+  c->D_300 = data + (n++) * padded_count;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+  c->M_004 = data + (n++) * padded_count;
+  c->M_013 = data + (n++) * padded_count;
+  c->M_022 = data + (n++) * padded_count;
+  c->M_031 = data + (n++) * padded_count;
+  c->M_040 = data + (n++) * padded_count;
+  c->M_103 = data + (n++) * padded_count;
+  c->M_112 = data + (n++) * padded_count;
+  c->M_121 = data + (n++) * padded_count;
+  c->M_130 = data + (n++) * padded_count;
+  c->M_202 = data + (n++) * padded_count;
+  c->M_211 = data + (n++) * padded_count;
+  c->M_220 = data + (n++) * padded_count;
+  c->M_301 = data + (n++) * padded_count;
+  c->M_310 = data + (n++) * padded_count;
+  c->M_400 = data + (n++) * padded_count;
+  c->D_004 = data + (n++) * padded_count;
+  c->D_013 = data + (n++) * padded_count;
+  c->D_022 = data + (n++) * padded_count;
+  c->D_031 = data + (n++) * padded_count;
+  c->D_040 = data + (n++) * padded_count;
+  c->D_103 = data + (n++) * padded_count;
+  c->D_112 = data + (n++) * padded_count;
+  c->D_121 = data + (n++) * padded_count;
+  c->D_130 = data + (n++) * padded_count;
+  c->D_202 = data + (n++) * padded_count;
+  c->D_211 = data + (n++) * padded_count;
+  c->D_220 = data + (n++) * padded_count;
+  c->D_301 = data + (n++) * padded_count;
+  c->D_310 = data + (n++) * padded_count;
+  c->D_400 = data + (n++) * padded_count;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+  c->M_005 = data + (n++) * padded_count;
+  c->M_014 = data + (n++) * padded_count;
+  c->M_023 = data + (n++) * padded_count;
+  c->M_032 = data + (n++) * padded_count;
+  c->M_041 = data + (n++) * padded_count;
+  c->M_050 = data + (n++) * padded_count;
+  c->M_104 = data + (n++) * padded_count;
+  c->M_113 = data + (n++) * padded_count;
+  c->M_122 = data + (n++) * padded_count;
+  c->M_131 = data + (n++) * padded_count;
+  c->M_140 = data + (n++) * padded_count;
+  c->M_203 = data + (n++) * padded_count;
+  c->M_212 = data + (n++) * padded_count;
+  c->M_221 = data + (n++) * padded_count;
+  c->M_230 = data + (n++) * padded_count;
+  c->M_302 = data + (n++) * padded_count;
+  c->M_311 = data + (n++) * padded_count;
+  c->M_320 = data + (n++) * padded_count;
+  c->M_401 = data + (n++) * padded_count;
+  c->M_410 = data + (n++) * padded_count;
+  c->M_500 = data + (n++) * padded_count;
+  c->D_005 = data + (n++) * padded_count;
+  c->D_014 = data + (n++) * padded_count;
+  c->D_023 = data + (n++) * padded_count;
+  c->D_032 = data + (n++) * padded_count;
+  c->D_041 = data + (n++) * padded_count;
+  c->D_050 = data + (n++) * padded_count;
+  c->D_104 = data + (n++) * padded_count;
+  c->D_113 = data + (n++) * padded_count;
+  c->D_122 = data + (n++) * padded_count;
+  c->D_131 = data + (n++) * padded_count;
+  c->D_140 = data + (n++) * padded_count;
+  c->D_203 = data + (n++) * padded_count;
+  c->D_212 = data + (n++) * padded_count;
+  c->D_221 = data + (n++) * padded_count;
+  c->D_230 = data + (n++) * padded_count;
+  c->D_302 = data + (n++) * padded_count;
+  c->D_311 = data + (n++) * padded_count;
+  c->D_320 = data + (n++) * padded_count;
+  c->D_401 = data + (n++) * padded_count;
+  c->D_410 = data + (n++) * padded_count;
+  c->D_500 = data + (n++) * padded_count;
+#endif
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (n != num_arrays) error("Invalid number of arrays in the M2L cache!");
+#endif
+
+  c->count = padded_count;
+  c->nr_mpoles = 0;
+}
+
+/**
+ * @brief Is there no more space left in a #gravity_m2l_cache?
+ *
+ * @param c The #gravity_m2l_cache.
+ */
+static INLINE int gravity_m2l_cache_is_full(const struct gravity_m2l_cache *c) {
+
+  return c->nr_mpoles == c->count;
+}
+
+/**
+ * @brief Empties a #gravity_m2l_cache before collecting a new list.
+ *
+ * @param c The #gravity_m2l_cache.
+ */
+static INLINE void gravity_m2l_cache_reset(struct gravity_m2l_cache *c) {
+
+  c->nr_mpoles = 0;
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+  c->num_gpart = 0;
+#endif
+}
+
+/**
+ * @brief Adds a multipole to the list of interactions of a field tensor.
+ *
+ * The distance vector and softening are computed exactly as in
+ * gravity_M2L_nonsym().
+ *
+ * @param c The #gravity_m2l_cache to add to.
+ * @param m_a The multipole creating the field.
+ * @param pos_a The position of the multipole.
+ * @param pos_b The position of the field tensor.
+ * @param periodic Is the calculation periodic ?
+ * @param dim The size of the simulation box.
+ */
+__attribute__((nonnull)) INLINE static void gravity_m2l_cache_add(
+    struct gravity_m2l_cache *c, const struct multipole *m_a,
+    const double pos_a[3], const double pos_b[3], const int periodic,
+    const double dim[3]) {
+
+  const int n = c->nr_mpoles;
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (n >= c->count) error("M2L cache is too small!");
+#endif
+
+  /* Compute distance vector */
+  float dx = (float)(pos_b[0] - pos_a[0]);
+  float dy = (float)(pos_b[1] - pos_a[1]);
+  float dz = (float)(pos_b[2] - pos_a[2]);
+
+  /* Apply BC */
+  if (periodic) {
+    dx = nearest(dx, dim[0]);
+    dy = nearest(dy, dim[1]);
+    dz = nearest(dz, dim[2]);
+  }
+
+  c->dx[n] = dx;
+  c->dy[n] = dy;
+  c->dz[n] = dz;
+  c->eps[n] = m_a->max_softening;
+
+  c->M_000[n] = m_a->M_000;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+  c->M_002[n] = m_a->M_002;
+  c->M_011[n] = m_a->M_011;
+  c->M_020[n] = m_a->M_020;
+  c->M_101[n] = m_a->M_101;
+  c->M_110[n] = m_a->M_110;
+  c->M_200[n] = m_a->M_200;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+  c->M_003[n] = m_a->M_003;
+  c->M_012[n] = m_a->M_012;
+  c->M_021[n] = m_a->M_021;
+  c->M_030[n] = m_a->M_030;
+  c->M_102[n] = m_a->M_102;
+  c->M_111[n] = m_a->M_111;
+  c->M_120[n] = m_a->M_120;
+  c->M_201[n] = m_a->M_201;
+  c->M_210[n] = m_a->M_210;
+  c->M_300[n] = m_a->M_300;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+  c->M_004[n] = m_a->M_004;
+  c->M_013[n] = m_a->M_013;
+  c->M_022[n] = m_a->M_022;
+  c->M_031[n] = m_a->M_031;
+  c->M_040[n] = m_a->M_040;
+  c->M_103[n] = m_a->M_103;
+  c->M_112[n] = m_a->M_112;
+  c->M_121[n] = m_a->M_121;
+  c->M_130[n] = m_a->M_130;
+  c->M_202[n] = m_a->M_202;
+  c->M_211[n] = m_a->M_211;
+  c->M_220[n] = m_a->M_220;
+  c->M_301[n] = m_a->M_301;
+  c->M_310[n] = m_a->M_310;
+  c->M_400[n] = m_a->M_400;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+  c->M_005[n] = m_a->M_005;
+  c->M_014[n] = m_a->M_014;
+  c->M_023[n] = m_a->M_023;
+  c->M_032[n] = m_a->M_032;
+  c->M_041[n] = m_a->M_041;
+  c->M_050[n] = m_a->M_050;
+  c->M_104[n] = m_a->M_104;
+  c->M_113[n] = m_a->M_113;
+  c->M_122[n] = m_a->M_122;
+  c->M_131[n] = m_a->M_131;
+  c->M_140[n] = m_a->M_140;
+  c->M_203[n] = m_a->M_203;
+  c->M_212[n] = m_a->M_212;
+  c->M_221[n] = m_a->M_221;
+  c->M_230[n] = m_a->M_230;
+  c->M_302[n] = m_a->M_302;
+  c->M_311[n] = m_a->M_311;
+  c->M_320[n] = m_a->M_320;
+  c->M_401[n] = m_a->M_401;
+  c->M_410[n] = m_a->M_410;
+  c->M_500[n] = m_a->M_500;
+#endif
+
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+  c->num_gpart += m_a->num_gpart;
+#endif
+
+  c->nr_mpoles = n + 1;
+}
+
+/**
+ * @brief Compute the derivatives of the potential for all the (padded)
+ * entries of a #gravity_m2l_cache.
+ *
+ * @param c The #gravity_m2l_cache.
+ * @param nr_padded The number of entries padded to the vector length.
+ * @param periodic Is the calculation periodic ?
+ * @param rs_inv The inverse of the gravity mesh-smoothing scale.
+ */
+__attribute__((always_inline, nonnull)) INLINE static void
+gravity_M2L_batch_derivatives(struct gravity_m2l_cache *c, const int nr_padded,
+                              const int periodic, const float rs_inv) {
+
+  /* Make the compiler understand we are in happy vectorization land */
+  swift_declare_aligned_ptr(const float, dx, c->dx, SWIFT_CACHE_ALIGNMENT);
+  swift_declare_aligned_ptr(const float, dy, c->dy, SWIFT_CACHE_ALIGNMENT);
+  swift_declare_aligned_ptr(const float, dz, c->dz, SWIFT_CACHE_ALIGNMENT);
+  swift_declare_aligned_ptr(const float, eps, c->eps, SWIFT_CACHE_ALIGNMENT);
+  swift_assume_size(nr_padded, VEC_SIZE);
+
+#if !defined(SWIFT_DEBUG_CHECKS) && _OPENMP >= 201307
+#pragma omp simd
+#endif
+  for (int i = 0; i < nr_padded; ++i) {
+
+    /* Compute distance */
+    const float r_x = dx[i];
+    const float r_y = dy[i];
+    const float r_z = dz[i];
+    const float r2 = r_x * r_x + r_y * r_y + r_z * r_z;
+    const float r_inv = 1.f / sqrtf(r2);
+    const float r = r2 * r_inv;
+    const float eps_i = eps[i];
+
+    /* Compute both the softened and un-softened radial terms and pick the
+     * right ones afterwards such that the loop has no branches */
+    struct potential_derivatives_M2L_radial Dt_soft, Dt_far, Dt;
+    potential_derivatives_M2L_radial_softened(min(r, eps_i), eps_i, &Dt_soft);
+    if (periodic)
+      potential_derivatives_M2L_radial_truncated(r, r_inv, rs_inv, &Dt_far);
+    else
+      potential_derivatives_M2L_radial_newtonian(r_inv, &Dt_far);
+
+    const int softened = r2 < eps_i * eps_i;
+    Dt.Dt_1 = softened ? Dt_soft.Dt_1 : Dt_far.Dt_1;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+    Dt.Dt_2 = softened ? Dt_soft.Dt_2 : Dt_far.Dt_2;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+    Dt.Dt_3 = softened ? Dt_soft.Dt_3 : Dt_far.Dt_3;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+    Dt.Dt_4 = softened ? Dt_soft.Dt_4 : Dt_far.Dt_4;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+    Dt.Dt_5 = softened ? Dt_soft.Dt_5 : Dt_far.Dt_5;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+    Dt.Dt_6 = softened ? Dt_soft.Dt_6 : Dt_far.Dt_6;
+#endif
+
+    /* Alright, let's get the full terms */
+    struct potential_derivatives_M2L pot;
+    potential_derivatives_M2L_tensors(r_x, r_y, r_z, r_inv, &Dt, &pot);
+
+    c->D_000[i] = pot.D_000;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+    c->D_001[i] = pot.D_001;
+    c->D_010[i] = pot.D_010;
+    c->D_100[i] = pot.D_100;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+    c->D_002[i] = pot.D_002;
+    c->D_011[i] = pot.D_011;
+    c->D_020[i] = pot.D_020;
+    c->D_101[i] = pot.D_101;
+    c->D_110[i] = pot.D_110;
+    c->D_200[i] = pot.D_200;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+    c->D_003[i] = pot.D_003;
+    c->D_012[i] = pot.D_012;
+    c->D_021[i] = pot.D_021;
+    c->D_030[i] = pot.D_030;
+    c->D_102[i] = pot.D_102;
+    c->D_111[i] = pot.D_111;
+    c->D_120[i] = pot.D_120;
+    c->D_201[i] = pot.D_201;
+    c->D_210[i] = pot.D_210;
+    c->D_300[i] = pot.D_300;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+    c->D_004[i] = pot.D_004;
+    c->D_013[i] = pot.D_013;
+    c->D_022[i] = pot.D_022;
+    c->D_031[i] = pot.D_031;
+    c->D_040[i] = pot.D_040;
+    c->D_103[i] = pot.D_103;
+    c->D_112[i] = pot.D_112;
+    c->D_121[i] = pot.D_121;
+    c->D_130[i] = pot.D_130;
+    c->D_202[i] = pot.D_202;
+    c->D_211[i] = pot.D_211;
+    c->D_220[i] = pot.D_220;
+    c->D_301[i] = pot.D_301;
+    c->D_310[i] = pot.D_310;
+    c->D_400[i] = pot.D_400;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+    c->D_005[i] = pot.D_005;
+    c->D_014[i] = pot.D_014;
+    c->D_023[i] = pot.D_023;
+    c->D_032[i] = pot.D_032;
+    c->D_041[i] = pot.D_041;
+    c->D_050[i] = pot.D_050;
+    c->D_104[i] = pot.D_104;
+    c->D_113[i] = pot.D_113;
+    c->D_122[i] = pot.D_122;
+    c->D_131[i] = pot.D_131;
+    c->D_140[i] = pot.D_140;
+    c->D_203[i] = pot.D_203;
+    c->D_212[i] = pot.D_212;
+    c->D_221[i] = pot.D_221;
+    c->D_230[i] = pot.D_230;
+    c->D_302[i] = pot.D_302;
+    c->D_311[i] = pot.D_311;
+    c->D_320[i] = pot.D_320;
+    c->D_401[i] = pot.D_401;
+    c->D_410[i] = pot.D_410;
+    c->D_500[i] = pot.D_500;
+#endif
+  }
+}
+
+/**
+ * @brief Compute the field tensor due to all the multipoles stored in a
+ * #gravity_m2l_cache.
+ *
+ * This is equivalent to calling gravity_M2L_nonsym() for every multipole in
+ * the list but is organised in two vectorizable passes: the first computes
+ * the derivatives of the potential for all the entries, the second contracts
+ * them with the multipoles and accumulates the field tensor terms. The list
+ * is padded with massless entries placed far from the softening regime.
+ *
+ * @param l_b The field tensor to compute.
+ * @param c The #gravity_m2l_cache containing the multipoles.
+ * @param periodic Is the calculation periodic ?
+ * @param rs_inv The inverse of the gravity mesh-smoothing scale.
+ */
+__attribute__((nonnull)) INLINE static void gravity_M2L_batch(
+    struct grav_tensor *l_b, struct gravity_m2l_cache *c, const int periodic,
+    const float rs_inv) {
+
+  const int nr_mpoles = c->nr_mpoles;
+
+  /* Nothing to do here */
+  if (nr_mpoles == 0) return;
+
+  /* Pad the list to the vector length with massless multipoles */
+  const int nr_padded = nr_mpoles - (nr_mpoles % VEC_SIZE) +
+                        (nr_mpoles % VEC_SIZE == 0 ? 0 : VEC_SIZE);
+  for (int i = nr_mpoles; i < nr_padded; ++i) {
+    c->dx[i] = 2.f;
+    c->dy[i] = 0.f;
+    c->dz[i] = 0.f;
+    c->eps[i] = 1.f;
+
+    c->M_000[i] = 0.f;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+    c->M_002[i] = 0.f;
+    c->M_011[i] = 0.f;
+    c->M_020[i] = 0.f;
+    c->M_101[i] = 0.f;
+    c->M_110[i] = 0.f;
+    c->M_200[i] = 0.f;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+    c->M_003[i] = 0.f;
+    c->M_012[i] = 0.f;
+    c->M_021[i] = 0.f;
+    c->M_030[i] = 0.f;
+    c->M_102[i] = 0.f;
+    c->M_111[i] = 0.f;
+    c->M_120[i] = 0.f;
+    c->M_201[i] = 0.f;
+    c->M_210[i] = 0.f;
+    c->M_300[i] = 0.f;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+    c->M_004[i] = 0.f;
+    c->M_013[i] = 0.f;
+    c->M_022[i] = 0.f;
+    c->M_031[i] = 0.f;
+    c->M_040[i] = 0.f;
+    c->M_103[i] = 0.f;
+    c->M_112[i] = 0.f;
+    c->M_121[i] = 0.f;
+    c->M_130[i] = 0.f;
+    c->M_202[i] = 0.f;
+    c->M_211[i] = 0.f;
+    c->M_220[i] = 0.f;
+    c->M_301[i] = 0.f;
+    c->M_310[i] = 0.f;
+    c->M_400[i] = 0.f;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+    c->M_005[i] = 0.f;
+    c->M_014[i] = 0.f;
+    c->M_023[i] = 0.f;
+    c->M_032[i] = 0.f;
+    c->M_041[i] = 0.f;
+    c->M_050[i] = 0.f;
+    c->M_104[i] = 0.f;
+    c->M_113[i] = 0.f;
+    c->M_122[i] = 0.f;
+    c->M_131[i] = 0.f;
+    c->M_140[i] = 0.f;
+    c->M_203[i] = 0.f;
+    c->M_212[i] = 0.f;
+    c->M_221[i] = 0.f;
+    c->M_230[i] = 0.f;
+    c->M_302[i] = 0.f;
+    c->M_311[i] = 0.f;
+    c->M_320[i] = 0.f;
+    c->M_401[i] = 0.f;
+    c->M_410[i] = 0.f;
+    c->M_500[i] = 0.f;
+#endif
+  }
+
+  /* First pass: compute the derivatives of the potential. We call the loop
+   * with a constant periodicity flag such that it gets branch-free. */
+  if (periodic)
+    gravity_M2L_batch_derivatives(c, nr_padded, /*periodic=*/1, rs_inv);
+  else
+    gravity_M2L_batch_derivatives(c, nr_padded, /*periodic=*/0, rs_inv);
+
+  /* Second pass: contract the derivatives with the multipoles */
+  float F_000 = 0.f;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+  float F_001 = 0.f, F_010 = 0.f, F_100 = 0.f;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+  float F_002 = 0.f, F_011 = 0.f, F_020 = 0.f, F_101 = 0.f, F_110 = 0.f,
+      F_200 = 0.f;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+  float F_003 = 0.f, F_012 = 0.f, F_021 = 0.f, F_030 = 0.f, F_102 = 0.f,
+      F_111 = 0.f, F_120 = 0.f, F_201 = 0.f, F_210 = 0.f, F_300 = 0.f;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+  float F_004 = 0.f, F_013 = 0.f, F_022 = 0.f, F_031 = 0.f, F_040 = 0.f,
+      F_103 = 0.f, F_112 = 0.f, F_121 = 0.f, F_130 = 0.f, F_202 = 0.f,
+      F_211 = 0.f, F_220 = 0.f, F_301 = 0.f, F_310 = 0.f, F_400 = 0.f;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+  float F_005 = 0.f, F_014 = 0.f, F_023 = 0.f, F_032 = 0.f, F_041 = 0.f,
+      F_050 = 0.f, F_104 = 0.f, F_113 = 0.f, F_122 = 0.f, F_131 = 0.f,
+      F_140 = 0.f, F_203 = 0.f, F_212 = 0.f, F_221 = 0.f, F_230 = 0.f,
+      F_302 = 0.f, F_311 = 0.f, F_320 = 0.f, F_401 = 0.f, F_410 = 0.f,
+      F_500 = 0.f;
+#endif
+
+  for (int i = 0; i < nr_padded; ++i) {
+
+    const float M_000 = c->M_000[i];
+    const float D_000 = c->D_000[i];
+
+    /* Compute 0th order field tensor terms (addition to rank 0) */
+    F_000 += M_000 * D_000;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+
+    const float D_001 = c->D_001[i];
+    const float D_010 = c->D_010[i];
+    const float D_100 = c->D_100[i];
+
+    /* Compute 1st order field tensor terms (addition to rank 1) */
+    F_001 += M_000 * D_001;
+    F_010 += M_000 * D_010;
+    F_100 += M_000 * D_100;
+
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+
+    const float M_002 = c->M_002[i];
+    const float M_011 = c->M_011[i];
+    const float M_020 = c->M_020[i];
+    const float M_101 = c->M_101[i];
+    const float M_110 = c->M_110[i];
+    const float M_200 = c->M_200[i];
+    const float D_002 = c->D_002[i];
+    const float D_011 = c->D_011[i];
+    const float D_020 = c->D_020[i];
+    const float D_101 = c->D_101[i];
+    const float D_110 = c->D_110[i];
+    const float D_200 = c->D_200[i];
+
+    /* Compute 2nd order field tensor terms (addition to rank 0) */
+    F_000 += M_002 * D_002 + M_011 * D_011 + M_020 * D_020 + M_101 * D_101 +
+             M_110 * D_110 + M_200 * D_200;
+
+    /* Compute 2nd order field tensor terms (addition to rank 2) */
+    F_002 += M_000 * D_002;
+    F_011 += M_000 * D_011;
+    F_020 += M_000 * D_020;
+    F_101 += M_000 * D_101;
+    F_110 += M_000 * D_110;
+    F_200 += M_000 * D_200;
+
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+
+    const float M_003 = c->M_003[i];
+    const float M_012 = c->M_012[i];
+    const float M_021 = c->M_021[i];
+    const float M_030 = c->M_030[i];
+    const float M_102 = c->M_102[i];
+    const float M_111 = c->M_111[i];
+    const float M_120 = c->M_120[i];
+    const float M_201 = c->M_201[i];
+    const float M_210 = c->M_210[i];
+    const float M_300 = c->M_300[i];
+    const float D_003 = c->D_003[i];
+    const float D_012 = c->D_012[i];
+    const float D_021 = c->D_021[i];
+    const float D_030 = c->D_030[i];
+    const float D_102 = c->D_102[i];
+    const float D_111 = c->D_111[i];
+    const float D_120 = c->D_120[i];
+    const float D_201 = c->D_201[i];
+    const float D_210 = c->D_210[i];
+    const float D_300 = c->D_300[i];
+
+    /* Compute 3rd order field tensor terms (addition to rank 0) */
+    F_000 += M_003 * D_003 + M_012 * D_012 + M_021 * D_021 + M_030 * D_030 +
+             M_102 * D_102 + M_111 * D_111 + M_120 * D_120 + M_201 * D_201 +
+             M_210 * D_210 + M_300 * D_300;
+
+    /* Compute 3rd order field tensor terms (addition to rank 1) */
+    F_001 += M_002 * D_003 + M_011 * D_012 + M_020 * D_021 + M_101 * D_102 +
+             M_110 * D_111 + M_200 * D_201;
+    F_010 += M_002 * D_012 + M_011 * D_021 + M_020 * D_030 + M_101 * D_111 +
+             M_110 * D_120 + M_200 * D_210;
+    F_100 += M_002 * D_102 + M_011 * D_111 + M_020 * D_120 + M_101 * D_201 +
+             M_110 * D_210 + M_200 * D_300;
+
+    /* Compute 3rd order field tensor terms (addition to rank 3) */
+    F_003 += M_000 * D_003;
+    F_012 += M_000 * D_012;
+    F_021 += M_000 * D_021;
+    F_030 += M_000 * D_030;
+    F_102 += M_000 * D_102;
+    F_111 += M_000 * D_111;
+    F_120 += M_000 * D_120;
+    F_201 += M_000 * D_201;
+    F_210 += M_000 * D_210;
+    F_300 += M_000 * D_300;
+
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+
+    const float M_004 = c->M_004[i];
+    const float M_013 = c->M_013[i];
+    const float M_022 = c->M_022[i];
+    const float M_031 = c->M_031[i];
+    const float M_040 = c->M_040[i];
+    const float M_103 = c->M_103[i];
+    const float M_112 = c->M_112[i];
+    const float M_121 = c->M_121[i];
+    const float M_130 = c->M_130[i];
+    const float M_202 = c->M_202[i];
+    const float M_211 = c->M_211[i];
+    const float M_220 = c->M_220[i];
+    const float M_301 = c->M_301[i];
+    const float M_310 = c->M_310[i];
+    const float M_400 = c->M_400[i];
+    const float D_004 = c->D_004[i];
+    const float D_013 = c->D_013[i];
+    const float D_022 = c->D_022[i];
+    const float D_031 = c->D_031[i];
+    const float D_040 = c->D_040[i];
+    const float D_103 = c->D_103[i];
+    const float D_112 = c->D_112[i];
+    const float D_121 = c->D_121[i];
+    const float D_130 = c->D_130[i];
+    const float D_202 = c->D_202[i];
+    const float D_211 = c->D_211[i];
+    const float D_220 = c->D_220[i];
+    const float D_301 = c->D_301[i];
+    const float D_310 = c->D_310[i];
+    const float D_400 = c->D_400[i];
+
+    /* Compute 4th order field tensor terms (addition to rank 0) */
+    F_000 += M_004 * D_004 + M_013 * D_013 + M_022 * D_022 + M_031 * D_031 +
+             M_040 * D_040 + M_103 * D_103 + M_112 * D_112 + M_121 * D_121 +
+             M_130 * D_130 + M_202 * D_202 + M_211 * D_211 + M_220 * D_220 +
+             M_301 * D_301 + M_310 * D_310 + M_400 * D_400;
+
+    /* Compute 4th order field tensor terms (addition to rank 1) */
+    F_001 += M_003 * D_004 + M_012 * D_013 + M_021 * D_022 + M_030 * D_031 +
+             M_102 * D_103 + M_111 * D_112 + M_120 * D_121 + M_201 * D_202 +
+             M_210 * D_211 + M_300 * D_301;
+    F_010 += M_003 * D_013 + M_012 * D_022 + M_021 * D_031 + M_030 * D_040 +
+             M_102 * D_112 + M_111 * D_121 + M_120 * D_130 + M_201 * D_211 +
+             M_210 * D_220 + M_300 * D_310;
+    F_100 += M_003 * D_103 + M_012 * D_112 + M_021 * D_121 + M_030 * D_130 +
+             M_102 * D_202 + M_111 * D_211 + M_120 * D_220 + M_201 * D_301 +
+             M_210 * D_310 + M_300 * D_400;
+
+    /* Compute 4th order field tensor terms (addition to rank 2) */
+    F_002 += M_002 * D_004 + M_011 * D_013 + M_020 * D_022 + M_101 * D_103 +
+             M_110 * D_112 + M_200 * D_202;
+    F_011 += M_002 * D_013 + M_011 * D_022 + M_020 * D_031 + M_101 * D_112 +
+             M_110 * D_121 + M_200 * D_211;
+    F_020 += M_002 * D_022 + M_011 * D_031 + M_020 * D_040 + M_101 * D_121 +
+             M_110 * D_130 + M_200 * D_220;
+    F_101 += M_002 * D_103 + M_011 * D_112 + M_020 * D_121 + M_101 * D_202 +
+             M_110 * D_211 + M_200 * D_301;
+    F_110 += M_002 * D_112 + M_011 * D_121 + M_020 * D_130 + M_101 * D_211 +
+             M_110 * D_220 + M_200 * D_310;
+    F_200 += M_002 * D_202 + M_011 * D_211 + M_020 * D_220 + M_101 * D_301 +
+             M_110 * D_310 + M_200 * D_400;
+
+    /* Compute 4th order field tensor terms (addition to rank 4) */
+    F_004 += M_000 * D_004;
+    F_013 += M_000 * D_013;
+    F_022 += M_000 * D_022;
+    F_031 += M_000 * D_031;
+    F_040 += M_000 * D_040;
+    F_103 += M_000 * D_103;
+    F_112 += M_000 * D_112;
+    F_121 += M_000 * D_121;
+    F_130 += M_000 * D_130;
+    F_202 += M_000 * D_202;
+    F_211 += M_000 * D_211;
+    F_220 += M_000 * D_220;
+    F_301 += M_000 * D_301;
+    F_310 += M_000 * D_310;
+    F_400 += M_000 * D_400;
+
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+
+    const float M_005 = c->M_005[i];
+    const float M_014 = c->M_014[i];
+    const float M_023 = c->M_023[i];
+    const float M_032 = c->M_032[i];
+    const float M_041 = c->M_041[i];
+    const float M_050 = c->M_050[i];
+    const float M_104 = c->M_104[i];
+    const float M_113 = c->M_113[i];
+    const float M_122 = c->M_122[i];
+    const float M_131 = c->M_131[i];
+    const float M_140 = c->M_140[i];
+    const float M_203 = c->M_203[i];
+    const float M_212 = c->M_212[i];
+    const float M_221 = c->M_221[i];
+    const float M_230 = c->M_230[i];
+    const float M_302 = c->M_302[i];
+    const float M_311 = c->M_311[i];
+    const float M_320 = c->M_320[i];
+    const float M_401 = c->M_401[i];
+    const float M_410 = c->M_410[i];
+    const float M_500 = c->M_500[i];
+    const float D_005 = c->D_005[i];
+    const float D_014 = c->D_014[i];
+    const float D_023 = c->D_023[i];
+    const float D_032 = c->D_032[i];
+    const float D_041 = c->D_041[i];
+    const float D_050 = c->D_050[i];
+    const float D_104 = c->D_104[i];
+    const float D_113 = c->D_113[i];
+    const float D_122 = c->D_122[i];
+    const float D_131 = c->D_131[i];
+    const float D_140 = c->D_140[i];
+    const float D_203 = c->D_203[i];
+    const float D_212 = c->D_212[i];
+    const float D_221 = c->D_221[i];
+    const float D_230 = c->D_230[i];
+    const float D_302 = c->D_302[i];
+    const float D_311 = c->D_311[i];
+    const float D_320 = c->D_320[i];
+    const float D_401 = c->D_401[i];
+    const float D_410 = c->D_410[i];
+    const float D_500 = c->D_500[i];
+
+    /* Compute 5th order field tensor terms (addition to rank 0) */
+    F_000 += M_005 * D_005 + M_014 * D_014 + M_023 * D_023 + M_032 * D_032 +
+             M_041 * D_041 + M_050 * D_050 + M_104 * D_104 + M_113 * D_113 +
+             M_122 * D_122 + M_131 * D_131 + M_140 * D_140 + M_203 * D_203 +
+             M_212 * D_212 + M_221 * D_221 + M_230 * D_230 + M_302 * D_302 +
+             M_311 * D_311 + M_320 * D_320 + M_401 * D_401 + M_410 * D_410 +
+             M_500 * D_500;
+
+    /* Compute 5th order field tensor terms (addition to rank 1) */
+    F_001 += M_004 * D_005 + M_013 * D_014 + M_022 * D_023 + M_031 * D_032 +
+             M_040 * D_041 + M_103 * D_104 + M_112 * D_113 + M_121 * D_122 +
+             M_130 * D_131 + M_202 * D_203 + M_211 * D_212 + M_220 * D_221 +
+             M_301 * D_302 + M_310 * D_311 + M_400 * D_401;
+    F_010 += M_004 * D_014 + M_013 * D_023 + M_022 * D_032 + M_031 * D_041 +
+             M_040 * D_050 + M_103 * D_113 + M_112 * D_122 + M_121 * D_131 +
+             M_130 * D_140 + M_202 * D_212 + M_211 * D_221 + M_220 * D_230 +
+             M_301 * D_311 + M_310 * D_320 + M_400 * D_410;
+    F_100 += M_004 * D_104 + M_013 * D_113 + M_022 * D_122 + M_031 * D_131 +
+             M_040 * D_140 + M_103 * D_203 + M_112 * D_212 + M_121 * D_221 +
+             M_130 * D_230 + M_202 * D_302 + M_211 * D_311 + M_220 * D_320 +
+             M_301 * D_401 + M_310 * D_410 + M_400 * D_500;
+
+    /* Compute 5th order field tensor terms (addition to rank 2) */
+    F_002 += M_003 * D_005 + M_012 * D_014 + M_021 * D_023 + M_030 * D_032 +
+             M_102 * D_104 + M_111 * D_113 + M_120 * D_122 + M_201 * D_203 +
+             M_210 * D_212 + M_300 * D_302;
+    F_011 += M_003 * D_014 + M_012 * D_023 + M_021 * D_032 + M_030 * D_041 +
+             M_102 * D_113 + M_111 * D_122 + M_120 * D_131 + M_201 * D_212 +
+             M_210 * D_221 + M_300 * D_311;
+    F_020 += M_003 * D_023 + M_012 * D_032 + M_021 * D_041 + M_030 * D_050 +
+             M_102 * D_122 + M_111 * D_131 + M_120 * D_140 + M_201 * D_221 +
+             M_210 * D_230 + M_300 * D_320;
+    F_101 += M_003 * D_104 + M_012 * D_113 + M_021 * D_122 + M_030 * D_131 +
+             M_102 * D_203 + M_111 * D_212 + M_120 * D_221 + M_201 * D_302 +
+             M_210 * D_311 + M_300 * D_401;
+    F_110 += M_003 * D_113 + M_012 * D_122 + M_021 * D_131 + M_030 * D_140 +
+             M_102 * D_212 + M_111 * D_221 + M_120 * D_230 + M_201 * D_311 +
+             M_210 * D_320 + M_300 * D_410;
+    F_200 += M_003 * D_203 + M_012 * D_212 + M_021 * D_221 + M_030 * D_230 +
+             M_102 * D_302 + M_111 * D_311 + M_120 * D_320 + M_201 * D_401 +
+             M_210 * D_410 + M_300 * D_500;
+
+    /* Compute 5th order field tensor terms (addition to rank 3) */
+    F_003 += M_002 * D_005 + M_011 * D_014 + M_020 * D_023 + M_101 * D_104 +
+             M_110 * D_113 + M_200 * D_203;
+    F_012 += M_002 * D_014 + M_011 * D_023 + M_020 * D_032 + M_101 * D_113 +
+             M_110 * D_122 + M_200 * D_212;
+    F_021 += M_002 * D_023 + M_011 * D_032 + M_020 * D_041 + M_101 * D_122 +
+             M_110 * D_131 + M_200 * D_221;
+    F_030 += M_002 * D_032 + M_011 * D_041 + M_020 * D_050 + M_101 * D_131 +
+             M_110 * D_140 + M_200 * D_230;
+    F_102 += M_002 * D_104 + M_011 * D_113 + M_020 * D_122 + M_101 * D_203 +
+             M_110 * D_212 + M_200 * D_302;
+    F_111 += M_002 * D_113 + M_011 * D_122 + M_020 * D_131 + M_101 * D_212 +
+             M_110 * D_221 + M_200 * D_311;
+    F_120 += M_002 * D_122 + M_011 * D_131 + M_020 * D_140 + M_101 * D_221 +
+             M_110 * D_230 + M_200 * D_320;
+    F_201 += M_002 * D_203 + M_011 * D_212 + M_020 * D_221 + M_101 * D_302 +
+             M_110 * D_311 + M_200 * D_401;
+    F_210 += M_002 * D_212 + M_011 * D_221 + M_020 * D_230 + M_101 * D_311 +
+             M_110 * D_320 + M_200 * D_410;
+    F_300 += M_002 * D_302 + M_011 * D_311 + M_020 * D_320 + M_101 * D_401 +
+             M_110 * D_410 + M_200 * D_500;
+
+    /* Compute 5th order field tensor terms (addition to rank 5) */
+    F_005 += M_000 * D_005;
+    F_014 += M_000 * D_014;
+    F_023 += M_000 * D_023;
+    F_032 += M_000 * D_032;
+    F_041 += M_000 * D_041;
+    F_050 += M_000 * D_050;
+    F_104 += M_000 * D_104;
+    F_113 += M_000 * D_113;
+    F_122 += M_000 * D_122;
+    F_131 += M_000 * D_131;
+    F_140 += M_000 * D_140;
+    F_203 += M_000 * D_203;
+    F_212 += M_000 * D_212;
+    F_221 += M_000 * D_221;
+    F_230 += M_000 * D_230;
+    F_302 += M_000 * D_302;
+    F_311 += M_000 * D_311;
+    F_320 += M_000 * D_320;
+    F_401 += M_000 * D_401;
+    F_410 += M_000 * D_410;
+    F_500 += M_000 * D_500;
+
+#endif
+  }
+
+#ifdef SWIFT_DEBUG_CHECKS
+  /* Count all interactions
+   * Note that despite being in a section of the code protected by locks,
+   * we must use atomics here as the long-range task may update this
+   * counter in a lock-free section of code. */
+  accumulate_add_ll(&l_b->num_interacted, c->num_gpart);
+#endif
+
+#ifdef SWIFT_GRAVITY_FORCE_CHECKS
+  /* Count tree interactions
+   * Note that despite being in a section of the code protected by locks,
+   * we must use atomics here as the long-range task may update this
+   * counter in a lock-free section of code. */
+  accumulate_add_ll(&l_b->num_interacted_tree, c->num_gpart);
+#endif
+
+  /* Record that this tensor has received contributions */
+  l_b->interacted = 1;
+
+  /* Write the accumulated terms back to the field tensor */
+  l_b->F_000 += F_000;
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+  l_b->F_001 += F_001;
+  l_b->F_010 += F_010;
+  l_b->F_100 += F_100;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
+  l_b->F_002 += F_002;
+  l_b->F_011 += F_011;
+  l_b->F_020 += F_020;
+  l_b->F_101 += F_101;
+  l_b->F_110 += F_110;
+  l_b->F_200 += F_200;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 2
+  l_b->F_003 += F_003;
+  l_b->F_012 += F_012;
+  l_b->F_021 += F_021;
+  l_b->F_030 += F_030;
+  l_b->F_102 += F_102;
+  l_b->F_111 += F_111;
+  l_b->F_120 += F_120;
+  l_b->F_201 += F_201;
+  l_b->F_210 += F_210;
+  l_b->F_300 += F_300;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 3
+  l_b->F_004 += F_004;
+  l_b->F_013 += F_013;
+  l_b->F_022 += F_022;
+  l_b->F_031 += F_031;
+  l_b->F_040 += F_040;
+  l_b->F_103 += F_103;
+  l_b->F_112 += F_112;
+  l_b->F_121 += F_121;
+  l_b->F_130 += F_130;
+  l_b->F_202 += F_202;
+  l_b->F_211 += F_211;
+  l_b->F_220 += F_220;
+  l_b->F_301 += F_301;
+  l_b->F_310 += F_310;
+  l_b->F_400 += F_400;
+#endif
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 4
+  l_b->F_005 += F_005;
+  l_b->F_014 += F_014;
+  l_b->F_023 += F_023;
+  l_b->F_032 += F_032;
+  l_b->F_041 += F_041;
+  l_b->F_050 += F_050;
+  l_b->F_104 += F_104;
+  l_b->F_113 += F_113;
+  l_b->F_122 += F_122;
+  l_b->F_131 += F_131;
+  l_b->F_140 += F_140;
+  l_b->F_203 += F_203;
+  l_b->F_212 += F_212;
+  l_b->F_221 += F_221;
+  l_b->F_230 += F_230;
+  l_b->F_302 += F_302;
+  l_b->F_311 += F_311;
+  l_b->F_320 += F_320;
+  l_b->F_401 += F_401;
+  l_b->F_410 += F_410;
+  l_b->F_500 += F_500;
+#endif
+}
+
+#endif /* SWIFT_GRAVITY_M2L_CACHE_H */
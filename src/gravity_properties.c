@@ -71,8 +71,41 @@ void gravity_props_init(struct gravity_props *p, struct swift_params *params,
     p->distributed_mesh =
         parser_get_opt_param_int(params, "Gravity:distributed_mesh",
                                  gravity_props_default_distributed_mesh);
+
+    char decomposition[32] = {0};
+    parser_get_opt_param_string(params,
+                                "Gravity:distributed_mesh_decomposition",
+                                decomposition, "slabs");
+    if (strcmp(decomposition, "slabs") == 0)
+      p->distributed_mesh_pencils = 0;
+    else if (strcmp(decomposition, "pencils") == 0)
+      p->distributed_mesh_pencils = 1;
+    else
+      error(
+          "Invalid choice of distributed mesh decomposition: '%s'. Should be "
+          "'slabs' or 'pencils'",
+          decomposition);
     p->mesh_uses_local_patches =
         parser_get_opt_param_int(params, "Gravity:mesh_uses_local_patches", 1);
+    p->mesh_uses_coloured_deposit = parser_get_opt_param_int(
+        params, "Gravity:mesh_uses_coloured_deposit", 0);
+
+    char planning[32] = {0};
+    parser_get_opt_param_string(params, "Gravity:mesh_fftw_planning",
+                                planning, "measure");
+    if (strcmp(planning, "estimate") == 0)
+      p->mesh_fftw_planning = 0;
+    else if (strcmp(planning, "measure") == 0)
+      p->mesh_fftw_planning = 1;
+    else if (strcmp(planning, "patient") == 0)
+      p->mesh_fftw_planning = 2;
+    else if (strcmp(planning, "exhaustive") == 0)
+      p->mesh_fftw_planning = 3;
+    else
+      error(
+          "Invalid choice of mesh FFT planning: '%s'. Should be 'estimate', "
+          "'measure', 'patient' or 'exhaustive'",
+          planning);
     p->a_smooth = parser_get_opt_param_float(params, "Gravity:a_smooth",
                                              gravity_props_default_a_smooth);
     p->r_cut_max_ratio = parser_get_opt_param_float(
@@ -90,11 +123,16 @@ void gravity_props_init(struct gravity_props *p, struct swift_params *params,
     if (p->a_smooth <= 0.)
       error("The mesh smoothing scale 'a_smooth' must be > 0.");
 
-#if !defined(WITH_MPI) || !defined(HAVE_MPI_FFTW)
+#if !defined(WITH_MPI)
     if (p->distributed_mesh)
+      error("Need to use MPI to run with distributed mesh.");
+#elif !defined(HAVE_MPI_FFTW)
+    if (p->distributed_mesh && !p->distributed_mesh_pencils)
       error(
-          "Need to use MPI and FFTW MPI library (i.e. compile with "
-          "--enable-mpi-mesh-gravity) to run with distributed mesh.");
+          "Need to use the FFTW MPI library (i.e. compile with "
+          "--enable-mpi-mesh-gravity) to run with a distributed mesh in "
+          "slabs. Use 'Gravity:distributed_mesh_decomposition: pencils' "
+          "instead.");
 #endif
 
     if (2. * p->a_smooth * p->r_cut_max_ratio > p->mesh_size)
@@ -110,6 +148,7 @@ void gravity_props_init(struct gravity_props *p, struct swift_params *params,
   } else {
     p->mesh_size = 0;
     p->distributed_mesh = 0;
+    p->distributed_mesh_pencils = 0;
     p->a_smooth = 0.f;
     p->r_s = FLT_MAX;
     p->r_s_inv = 0.f;
@@ -372,6 +411,9 @@ void gravity_props_print(const struct gravity_props *p) {
   message("Self-gravity mesh side-length: N=%d", p->mesh_size);
   message("Self-gravity mesh smoothing-scale: a_smooth=%f", p->a_smooth);
   message("Self-gravity distributed mesh enabled: %d", p->distributed_mesh);
+  if (p->distributed_mesh)
+    message("Self-gravity distributed mesh decomposition: %s",
+            p->distributed_mesh_pencils ? "pencils" : "slabs");
 
   message("Self-gravity tree cut-off ratio: r_cut_max=%f", p->r_cut_max_ratio);
   message("Self-gravity truncation cut-off ratio: r_cut_min=%f",
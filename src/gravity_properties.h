@@ -134,10 +134,22 @@ struct gravity_props {
   /*! Whether mesh is distributed between MPI ranks when we use MPI  */
   int distributed_mesh;
 
+  /*! Whether the distributed mesh is split in pencils (1) rather than in the
+   * slabs of the FFTW MPI library (0) */
+  int distributed_mesh_pencils;
+
   /*! Whether or not to use local patches rather than
    * direct atomic writes to the mesh when running without MPI */
   int mesh_uses_local_patches;
 
+  /*! Whether or not to add the local patches to the mesh colour by colour
+   * rather than with atomic writes */
+  int mesh_uses_coloured_deposit;
+
+  /*! Rigour of the planning of the mesh FFTs (0: estimate, 1: measure,
+   * 2: patient, 3: exhaustive) */
+  int mesh_fftw_planning;
+
   /*! Mesh smoothing scale in units of top-level cell size */
   float a_smooth;
 
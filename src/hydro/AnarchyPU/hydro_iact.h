@@ -31,6 +31,7 @@
 
 #include "adaptive_softening_iact.h"
 #include "adiabatic_index.h"
+#include "cache.h"
 #include "hydro_parameters.h"
 #include "minmax.h"
 #include "signal_velocity.h"
@@ -570,4 +571,289 @@ __attribute__((always_inline)) INLINE static void runner_iact_nonsym_force(
   pi->force.h_dt -= mj * dvdr * r_inv / rhoj * wi_dr;
 }
 
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
+
+/**
+ * @brief Properties of the particle pi broadcast to all the lanes of the
+ * vectorised force loops.
+ */
+struct hydro_vec_force_pi {
+
+  /*! Velocity */
+  vector vx, vy, vz;
+
+  /*! Density and "grad h" term */
+  vector rho, grad_h;
+
+  /*! Balsara switch and sound speed */
+  vector balsara, c;
+
+  /*! Mass, internal energy and weighted pressure */
+  vector m, u, pressure_bar;
+
+  /*! Viscosity and diffusion coefficients */
+  vector alpha_visc, alpha_diff;
+
+  /*! Signal velocity */
+  vector v_sig;
+};
+
+/**
+ * @brief Updates of the particle pi accumulated by the vectorised force loops.
+ */
+struct hydro_vec_force_sums {
+
+  /*! Hydro acceleration */
+  vector a_hydro_x, a_hydro_y, a_hydro_z;
+
+  /*! Time derivatives of the smoothing length and internal energy */
+  vector h_dt, u_dt;
+
+  /*! Smallest time-bin of the neighbours */
+  vector min_ngb_time_bin;
+};
+
+/**
+ * @brief Broadcast the properties of a particle read in the #cache.
+ *
+ * @param v_pi (return) The broadcast properties.
+ * @param c The #cache.
+ * @param i The index of the particle in the cache.
+ */
+__attribute__((always_inline)) INLINE static void hydro_vec_force_read_pi(
+    struct hydro_vec_force_pi* restrict v_pi, const struct cache* restrict c,
+    const int i) {
+
+  v_pi->vx = vector_set1(c->vx[i]);
+  v_pi->vy = vector_set1(c->vy[i]);
+  v_pi->vz = vector_set1(c->vz[i]);
+  v_pi->rho = vector_set1(c->rho[i]);
+  v_pi->grad_h = vector_set1(c->grad_h[i]);
+  v_pi->balsara = vector_set1(c->balsara[i]);
+  v_pi->c = vector_set1(c->soundspeed[i]);
+  v_pi->m = vector_set1(c->m[i]);
+  v_pi->u = vector_set1(c->u[i]);
+  v_pi->pressure_bar = vector_set1(c->pressure_bar[i]);
+  v_pi->alpha_visc = vector_set1(c->alpha_visc[i]);
+  v_pi->alpha_diff = vector_set1(c->alpha_diff[i]);
+  v_pi->v_sig = vector_set1(c->v_sig[i]);
+}
+
+/**
+ * @brief Reset the force updates accumulated for a particle.
+ *
+ * @param sums (return) The accumulated updates.
+ * @param p The #part about to be updated.
+ */
+__attribute__((always_inline)) INLINE static void hydro_vec_force_init_sums(
+    struct hydro_vec_force_sums* restrict sums,
+    const struct part* restrict p) {
+
+  sums->a_hydro_x = vector_setzero();
+  sums->a_hydro_y = vector_setzero();
+  sums->a_hydro_z = vector_setzero();
+  sums->h_dt = vector_setzero();
+  sums->u_dt = vector_setzero();
+  sums->min_ngb_time_bin = vector_set1(p->limiter_data.min_ngb_time_bin);
+}
+
+/**
+ * @brief Reduce the accumulated force updates and add them to a particle.
+ *
+ * @param sums The accumulated updates.
+ * @param p The #part to update.
+ */
+__attribute__((always_inline)) INLINE static void hydro_vec_force_write_sums(
+    struct hydro_vec_force_sums* restrict sums, struct part* restrict p) {
+
+  VEC_HADD(sums->a_hydro_x, p->a_hydro[0]);
+  VEC_HADD(sums->a_hydro_y, p->a_hydro[1]);
+  VEC_HADD(sums->a_hydro_z, p->a_hydro[2]);
+  VEC_HADD(sums->h_dt, p->force.h_dt);
+  VEC_HADD(sums->u_dt, p->u_dt);
+
+  float min_ngb_time_bin = p->limiter_data.min_ngb_time_bin;
+  VEC_HMIN(sums->min_ngb_time_bin, min_ngb_time_bin);
+  p->limiter_data.min_ngb_time_bin = (timebin_t)min_ngb_time_bin;
+}
+
+/**
+ * @brief Force interaction of a particle with one vector of neighbours read
+ * in the #cache (non-symmetric vectorized version).
+ *
+ * Follows runner_iact_nonsym_force() term by term and also updates the
+ * minimal time-bin of the neighbours used by the time-step limiter.
+ *
+ * @param r2 The squared distances.
+ * @param dx The x separations.
+ * @param dy The y separations.
+ * @param dz The z separations.
+ * @param v_pi The broadcast properties of pi.
+ * @param cj_cache The #cache of the neighbours.
+ * @param pjd The index of the first neighbour in the cache.
+ * @param hi_inv The inverse smoothing length of pi.
+ * @param hj_inv The inverse smoothing lengths of the neighbours.
+ * @param a Current scale factor.
+ * @param H Current Hubble parameter.
+ * @param sums (return) The accumulated updates of pi.
+ * @param mask The neighbours to interact with.
+ */
+__attribute__((always_inline)) INLINE static void
+runner_iact_nonsym_cache_vec_force(
+    vector* r2, vector* dx, vector* dy, vector* dz,
+    const struct hydro_vec_force_pi* restrict v_pi,
+    const struct cache* restrict cj_cache, const int pjd, vector hi_inv,
+    vector hj_inv, const float a, const float H,
+    struct hydro_vec_force_sums* restrict sums, mask_t mask) {
+
+  vector r, ri;
+  vector dvx, dvy, dvz;
+  vector xi, xj;
+  vector hid_inv, hjd_inv;
+  vector wi_dx, wj_dx, wi_dr, wj_dr, dvdr, dvdr_Hubble;
+  vector piax, piay, piaz;
+  vector pih_dt;
+  vector v_sig, omega_ij, mu_ij, f_ij, f_ji;
+  vector rho_ij, alpha, visc, visc_acc_term, sph_acc_term, acc;
+  vector u_fac, f_over_P_i, f_over_P_j;
+  vector sph_du_term_i, visc_du_term, alpha_diff, v_diff, diff_du_term;
+  vector du_dt_i;
+
+  /* Fill vectors. */
+  const vector vjx = vector_load(&cj_cache->vx[pjd]);
+  const vector vjy = vector_load(&cj_cache->vy[pjd]);
+  const vector vjz = vector_load(&cj_cache->vz[pjd]);
+  const vector mj = vector_load(&cj_cache->m[pjd]);
+  const vector pjrho = vector_load(&cj_cache->rho[pjd]);
+  const vector grad_hj = vector_load(&cj_cache->grad_h[pjd]);
+  const vector pressure_bar_j = vector_load(&cj_cache->pressure_bar[pjd]);
+  const vector balsara_j = vector_load(&cj_cache->balsara[pjd]);
+  const vector cj = vector_load(&cj_cache->soundspeed[pjd]);
+  const vector alpha_visc_j = vector_load(&cj_cache->alpha_visc[pjd]);
+  const vector alpha_diff_j = vector_load(&cj_cache->alpha_diff[pjd]);
+  const vector uj = vector_load(&cj_cache->u[pjd]);
+  const vector v_sig_j = vector_load(&cj_cache->v_sig[pjd]);
+  const vector time_bin_j = vector_load(&cj_cache->time_bin[pjd]);
+
+  /* Cosmological terms */
+  const float fac_mu = pow_three_gamma_minus_five_over_two(a);
+  const float a2_Hubble = a * a * H;
+  const vector v_fac_mu = vector_set1(fac_mu);
+  const vector v_a2_Hubble = vector_set1(a2_Hubble);
+
+  /* Get the radius and inverse radius. */
+  ri = vec_reciprocal_sqrt(*r2);
+  r.v = vec_mul(r2->v, ri.v);
+
+  /* Get the kernel for hi. */
+  hid_inv = pow_dimension_plus_one_vec(hi_inv);
+  xi.v = vec_mul(r.v, hi_inv.v);
+  kernel_eval_dWdx_force_vec(&xi, &wi_dx);
+  wi_dr.v = vec_mul(hid_inv.v, wi_dx.v);
+
+  /* Get the kernel for hj. */
+  hjd_inv = pow_dimension_plus_one_vec(hj_inv);
+  xj.v = vec_mul(r.v, hj_inv.v);
+  kernel_eval_dWdx_force_vec(&xj, &wj_dx);
+  wj_dr.v = vec_mul(hjd_inv.v, wj_dx.v);
+
+  /* Compute gradient terms */
+  f_ij.v = vec_sub(vec_set1(1.f),
+                   vec_div(v_pi->grad_h.v, vec_mul(mj.v, uj.v)));
+  f_ji.v = vec_sub(vec_set1(1.f),
+                   vec_div(grad_hj.v, vec_mul(v_pi->m.v, v_pi->u.v)));
+
+  /* Compute dv. */
+  dvx.v = vec_sub(v_pi->vx.v, vjx.v);
+  dvy.v = vec_sub(v_pi->vy.v, vjy.v);
+  dvz.v = vec_sub(v_pi->vz.v, vjz.v);
+
+  /* Compute dv dot r. */
+  dvdr.v = vec_fma(dvx.v, dx->v, vec_fma(dvy.v, dy->v, vec_mul(dvz.v, dz->v)));
+
+  /* Includes the hubble flow term; not used for du/dt */
+  dvdr_Hubble.v = vec_fma(v_a2_Hubble.v, r2->v, dvdr.v);
+
+  /* Are the particles moving towards each others ? */
+  omega_ij.v = vec_fmin(dvdr_Hubble.v, vec_setzero());
+  mu_ij.v = vec_mul(v_fac_mu.v,
+                    vec_mul(ri.v, omega_ij.v)); /* This is 0 or negative */
+
+  /* Compute signal velocity */
+  v_sig.v = vec_mul(vec_set1(0.5f), vec_add(v_pi->v_sig.v, v_sig_j.v));
+
+  /* Construct the full viscosity term */
+  rho_ij.v = vec_add(v_pi->rho.v, pjrho.v);
+  alpha.v = vec_add(v_pi->alpha_visc.v, alpha_visc_j.v);
+  visc.v = vec_div(
+      vec_mul(vec_mul(vec_set1(-0.25f), vec_mul(alpha.v, v_sig.v)),
+              vec_mul(mu_ij.v, vec_add(v_pi->balsara.v, balsara_j.v))),
+      rho_ij.v);
+
+  /* Convolve with the kernel */
+  visc_acc_term.v = vec_mul(vec_mul(vec_set1(0.5f), visc.v),
+                            vec_mul(vec_add(wi_dr.v, wj_dr.v), ri.v));
+
+  /* SPH acceleration term */
+  u_fac.v = vec_mul(vec_set1(hydro_gamma_minus_one * hydro_gamma_minus_one),
+                    vec_mul(v_pi->u.v, uj.v));
+  f_over_P_i.v = vec_div(f_ij.v, v_pi->pressure_bar.v);
+  f_over_P_j.v = vec_div(f_ji.v, pressure_bar_j.v);
+  sph_acc_term.v =
+      vec_mul(vec_mul(u_fac.v, vec_fma(f_over_P_i.v, wi_dr.v,
+                                       vec_mul(f_over_P_j.v, wj_dr.v))),
+              ri.v);
+
+  /* Assemble the acceleration */
+  acc.v = vec_add(sph_acc_term.v, visc_acc_term.v);
+
+  /* Use the force Luke ! */
+  piax.v = vec_mul(mj.v, vec_mul(dx->v, acc.v));
+  piay.v = vec_mul(mj.v, vec_mul(dy->v, acc.v));
+  piaz.v = vec_mul(mj.v, vec_mul(dz->v, acc.v));
+
+  /* Get the time derivative for u. */
+  sph_du_term_i.v = vec_mul(vec_mul(u_fac.v, f_over_P_i.v),
+                            vec_mul(vec_mul(wi_dr.v, dvdr.v), ri.v));
+
+  /* Viscosity term */
+  visc_du_term.v =
+      vec_mul(vec_mul(vec_set1(0.5f), visc_acc_term.v), dvdr_Hubble.v);
+
+  /* Diffusion term */
+  v_diff.v =
+      vec_fmax(vec_add(vec_add(v_pi->c.v, cj.v), mu_ij.v), vec_setzero());
+  alpha_diff.v =
+      vec_mul(vec_set1(0.5f), vec_add(v_pi->alpha_diff.v, alpha_diff_j.v));
+  diff_du_term.v = vec_div(
+      vec_mul(vec_mul(vec_mul(alpha_diff.v, v_fac_mu.v), v_diff.v),
+              vec_mul(vec_sub(v_pi->u.v, uj.v), vec_add(wi_dr.v, wj_dr.v))),
+      rho_ij.v);
+
+  /* Assemble the energy equation term */
+  du_dt_i.v =
+      vec_add(vec_add(sph_du_term_i.v, visc_du_term.v), diff_du_term.v);
+
+  /* Get the time derivative for h. */
+  pih_dt.v =
+      vec_div(vec_mul(mj.v, vec_mul(dvdr.v, vec_mul(ri.v, wi_dr.v))), pjrho.v);
+
+  /* Only the neighbours that are not inhibited enter the time-step limiter */
+  mask_t mask_time_bin;
+  vec_create_mask(mask_time_bin, vec_cmp_gt(time_bin_j.v, vec_setzero()));
+  vec_combine_masks(mask_time_bin, mask);
+
+  /* Store the forces back on the particles. */
+  sums->a_hydro_x.v = vec_mask_sub(sums->a_hydro_x.v, piax.v, mask);
+  sums->a_hydro_y.v = vec_mask_sub(sums->a_hydro_y.v, piay.v, mask);
+  sums->a_hydro_z.v = vec_mask_sub(sums->a_hydro_z.v, piaz.v, mask);
+  sums->h_dt.v = vec_mask_sub(sums->h_dt.v, pih_dt.v, mask);
+  sums->u_dt.v = vec_mask_add(sums->u_dt.v, vec_mul(du_dt_i.v, mj.v), mask);
+  sums->min_ngb_time_bin.v = vec_fmin(
+      sums->min_ngb_time_bin.v,
+      vec_blend(mask_time_bin, sums->min_ngb_time_bin.v, time_bin_j.v));
+}
+
+#endif /* WITH_HYDRO_FORCE_VECTORIZATION */
+
 #endif /* SWIFT_ANARCHY_PU_HYDRO_IACT_H */
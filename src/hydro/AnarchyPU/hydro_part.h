@@ -254,4 +254,18 @@ struct part {
 
 } SWIFT_STRUCT_ALIGN;
 
+/* Fields gathered in the #cache by the vectorised force loop (see cache.h),
+ * only used when none of the extra physics handled by the scalar loops is. */
+#if defined(NONE_MHD) && !defined(ADAPTIVE_SOFTENING) &&       \
+    defined(CHEMISTRY_NONE) && defined(PRESSURE_FLOOR_NONE) && \
+    defined(SINK_NONE) && defined(RT_NONE)
+#define hydro_cache_force_fields(FIELD)      \
+  FIELD(pressure_bar, p->pressure_bar, 1.f)  \
+  FIELD(u, p->u, 1.f)                        \
+  FIELD(alpha_visc, p->viscosity.alpha, 1.f) \
+  FIELD(alpha_diff, p->diffusion.alpha, 1.f) \
+  FIELD(v_sig, p->viscosity.v_sig, 1.f)      \
+  FIELD(time_bin, p->time_bin, 0.f)
+#endif
+
 #endif /* SWIFT_ANARCHY_PU_HYDRO_PART_H */
@@ -1107,4 +1107,131 @@ runner_iact_nonsym_2_vec_force(
 
 #endif
 
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
+
+/**
+ * @brief Properties of the particle pi broadcast to all the lanes of the
+ * vectorised force loops.
+ */
+struct hydro_vec_force_pi {
+
+  /*! Velocity */
+  vector vx, vy, vz;
+
+  /*! Density, "grad h" term and pressure over density squared */
+  vector rho, grad_h, pOrho2;
+
+  /*! Balsara switch and sound speed */
+  vector balsara, c;
+};
+
+/**
+ * @brief Updates of the particle pi accumulated by the vectorised force loops.
+ */
+struct hydro_vec_force_sums {
+
+  /*! Hydro acceleration */
+  vector a_hydro_x, a_hydro_y, a_hydro_z;
+
+  /*! Time derivatives of the smoothing length and entropy */
+  vector h_dt, entropy_dt;
+
+  /*! Signal velocity */
+  vector v_sig;
+};
+
+/**
+ * @brief Broadcast the properties of a particle read in the #cache.
+ *
+ * @param v_pi (return) The broadcast properties.
+ * @param c The #cache.
+ * @param i The index of the particle in the cache.
+ */
+__attribute__((always_inline)) INLINE static void hydro_vec_force_read_pi(
+    struct hydro_vec_force_pi *restrict v_pi, const struct cache *restrict c,
+    const int i) {
+
+  v_pi->vx = vector_set1(c->vx[i]);
+  v_pi->vy = vector_set1(c->vy[i]);
+  v_pi->vz = vector_set1(c->vz[i]);
+  v_pi->rho = vector_set1(c->rho[i]);
+  v_pi->grad_h = vector_set1(c->grad_h[i]);
+  v_pi->pOrho2 = vector_set1(c->pOrho2[i]);
+  v_pi->balsara = vector_set1(c->balsara[i]);
+  v_pi->c = vector_set1(c->soundspeed[i]);
+}
+
+/**
+ * @brief Reset the force updates accumulated for a particle.
+ *
+ * @param sums (return) The accumulated updates.
+ * @param p The #part about to be updated.
+ */
+__attribute__((always_inline)) INLINE static void hydro_vec_force_init_sums(
+    struct hydro_vec_force_sums *restrict sums,
+    const struct part *restrict p) {
+
+  sums->a_hydro_x = vector_setzero();
+  sums->a_hydro_y = vector_setzero();
+  sums->a_hydro_z = vector_setzero();
+  sums->h_dt = vector_setzero();
+  sums->entropy_dt = vector_setzero();
+  sums->v_sig = vector_set1(p->force.v_sig);
+}
+
+/**
+ * @brief Reduce the accumulated force updates and add them to a particle.
+ *
+ * @param sums The accumulated updates.
+ * @param p The #part to update.
+ */
+__attribute__((always_inline)) INLINE static void hydro_vec_force_write_sums(
+    struct hydro_vec_force_sums *restrict sums, struct part *restrict p) {
+
+  VEC_HADD(sums->a_hydro_x, p->a_hydro[0]);
+  VEC_HADD(sums->a_hydro_y, p->a_hydro[1]);
+  VEC_HADD(sums->a_hydro_z, p->a_hydro[2]);
+  VEC_HADD(sums->h_dt, p->force.h_dt);
+  VEC_HADD(sums->entropy_dt, p->entropy_dt);
+  VEC_HMAX(sums->v_sig, p->force.v_sig);
+}
+
+/**
+ * @brief Force interaction of a particle with one vector of neighbours read
+ * in the #cache (non-symmetric vectorized version).
+ *
+ * @param r2 The squared distances.
+ * @param dx The x separations.
+ * @param dy The y separations.
+ * @param dz The z separations.
+ * @param v_pi The broadcast properties of pi.
+ * @param cj_cache The #cache of the neighbours.
+ * @param pjd The index of the first neighbour in the cache.
+ * @param hi_inv The inverse smoothing length of pi.
+ * @param hj_inv The inverse smoothing lengths of the neighbours.
+ * @param a Current scale factor.
+ * @param H Current Hubble parameter.
+ * @param sums (return) The accumulated updates of pi.
+ * @param mask The neighbours to interact with.
+ */
+__attribute__((always_inline)) INLINE static void
+runner_iact_nonsym_cache_vec_force(
+    vector *r2, vector *dx, vector *dy, vector *dz,
+    const struct hydro_vec_force_pi *restrict v_pi,
+    const struct cache *restrict cj_cache, const int pjd, vector hi_inv,
+    vector hj_inv, const float a, const float H,
+    struct hydro_vec_force_sums *restrict sums, mask_t mask) {
+
+  runner_iact_nonsym_1_vec_force(
+      r2, dx, dy, dz, v_pi->vx, v_pi->vy, v_pi->vz, v_pi->rho, v_pi->grad_h,
+      v_pi->pOrho2, v_pi->balsara, v_pi->c, &cj_cache->vx[pjd],
+      &cj_cache->vy[pjd], &cj_cache->vz[pjd], &cj_cache->rho[pjd],
+      &cj_cache->grad_h[pjd], &cj_cache->pOrho2[pjd], &cj_cache->balsara[pjd],
+      &cj_cache->soundspeed[pjd], &cj_cache->m[pjd], hi_inv, hj_inv, a, H,
+      &sums->a_hydro_x, &sums->a_hydro_y, &sums->a_hydro_z, &sums->h_dt,
+      &sums->v_sig, &sums->entropy_dt, mask);
+}
+
+#endif /* WITH_HYDRO_FORCE_VECTORIZATION */
+
 #endif /* SWIFT_GADGET2_HYDRO_IACT_H */
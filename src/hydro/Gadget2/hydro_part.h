@@ -228,4 +228,8 @@ struct part {
 
 } SWIFT_STRUCT_ALIGN;
 
+/* Fields gathered in the #cache by the vectorised force loops (see cache.h). */
+#define hydro_cache_force_fields(FIELD) \
+  FIELD(pOrho2, p->force.P_over_rho2, 1.f)
+
 #endif /* SWIFT_GADGET2_HYDRO_PART_H */
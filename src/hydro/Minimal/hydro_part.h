@@ -232,4 +232,18 @@ struct part {
 
 } SWIFT_STRUCT_ALIGN;
 
+/* Fields of the #part updated by the density loop and its ghost. They are
+ * the only ones sent by the rho communications (see part.h), the xv ones
+ * having already provided the rest of the foreign particles. */
+#define hydro_mpi_rho_fields(FIELD)                       \
+  FIELD(h, h)                                             \
+  FIELD(rho, rho)                                         \
+  FIELD(force, force)                                     \
+  FIELD(adaptive_softening_data, adaptive_softening_data) \
+  FIELD(mhd_data, mhd_data)                               \
+  FIELD(chemistry_data, chemistry_data)                   \
+  FIELD(rt_data, rt_data)                                 \
+  FIELD(rt_time_data, rt_time_data)                       \
+  FIELD(limiter_data, limiter_data)
+
 #endif /* SWIFT_MINIMAL_HYDRO_PART_H */
@@ -28,6 +28,7 @@
 
 #include "adaptive_softening_iact.h"
 #include "adiabatic_index.h"
+#include "cache.h"
 #include "hydro_parameters.h"
 #include "minmax.h"
 #include "signal_velocity.h"
@@ -179,6 +180,237 @@ __attribute__((always_inline)) INLINE static void runner_iact_nonsym_density(
 #endif
 }
 
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
+
+/**
+ * @brief Density interaction computed using 1 vector
+ * (non-symmetric vectorized version).
+ *
+ * The velocity divergence is accumulated in the same way as in
+ * runner_iact_nonsym_density() and stored in the viscosity sub-structure by
+ * the calling loop.
+ */
+__attribute__((always_inline)) INLINE static void
+runner_iact_nonsym_1_vec_density(vector *r2, vector *dx, vector *dy, vector *dz,
+                                 vector hi_inv, vector vix, vector viy,
+                                 vector viz, float *Vjx, float *Vjy, float *Vjz,
+                                 float *Mj, vector *rhoSum, vector *rho_dhSum,
+                                 vector *wcountSum, vector *wcount_dhSum,
+                                 vector *div_vSum, vector *curlvxSum,
+                                 vector *curlvySum, vector *curlvzSum,
+                                 mask_t mask) {
+
+  vector r, ri, ui, wi, wi_dx;
+  vector dvx, dvy, dvz;
+  vector dvdr;
+  vector curlvrx, curlvry, curlvrz;
+
+  /* Fill the vectors. */
+  const vector mj = vector_load(Mj);
+  const vector vjx = vector_load(Vjx);
+  const vector vjy = vector_load(Vjy);
+  const vector vjz = vector_load(Vjz);
+
+  /* Get the radius and inverse radius. */
+  ri = vec_reciprocal_sqrt(*r2);
+  r.v = vec_mul(r2->v, ri.v);
+
+  ui.v = vec_mul(r.v, hi_inv.v);
+
+  /* Calculate the kernel for two particles. */
+  kernel_deval_1_vec(&ui, &wi, &wi_dx);
+
+  /* Compute dv. */
+  dvx.v = vec_sub(vix.v, vjx.v);
+  dvy.v = vec_sub(viy.v, vjy.v);
+  dvz.v = vec_sub(viz.v, vjz.v);
+
+  /* Compute dv dot r */
+  dvdr.v = vec_fma(dvx.v, dx->v, vec_fma(dvy.v, dy->v, vec_mul(dvz.v, dz->v)));
+  dvdr.v = vec_mul(dvdr.v, ri.v);
+
+  /* Compute dv cross r */
+  curlvrx.v =
+      vec_fma(dvy.v, dz->v, vec_mul(vec_set1(-1.0f), vec_mul(dvz.v, dy->v)));
+  curlvry.v =
+      vec_fma(dvz.v, dx->v, vec_mul(vec_set1(-1.0f), vec_mul(dvx.v, dz->v)));
+  curlvrz.v =
+      vec_fma(dvx.v, dy->v, vec_mul(vec_set1(-1.0f), vec_mul(dvy.v, dx->v)));
+  curlvrx.v = vec_mul(curlvrx.v, ri.v);
+  curlvry.v = vec_mul(curlvry.v, ri.v);
+  curlvrz.v = vec_mul(curlvrz.v, ri.v);
+
+  vector wcount_dh_update;
+  wcount_dh_update.v =
+      vec_fma(vec_set1(hydro_dimension), wi.v, vec_mul(ui.v, wi_dx.v));
+
+  /* Mask updates to intermediate vector sums for particle pi. */
+  rhoSum->v = vec_mask_add(rhoSum->v, vec_mul(mj.v, wi.v), mask);
+  rho_dhSum->v =
+      vec_mask_sub(rho_dhSum->v, vec_mul(mj.v, wcount_dh_update.v), mask);
+  wcountSum->v = vec_mask_add(wcountSum->v, wi.v, mask);
+  wcount_dhSum->v = vec_mask_sub(wcount_dhSum->v, wcount_dh_update.v, mask);
+  div_vSum->v =
+      vec_mask_sub(div_vSum->v, vec_mul(mj.v, vec_mul(dvdr.v, wi_dx.v)), mask);
+  curlvxSum->v = vec_mask_add(curlvxSum->v,
+                              vec_mul(mj.v, vec_mul(curlvrx.v, wi_dx.v)), mask);
+  curlvySum->v = vec_mask_add(curlvySum->v,
+                              vec_mul(mj.v, vec_mul(curlvry.v, wi_dx.v)), mask);
+  curlvzSum->v = vec_mask_add(curlvzSum->v,
+                              vec_mul(mj.v, vec_mul(curlvrz.v, wi_dx.v)), mask);
+}
+
+/**
+ * @brief Density interaction computed using 2 interleaved vectors
+ * (non-symmetric vectorized version).
+ */
+__attribute__((always_inline)) INLINE static void
+runner_iact_nonsym_2_vec_density(float *R2, float *Dx, float *Dy, float *Dz,
+                                 vector hi_inv, vector vix, vector viy,
+                                 vector viz, float *Vjx, float *Vjy, float *Vjz,
+                                 float *Mj, vector *rhoSum, vector *rho_dhSum,
+                                 vector *wcountSum, vector *wcount_dhSum,
+                                 vector *div_vSum, vector *curlvxSum,
+                                 vector *curlvySum, vector *curlvzSum,
+                                 mask_t mask, mask_t mask2, int mask_cond) {
+
+  vector r, ri, ui, wi, wi_dx;
+  vector dvx, dvy, dvz;
+  vector dvdr;
+  vector curlvrx, curlvry, curlvrz;
+  vector r_2, ri2, ui2, wi2, wi_dx2;
+  vector dvx2, dvy2, dvz2;
+  vector dvdr2;
+  vector curlvrx2, curlvry2, curlvrz2;
+
+  /* Fill the vectors. */
+  const vector mj = vector_load(Mj);
+  const vector mj2 = vector_load(&Mj[VEC_SIZE]);
+  const vector vjx = vector_load(Vjx);
+  const vector vjx2 = vector_load(&Vjx[VEC_SIZE]);
+  const vector vjy = vector_load(Vjy);
+  const vector vjy2 = vector_load(&Vjy[VEC_SIZE]);
+  const vector vjz = vector_load(Vjz);
+  const vector vjz2 = vector_load(&Vjz[VEC_SIZE]);
+  const vector dx = vector_load(Dx);
+  const vector dx2 = vector_load(&Dx[VEC_SIZE]);
+  const vector dy = vector_load(Dy);
+  const vector dy2 = vector_load(&Dy[VEC_SIZE]);
+  const vector dz = vector_load(Dz);
+  const vector dz2 = vector_load(&Dz[VEC_SIZE]);
+
+  /* Get the radius and inverse radius. */
+  const vector r2 = vector_load(R2);
+  const vector r2_2 = vector_load(&R2[VEC_SIZE]);
+  ri = vec_reciprocal_sqrt(r2);
+  ri2 = vec_reciprocal_sqrt(r2_2);
+  r.v = vec_mul(r2.v, ri.v);
+  r_2.v = vec_mul(r2_2.v, ri2.v);
+
+  ui.v = vec_mul(r.v, hi_inv.v);
+  ui2.v = vec_mul(r_2.v, hi_inv.v);
+
+  /* Calculate the kernel for two particles. */
+  kernel_deval_2_vec(&ui, &wi, &wi_dx, &ui2, &wi2, &wi_dx2);
+
+  /* Compute dv. */
+  dvx.v = vec_sub(vix.v, vjx.v);
+  dvx2.v = vec_sub(vix.v, vjx2.v);
+  dvy.v = vec_sub(viy.v, vjy.v);
+  dvy2.v = vec_sub(viy.v, vjy2.v);
+  dvz.v = vec_sub(viz.v, vjz.v);
+  dvz2.v = vec_sub(viz.v, vjz2.v);
+
+  /* Compute dv dot r */
+  dvdr.v = vec_fma(dvx.v, dx.v, vec_fma(dvy.v, dy.v, vec_mul(dvz.v, dz.v)));
+  dvdr2.v =
+      vec_fma(dvx2.v, dx2.v, vec_fma(dvy2.v, dy2.v, vec_mul(dvz2.v, dz2.v)));
+  dvdr.v = vec_mul(dvdr.v, ri.v);
+  dvdr2.v = vec_mul(dvdr2.v, ri2.v);
+
+  /* Compute dv cross r */
+  curlvrx.v =
+      vec_fma(dvy.v, dz.v, vec_mul(vec_set1(-1.0f), vec_mul(dvz.v, dy.v)));
+  curlvrx2.v =
+      vec_fma(dvy2.v, dz2.v, vec_mul(vec_set1(-1.0f), vec_mul(dvz2.v, dy2.v)));
+  curlvry.v =
+      vec_fma(dvz.v, dx.v, vec_mul(vec_set1(-1.0f), vec_mul(dvx.v, dz.v)));
+  curlvry2.v =
+      vec_fma(dvz2.v, dx2.v, vec_mul(vec_set1(-1.0f), vec_mul(dvx2.v, dz2.v)));
+  curlvrz.v =
+      vec_fma(dvx.v, dy.v, vec_mul(vec_set1(-1.0f), vec_mul(dvy.v, dx.v)));
+  curlvrz2.v =
+      vec_fma(dvx2.v, dy2.v, vec_mul(vec_set1(-1.0f), vec_mul(dvy2.v, dx2.v)));
+  curlvrx.v = vec_mul(curlvrx.v, ri.v);
+  curlvrx2.v = vec_mul(curlvrx2.v, ri2.v);
+  curlvry.v = vec_mul(curlvry.v, ri.v);
+  curlvry2.v = vec_mul(curlvry2.v, ri2.v);
+  curlvrz.v = vec_mul(curlvrz.v, ri.v);
+  curlvrz2.v = vec_mul(curlvrz2.v, ri2.v);
+
+  vector wcount_dh_update, wcount_dh_update2;
+  wcount_dh_update.v =
+      vec_fma(vec_set1(hydro_dimension), wi.v, vec_mul(ui.v, wi_dx.v));
+  wcount_dh_update2.v =
+      vec_fma(vec_set1(hydro_dimension), wi2.v, vec_mul(ui2.v, wi_dx2.v));
+
+  /* Mask updates to intermediate vector sums for particle pi. */
+  /* Mask only when needed. */
+  if (mask_cond) {
+    rhoSum->v = vec_mask_add(rhoSum->v, vec_mul(mj.v, wi.v), mask);
+    rhoSum->v = vec_mask_add(rhoSum->v, vec_mul(mj2.v, wi2.v), mask2);
+    rho_dhSum->v =
+        vec_mask_sub(rho_dhSum->v, vec_mul(mj.v, wcount_dh_update.v), mask);
+    rho_dhSum->v =
+        vec_mask_sub(rho_dhSum->v, vec_mul(mj2.v, wcount_dh_update2.v), mask2);
+    wcountSum->v = vec_mask_add(wcountSum->v, wi.v, mask);
+    wcountSum->v = vec_mask_add(wcountSum->v, wi2.v, mask2);
+    wcount_dhSum->v = vec_mask_sub(wcount_dhSum->v, wcount_dh_update.v, mask);
+    wcount_dhSum->v = vec_mask_sub(wcount_dhSum->v, wcount_dh_update2.v, mask2);
+    div_vSum->v = vec_mask_sub(div_vSum->v,
+                               vec_mul(mj.v, vec_mul(dvdr.v, wi_dx.v)), mask);
+    div_vSum->v = vec_mask_sub(
+        div_vSum->v, vec_mul(mj2.v, vec_mul(dvdr2.v, wi_dx2.v)), mask2);
+    curlvxSum->v = vec_mask_add(
+        curlvxSum->v, vec_mul(mj.v, vec_mul(curlvrx.v, wi_dx.v)), mask);
+    curlvxSum->v = vec_mask_add(
+        curlvxSum->v, vec_mul(mj2.v, vec_mul(curlvrx2.v, wi_dx2.v)), mask2);
+    curlvySum->v = vec_mask_add(
+        curlvySum->v, vec_mul(mj.v, vec_mul(curlvry.v, wi_dx.v)), mask);
+    curlvySum->v = vec_mask_add(
+        curlvySum->v, vec_mul(mj2.v, vec_mul(curlvry2.v, wi_dx2.v)), mask2);
+    curlvzSum->v = vec_mask_add(
+        curlvzSum->v, vec_mul(mj.v, vec_mul(curlvrz.v, wi_dx.v)), mask);
+    curlvzSum->v = vec_mask_add(
+        curlvzSum->v, vec_mul(mj2.v, vec_mul(curlvrz2.v, wi_dx2.v)), mask2);
+  } else {
+    rhoSum->v = vec_add(rhoSum->v, vec_mul(mj.v, wi.v));
+    rhoSum->v = vec_add(rhoSum->v, vec_mul(mj2.v, wi2.v));
+    rho_dhSum->v = vec_sub(rho_dhSum->v, vec_mul(mj.v, wcount_dh_update.v));
+    rho_dhSum->v = vec_sub(rho_dhSum->v, vec_mul(mj2.v, wcount_dh_update2.v));
+    wcountSum->v = vec_add(wcountSum->v, wi.v);
+    wcountSum->v = vec_add(wcountSum->v, wi2.v);
+    wcount_dhSum->v = vec_sub(wcount_dhSum->v, wcount_dh_update.v);
+    wcount_dhSum->v = vec_sub(wcount_dhSum->v, wcount_dh_update2.v);
+    div_vSum->v = vec_sub(div_vSum->v, vec_mul(mj.v, vec_mul(dvdr.v, wi_dx.v)));
+    div_vSum->v =
+        vec_sub(div_vSum->v, vec_mul(mj2.v, vec_mul(dvdr2.v, wi_dx2.v)));
+    curlvxSum->v =
+        vec_add(curlvxSum->v, vec_mul(mj.v, vec_mul(curlvrx.v, wi_dx.v)));
+    curlvxSum->v =
+        vec_add(curlvxSum->v, vec_mul(mj2.v, vec_mul(curlvrx2.v, wi_dx2.v)));
+    curlvySum->v =
+        vec_add(curlvySum->v, vec_mul(mj.v, vec_mul(curlvry.v, wi_dx.v)));
+    curlvySum->v =
+        vec_add(curlvySum->v, vec_mul(mj2.v, vec_mul(curlvry2.v, wi_dx2.v)));
+    curlvzSum->v =
+        vec_add(curlvzSum->v, vec_mul(mj.v, vec_mul(curlvrz.v, wi_dx.v)));
+    curlvzSum->v =
+        vec_add(curlvzSum->v, vec_mul(mj2.v, vec_mul(curlvrz2.v, wi_dx2.v)));
+  }
+}
+#endif /* WITH_HYDRO_DENSITY_VECTORIZATION */
+
 /**
  * @brief Calculate the gradient interaction between particle i and particle j
  *
@@ -618,4 +850,291 @@ __attribute__((always_inline)) INLINE static void runner_iact_nonsym_force(
 #endif
 }
 
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
+
+/**
+ * @brief Properties of the particle pi broadcast to all the lanes of the
+ * vectorised force loops.
+ */
+struct hydro_vec_force_pi {
+
+  /*! Velocity */
+  vector vx, vy, vz;
+
+  /*! Density and "grad h" term */
+  vector rho, grad_h;
+
+  /*! Pressure, Balsara switch and sound speed */
+  vector pressure, balsara, c;
+
+  /*! Mass and internal energy */
+  vector m, u;
+
+  /*! Viscosity and diffusion coefficients */
+  vector alpha_visc, alpha_diff;
+};
+
+/**
+ * @brief Updates of the particle pi accumulated by the vectorised force loops.
+ */
+struct hydro_vec_force_sums {
+
+  /*! Hydro acceleration */
+  vector a_hydro_x, a_hydro_y, a_hydro_z;
+
+  /*! Time derivatives of the smoothing length and internal energy */
+  vector h_dt, u_dt;
+
+  /*! Smallest time-bin of the neighbours */
+  vector min_ngb_time_bin;
+};
+
+/**
+ * @brief Broadcast the properties of a particle read in the #cache.
+ *
+ * @param v_pi (return) The broadcast properties.
+ * @param c The #cache.
+ * @param i The index of the particle in the cache.
+ */
+__attribute__((always_inline)) INLINE static void hydro_vec_force_read_pi(
+    struct hydro_vec_force_pi* restrict v_pi, const struct cache* restrict c,
+    const int i) {
+
+  v_pi->vx = vector_set1(c->vx[i]);
+  v_pi->vy = vector_set1(c->vy[i]);
+  v_pi->vz = vector_set1(c->vz[i]);
+  v_pi->rho = vector_set1(c->rho[i]);
+  v_pi->grad_h = vector_set1(c->grad_h[i]);
+  v_pi->pressure = vector_set1(c->pressure[i]);
+  v_pi->balsara = vector_set1(c->balsara[i]);
+  v_pi->c = vector_set1(c->soundspeed[i]);
+  v_pi->m = vector_set1(c->m[i]);
+  v_pi->u = vector_set1(c->u[i]);
+  v_pi->alpha_visc = vector_set1(c->alpha_visc[i]);
+  v_pi->alpha_diff = vector_set1(c->alpha_diff[i]);
+}
+
+/**
+ * @brief Reset the force updates accumulated for a particle.
+ *
+ * @param sums (return) The accumulated updates.
+ * @param p The #part about to be updated.
+ */
+__attribute__((always_inline)) INLINE static void hydro_vec_force_init_sums(
+    struct hydro_vec_force_sums* restrict sums,
+    const struct part* restrict p) {
+
+  sums->a_hydro_x = vector_setzero();
+  sums->a_hydro_y = vector_setzero();
+  sums->a_hydro_z = vector_setzero();
+  sums->h_dt = vector_setzero();
+  sums->u_dt = vector_setzero();
+  sums->min_ngb_time_bin = vector_set1(p->limiter_data.min_ngb_time_bin);
+}
+
+/**
+ * @brief Reduce the accumulated force updates and add them to a particle.
+ *
+ * @param sums The accumulated updates.
+ * @param p The #part to update.
+ */
+__attribute__((always_inline)) INLINE static void hydro_vec_force_write_sums(
+    struct hydro_vec_force_sums* restrict sums, struct part* restrict p) {
+
+  VEC_HADD(sums->a_hydro_x, p->a_hydro[0]);
+  VEC_HADD(sums->a_hydro_y, p->a_hydro[1]);
+  VEC_HADD(sums->a_hydro_z, p->a_hydro[2]);
+  VEC_HADD(sums->h_dt, p->force.h_dt);
+  VEC_HADD(sums->u_dt, p->u_dt);
+
+  float min_ngb_time_bin = p->limiter_data.min_ngb_time_bin;
+  VEC_HMIN(sums->min_ngb_time_bin, min_ngb_time_bin);
+  p->limiter_data.min_ngb_time_bin = (timebin_t)min_ngb_time_bin;
+}
+
+/**
+ * @brief Force interaction of a particle with one vector of neighbours read
+ * in the #cache (non-symmetric vectorized version).
+ *
+ * Follows runner_iact_nonsym_force() term by term and also updates the
+ * minimal time-bin of the neighbours used by the time-step limiter.
+ *
+ * @param r2 The squared distances.
+ * @param dx The x separations.
+ * @param dy The y separations.
+ * @param dz The z separations.
+ * @param v_pi The broadcast properties of pi.
+ * @param cj_cache The #cache of the neighbours.
+ * @param pjd The index of the first neighbour in the cache.
+ * @param hi_inv The inverse smoothing length of pi.
+ * @param hj_inv The inverse smoothing lengths of the neighbours.
+ * @param a Current scale factor.
+ * @param H Current Hubble parameter.
+ * @param sums (return) The accumulated updates of pi.
+ * @param mask The neighbours to interact with.
+ */
+__attribute__((always_inline)) INLINE static void
+runner_iact_nonsym_cache_vec_force(
+    vector* r2, vector* dx, vector* dy, vector* dz,
+    const struct hydro_vec_force_pi* restrict v_pi,
+    const struct cache* restrict cj_cache, const int pjd, vector hi_inv,
+    vector hj_inv, const float a, const float H,
+    struct hydro_vec_force_sums* restrict sums, mask_t mask) {
+
+  vector r, ri;
+  vector dvx, dvy, dvz;
+  vector xi, xj;
+  vector hid_inv, hjd_inv;
+  vector wi_dx, wj_dx, wi_dr, wj_dr, dvdr, dvdr_Hubble;
+  vector piax, piay, piaz;
+  vector pih_dt;
+  vector v_sig, omega_ij, mu_ij, f_ij, f_ji;
+  vector rho_ij, alpha, visc, visc_acc_term, sph_acc_term, acc;
+  vector P_over_rho2_i, P_over_rho2_j;
+  vector sph_du_term_i, visc_du_term, alpha_diff, v_diff, diff_du_term;
+  vector du_dt_i;
+
+  /* Fill vectors. */
+  const vector vjx = vector_load(&cj_cache->vx[pjd]);
+  const vector vjy = vector_load(&cj_cache->vy[pjd]);
+  const vector vjz = vector_load(&cj_cache->vz[pjd]);
+  const vector mj = vector_load(&cj_cache->m[pjd]);
+  const vector pjrho = vector_load(&cj_cache->rho[pjd]);
+  const vector grad_hj = vector_load(&cj_cache->grad_h[pjd]);
+  const vector pressure_j = vector_load(&cj_cache->pressure[pjd]);
+  const vector balsara_j = vector_load(&cj_cache->balsara[pjd]);
+  const vector cj = vector_load(&cj_cache->soundspeed[pjd]);
+  const vector alpha_visc_j = vector_load(&cj_cache->alpha_visc[pjd]);
+  const vector alpha_diff_j = vector_load(&cj_cache->alpha_diff[pjd]);
+  const vector uj = vector_load(&cj_cache->u[pjd]);
+  const vector time_bin_j = vector_load(&cj_cache->time_bin[pjd]);
+
+  /* Cosmological terms */
+  const float fac_mu = pow_three_gamma_minus_five_over_two(a);
+  const float a2_Hubble = a * a * H;
+  const vector v_fac_mu = vector_set1(fac_mu);
+  const vector v_a2_Hubble = vector_set1(a2_Hubble);
+
+  /* Get the radius and inverse radius. */
+  ri = vec_reciprocal_sqrt(*r2);
+  r.v = vec_mul(r2->v, ri.v);
+
+  /* Get the kernel for hi. */
+  hid_inv = pow_dimension_plus_one_vec(hi_inv);
+  xi.v = vec_mul(r.v, hi_inv.v);
+  kernel_eval_dWdx_force_vec(&xi, &wi_dx);
+  wi_dr.v = vec_mul(hid_inv.v, wi_dx.v);
+
+  /* Get the kernel for hj. */
+  hjd_inv = pow_dimension_plus_one_vec(hj_inv);
+  xj.v = vec_mul(r.v, hj_inv.v);
+  kernel_eval_dWdx_force_vec(&xj, &wj_dx);
+  wj_dr.v = vec_mul(hjd_inv.v, wj_dx.v);
+
+  /* Compute dv. */
+  dvx.v = vec_sub(v_pi->vx.v, vjx.v);
+  dvy.v = vec_sub(v_pi->vy.v, vjy.v);
+  dvz.v = vec_sub(v_pi->vz.v, vjz.v);
+
+  /* Compute dv dot r. */
+  dvdr.v = vec_fma(dvx.v, dx->v, vec_fma(dvy.v, dy->v, vec_mul(dvz.v, dz->v)));
+
+  /* Includes the hubble flow term; not used for du/dt */
+  dvdr_Hubble.v = vec_fma(v_a2_Hubble.v, r2->v, dvdr.v);
+
+  /* Are the particles moving towards each others ? */
+  omega_ij.v = vec_fmin(dvdr_Hubble.v, vec_setzero());
+  mu_ij.v = vec_mul(v_fac_mu.v,
+                    vec_mul(ri.v, omega_ij.v)); /* This is 0 or negative */
+
+  /* Compute signal velocity */
+  v_sig.v = vec_fnma(vec_set1(const_viscosity_beta), mu_ij.v,
+                     vec_add(v_pi->c.v, cj.v));
+
+  /* Variable smoothing length term */
+  f_ij.v = vec_sub(vec_set1(1.f), vec_div(v_pi->grad_h.v, mj.v));
+  f_ji.v = vec_sub(vec_set1(1.f), vec_div(grad_hj.v, v_pi->m.v));
+
+  /* Construct the full viscosity term */
+  rho_ij.v = vec_add(v_pi->rho.v, pjrho.v);
+  alpha.v = vec_add(v_pi->alpha_visc.v, alpha_visc_j.v);
+  visc.v = vec_div(
+      vec_mul(vec_mul(vec_set1(-0.25f), vec_mul(alpha.v, v_sig.v)),
+              vec_mul(mu_ij.v, vec_add(v_pi->balsara.v, balsara_j.v))),
+      rho_ij.v);
+
+  /* Convolve with the kernel */
+  visc_acc_term.v = vec_mul(
+      vec_mul(vec_set1(0.5f), visc.v),
+      vec_mul(vec_fma(wi_dr.v, f_ij.v, vec_mul(wj_dr.v, f_ji.v)), ri.v));
+
+  /* Compute gradient terms */
+  P_over_rho2_i.v = vec_mul(
+      vec_div(v_pi->pressure.v, vec_mul(v_pi->rho.v, v_pi->rho.v)), f_ij.v);
+  P_over_rho2_j.v =
+      vec_mul(vec_div(pressure_j.v, vec_mul(pjrho.v, pjrho.v)), f_ji.v);
+
+  /* SPH acceleration term */
+  sph_acc_term.v = vec_mul(vec_fma(P_over_rho2_i.v, wi_dr.v,
+                                   vec_mul(P_over_rho2_j.v, wj_dr.v)),
+                           ri.v);
+
+  /* Assemble the acceleration */
+  acc.v = vec_add(sph_acc_term.v, visc_acc_term.v);
+
+  /* Use the force Luke ! */
+  piax.v = vec_mul(mj.v, vec_mul(dx->v, acc.v));
+  piay.v = vec_mul(mj.v, vec_mul(dy->v, acc.v));
+  piaz.v = vec_mul(mj.v, vec_mul(dz->v, acc.v));
+
+  /* Get the time derivative for u. */
+  sph_du_term_i.v =
+      vec_mul(vec_mul(P_over_rho2_i.v, dvdr.v), vec_mul(ri.v, wi_dr.v));
+
+  /* Viscosity term */
+  visc_du_term.v =
+      vec_mul(vec_mul(vec_set1(0.5f), visc_acc_term.v), dvdr_Hubble.v);
+
+  /* Diffusion term */
+  alpha_diff.v = vec_div(vec_fma(v_pi->pressure.v, v_pi->alpha_diff.v,
+                                 vec_mul(pressure_j.v, alpha_diff_j.v)),
+                         vec_add(v_pi->pressure.v, pressure_j.v));
+  v_diff.v = vec_mul(
+      vec_mul(alpha_diff.v, vec_set1(0.5f)),
+      vec_add(vec_sqrt(vec_div(
+                  vec_mul(vec_set1(2.f),
+                          vec_fabs(vec_sub(v_pi->pressure.v, pressure_j.v))),
+                  rho_ij.v)),
+              vec_fabs(vec_mul(v_fac_mu.v, vec_mul(ri.v, dvdr_Hubble.v)))));
+  diff_du_term.v =
+      vec_mul(vec_mul(v_diff.v, vec_sub(v_pi->u.v, uj.v)),
+              vec_add(vec_div(vec_mul(f_ij.v, wi_dr.v), v_pi->rho.v),
+                      vec_div(vec_mul(f_ji.v, wj_dr.v), pjrho.v)));
+
+  /* Assemble the energy equation term */
+  du_dt_i.v =
+      vec_add(vec_add(sph_du_term_i.v, visc_du_term.v), diff_du_term.v);
+
+  /* Get the time derivative for h. */
+  pih_dt.v =
+      vec_div(vec_mul(mj.v, vec_mul(dvdr.v, vec_mul(ri.v, wi_dr.v))), pjrho.v);
+
+  /* Only the neighbours that are not inhibited enter the time-step limiter */
+  mask_t mask_time_bin;
+  vec_create_mask(mask_time_bin, vec_cmp_gt(time_bin_j.v, vec_setzero()));
+  vec_combine_masks(mask_time_bin, mask);
+
+  /* Store the forces back on the particles. */
+  sums->a_hydro_x.v = vec_mask_sub(sums->a_hydro_x.v, piax.v, mask);
+  sums->a_hydro_y.v = vec_mask_sub(sums->a_hydro_y.v, piay.v, mask);
+  sums->a_hydro_z.v = vec_mask_sub(sums->a_hydro_z.v, piaz.v, mask);
+  sums->h_dt.v = vec_mask_sub(sums->h_dt.v, pih_dt.v, mask);
+  sums->u_dt.v = vec_mask_add(sums->u_dt.v, vec_mul(du_dt_i.v, mj.v), mask);
+  sums->min_ngb_time_bin.v = vec_fmin(
+      sums->min_ngb_time_bin.v,
+      vec_blend(mask_time_bin, sums->min_ngb_time_bin.v, time_bin_j.v));
+}
+
+#endif /* WITH_HYDRO_FORCE_VECTORIZATION */
+
 #endif /* SWIFT_SPHENIX_HYDRO_IACT_H */
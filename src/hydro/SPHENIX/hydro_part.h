@@ -312,4 +312,45 @@ struct part {
 
 } SWIFT_STRUCT_ALIGN;
 
+/* Fields gathered in the #cache by the vectorised force loops (see cache.h).
+ * These loops skip the MHD, adaptive softening and sub-grid interactions, so
+ * the scalar loops are kept when any of them is switched on. */
+#if defined(NONE_MHD) && !defined(ADAPTIVE_SOFTENING) &&       \
+    defined(CHEMISTRY_NONE) && defined(PRESSURE_FLOOR_NONE) && \
+    defined(SINK_NONE) && defined(RT_NONE)
+#define hydro_cache_force_fields(FIELD)      \
+  FIELD(pressure, p->force.pressure, 1.f)    \
+  FIELD(alpha_visc, p->viscosity.alpha, 1.f) \
+  FIELD(alpha_diff, p->diffusion.alpha, 1.f) \
+  FIELD(u, p->u, 1.f)                        \
+  FIELD(time_bin, p->time_bin, 0.f)
+#endif
+
+/* Fields of the #part updated by the density loop and its ghost, and by the
+ * gradient loop and the extra ghost. They are the only ones sent by the rho
+ * and gradient communications (see part.h), the xv ones having already
+ * provided the rest of the foreign particles. */
+#define hydro_mpi_rho_fields(FIELD)                       \
+  FIELD(h, h)                                             \
+  FIELD(rho, rho)                                         \
+  FIELD(viscosity, viscosity)                             \
+  FIELD(diffusion, diffusion)                             \
+  FIELD(force, force)                                     \
+  FIELD(adaptive_softening_data, adaptive_softening_data) \
+  FIELD(mhd_data, mhd_data)                               \
+  FIELD(chemistry_data, chemistry_data)                   \
+  FIELD(pressure_floor_data, pressure_floor_data)         \
+  FIELD(rt_data, rt_data)                                 \
+  FIELD(rt_time_data, rt_time_data)                       \
+  FIELD(limiter_data, limiter_data)
+
+#define hydro_mpi_gradient_fields(FIELD) \
+  FIELD(viscosity, viscosity)            \
+  FIELD(diffusion, diffusion)            \
+  FIELD(force, force)                    \
+  FIELD(mhd_data, mhd_data)              \
+  FIELD(rt_data, rt_data)                \
+  FIELD(rt_time_data, rt_time_data)      \
+  FIELD(limiter_data, limiter_data)
+
 #endif /* SWIFT_SPHENIX_HYDRO_PART_H */
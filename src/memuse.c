@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -47,6 +48,7 @@
 #include "clocks.h"
 #include "engine.h"
 #include "error.h"
+#include "lock.h"
 #include "memuse_rnodes.h"
 
 #ifdef SWIFT_MEMUSE_REPORTS
@@ -457,6 +459,68 @@ void memuse_log_dump_error(int rank) {
 
 #endif /* SWIFT_MEMUSE_REPORTS */
 
+/* Maximum number of regions mapped from files at any time. */
+#define MEMUSE_MAXMAPPED 16
+
+/* The regions mapped from files, see memuse_mapped_register(). */
+static struct {
+  void *ptr;
+  size_t size;
+} memuse_mapped[MEMUSE_MAXMAPPED];
+volatile int memuse_nr_mapped = 0;
+static swift_lock_type memuse_mapped_lock = lock_static_initializer;
+
+/**
+ * @brief Register a region of memory mapped using mmap() so that it is
+ *        unmapped, rather than freed, when passed to swift_free().
+ *
+ * @param ptr the start of the mapped region.
+ * @param size the size of the mapped region in bytes.
+ */
+void memuse_mapped_register(void *ptr, size_t size) {
+
+  if (lock_lock(&memuse_mapped_lock) != 0) error("Failed to lock.");
+
+  int ind = 0;
+  while (ind < MEMUSE_MAXMAPPED && memuse_mapped[ind].ptr != NULL) ind++;
+  if (ind == MEMUSE_MAXMAPPED) error("Too many memory mapped regions.");
+
+  memuse_mapped[ind].ptr = ptr;
+  memuse_mapped[ind].size = size;
+  memuse_nr_mapped++;
+
+  if (lock_unlock(&memuse_mapped_lock) != 0) error("Failed to unlock.");
+}
+
+/**
+ * @brief Unmap a region registered with memuse_mapped_register().
+ *
+ * @param ptr the start of the region.
+ * @result 1 if the region was found and unmapped, 0 otherwise.
+ */
+int memuse_mapped_release(void *ptr) {
+
+  if (ptr == NULL) return 0;
+
+  if (lock_lock(&memuse_mapped_lock) != 0) error("Failed to lock.");
+
+  int found = 0;
+  for (int ind = 0; ind < MEMUSE_MAXMAPPED; ind++) {
+    if (memuse_mapped[ind].ptr == ptr) {
+      if (munmap(ptr, memuse_mapped[ind].size) != 0)
+        error("Failed to unmap memory region.");
+      memuse_mapped[ind].ptr = NULL;
+      memuse_mapped[ind].size = 0;
+      memuse_nr_mapped--;
+      found = 1;
+      break;
+    }
+  }
+
+  if (lock_unlock(&memuse_mapped_lock) != 0) error("Failed to unlock.");
+  return found;
+}
+
 /**
  * @brief parse the process /proc/self/statm file to get the process
  *        memory use (in KB). Top field in (). If this file is not
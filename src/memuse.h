@@ -30,6 +30,11 @@ void memuse_use(long *size, long *resident, long *shared, long *text,
                 long *data, long *library, long *dirty);
 const char *memuse_process(int inmb);
 
+/* Regions mapped from files that swift_free() must unmap. */
+extern volatile int memuse_nr_mapped;
+void memuse_mapped_register(void *ptr, size_t size);
+int memuse_mapped_release(void *ptr);
+
 #ifdef SWIFT_MEMUSE_REPORTS
 void memuse_log_dump(const char *filename);
 void memuse_log_dump_error(int rank);
@@ -190,6 +195,8 @@ __attribute__((always_inline)) inline void swift_free(const char *label,
 #ifdef SWIFT_MEMUSE_REPORTS
   memuse_log_allocation(label, ptr, 0, 0);
 #endif
+  /* Memory mapped from a restart file is not from the heap. */
+  if (memuse_nr_mapped > 0 && memuse_mapped_release(ptr)) return;
   free(ptr);
   return;
 }
@@ -39,6 +39,7 @@
 #include "kernel_long_gravity.h"
 #include "mesh_gravity_mpi.h"
 #include "mesh_gravity_patch.h"
+#include "mesh_gravity_pencil.h"
 #include "neutrino.h"
 #include "part.h"
 #include "restart.h"
@@ -101,27 +102,27 @@ __attribute__((always_inline, const)) INLINE static double CIC_get(
  * @param value The value to interpolate.
  */
 __attribute__((always_inline)) INLINE static void CIC_set(
-    double* mesh, const int N, const int i, const int j, const int k,
+    mesh_real* mesh, const int N, const int i, const int j, const int k,
     const double tx, const double ty, const double tz, const double dx,
     const double dy, const double dz, const double value) {
 
   /* Classic CIC interpolation */
-  atomic_add_d(&mesh[row_major_id_periodic(i + 0, j + 0, k + 0, N)],
-               value * tx * ty * tz);
-  atomic_add_d(&mesh[row_major_id_periodic(i + 0, j + 0, k + 1, N)],
-               value * tx * ty * dz);
-  atomic_add_d(&mesh[row_major_id_periodic(i + 0, j + 1, k + 0, N)],
-               value * tx * dy * tz);
-  atomic_add_d(&mesh[row_major_id_periodic(i + 0, j + 1, k + 1, N)],
-               value * tx * dy * dz);
-  atomic_add_d(&mesh[row_major_id_periodic(i + 1, j + 0, k + 0, N)],
-               value * dx * ty * tz);
-  atomic_add_d(&mesh[row_major_id_periodic(i + 1, j + 0, k + 1, N)],
-               value * dx * ty * dz);
-  atomic_add_d(&mesh[row_major_id_periodic(i + 1, j + 1, k + 0, N)],
-               value * dx * dy * tz);
-  atomic_add_d(&mesh[row_major_id_periodic(i + 1, j + 1, k + 1, N)],
-               value * dx * dy * dz);
+  atomic_add_mesh(&mesh[row_major_id_periodic(i + 0, j + 0, k + 0, N)],
+                  value * tx * ty * tz);
+  atomic_add_mesh(&mesh[row_major_id_periodic(i + 0, j + 0, k + 1, N)],
+                  value * tx * ty * dz);
+  atomic_add_mesh(&mesh[row_major_id_periodic(i + 0, j + 1, k + 0, N)],
+                  value * tx * dy * tz);
+  atomic_add_mesh(&mesh[row_major_id_periodic(i + 0, j + 1, k + 1, N)],
+                  value * tx * dy * dz);
+  atomic_add_mesh(&mesh[row_major_id_periodic(i + 1, j + 0, k + 0, N)],
+                  value * dx * ty * tz);
+  atomic_add_mesh(&mesh[row_major_id_periodic(i + 1, j + 0, k + 1, N)],
+                  value * dx * ty * dz);
+  atomic_add_mesh(&mesh[row_major_id_periodic(i + 1, j + 1, k + 0, N)],
+                  value * dx * dy * tz);
+  atomic_add_mesh(&mesh[row_major_id_periodic(i + 1, j + 1, k + 1, N)],
+                  value * dx * dy * dz);
 }
 
 /**
@@ -134,7 +135,7 @@ __attribute__((always_inline)) INLINE static void CIC_set(
  * @param dim The dimensions of the simulation box.
  * @param nu_model Struct with neutrino constants
  */
-INLINE static void gpart_to_mesh_CIC(const struct gpart* gp, double* rho,
+INLINE static void gpart_to_mesh_CIC(const struct gpart* gp, mesh_real* rho,
                                      const int N, const double fac,
                                      const double dim[3],
                                      const struct neutrino_model* nu_model) {
@@ -192,7 +193,7 @@ INLINE static void gpart_to_mesh_CIC(const struct gpart* gp, double* rho,
  * @param dim The dimensions of the simulation box.
  * @param nu_model Struct with neutrino constants
  */
-void cell_gpart_to_mesh_CIC(const struct cell* c, double* rho, const int N,
+void cell_gpart_to_mesh_CIC(const struct cell* c, mesh_real* rho, const int N,
                             const double fac, const double dim[3],
                             const struct neutrino_model* nu_model) {
 
@@ -212,8 +213,8 @@ void cell_gpart_to_mesh_CIC(const struct cell* c, double* rho, const int N,
  */
 struct cic_mapper_data {
   const struct cell* cells;
-  double* rho;
-  double* potential;
+  mesh_real* rho;
+  mesh_real* potential;
   int N;
   int use_local_patches;
   double fac;
@@ -225,7 +226,7 @@ struct cic_mapper_data {
 void gpart_to_mesh_CIC_mapper(void* map_data, int num, void* extra) {
 
   const struct cic_mapper_data* data = (struct cic_mapper_data*)extra;
-  double* rho = data->rho;
+  mesh_real* rho = data->rho;
   const int N = data->N;
   const double fac = data->fac;
   const double dim[3] = {data->dim[0], data->dim[1], data->dim[2]};
@@ -252,7 +253,7 @@ void cell_gpart_to_mesh_CIC_mapper(void* map_data, int num, void* extra) {
   /* Unpack the shared information */
   const struct cic_mapper_data* data = (struct cic_mapper_data*)extra;
   const struct cell* cells = data->cells;
-  double* rho = data->rho;
+  mesh_real* rho = data->rho;
   const int N = data->N;
   const double fac = data->fac;
   const double dim[3] = {data->dim[0], data->dim[1], data->dim[2]};
@@ -293,6 +294,163 @@ void cell_gpart_to_mesh_CIC_mapper(void* map_data, int num, void* extra) {
   }
 }
 
+/**
+ * @brief Colour of a top-level cell for the deposit of its patch onto the
+ * global mesh.
+ *
+ * Along each axis, the cells get alternating colours 0 and 1, and the last
+ * cell gets a colour 2 if the number of cells is odd, such that two distinct
+ * cells of the same colour are never neighbours, including through the
+ * periodic boundaries. If all the patches lie within half a cell of their
+ * cell, patches of the same colour can hence not overlap.
+ *
+ * @param s The #space.
+ * @param c The top-level #cell.
+ * @param patch The #pm_mesh_patch of the cell.
+ * @param fac The inverse of the mesh cell size.
+ * @return The colour in [0, 27[ or -1 if the patch extends too far beyond the
+ * cell.
+ */
+static int mesh_patch_colour(const struct space* s, const struct cell* c,
+                             const struct pm_mesh_patch* patch,
+                             const double fac) {
+
+  int colour = 0;
+  for (int d = 0; d < 3; d++) {
+
+    const double width = s->width[d];
+    const int cdim = s->cdim[d];
+    const int ind = (int)(c->loc[d] * s->iwidth[d] + 0.5);
+
+    /* Is the patch within half a cell of its cell? */
+    if (patch->mesh_min[d] <= (int)floor((c->loc[d] - 0.5 * width) * fac) ||
+        patch->mesh_max[d] >= (int)floor((c->loc[d] + 1.5 * width) * fac))
+      return -1;
+
+    const int colour_d = (cdim % 2 == 1 && ind == cdim - 1) ? 2 : ind % 2;
+    colour = 3 * colour + colour_d;
+  }
+  return colour;
+}
+
+/**
+ * @brief Shared information for the deposit of the patches of one colour.
+ */
+struct patch_colour_mapper_data {
+  mesh_real* rho;
+  const struct pm_mesh_patch* patches;
+};
+
+/**
+ * @brief Threadpool mapper function adding patches of the same colour to the
+ * global mesh.
+ *
+ * @param map_data A chunk of the list of patch indices.
+ * @param num The number of patches in the chunk.
+ * @param extra The #patch_colour_mapper_data.
+ */
+void patch_to_mesh_colour_mapper(void* map_data, int num, void* extra) {
+
+  const struct patch_colour_mapper_data* data =
+      (struct patch_colour_mapper_data*)extra;
+  const int* patch_ids = (int*)map_data;
+
+  for (int i = 0; i < num; ++i)
+    pm_add_patch_to_global_mesh_no_atomics(data->rho,
+                                           &data->patches[patch_ids[i]]);
+}
+
+/**
+ * @brief Assigns the #gpart of all the local top-level cells to the global
+ * density mesh without any atomic operation.
+ *
+ * The cells are first all accumulated onto their own patch in parallel. The
+ * patches are then added to the mesh one colour at a time (see
+ * mesh_patch_colour()), such that the threads never write to the same
+ * elements. The rare patches extending too far beyond their cell are added
+ * serially at the end.
+ *
+ * @param rho The density mesh.
+ * @param N the size of the mesh along one axis.
+ * @param fac The width of a mesh cell.
+ * @param s The #space containing the particles.
+ * @param tp The #threadpool object used for parallelisation.
+ * @param verbose Are we talkative?
+ */
+static void mesh_coloured_deposit(mesh_real* rho, const int N, const double fac,
+                                  const struct space* s, struct threadpool* tp,
+                                  const int verbose) {
+
+  const int* local_cells = s->local_cells_top;
+  const int nr_local_cells = s->nr_local_cells;
+  const int nr_colours = 27;
+
+  ticks tic = getticks();
+
+  /* Accumulate each cell onto its own patch */
+  struct pm_mesh_patch* patches = (struct pm_mesh_patch*)malloc(
+      nr_local_cells * sizeof(struct pm_mesh_patch));
+  if (patches == NULL) error("Failed to allocate array of mesh patches!");
+  memset(patches, 0, nr_local_cells * sizeof(struct pm_mesh_patch));
+  mpi_mesh_accumulate_gparts_to_local_patches(tp, N, fac, s, patches);
+
+  if (verbose)
+    message("Accumulating the patches took %.3f %s.",
+            clocks_from_ticks(getticks() - tic), clocks_getunit());
+
+  tic = getticks();
+
+  /* Sort the patches by colour, the last bin being for the patches that
+   * have to be added serially */
+  int* colours = (int*)malloc(nr_local_cells * sizeof(int));
+  int* patch_ids = (int*)malloc(nr_local_cells * sizeof(int));
+  if (colours == NULL || patch_ids == NULL)
+    error("Failed to allocate patch colours!");
+  int offsets[nr_colours + 2];
+  bzero(offsets, sizeof(offsets));
+  for (int i = 0; i < nr_local_cells; ++i) {
+    const struct cell* c = &s->cells_top[local_cells[i]];
+    if (patches[i].mesh == NULL) {
+      colours[i] = -1;
+      continue;
+    }
+    const int colour = mesh_patch_colour(s, c, &patches[i], fac);
+    colours[i] = colour >= 0 ? colour : nr_colours;
+    offsets[colours[i] + 1]++;
+  }
+  for (int k = 0; k <= nr_colours; ++k) offsets[k + 1] += offsets[k];
+  int fill[nr_colours + 1];
+  memcpy(fill, offsets, sizeof(fill));
+  for (int i = 0; i < nr_local_cells; ++i)
+    if (colours[i] >= 0) patch_ids[fill[colours[i]]++] = i;
+
+  /* Add the patches to the mesh, one colour at a time */
+  struct patch_colour_mapper_data data;
+  data.rho = rho;
+  data.patches = patches;
+  for (int k = 0; k < nr_colours; ++k) {
+    const int count = offsets[k + 1] - offsets[k];
+    if (count == 0) continue;
+    threadpool_map(tp, patch_to_mesh_colour_mapper, patch_ids + offsets[k],
+                   count, sizeof(int), /*chunk=*/1, (void*)&data);
+  }
+
+  /* And the remaining ones */
+  const int nr_serial = offsets[nr_colours + 1] - offsets[nr_colours];
+  for (int i = offsets[nr_colours]; i < offsets[nr_colours + 1]; ++i)
+    pm_add_patch_to_global_mesh_no_atomics(rho, &patches[patch_ids[i]]);
+
+  if (verbose)
+    message("Adding the patches by colour took %.3f %s (%d added serially).",
+            clocks_from_ticks(getticks() - tic), clocks_getunit(), nr_serial);
+
+  /* Clean-up the mess */
+  for (int i = 0; i < nr_local_cells; ++i) pm_mesh_patch_clean(&patches[i]);
+  free(patches);
+  free(colours);
+  free(patch_ids);
+}
+
 /**
  * @brief Computes the potential on a gpart from a given mesh using the CIC
  * method.
@@ -305,7 +463,7 @@ void cell_gpart_to_mesh_CIC_mapper(void* map_data, int num, void* extra) {
  * @param fac width of a mesh cell.
  * @param dim The dimensions of the simulation box.
  */
-void mesh_to_gpart_CIC(struct gpart* gp, const double* pot, const int N,
+void mesh_to_gpart_CIC(struct gpart* gp, const mesh_real* pot, const int N,
                        const double fac, const double dim[3]) {
 
   /* Box wrap the gpart's position */
@@ -393,7 +551,7 @@ void mesh_to_gpart_CIC(struct gpart* gp, const double* pot, const int N,
   gravity_add_comoving_mesh_potential(gp, p);
 }
 
-void cell_mesh_to_gpart_CIC(const struct cell* c, const double* potential,
+void cell_mesh_to_gpart_CIC(const struct cell* c, const mesh_real* potential,
                             const int N, const double fac, const float const_G,
                             const double dim[3]) {
 
@@ -429,7 +587,7 @@ void mesh_to_gpart_CIC_mapper(void* map_data, int num, void* extra) {
 
   /* Unpack the shared information */
   const struct cic_mapper_data* data = (struct cic_mapper_data*)extra;
-  const double* const potential = data->potential;
+  const mesh_real* const potential = data->potential;
   const int N = data->N;
   const double fac = data->fac;
   const double dim[3] = {data->dim[0], data->dim[1], data->dim[2]};
@@ -474,7 +632,7 @@ void cell_mesh_to_gpart_CIC_mapper(void* map_data, int num, void* extra) {
   /* Unpack the shared information */
   const struct cic_mapper_data* data = (struct cic_mapper_data*)extra;
   const struct cell* cells = data->cells;
-  const double* const potential = data->potential;
+  const mesh_real* const potential = data->potential;
   const int N = data->N;
   const double fac = data->fac;
   const double dim[3] = {data->dim[0], data->dim[1], data->dim[2]};
@@ -501,19 +659,19 @@ void cell_mesh_to_gpart_CIC_mapper(void* map_data, int num, void* extra) {
 struct Green_function_data {
 
   int N;
-  fftw_complex* frho;
+  mesh_complex* frho;
   double green_fac;
   double a_smooth2;
   double k_fac;
-  int slice_offset;
-  int slice_width;
+  int offset[3];
+  int width[3];
 };
 
 /**
  * @brief Mapper function for the application of the Green function.
  *
  * @param map_data The array of the density field Fourier transform.
- * @param num The number of elements to iterate on (along the x-axis).
+ * @param num The number of elements to iterate on (along the first axis).
  * @param extra The properties of the Green function.
  */
 void mesh_apply_Green_function_mapper(void* map_data, const int num,
@@ -522,7 +680,7 @@ void mesh_apply_Green_function_mapper(void* map_data, const int num,
   struct Green_function_data* data = (struct Green_function_data*)extra;
 
   /* Unpack the array */
-  fftw_complex* const frho = data->frho;
+  mesh_complex* const frho = data->frho;
   const int N = data->N;
   const int N_half = N / 2;
 
@@ -531,14 +689,15 @@ void mesh_apply_Green_function_mapper(void* map_data, const int num,
   const double a_smooth2 = data->a_smooth2;
   const double k_fac = data->k_fac;
 
-  /* Find what slice of the full mesh is stored on this MPI rank */
-  const int slice_offset = data->slice_offset;
+  /* Find what block of the full mesh is stored on this MPI rank */
+  const int offset[3] = {data->offset[0], data->offset[1], data->offset[2]};
+  const int width[3] = {data->width[0], data->width[1], data->width[2]};
 
-  /* Range of x coordinates in the full mesh handled by this call */
-  const int i_start = ((fftw_complex*)map_data - frho) + slice_offset;
+  /* Range of coordinates along the first axis handled by this call */
+  const int i_start = ((mesh_complex*)map_data - frho) + offset[0];
   const int i_end = i_start + num;
 
-  /* Loop over the x range corresponding to this thread */
+  /* Loop over the range of the first axis corresponding to this thread */
   for (int i = i_start; i < i_end; ++i) {
 
     /* kx component of vector in Fourier space and 1/sinc(kx) */
@@ -547,7 +706,7 @@ void mesh_apply_Green_function_mapper(void* map_data, const int num,
     const double fx = k_fac * kx_d;
     const double sinc_kx_inv = (kx != 0) ? fx / sin(fx) : 1.;
 
-    for (int j = 0; j < N; ++j) {
+    for (int j = offset[1]; j < offset[1] + width[1]; ++j) {
 
       /* ky component of vector in Fourier space and 1/sinc(ky) */
       const int ky = (j > N_half ? j - N : j);
@@ -555,7 +714,7 @@ void mesh_apply_Green_function_mapper(void* map_data, const int num,
       const double fy = k_fac * ky_d;
       const double sinc_ky_inv = (ky != 0) ? fy / sin(fy) : 1.;
 
-      for (int k = 0; k < N_half + 1; ++k) {
+      for (int k = offset[2]; k < offset[2] + width[2]; ++k) {
 
         /* kz component of vector in Fourier space and 1/sinc(kz) */
         const int kz = (k > N_half ? k - N : k);
@@ -583,8 +742,9 @@ void mesh_apply_Green_function_mapper(void* map_data, const int num,
         const double total_cor = green_cor * CIC_cor4;
 
         /* Apply to the mesh */
-        const int index =
-            N * (N_half + 1) * (i - slice_offset) + (N_half + 1) * j + k;
+        const size_t index =
+            ((size_t)(i - offset[0]) * width[1] + (j - offset[1])) * width[2] +
+            (k - offset[2]);
         frho[index][0] *= total_cor;
         frho[index][1] *= total_cor;
       }
@@ -598,18 +758,22 @@ void mesh_apply_Green_function_mapper(void* map_data, const int num,
  *
  * Also deconvolves the CIC kernel.
  *
+ * The local modes are stored in row-major order over the three axes of a
+ * block of the NxNx(N/2+1) array. The Green function only depends on |k|, so
+ * the axes can be given in any order, e.g. [ky][kz][kx] for the pencils.
+ *
  * @param tp The threadpool.
- * @param frho The NxNx(N/2) complex array of the Fourier transform of the
- * density field.
- * @param slice_offset The x coordinate of the start of the slice on this MPI
- * rank
- * @param slice_width The width of the local slice on this MPI rank
+ * @param frho The local block of the complex array of the Fourier transform
+ * of the density field.
+ * @param offset The first index along each axis of the block on this MPI
+ * rank.
+ * @param width The width along each axis of the block on this MPI rank.
  * @param N The dimension of the array.
  * @param r_s The Green function smoothing scale.
  * @param box_size The physical size of the simulation box.
  */
-void mesh_apply_Green_function(struct threadpool* tp, fftw_complex* frho,
-                               const int slice_offset, const int slice_width,
+void mesh_apply_Green_function(struct threadpool* tp, mesh_complex* frho,
+                               const int offset[3], const int width[3],
                                const int N, const double r_s,
                                const double box_size) {
 
@@ -620,18 +784,21 @@ void mesh_apply_Green_function(struct threadpool* tp, fftw_complex* frho,
   data.green_fac = -1. / (M_PI * box_size);
   data.a_smooth2 = 4. * M_PI * M_PI * r_s * r_s / (box_size * box_size);
   data.k_fac = M_PI / (double)N;
-  data.slice_offset = slice_offset;
-  data.slice_width = slice_width;
+  for (int i = 0; i < 3; i++) {
+    data.offset[i] = offset[i];
+    data.width[i] = width[i];
+  }
 
   /* Parallelize the Green function application using the threadpool
-     to split the x-axis loop over the threads.
-     The array is N x N x (N/2). We use the thread to each deal with
-     a range [i_min, i_max[ x N x (N/2) */
-  threadpool_map(tp, mesh_apply_Green_function_mapper, frho, slice_width,
-                 sizeof(fftw_complex), threadpool_auto_chunk_size, &data);
+     to split the loop over the first axis over the threads.
+     We use the thread to each deal with a range
+     [i_min, i_max[ x width[1] x width[2] */
+  threadpool_map(tp, mesh_apply_Green_function_mapper, frho, width[0],
+                 sizeof(mesh_complex), threadpool_auto_chunk_size, &data);
 
   /* Correct singularity at (0,0,0) */
-  if (slice_offset == 0 && slice_width > 0) {
+  if (offset[0] == 0 && offset[1] == 0 && offset[2] == 0 && width[0] > 0 &&
+      width[1] > 0 && width[2] > 0) {
     frho[0][0] = 0.;
     frho[0][1] = 0.;
   }
@@ -648,7 +815,8 @@ void mesh_apply_Green_function(struct threadpool* tp, fftw_complex* frho,
  *
  * The potential is stored as a hashmap containing the potential mesh cells
  * which will be needed on this MPI rank. This is stored in
- * mesh->potential_local. The FFTW MPI library is used to do the FFTs.
+ * mesh->potential_local. The FFTs use either the slabs of the FFTW MPI
+ * library or our own pencil decomposition (see mesh_gravity_pencil.h).
  *
  * The particles mesh accelerations and potentials are also updated.
  *
@@ -660,7 +828,7 @@ void mesh_apply_Green_function(struct threadpool* tp, fftw_complex* frho,
 void compute_potential_distributed(struct pm_mesh* mesh, const struct space* s,
                                    struct threadpool* tp, const int verbose) {
 
-#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+#if defined(WITH_MPI) && defined(HAVE_FFTW)
 
   const double r_s = mesh->r_s;
   const double box_size = s->dim[0];
@@ -694,36 +862,79 @@ void compute_potential_distributed(struct pm_mesh* mesh, const struct space* s,
 
   tic = getticks();
 
-  /* Ask FFTW what slice of the density field we need to store on this task.
-     Note that fftw_mpi_local_size_3d works in terms of the size of the complex
-     output. The last dimension of the real input is padded to 2*(N/2+1). */
-  ptrdiff_t local_n0, local_0_start;
-  ptrdiff_t nalloc =
-      fftw_mpi_local_size_3d((ptrdiff_t)N, (ptrdiff_t)N, (ptrdiff_t)(N / 2 + 1),
-                             MPI_COMM_WORLD, &local_n0, &local_0_start);
-  if (verbose)
-    message("Local density field slice has thickness %d.", (int)local_n0);
+  /* Work out what part of the density field we need to store on this task,
+   * in real and in Fourier space */
+  struct pm_mesh_decomposition slabs;
+  const struct pm_mesh_decomposition* decomp = NULL;
+  size_t nr_real = 0, nr_complex = 0;
+  int fourier_offset[3] = {0, 0, 0};
+  int fourier_width[3] = {0, 0, 0};
+
+  if (mesh->pencils != NULL) {
+
+    /* Our own pencil decomposition. Each MPI rank has a block of the x and y
+     * axes in real space and of the ky and kz axes in Fourier space. The
+     * local Fourier transform is stored as [ky][kz][kx]. */
+    const struct pm_mesh_pencils* pencils = mesh->pencils;
+    decomp = &pencils->decomp;
+    nr_real = pencils->local_real_size;
+    nr_complex = pencils->local_complex_size;
+    fourier_offset[0] = pencils->ky_offset;
+    fourier_offset[1] = pencils->kz_offset;
+    fourier_width[0] = pencils->ky_width;
+    fourier_width[1] = pencils->kz_width;
+    fourier_width[2] = N;
+
+    if (verbose)
+      message("Local density field pencil has size %d x %d.", pencils->nx,
+              pencils->ny);
+
+  } else {
+#ifdef HAVE_MPI_FFTW
+
+    /* Ask FFTW what slice of the density field we need to store on this
+       task. Note that fftw_mpi_local_size_3d works in terms of the size of
+       the complex output. The last dimension of the real input is padded to
+       2*(N/2+1). */
+    ptrdiff_t local_n0, local_0_start;
+    ptrdiff_t nalloc = mesh_fftw(mpi_local_size_3d)(
+        (ptrdiff_t)N, (ptrdiff_t)N, (ptrdiff_t)(N / 2 + 1), MPI_COMM_WORLD,
+        &local_n0, &local_0_start);
+    pm_mesh_decomposition_init_slabs(&slabs, N, (int)local_n0);
+    decomp = &slabs;
+    nr_real = 2 * nalloc;
+    nr_complex = nalloc;
+
+    /* The first two dimensions of the transform are transposed in the output
+     * and each MPI rank has slice of thickness local_n0 starting at
+     * local_0_start in the first dimension. */
+    fourier_offset[0] = local_0_start;
+    fourier_width[0] = local_n0;
+    fourier_width[1] = N;
+    fourier_width[2] = N / 2 + 1;
+
+    if (verbose)
+      message("Local density field slice has thickness %d.", (int)local_n0);
+#else
+    error("No FFTW MPI library available. Use a pencil-decomposed mesh.");
+#endif
+  }
   if (verbose)
     message("local patch size = %d, local mesh cells = %lld", nr_local_cells,
-            (long long)(local_n0 * N * N));
-  if (verbose)
-    message("Planning the FFT took %.3f %s.",
-            clocks_from_ticks(getticks() - tic), clocks_getunit());
+            (long long)(nr_real / (2 * (N / 2 + 1)) * N));
 
-  /* Allocate storage for mesh slices.
-   *
-   * Note: nalloc is the number of *complex* values.
-   */
-  double* rho_slice = (double*)fftw_malloc(2 * nalloc * sizeof(double));
-  memset(rho_slice, 0, 2 * nalloc * sizeof(double));
+  /* Allocate storage for mesh slices. */
+  mesh_real* rho_slice =
+      (mesh_real*)mesh_fftw(malloc)(nr_real * sizeof(mesh_real));
+  memset(rho_slice, 0, nr_real * sizeof(mesh_real));
 
   tic = getticks();
 
   /* Construct density field slices from contributions stored in the local
    * patches.
    * Note: This cleans up the local_patches entries. */
-  mpi_mesh_local_patches_to_slices(N, (int)local_n0, local_patches,
-                                   nr_local_cells, rho_slice, tp, verbose);
+  mpi_mesh_local_patches_to_slices(decomp, local_patches, nr_local_cells,
+                                   rho_slice, tp, verbose);
   if (verbose)
     message("Assembling mesh slices took %.3f %s.",
             clocks_from_ticks(getticks() - tic), clocks_getunit());
@@ -731,26 +942,25 @@ void compute_potential_distributed(struct pm_mesh* mesh, const struct space* s,
   tic = getticks();
 
   /* Allocate storage for the slices of the FFT of the density mesh */
-  fftw_complex* frho_slice =
-      (fftw_complex*)fftw_malloc(nalloc * sizeof(fftw_complex));
-
-  /* Carry out the MPI Fourier transform. We can save a bit of time
-   * if we allow FFTW to transpose the first two dimensions of the output.
-   *
-   * Layout of the MPI FFTW input and output:
-   *
-   * Input mesh contains N*N*N reals, padded to N*N*(2*(N/2+1)).
-   * Output Fourier transform is N*N*(N/2+1) complex values.
-   *
-   * The first two dimensions of the transform are transposed in
-   * the output. Each MPI rank has slice of thickness local_n0
-   * starting at local_0_start in the first dimension.
-   */
-  fftw_plan mpi_plan = fftw_mpi_plan_dft_r2c_3d(
-      N, N, N, rho_slice, frho_slice, MPI_COMM_WORLD,
-      FFTW_ESTIMATE | FFTW_MPI_TRANSPOSED_OUT | FFTW_DESTROY_INPUT);
-  fftw_execute(mpi_plan);
-  fftw_destroy_plan(mpi_plan);
+  mesh_complex* frho_slice =
+      (mesh_complex*)mesh_fftw(malloc)(nr_complex * sizeof(mesh_complex));
+
+  /* Carry out the MPI Fourier transform. The plans were made in
+   * pm_mesh_init() on arrays of the same size. */
+  if (mesh->pencils != NULL) {
+    pm_mesh_pencils_forward(mesh->pencils, rho_slice, frho_slice);
+  } else {
+#ifdef HAVE_MPI_FFTW
+    /* Layout of the MPI FFTW input and output:
+     *
+     * Input mesh contains N*N*N reals, padded to N*N*(2*(N/2+1)).
+     * Output Fourier transform is N*N*(N/2+1) complex values.
+     *
+     * We can save a bit of time if we allow FFTW to transpose the first two
+     * dimensions of the output. */
+    mesh_fftw(mpi_execute_dft_r2c)(mesh->forward_plan, rho_slice, frho_slice);
+#endif
+  }
   if (verbose)
     message("MPI Forward Fourier transform took %.3f %s.",
             clocks_from_ticks(getticks() - tic), clocks_getunit());
@@ -758,8 +968,8 @@ void compute_potential_distributed(struct pm_mesh* mesh, const struct space* s,
   tic = getticks();
 
   /* Apply Green function to local slice of the MPI mesh */
-  mesh_apply_Green_function(tp, frho_slice, local_0_start, local_n0, N, r_s,
-                            box_size);
+  mesh_apply_Green_function(tp, frho_slice, fourier_offset, fourier_width, N,
+                            r_s, box_size);
   if (verbose)
     message("Applying Green function took %.3f %s.",
             clocks_from_ticks(getticks() - tic), clocks_getunit());
@@ -768,8 +978,8 @@ void compute_potential_distributed(struct pm_mesh* mesh, const struct space* s,
 
   /* If using linear response neutrinos, apply to local slice of the MPI mesh */
   if (s->e->neutrino_properties->use_linear_response) {
-    neutrino_response_compute(s, mesh, tp, frho_slice, local_0_start, local_n0,
-                              verbose);
+    neutrino_response_compute(s, mesh, tp, frho_slice, fourier_offset,
+                              fourier_width, verbose);
 
     if (verbose)
       message("Applying neutrino response took %.3f %s.",
@@ -779,31 +989,34 @@ void compute_potential_distributed(struct pm_mesh* mesh, const struct space* s,
   }
 
   /* Carry out the reverse MPI Fourier transform */
-  fftw_plan mpi_inverse_plan = fftw_mpi_plan_dft_c2r_3d(
-      N, N, N, frho_slice, rho_slice, MPI_COMM_WORLD,
-      FFTW_ESTIMATE | FFTW_MPI_TRANSPOSED_IN | FFTW_DESTROY_INPUT);
-  fftw_execute(mpi_inverse_plan);
-  fftw_destroy_plan(mpi_inverse_plan);
+  if (mesh->pencils != NULL) {
+    pm_mesh_pencils_inverse(mesh->pencils, frho_slice, rho_slice);
+  } else {
+#ifdef HAVE_MPI_FFTW
+    mesh_fftw(mpi_execute_dft_c2r)(mesh->inverse_plan, frho_slice, rho_slice);
+#endif
+  }
 
   if (verbose)
     message("MPI Reverse Fourier transform took %.3f %s.",
             clocks_from_ticks(getticks() - tic), clocks_getunit());
 
   /* We can now free the Fourier-space data */
-  fftw_free(frho_slice);
+  mesh_fftw(free)(frho_slice);
 
   tic = getticks();
 
   /* Fetch MPI mesh entries we need on this rank from other ranks */
-  mpi_mesh_fetch_potential(N, cell_fac, s, local_0_start, local_n0, rho_slice,
-                           local_patches, tp, verbose);
+  mpi_mesh_fetch_potential(N, cell_fac, s, decomp, rho_slice, local_patches,
+                           tp, verbose);
 
   if (verbose)
     message("Fetching local potential took %.3f %s.",
             clocks_from_ticks(getticks() - tic), clocks_getunit());
 
   /* Free the local slice of the potential */
-  fftw_free(rho_slice);
+  mesh_fftw(free)(rho_slice);
+  if (decomp == &slabs) pm_mesh_decomposition_clean(&slabs);
 
   tic = getticks();
 
@@ -820,7 +1033,7 @@ void compute_potential_distributed(struct pm_mesh* mesh, const struct space* s,
             clocks_from_ticks(getticks() - tic), clocks_getunit());
 
 #else
-  error("No FFTW MPI library available. Cannot compute distributed mesh.");
+  error("No MPI or FFTW library available. Cannot compute distributed mesh.");
 #endif
 }
 
@@ -863,27 +1076,21 @@ void compute_potential_global(struct pm_mesh* mesh, const struct space* s,
   const double cell_fac = N / box_size;
 
   /* Use the memory allocated for the potential to temporarily store rho */
-  double* restrict rho = mesh->potential_global;
+  mesh_real* restrict rho = mesh->potential_global;
   if (rho == NULL) error("Error allocating memory for density mesh");
 
   /* Allocates some memory for the mesh in Fourier space */
-  fftw_complex* restrict frho =
-      (fftw_complex*)fftw_malloc(sizeof(fftw_complex) * N * N * (N_half + 1));
+  mesh_complex* restrict frho = (mesh_complex*)mesh_fftw(malloc)(
+      sizeof(mesh_complex) * N * N * (N_half + 1));
   if (frho == NULL)
     error("Error allocating memory for transform of density mesh");
   memuse_log_allocation("fftw_frho", frho, 1,
-                        sizeof(fftw_complex) * N * N * (N_half + 1));
-
-  /* Prepare the FFT library */
-  fftw_plan forward_plan = fftw_plan_dft_r2c_3d(
-      N, N, N, rho, frho, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
-  fftw_plan inverse_plan = fftw_plan_dft_c2r_3d(
-      N, N, N, frho, rho, FFTW_ESTIMATE | FFTW_DESTROY_INPUT);
+                        sizeof(mesh_complex) * N * N * (N_half + 1));
 
   ticks tic = getticks();
 
   /* Zero everything */
-  bzero(rho, N * N * N * sizeof(double));
+  bzero(rho, N * N * N * sizeof(mesh_real));
 
   /* Gather some neutrino constants if using delta-f weighting on the mesh */
   struct neutrino_model nu_model;
@@ -913,6 +1120,12 @@ void compute_potential_global(struct pm_mesh* mesh, const struct space* s,
                    sizeof(struct gpart), threadpool_auto_chunk_size,
                    (void*)&data);
 
+  } else if (mesh->use_coloured_deposit) {
+
+    /* Accumulate the local top-level cells onto patches and add them to the
+     * mesh by colours, without atomics */
+    mesh_coloured_deposit(rho, N, cell_fac, s, tp, verbose);
+
   } else { /* Normal case */
 
     /* Do a parallel CIC mesh assignment of the gparts but only using
@@ -923,7 +1136,11 @@ void compute_potential_global(struct pm_mesh* mesh, const struct space* s,
   }
 
   if (verbose)
-    message("Gpart assignment took %.3f %s.",
+    message("Gpart assignment (%s) took %.3f %s.",
+            nr_local_cells == 0           ? "atomic, no cells"
+            : mesh->use_coloured_deposit ? "coloured patches"
+            : mesh->use_local_patches    ? "local patches"
+                                         : "atomic",
             clocks_from_ticks(getticks() - tic), clocks_getunit());
 
 #ifdef WITH_MPI
@@ -932,7 +1149,7 @@ void compute_potential_global(struct pm_mesh* mesh, const struct space* s,
   tic = getticks();
 
   /* Merge everybody's share of the density mesh */
-  MPI_Allreduce(MPI_IN_PLACE, rho, N * N * N, MPI_DOUBLE, MPI_SUM,
+  MPI_Allreduce(MPI_IN_PLACE, rho, N * N * N, mesh_mpi_real, MPI_SUM,
                 MPI_COMM_WORLD);
 
   if (verbose)
@@ -946,7 +1163,7 @@ void compute_potential_global(struct pm_mesh* mesh, const struct space* s,
   tic = getticks();
 
   /* Fourier transform to go to magic-land */
-  fftw_execute(forward_plan);
+  mesh_fftw(execute_dft_r2c)(mesh->forward_plan, rho, frho);
 
   if (verbose)
     message("Forward Fourier transform took %.3f %s.",
@@ -957,8 +1174,12 @@ void compute_potential_global(struct pm_mesh* mesh, const struct space* s,
 
   tic = getticks();
 
+  /* frho holds the whole mesh */
+  const int fourier_offset[3] = {0, 0, 0};
+  const int fourier_width[3] = {N, N, N / 2 + 1};
+
   /* Now de-convolve the CIC kernel and apply the Green function */
-  mesh_apply_Green_function(tp, frho, /*slice_offset=*/0, /*slice_width=*/N,
+  mesh_apply_Green_function(tp, frho, fourier_offset, fourier_width,
                             /* mesh_size=*/N, r_s, box_size);
 
   if (verbose)
@@ -969,8 +1190,8 @@ void compute_potential_global(struct pm_mesh* mesh, const struct space* s,
 
   /* If using linear response neutrinos, apply the response to the mesh */
   if (s->e->neutrino_properties->use_linear_response) {
-    neutrino_response_compute(s, mesh, tp, frho, /*slice_offset=*/0,
-                              /*slice_width=*/N, verbose);
+    neutrino_response_compute(s, mesh, tp, frho, fourier_offset,
+                              fourier_width, verbose);
 
     if (verbose)
       message("Applying neutrino response took %.3f %s.",
@@ -980,7 +1201,7 @@ void compute_potential_global(struct pm_mesh* mesh, const struct space* s,
   }
 
   /* Fourier transform to come back from magic-land */
-  fftw_execute(inverse_plan);
+  mesh_fftw(execute_dft_c2r)(mesh->inverse_plan, frho, rho);
 
   if (verbose)
     message("Reverse Fourier transform took %.3f %s.",
@@ -1030,10 +1251,8 @@ void compute_potential_global(struct pm_mesh* mesh, const struct space* s,
             clocks_from_ticks(getticks() - tic), clocks_getunit());
 
   /* Clean-up the mess */
-  fftw_destroy_plan(forward_plan);
-  fftw_destroy_plan(inverse_plan);
   memuse_log_allocation("fftw_frho", frho, 0, 0);
-  fftw_free(frho);
+  mesh_fftw(free)(frho);
 
 #else
   error("No FFTW library found. Cannot compute periodic long-range forces.");
@@ -1079,11 +1298,12 @@ void pm_mesh_allocate(struct pm_mesh* mesh) {
     const int N = mesh->N;
 
     /* Allocate the memory for the combined density and potential array */
-    mesh->potential_global = (double*)fftw_malloc(sizeof(double) * N * N * N);
+    mesh->potential_global =
+        (mesh_real*)mesh_fftw(malloc)(sizeof(mesh_real) * N * N * N);
     if (mesh->potential_global == NULL)
       error("Error allocating memory for the long-range gravity mesh.");
     memuse_log_allocation("fftw_mesh.potential", mesh->potential_global, 1,
-                          sizeof(double) * N * N * N);
+                          sizeof(mesh_real) * N * N * N);
   }
 #else
   error("No FFTW library found. Cannot compute periodic long-range forces.");
@@ -1119,18 +1339,146 @@ void initialise_fftw(int N, int nr_threads) {
 
 #ifdef HAVE_THREADED_FFTW
   /* Initialise the thread-parallel FFTW version */
-  if (N >= 64) fftw_init_threads();
+  if (N >= 64) mesh_fftw(init_threads)();
 #endif
 #if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
   /* Initialize FFTW MPI support - must be called after fftw_init_threads() */
-  fftw_mpi_init();
+  mesh_fftw(mpi_init)();
 #endif
 #ifdef HAVE_THREADED_FFTW
   /* Set  number of threads to use */
-  if (N >= 64) fftw_plan_with_nthreads(nr_threads);
+  if (N >= 64) mesh_fftw(plan_with_nthreads)(nr_threads);
 #endif
 }
 
+#ifdef HAVE_FFTW
+
+/**
+ * @brief FFTW planner flags corresponding to the planning rigour of a mesh.
+ *
+ * @param mesh The #pm_mesh.
+ */
+static unsigned int pm_mesh_fftw_flags(const struct pm_mesh* mesh) {
+
+  switch (mesh->fftw_planning) {
+    case 0:
+      return FFTW_ESTIMATE;
+    case 2:
+      return FFTW_PATIENT;
+    case 3:
+      return FFTW_EXHAUSTIVE;
+    default:
+      return FFTW_MEASURE;
+  }
+}
+
+/**
+ * @brief Creates the FFTW plans of the mesh.
+ *
+ * The plans are made once on arrays of the same sizes and alignment as those
+ * used at each step, which are then passed to the new-array execute
+ * functions. The wisdom of previous runs is read from the wisdom file, if
+ * any, and the file is updated with the new plans.
+ *
+ * Must be called after pm_mesh_allocate() by all the ranks.
+ *
+ * @param mesh The #pm_mesh.
+ */
+static void pm_mesh_make_plans(struct pm_mesh* mesh) {
+
+  const int N = mesh->N;
+  const unsigned int flags = pm_mesh_fftw_flags(mesh) | FFTW_DESTROY_INPUT;
+  const int use_wisdom = mesh->fftw_wisdom_file[0] != '\0';
+  const ticks tic = getticks();
+
+  /* Start from what we learned in previous runs */
+  if (use_wisdom) {
+#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+    if (engine_rank == 0)
+      mesh_fftw(import_wisdom_from_filename)(mesh->fftw_wisdom_file);
+    mesh_fftw(mpi_broadcast_wisdom)(MPI_COMM_WORLD);
+#else
+    mesh_fftw(import_wisdom_from_filename)(mesh->fftw_wisdom_file);
+#endif
+  }
+
+  if (mesh->distributed_mesh && mesh->use_pencils) {
+#ifdef WITH_MPI
+
+    /* The 1D transforms of our own pencil decomposition */
+    mesh->pencils =
+        (struct pm_mesh_pencils*)malloc(sizeof(struct pm_mesh_pencils));
+    if (mesh->pencils == NULL)
+      error("Error allocating memory for the pencil decomposition");
+    pm_mesh_pencils_init(mesh->pencils, N, flags);
+
+#else
+    error("No MPI library available. Cannot compute distributed mesh.");
+#endif
+  } else if (mesh->distributed_mesh) {
+#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+
+    /* Temporary slices of the same size as the ones used at each step */
+    ptrdiff_t local_n0, local_0_start;
+    const ptrdiff_t nalloc = mesh_fftw(mpi_local_size_3d)(
+        (ptrdiff_t)N, (ptrdiff_t)N, (ptrdiff_t)(N / 2 + 1), MPI_COMM_WORLD,
+        &local_n0, &local_0_start);
+    mesh_real* rho_slice =
+        (mesh_real*)mesh_fftw(malloc)(2 * nalloc * sizeof(mesh_real));
+    mesh_complex* frho_slice =
+        (mesh_complex*)mesh_fftw(malloc)(nalloc * sizeof(mesh_complex));
+    if (rho_slice == NULL || frho_slice == NULL)
+      error("Error allocating memory to plan the mesh FFTs");
+
+    mesh->forward_plan = mesh_fftw(mpi_plan_dft_r2c_3d)(
+        N, N, N, rho_slice, frho_slice, MPI_COMM_WORLD,
+        flags | FFTW_MPI_TRANSPOSED_OUT);
+    mesh->inverse_plan = mesh_fftw(mpi_plan_dft_c2r_3d)(
+        N, N, N, frho_slice, rho_slice, MPI_COMM_WORLD,
+        flags | FFTW_MPI_TRANSPOSED_IN);
+
+    mesh_fftw(free)(rho_slice);
+    mesh_fftw(free)(frho_slice);
+#else
+    error("No FFTW MPI library available. Cannot compute distributed mesh.");
+#endif
+  } else {
+
+    /* Plan on the potential and a temporary transform array */
+    mesh_complex* frho = (mesh_complex*)mesh_fftw(malloc)(
+        sizeof(mesh_complex) * N * N * (N / 2 + 1));
+    if (frho == NULL) error("Error allocating memory to plan the mesh FFTs");
+
+    mesh->forward_plan = mesh_fftw(plan_dft_r2c_3d)(
+        N, N, N, mesh->potential_global, frho, flags);
+    mesh->inverse_plan = mesh_fftw(plan_dft_c2r_3d)(
+        N, N, N, frho, mesh->potential_global, flags);
+
+    mesh_fftw(free)(frho);
+  }
+
+  if (mesh->pencils == NULL &&
+      (mesh->forward_plan == NULL || mesh->inverse_plan == NULL))
+    error("Failed to plan the mesh FFTs.");
+
+  /* Save the wisdom for the next runs */
+  if (use_wisdom) {
+#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+    mesh_fftw(mpi_gather_wisdom)(MPI_COMM_WORLD);
+#endif
+    if (engine_rank == 0 &&
+        !mesh_fftw(export_wisdom_to_filename)(mesh->fftw_wisdom_file))
+      message("WARNING: Could not write the FFTW wisdom to '%s'.",
+              mesh->fftw_wisdom_file);
+  }
+
+  if (engine_rank == 0)
+    message("Planning the mesh FFTs took %.3f %s.",
+            clocks_from_ticks(getticks() - tic), clocks_getunit());
+}
+
+#endif /* HAVE_FFTW */
+
 /**
  * @brief Initialises the mesh used for the long-range periodic forces
  *
@@ -1138,9 +1486,11 @@ void initialise_fftw(int N, int nr_threads) {
  * @param props The propoerties of the gravity scheme.
  * @param dim The (comoving) side-lengths of the simulation volume.
  * @param nr_threads The number of threads on this MPI rank.
+ * @param wisdom_file File in which to keep the FFTW wisdom, NULL for none.
  */
 void pm_mesh_init(struct pm_mesh* mesh, const struct gravity_props* props,
-                  const double dim[3], int nr_threads) {
+                  const double dim[3], int nr_threads,
+                  const char* wisdom_file) {
 
 #ifdef HAVE_FFTW
 
@@ -1154,7 +1504,10 @@ void pm_mesh_init(struct pm_mesh* mesh, const struct gravity_props* props,
   mesh->periodic = 1;
   mesh->N = N;
   mesh->distributed_mesh = props->distributed_mesh;
+  mesh->use_pencils = props->distributed_mesh_pencils;
+  mesh->pencils = NULL;
   mesh->use_local_patches = props->mesh_uses_local_patches;
+  mesh->use_coloured_deposit = props->mesh_uses_coloured_deposit;
   mesh->dim[0] = dim[0];
   mesh->dim[1] = dim[1];
   mesh->dim[2] = dim[2];
@@ -1168,6 +1521,13 @@ void pm_mesh_init(struct pm_mesh* mesh, const struct gravity_props* props,
   mesh->ti_end_mesh_last = -1;
   mesh->ti_beg_mesh_next = -1;
   mesh->ti_end_mesh_next = -1;
+  mesh->fftw_planning = props->mesh_fftw_planning;
+  if (wisdom_file != NULL) {
+    if (snprintf(mesh->fftw_wisdom_file, PARSER_MAX_LINE_SIZE, "%s",
+                 wisdom_file) >= PARSER_MAX_LINE_SIZE)
+      error("FFTW wisdom file name too long: %s", wisdom_file);
+  } else
+    mesh->fftw_wisdom_file[0] = '\0';
 
   if (!mesh->distributed_mesh && mesh->N > 1290)
     error(
@@ -1180,6 +1540,7 @@ void pm_mesh_init(struct pm_mesh* mesh, const struct gravity_props* props,
   initialise_fftw(N, mesh->nr_threads);
 
   pm_mesh_allocate(mesh);
+  pm_mesh_make_plans(mesh);
 
 #else
   error("No FFTW library found. Cannot compute periodic long-range forces.");
@@ -1219,11 +1580,24 @@ void pm_mesh_init_no_mesh(struct pm_mesh* mesh, double dim[3]) {
  */
 void pm_mesh_clean(struct pm_mesh* mesh) {
 
+#ifdef HAVE_FFTW
+  if (mesh->forward_plan != NULL) mesh_fftw(destroy_plan)(mesh->forward_plan);
+  if (mesh->inverse_plan != NULL) mesh_fftw(destroy_plan)(mesh->inverse_plan);
+  mesh->forward_plan = NULL;
+  mesh->inverse_plan = NULL;
+#ifdef WITH_MPI
+  if (mesh->pencils != NULL) {
+    pm_mesh_pencils_clean(mesh->pencils);
+    free(mesh->pencils);
+    mesh->pencils = NULL;
+  }
+#endif
+#endif
 #ifdef HAVE_THREADED_FFTW
-  fftw_cleanup_threads();
+  mesh_fftw(cleanup_threads)();
 #endif
 #if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
-  fftw_mpi_cleanup();
+  mesh_fftw(mpi_cleanup)();
 #endif
 
   pm_mesh_free(mesh);
@@ -1257,8 +1631,12 @@ void pm_mesh_struct_restore(struct pm_mesh* mesh, FILE* stream) {
 #ifdef HAVE_FFTW
     const int N = mesh->N;
 
+    /* The pencil decomposition is re-created with the plans */
+    mesh->pencils = NULL;
+
     initialise_fftw(N, mesh->nr_threads);
     pm_mesh_allocate(mesh);
+    pm_mesh_make_plans(mesh);
 
 #else
     error("No FFTW library found. Cannot compute periodic long-range forces.");
@@ -24,6 +24,8 @@
 
 /* Local headers */
 #include "gravity_properties.h"
+#include "mesh_gravity_real.h"
+#include "parser.h"
 #include "timeline.h"
 
 /* Forward declarations */
@@ -32,6 +34,7 @@ struct space;
 struct gpart;
 struct threadpool;
 struct cell;
+struct pm_mesh_pencils;
 
 /**
  * @brief Data structure for the long-range periodic forces using a mesh
@@ -50,10 +53,18 @@ struct pm_mesh {
   /*! Whether mesh is distributed between MPI ranks */
   int distributed_mesh;
 
+  /*! Whether the distributed mesh is split in pencils and transformed with
+   * our own transposes rather than in the slabs of the FFTW MPI library */
+  int use_pencils;
+
   /*! Whether or not to use local patches rather than
    * direct atomic writes to the mesh when running without MPI */
   int use_local_patches;
 
+  /*! Whether or not to add the local patches to the mesh colour by colour,
+   * without atomics, when running without a distributed mesh */
+  int use_coloured_deposit;
+
   /*! Integer time-step end of the mesh force for the last step */
   integertime_t ti_end_mesh_last;
 
@@ -84,12 +95,29 @@ struct pm_mesh {
   /*! Distance below which tree forces are Newtonian */
   double r_cut_min;
 
-  /*! Full N*N*N potential field */
-  double *potential_global;
+  /*! Full N*N*N potential field (in the precision of the mesh) */
+  mesh_real *potential_global;
+
+  /*! Rigour of the planning of the FFTs (see gravity_props) */
+  int fftw_planning;
+
+  /*! File in which the FFTW wisdom is kept across runs, empty for none */
+  char fftw_wisdom_file[PARSER_MAX_LINE_SIZE];
+
+#ifdef HAVE_FFTW
+  /*! Plans of the forward and inverse FFTs, created once and executed on
+   * the arrays of each step */
+  mesh_plan forward_plan;
+  mesh_plan inverse_plan;
+#endif
+
+  /*! Decomposition and plans of the pencil FFT (NULL when not in use) */
+  struct pm_mesh_pencils *pencils;
 };
 
 void pm_mesh_init(struct pm_mesh *mesh, const struct gravity_props *props,
-                  const double dim[3], int nr_threads);
+                  const double dim[3], int nr_threads,
+                  const char *wisdom_file);
 void pm_mesh_init_no_mesh(struct pm_mesh *mesh, double dim[3]);
 void pm_mesh_compute_potential(struct pm_mesh *mesh, const struct space *s,
                                struct threadpool *tp, int verbose);
@@ -36,6 +36,7 @@
 #include "exchange_structs.h"
 #include "lock.h"
 #include "mesh_gravity_patch.h"
+#include "mesh_gravity_pencil.h"
 #include "mesh_gravity_sort.h"
 #include "neutrino.h"
 #include "part.h"
@@ -175,7 +176,10 @@ void accumulate_cell_to_local_patches_mapper(void *map_data, int num,
  * Fill the array of local patches with the data corresponding
  * to the local top-level cells.
  * The patches are stored in the order of the space->local_cells_top list.
+ * This does not require MPI and is also used by the coloured deposit onto the
+ * global mesh.
  *
+ * @param tp The #threadpool object used for parallelisation.
  * @param N The size of the mesh
  * @param fac Inverse of the cell size
  * @param s The #space containing the particles.
@@ -186,7 +190,6 @@ void mpi_mesh_accumulate_gparts_to_local_patches(
     struct threadpool *tp, const int N, const double fac, const struct space *s,
     struct pm_mesh_patch *local_patches) {
 
-#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
   const int *local_cells = s->local_cells_top;
   const int nr_local_cells = s->nr_local_cells;
   const double dim[3] = {s->dim[0], s->dim[1], s->dim[2]};
@@ -211,11 +214,6 @@ void mpi_mesh_accumulate_gparts_to_local_patches(
   threadpool_map(tp, accumulate_cell_to_local_patches_mapper,
                  (void *)local_cells, nr_local_cells, sizeof(int),
                  threadpool_auto_chunk_size, (void *)&data);
-  if (lock_destroy(&lock) != 0) error("Impossible to destroy lock!");
-
-#else
-  error("FFTW MPI not found - unable to use distributed mesh");
-#endif
 }
 
 void mesh_patches_to_sorted_array(const struct pm_mesh_patch *local_patches,
@@ -259,30 +257,29 @@ void mesh_patches_to_sorted_array(const struct pm_mesh_patch *local_patches,
 }
 
 /**
- * @brief Convert the array of local patches to a slab-distributed 3D mesh
+ * @brief Convert the array of local patches to a slab- or pencil-distributed
+ * 3D mesh
  *
- * For FFTW each rank needs to hold a slice of the full mesh.
- * This routine does the necessary communication to convert
- * the per-rank local patches into a slab-distributed mesh.
+ * For the distributed FFT each rank needs to hold a slice (or pencil) of the
+ * full mesh. This routine does the necessary communication to convert
+ * the per-rank local patches into a distributed mesh.
  *
  * This function will clean the memory allocated by each of the entry
  * in the local_patches array.
  *
- * @param N The size of the mesh
- * @param local_n0 The thickness of the slice to store on this rank
+ * @param decomp The distribution of the mesh over the ranks.
  * @param local_patches The array of local patches.
  * @param nr_patches The number of local patches.
  * @param mesh Pointer to the output data buffer.
  * @param tp The #threadpool object.
  * @param verbose Are we talkative?
  */
-void mpi_mesh_local_patches_to_slices(const int N, const int local_n0,
-                                      struct pm_mesh_patch *local_patches,
-                                      const int nr_patches, double *mesh,
-                                      struct threadpool *tp,
-                                      const int verbose) {
+void mpi_mesh_local_patches_to_slices(
+    const struct pm_mesh_decomposition *decomp,
+    struct pm_mesh_patch *local_patches, const int nr_patches, mesh_real *mesh,
+    struct threadpool *tp, const int verbose) {
 
-#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+#if defined(WITH_MPI) && defined(HAVE_FFTW)
 
   /* Determine rank, number of ranks */
   int nr_nodes, nodeID;
@@ -311,7 +308,8 @@ void mpi_mesh_local_patches_to_slices(const int N, const int local_n0,
   /* Make an array with the (key, value) pairs from the mesh patches.
    *
    * We're going to distribute them between ranks according to their
-   * x coordinate, so we later need to put them in order of destination rank. */
+   * x and y coordinates, so we later need to put them in order of destination
+   * rank. */
   mesh_patches_to_sorted_array(local_patches, nr_patches, mesh_sendbuf_unsorted,
                                count);
 
@@ -331,12 +329,14 @@ void mpi_mesh_local_patches_to_slices(const int N, const int local_n0,
                      count * sizeof(struct mesh_key_value_rho)) != 0)
     error("Failed to allocate array for unsorted mesh send buffer!");
 
-  size_t *sorted_offsets = (size_t *)malloc(N * sizeof(size_t));
+  /* One bucket per destination rank */
+  size_t *sorted_offsets = (size_t *)malloc(nr_nodes * sizeof(size_t));
 
   /* Do a bucket sort of the mesh elements to have them sorted
-   * by global x-coordinate (note we don't care about y,z at this stage)
-   * Also reover the offsets where we switch from one bin to the next */
-  bucket_sort_mesh_key_value_rho(mesh_sendbuf_unsorted, count, N, tp,
+   * by the rank holding them (note we don't care about the order of the
+   * cells of a given rank at this stage)
+   * Also recover the offsets where we switch from one rank to the next */
+  bucket_sort_mesh_key_value_rho(mesh_sendbuf_unsorted, count, decomp, tp,
                                  mesh_sendbuf, sorted_offsets);
 
   /* Let's free the unsorted array to keep things lean */
@@ -349,59 +349,22 @@ void mpi_mesh_local_patches_to_slices(const int N, const int local_n0,
 
   tic = getticks();
 
-  /* Get width of the slice on each rank */
-  int *slice_width = (int *)malloc(sizeof(int) * nr_nodes);
-  MPI_Allgather(&local_n0, 1, MPI_INT, slice_width, 1, MPI_INT, MPI_COMM_WORLD);
-
-  /* Determine offset to the slice on each rank */
-  int *slice_offset = (int *)malloc(sizeof(int) * nr_nodes);
-  slice_offset[0] = 0;
-  for (int i = 1; i < nr_nodes; i++) {
-    slice_offset[i] = slice_offset[i - 1] + slice_width[i - 1];
-  }
-
   /* Compute how many elements are to be sent to each rank */
   size_t *nr_send = (size_t *)calloc(nr_nodes, sizeof(size_t));
-
-  /* Loop over the offsets */
-  int dest_node = 0;
-  for (int i = 0; i < N; ++i) {
-
-    /* Find the first mesh cell in that bucket */
-    const size_t j = sorted_offsets[i];
-
-    /* Get the x coordinate of this mesh cell in the global mesh */
-    const int mesh_x =
-        get_xcoord_from_padded_row_major_id((size_t)mesh_sendbuf[j].key, N);
-
-    /* Advance to the destination node that is to contain this x coordinate */
-    while ((mesh_x >= slice_offset[dest_node] + slice_width[dest_node]) ||
-           (slice_width[dest_node] == 0)) {
-      dest_node++;
-    }
-
-    /* Add all the mesh cells in this bucket */
-    if (i < N - 1)
-      nr_send[dest_node] += sorted_offsets[i + 1] - sorted_offsets[i];
+  for (int i = 0; i < nr_nodes; ++i) {
+    if (i < nr_nodes - 1)
+      nr_send[i] = sorted_offsets[i + 1] - sorted_offsets[i];
     else
-      nr_send[dest_node] += count - sorted_offsets[i];
+      nr_send[i] = count - sorted_offsets[i];
   }
 
 #ifdef SWIFT_DEBUG_CHECKS
   size_t *nr_send_check = (size_t *)calloc(nr_nodes, sizeof(size_t));
 
   /* Brute-force list without using the offsets */
-  int dest_node_check = 0;
   for (size_t i = 0; i < count; i++) {
-    /* Get the x coordinate of this mesh cell in the global mesh */
-    const int mesh_x =
-        get_xcoord_from_padded_row_major_id((size_t)mesh_sendbuf[i].key, N);
-    /* Advance to the destination node that is to contain this x coordinate */
-    while ((mesh_x >=
-            slice_offset[dest_node_check] + slice_width[dest_node_check]) ||
-           (slice_width[dest_node_check] == 0)) {
-      dest_node_check++;
-    }
+    const int dest_node_check =
+        pm_mesh_decomposition_rank_from_key(decomp, mesh_sendbuf[i].key);
     nr_send_check[dest_node_check]++;
   }
 
@@ -448,23 +411,20 @@ void mpi_mesh_local_patches_to_slices(const int N, const int local_n0,
   tic = getticks();
 
   /* Copy received data to the output buffer.
-   * This is now a local slice of the global mesh. */
+   * This is now the local slice (or pencil) of the global mesh. */
   for (size_t i = 0; i < nr_recv_tot; i++) {
 
 #ifdef SWIFT_DEBUG_CHECKS
-    /* Verify that we indeed got a cell that should be in the local mesh slice
+    /* Verify that we indeed got a cell that should be in the local mesh block
      */
-    const int xcoord =
-        get_xcoord_from_padded_row_major_id(mesh_recvbuf[i].key, N);
-    if (xcoord < slice_offset[nodeID])
-      error("Received mesh cell is not in the local slice (xcoord too small)");
-    if (xcoord >= slice_offset[nodeID] + slice_width[nodeID])
-      error("Received mesh cell is not in the local slice (xcoord too large)");
+    if (pm_mesh_decomposition_rank_from_key(decomp, mesh_recvbuf[i].key) !=
+        nodeID)
+      error("Received mesh cell is not in the local slice");
 #endif
 
     /* What cell are we looking at? */
-    const size_t local_index = get_index_in_local_slice(
-        (size_t)mesh_recvbuf[i].key, N, slice_offset[nodeID]);
+    const size_t local_index =
+        pm_mesh_decomposition_local_index(decomp, (size_t)mesh_recvbuf[i].key);
 
     /* Add to the cell*/
     mesh[local_index] += mesh_recvbuf[i].value;
@@ -475,14 +435,12 @@ void mpi_mesh_local_patches_to_slices(const int N, const int local_n0,
             clocks_from_ticks(getticks() - tic), clocks_getunit());
 
   /* Tidy up */
-  free(slice_width);
-  free(slice_offset);
   free(nr_send);
   free(nr_recv);
   swift_free("mesh_recvbuf", mesh_recvbuf);
   swift_free("mesh_sendbuf", mesh_sendbuf);
 #else
-  error("FFTW MPI not found - unable to use distributed mesh");
+  error("FFTW not found - unable to use distributed mesh");
 #endif
 }
 
@@ -676,7 +634,8 @@ void fill_local_patches_from_mesh_cells(
 
     /* Allocate the mesh */
     if (swift_memalign("mesh_patch", (void **)&patch->mesh,
-                       SWIFT_CACHE_ALIGNMENT, num_cells * sizeof(double)) != 0)
+                       SWIFT_CACHE_ALIGNMENT,
+                       num_cells * sizeof(mesh_real)) != 0)
       error("Failed to allocate array for mesh patch!");
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -741,20 +700,20 @@ void fill_local_patches_from_mesh_cells(
  * @param N The size of the mesh
  * @param fac Inverse of the FFT mesh cell size
  * @param s The #space containing the particles.
- * @param local_0_start Offset to the first mesh x coordinate on this rank
- * @param local_n0 Width of the mesh slab on this rank
- * @param potential_slice Array with the potential on the local slice of the
- * mesh
+ * @param decomp The distribution of the mesh over the ranks.
+ * @param potential_slice Array with the potential on the local slice (or
+ * pencil) of the mesh
  * @param tp The #threadpool object.
  * @param verbose Are we talkative?
  */
 void mpi_mesh_fetch_potential(const int N, const double fac,
-                              const struct space *s, const int local_0_start,
-                              const int local_n0, double *potential_slice,
+                              const struct space *s,
+                              const struct pm_mesh_decomposition *decomp,
+                              mesh_real *potential_slice,
                               struct pm_mesh_patch *local_patches,
                               struct threadpool *tp, const int verbose) {
 
-#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+#if defined(WITH_MPI) && defined(HAVE_FFTW)
 
   /* Determine rank, number of MPI ranks */
   int nr_nodes, nodeID;
@@ -796,11 +755,13 @@ void mpi_mesh_fetch_potential(const int N, const double fac,
                      nr_send_tot * sizeof(struct mesh_key_value_pot)) != 0)
     error("Failed to allocate array for cells to request!");
 
-  size_t *sorted_offsets = (size_t *)malloc(N * sizeof(size_t));
+  /* One bucket per destination rank */
+  size_t *sorted_offsets = (size_t *)malloc(nr_nodes * sizeof(size_t));
 
   /* Do a bucket sort of the mesh elements to have them sorted
-   * by global x-coordinate (note we don't care about y,z at this stage) */
-  bucket_sort_mesh_key_value_pot(send_cells_unsorted, nr_send_tot, N, tp,
+   * by the rank holding them (note we don't care about the order of the
+   * cells of a given rank at this stage) */
+  bucket_sort_mesh_key_value_pot(send_cells_unsorted, nr_send_tot, decomp, tp,
                                  send_cells, sorted_offsets);
 
   swift_free("send_cells_unsorted", send_cells_unsorted);
@@ -812,55 +773,22 @@ void mpi_mesh_fetch_potential(const int N, const double fac,
 
   tic = getticks();
 
-  /* Get width of the mesh slice on each rank */
-  int *slice_width = (int *)malloc(sizeof(int) * nr_nodes);
-  MPI_Allgather(&local_n0, 1, MPI_INT, slice_width, 1, MPI_INT, MPI_COMM_WORLD);
-
-  /* Determine first mesh x coordinate stored on each rank */
-  int *slice_offset = (int *)malloc(sizeof(int) * nr_nodes);
-  slice_offset[0] = 0;
-  for (int i = 1; i < nr_nodes; i++) {
-    slice_offset[i] = slice_offset[i - 1] + slice_width[i - 1];
-  }
-
   /* Count how many mesh cells we need to request from each MPI rank */
   size_t *nr_send = (size_t *)calloc(nr_nodes, sizeof(size_t));
-
-  /* Loop over the offsets */
-  int dest_node = 0;
-  for (int i = 0; i < N; ++i) {
-
-    /* Find the first mesh cell in that bucket */
-    const size_t j = sorted_offsets[i];
-
-    /* Get the x coordinate of this mesh cell in the global mesh */
-    const int mesh_x =
-        get_xcoord_from_padded_row_major_id((size_t)send_cells[j].key, N);
-
-    /* Advance to the destination node that is to contain this x coordinate */
-    while ((mesh_x >= slice_offset[dest_node] + slice_width[dest_node]) ||
-           (slice_width[dest_node] == 0)) {
-      dest_node++;
-    }
-
-    /* Add all the mesh cells in this bucket */
-    if (i < N - 1)
-      nr_send[dest_node] += sorted_offsets[i + 1] - sorted_offsets[i];
+  for (int i = 0; i < nr_nodes; ++i) {
+    if (i < nr_nodes - 1)
+      nr_send[i] = sorted_offsets[i + 1] - sorted_offsets[i];
     else
-      nr_send[dest_node] += nr_send_tot - sorted_offsets[i];
+      nr_send[i] = nr_send_tot - sorted_offsets[i];
   }
 
 #ifdef SWIFT_DEBUG_CHECKS
   size_t *nr_send_check = (size_t *)calloc(nr_nodes, sizeof(size_t));
 
   /* Brute-force list without using the offsets */
-  int dest_node_check = 0;
   for (size_t i = 0; i < nr_send_tot; i++) {
-    while (get_xcoord_from_padded_row_major_id(send_cells[i].key, N) >=
-               (slice_offset[dest_node_check] + slice_width[dest_node_check]) ||
-           slice_width[dest_node_check] == 0) {
-      dest_node_check++;
-    }
+    const int dest_node_check =
+        pm_mesh_decomposition_rank_from_key(decomp, send_cells[i].key);
     if (dest_node_check >= nr_nodes || dest_node_check < 0)
       error("Destination node out of range");
     nr_send_check[dest_node_check]++;
@@ -910,21 +838,13 @@ void mpi_mesh_fetch_potential(const int N, const double fac,
   /* Look up potential in the requested cells */
   for (size_t i = 0; i < nr_recv_tot; i++) {
 #ifdef SWIFT_DEBUG_CHECKS
-    const size_t cells_in_slab = ((size_t)N) * (2 * (N / 2 + 1));
-    const size_t first_local_id = local_0_start * cells_in_slab;
-    const size_t num_local_ids = local_n0 * cells_in_slab;
-    if (recv_cells[i].key < first_local_id ||
-        recv_cells[i].key >= first_local_id + num_local_ids) {
+    if (pm_mesh_decomposition_rank_from_key(decomp, recv_cells[i].key) !=
+        nodeID) {
       error("Requested potential mesh cell ID is out of range");
     }
 #endif
     const size_t local_id =
-        get_index_in_local_slice(recv_cells[i].key, N, local_0_start);
-#ifdef SWIFT_DEBUG_CHECKS
-    const size_t Ns = N;
-    if (local_id >= Ns * (2 * (Ns / 2 + 1)) * local_n0)
-      error("Local potential mesh cell ID is out of range");
-#endif
+        pm_mesh_decomposition_local_index(decomp, recv_cells[i].key);
     recv_cells[i].value = potential_slice[local_id];
   }
 
@@ -946,8 +866,6 @@ void mpi_mesh_fetch_potential(const int N, const double fac,
 
   /* Tidy up */
   swift_free("recv_cells", recv_cells);
-  free(slice_width);
-  free(slice_offset);
   free(nr_send);
   free(nr_recv);
 
@@ -982,7 +900,7 @@ void mpi_mesh_fetch_potential(const int N, const double fac,
   swift_free("send_cells_sorted", send_cells_sorted);
 
 #else
-  error("FFTW MPI not found - unable to use distributed mesh");
+  error("FFTW not found - unable to use distributed mesh");
 #endif
 }
 
@@ -993,7 +911,7 @@ void mpi_mesh_fetch_potential(const int N, const double fac,
  * @param gp The #gpart.
  * @param patch The local mesh patch
  */
-#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+#if defined(WITH_MPI) && defined(HAVE_FFTW)
 void mesh_patch_to_gparts_CIC(struct gpart *gp,
                               const struct pm_mesh_patch *patch) {
 
@@ -1095,7 +1013,7 @@ void cell_distributed_mesh_to_gpart_CIC(const struct cell *c,
                                         const float const_G,
                                         const double dim[3]) {
 
-#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+#if defined(WITH_MPI) && defined(HAVE_FFTW)
 
   const int gcount = c->grav.count;
   struct gpart *gparts = c->grav.parts;
@@ -1127,7 +1045,7 @@ void cell_distributed_mesh_to_gpart_CIC(const struct cell *c,
   }
 
 #else
-  error("FFTW MPI not found - unable to use distributed mesh");
+  error("FFTW not found - unable to use distributed mesh");
 #endif
 }
 
@@ -1155,7 +1073,7 @@ struct distributed_cic_mapper_data {
 void cell_distributed_mesh_to_gpart_CIC_mapper(void *map_data, int num,
                                                void *extra) {
 
-#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+#if defined(WITH_MPI) && defined(HAVE_FFTW)
 
   /* Unpack the shared information */
   const struct distributed_cic_mapper_data *data =
@@ -1185,7 +1103,7 @@ void cell_distributed_mesh_to_gpart_CIC_mapper(void *map_data, int num,
   }
 
 #else
-  error("FFTW MPI not found - unable to use distributed mesh");
+  error("FFTW not found - unable to use distributed mesh");
 #endif
 }
 
@@ -1193,7 +1111,7 @@ void mpi_mesh_update_gparts(struct pm_mesh_patch *local_patches,
                             const struct space *s, struct threadpool *tp,
                             const int N, const double cell_fac) {
 
-#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+#if defined(WITH_MPI) && defined(HAVE_FFTW)
 
   const int *local_cells = s->local_cells_top;
   const int nr_local_cells = s->nr_local_cells;
@@ -1219,6 +1137,6 @@ void mpi_mesh_update_gparts(struct pm_mesh_patch *local_patches,
                    threadpool_auto_chunk_size, (void *)&data);
   }
 #else
-  error("FFTW MPI not found - unable to use distributed mesh");
+  error("FFTW not found - unable to use distributed mesh");
 #endif
 }
@@ -22,12 +22,16 @@
 /* Config parameters. */
 #include <config.h>
 
+/* Local headers. */
+#include "mesh_gravity_real.h"
+
 /* Forward declarations */
 struct space;
 struct cell;
 struct threadpool;
 struct pm_mesh;
 struct pm_mesh_patch;
+struct pm_mesh_decomposition;
 struct neutrino_model;
 
 void accumulate_cell_to_local_patch(const int N, const double fac,
@@ -39,14 +43,15 @@ void mpi_mesh_accumulate_gparts_to_local_patches(
     struct threadpool *tp, const int N, const double fac, const struct space *s,
     struct pm_mesh_patch *local_patches);
 
-void mpi_mesh_local_patches_to_slices(const int N, const int local_n0,
-                                      struct pm_mesh_patch *local_patches,
-                                      const int nr_patches, double *mesh,
-                                      struct threadpool *tp, const int verbose);
+void mpi_mesh_local_patches_to_slices(
+    const struct pm_mesh_decomposition *decomp,
+    struct pm_mesh_patch *local_patches, const int nr_patches, mesh_real *mesh,
+    struct threadpool *tp, const int verbose);
 
 void mpi_mesh_fetch_potential(const int N, const double fac,
-                              const struct space *s, int local_0_start,
-                              int local_n0, double *potential_slice,
+                              const struct space *s,
+                              const struct pm_mesh_decomposition *decomp,
+                              mesh_real *potential_slice,
                               struct pm_mesh_patch *local_patches,
                               struct threadpool *tp, const int verbose);
 
@@ -97,7 +97,7 @@ void pm_mesh_patch_init(struct pm_mesh_patch *patch, const struct cell *cell,
 
   /* Allocate the mesh */
   if (swift_memalign("mesh_patch", (void **)&patch->mesh, SWIFT_CACHE_ALIGNMENT,
-                     num_cells * sizeof(double)) != 0)
+                     num_cells * sizeof(mesh_real)) != 0)
     error("Failed to allocate array for mesh patch!");
 }
 
@@ -108,7 +108,7 @@ void pm_mesh_patch_init(struct pm_mesh_patch *patch, const struct cell *cell,
  * @param global_mesh The global mesh to write to.
  * @param patch The #pm_mesh_patch object to write from.
  */
-void pm_add_patch_to_global_mesh(double *const global_mesh,
+void pm_add_patch_to_global_mesh(mesh_real *const global_mesh,
                                  const struct pm_mesh_patch *patch) {
 
   const int N = patch->N;
@@ -120,7 +120,7 @@ void pm_add_patch_to_global_mesh(double *const global_mesh,
   const int mesh_min_k = patch->mesh_min[2];
 
   /* Remind the compiler that the arrays are nicely aligned */
-  swift_declare_aligned_ptr(const double, mesh, patch->mesh,
+  swift_declare_aligned_ptr(const mesh_real, mesh, patch->mesh,
                             SWIFT_CACHE_ALIGNMENT);
 
   for (int i = 0; i < size_i; ++i) {
@@ -134,7 +134,49 @@ void pm_add_patch_to_global_mesh(double *const global_mesh,
         const int patch_index = pm_mesh_patch_index(patch, i, j, k);
         const int mesh_index = row_major_id_periodic(ii, jj, kk, N);
 
-        atomic_add_d(&global_mesh[mesh_index], mesh[patch_index]);
+        atomic_add_mesh(&global_mesh[mesh_index], mesh[patch_index]);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Write the content of a mesh patch back to the global mesh
+ * without atomic operations.
+ *
+ * The caller must guarantee that no other thread writes to the region of the
+ * global mesh covered by the patch at the same time.
+ *
+ * @param global_mesh The global mesh to write to.
+ * @param patch The #pm_mesh_patch object to write from.
+ */
+void pm_add_patch_to_global_mesh_no_atomics(
+    mesh_real *const global_mesh, const struct pm_mesh_patch *patch) {
+
+  const int N = patch->N;
+  const int size_i = patch->mesh_size[0];
+  const int size_j = patch->mesh_size[1];
+  const int size_k = patch->mesh_size[2];
+  const int mesh_min_i = patch->mesh_min[0];
+  const int mesh_min_j = patch->mesh_min[1];
+  const int mesh_min_k = patch->mesh_min[2];
+
+  /* Remind the compiler that the arrays are nicely aligned */
+  swift_declare_aligned_ptr(const mesh_real, mesh, patch->mesh,
+                            SWIFT_CACHE_ALIGNMENT);
+
+  for (int i = 0; i < size_i; ++i) {
+    for (int j = 0; j < size_j; ++j) {
+      for (int k = 0; k < size_k; ++k) {
+
+        const int ii = i + mesh_min_i;
+        const int jj = j + mesh_min_j;
+        const int kk = k + mesh_min_k;
+
+        const int patch_index = pm_mesh_patch_index(patch, i, j, k);
+        const int mesh_index = row_major_id_periodic(ii, jj, kk, N);
+
+        global_mesh[mesh_index] += mesh[patch_index];
       }
     }
   }
@@ -148,11 +190,12 @@ void pm_add_patch_to_global_mesh(double *const global_mesh,
 void pm_mesh_patch_zero(struct pm_mesh_patch *patch) {
 
   /* Remind the compiler that the arrays are nicely aligned */
-  swift_declare_aligned_ptr(double, mesh, patch->mesh, SWIFT_CACHE_ALIGNMENT);
+  swift_declare_aligned_ptr(mesh_real, mesh, patch->mesh,
+                            SWIFT_CACHE_ALIGNMENT);
 
   const int num =
       patch->mesh_size[0] * patch->mesh_size[1] * patch->mesh_size[2];
-  memset(mesh, 0, num * sizeof(double));
+  memset(mesh, 0, num * sizeof(mesh_real));
 }
 
 /**
@@ -27,6 +27,7 @@
 #include "align.h"
 #include "error.h"
 #include "inline.h"
+#include "mesh_gravity_real.h"
 
 /* Forward declarations */
 struct cell;
@@ -57,8 +58,8 @@ struct pm_mesh_patch {
   /*! Maximum integer coordinate of the mesh in each dimension */
   int mesh_max[3];
 
-  /*! Pointer to the mesh data */
-  double *mesh;
+  /*! Pointer to the mesh data (in the precision of the mesh) */
+  mesh_real *mesh;
 };
 
 void pm_mesh_patch_init(struct pm_mesh_patch *patch, const struct cell *cell,
@@ -116,7 +117,7 @@ __attribute__((always_inline)) INLINE static double pm_mesh_patch_CIC_get(
     const double dy, const double dz) {
 
   /* Remind the compiler that the arrays are nicely aligned */
-  swift_declare_aligned_ptr(const double, mesh, patch->mesh,
+  swift_declare_aligned_ptr(const mesh_real, mesh, patch->mesh,
                             SWIFT_CACHE_ALIGNMENT);
 
   double temp;
@@ -154,7 +155,8 @@ __attribute__((always_inline)) INLINE static void pm_mesh_patch_CIC_set(
     const double dy, const double dz, const double value) {
 
   /* Remind the compiler that the arrays are nicely aligned */
-  swift_declare_aligned_ptr(double, mesh, patch->mesh, SWIFT_CACHE_ALIGNMENT);
+  swift_declare_aligned_ptr(mesh_real, mesh, patch->mesh,
+                            SWIFT_CACHE_ALIGNMENT);
 
   /* Classic 3D CIC */
   mesh[pm_mesh_patch_index(patch, i + 0, j + 0, k + 0)] += value * tx * ty * tz;
@@ -167,7 +169,10 @@ __attribute__((always_inline)) INLINE static void pm_mesh_patch_CIC_set(
   mesh[pm_mesh_patch_index(patch, i + 1, j + 1, k + 1)] += value * dx * dy * dz;
 }
 
-void pm_add_patch_to_global_mesh(double *const global_mesh,
+void pm_add_patch_to_global_mesh(mesh_real *const global_mesh,
                                  const struct pm_mesh_patch *patch);
 
+void pm_add_patch_to_global_mesh_no_atomics(
+    mesh_real *const global_mesh, const struct pm_mesh_patch *patch);
+
 #endif
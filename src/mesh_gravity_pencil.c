@@ -0,0 +1,565 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include <config.h>
+
+/* Standard includes. */
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* This object's header. */
+#include "mesh_gravity_pencil.h"
+
+/* Local includes. */
+#include "error.h"
+
+#ifdef WITH_MPI
+
+/**
+ * @brief Allocate the tables of a #pm_mesh_decomposition.
+ *
+ * @param d The #pm_mesh_decomposition with N, nr_x and nr_y set.
+ */
+static void pm_mesh_decomposition_allocate(struct pm_mesh_decomposition *d) {
+
+  d->x_offset = (int *)malloc(d->nr_x * sizeof(int));
+  d->x_width = (int *)malloc(d->nr_x * sizeof(int));
+  d->y_offset = (int *)malloc(d->nr_y * sizeof(int));
+  d->y_width = (int *)malloc(d->nr_y * sizeof(int));
+  d->x_owner = (int *)malloc(d->N * sizeof(int));
+  d->y_owner = (int *)malloc(d->N * sizeof(int));
+  if (d->x_offset == NULL || d->x_width == NULL || d->y_offset == NULL ||
+      d->y_width == NULL || d->x_owner == NULL || d->y_owner == NULL)
+    error("Failed to allocate the mesh decomposition tables.");
+}
+
+/**
+ * @brief Fill the look-up tables of the block containing each coordinate
+ * from the offsets and widths of the blocks.
+ *
+ * @param d The #pm_mesh_decomposition.
+ */
+static void pm_mesh_decomposition_set_owners(struct pm_mesh_decomposition *d) {
+
+  for (int i = 0; i < d->nr_x; i++)
+    for (int x = d->x_offset[i]; x < d->x_offset[i] + d->x_width[i]; x++)
+      d->x_owner[x] = i;
+
+  for (int j = 0; j < d->nr_y; j++)
+    for (int y = d->y_offset[j]; y < d->y_offset[j] + d->y_width[j]; y++)
+      d->y_owner[y] = j;
+}
+
+/**
+ * @brief Describe the slabs of the FFTW MPI library as a
+ * #pm_mesh_decomposition.
+ *
+ * @param d The #pm_mesh_decomposition to initialise.
+ * @param N The side-length of the mesh.
+ * @param local_n0 The width of the slab of this rank.
+ */
+void pm_mesh_decomposition_init_slabs(struct pm_mesh_decomposition *d,
+                                      const int N, const int local_n0) {
+
+  int nr_nodes, nodeID;
+  MPI_Comm_size(MPI_COMM_WORLD, &nr_nodes);
+  MPI_Comm_rank(MPI_COMM_WORLD, &nodeID);
+
+  d->N = N;
+  d->nr_x = nr_nodes;
+  d->nr_y = 1;
+  d->rank_x = nodeID;
+  d->rank_y = 0;
+  pm_mesh_decomposition_allocate(d);
+
+  /* Get the width of the slab on each rank */
+  MPI_Allgather(&local_n0, 1, MPI_INT, d->x_width, 1, MPI_INT, MPI_COMM_WORLD);
+  d->x_offset[0] = 0;
+  for (int i = 1; i < nr_nodes; i++)
+    d->x_offset[i] = d->x_offset[i - 1] + d->x_width[i - 1];
+
+  /* The slabs span the whole y axis */
+  d->y_offset[0] = 0;
+  d->y_width[0] = N;
+
+  pm_mesh_decomposition_set_owners(d);
+}
+
+#endif /* WITH_MPI */
+
+/**
+ * @brief Free the tables of a #pm_mesh_decomposition.
+ *
+ * @param d The #pm_mesh_decomposition.
+ */
+void pm_mesh_decomposition_clean(struct pm_mesh_decomposition *d) {
+
+  free(d->x_offset);
+  free(d->x_width);
+  free(d->y_offset);
+  free(d->y_width);
+  free(d->x_owner);
+  free(d->y_owner);
+  d->x_offset = d->x_width = NULL;
+  d->y_offset = d->y_width = NULL;
+  d->x_owner = d->y_owner = NULL;
+}
+
+#if defined(WITH_MPI) && defined(HAVE_FFTW)
+
+/**
+ * @brief Balanced split of n elements into nr_blocks contiguous blocks.
+ *
+ * @param n The number of elements.
+ * @param nr_blocks The number of blocks.
+ * @param i The block we want.
+ * @param offset (return) The first element of block i.
+ * @param width (return) The number of elements in block i.
+ */
+static void pm_mesh_block(const int n, const int nr_blocks, const int i,
+                          int *offset, int *width) {
+
+  const long long start = ((long long)i * n) / nr_blocks;
+  const long long end = ((long long)(i + 1) * n) / nr_blocks;
+  *offset = (int)start;
+  *width = (int)(end - start);
+}
+
+/**
+ * @brief Set up the decomposition, communicators and plans of the
+ * pencil-decomposed FFT.
+ *
+ * The ranks are arranged in the most square nr_x x nr_y grid with
+ * nr_x >= nr_y. Ranks beyond N along x or N/2+1 along y get empty blocks.
+ * This is a collective call over all the ranks.
+ *
+ * @param p The #pm_mesh_pencils to initialise.
+ * @param N The side-length of the mesh.
+ * @param flags The FFTW planner flags.
+ */
+void pm_mesh_pencils_init(struct pm_mesh_pencils *p, const int N,
+                          const unsigned int flags) {
+
+  int nr_nodes, nodeID;
+  MPI_Comm_size(MPI_COMM_WORLD, &nr_nodes);
+  MPI_Comm_rank(MPI_COMM_WORLD, &nodeID);
+
+  const int N_half = N / 2;
+  const int Nc = N_half + 1;
+
+  bzero(p, sizeof(struct pm_mesh_pencils));
+
+  /* Most square grid of ranks */
+  int nr_y = 1;
+  for (int i = 1; i * i <= nr_nodes; i++)
+    if (nr_nodes % i == 0) nr_y = i;
+  const int nr_x = nr_nodes / nr_y;
+
+  /* Real-space blocks */
+  struct pm_mesh_decomposition *d = &p->decomp;
+  d->N = N;
+  d->nr_x = nr_x;
+  d->nr_y = nr_y;
+  d->rank_x = nodeID / nr_y;
+  d->rank_y = nodeID % nr_y;
+  pm_mesh_decomposition_allocate(d);
+  for (int i = 0; i < nr_x; i++)
+    pm_mesh_block(N, nr_x, i, &d->x_offset[i], &d->x_width[i]);
+  for (int j = 0; j < nr_y; j++)
+    pm_mesh_block(N, nr_y, j, &d->y_offset[j], &d->y_width[j]);
+  pm_mesh_decomposition_set_owners(d);
+
+  /* Fourier-space blocks: ky along the columns, kz along the rows */
+  p->ky_offsets = (int *)malloc(nr_x * sizeof(int));
+  p->ky_widths = (int *)malloc(nr_x * sizeof(int));
+  p->kz_offsets = (int *)malloc(nr_y * sizeof(int));
+  p->kz_widths = (int *)malloc(nr_y * sizeof(int));
+  if (p->ky_offsets == NULL || p->ky_widths == NULL || p->kz_offsets == NULL ||
+      p->kz_widths == NULL)
+    error("Failed to allocate the pencil decomposition tables.");
+  for (int i = 0; i < nr_x; i++)
+    pm_mesh_block(N, nr_x, i, &p->ky_offsets[i], &p->ky_widths[i]);
+  for (int j = 0; j < nr_y; j++)
+    pm_mesh_block(Nc, nr_y, j, &p->kz_offsets[j], &p->kz_widths[j]);
+
+  p->nx = d->x_width[d->rank_x];
+  p->ny = d->y_width[d->rank_y];
+  p->ky_offset = p->ky_offsets[d->rank_x];
+  p->ky_width = p->ky_widths[d->rank_x];
+  p->kz_offset = p->kz_offsets[d->rank_y];
+  p->kz_width = p->kz_widths[d->rank_y];
+
+  /* Local array sizes */
+  const size_t nx = p->nx, ny = p->ny;
+  const size_t nky = p->ky_width, nkz = p->kz_width;
+  size_t size = nx * ny * Nc;
+  if (nx * nkz * N > size) size = nx * nkz * N;
+  if (nky * nkz * N > size) size = nky * nkz * N;
+  p->local_complex_size = size;
+  p->local_real_size = 2 * nx * ny * Nc;
+
+  /* Communicators of our row and our column in the grid of ranks */
+  if (MPI_Comm_split(MPI_COMM_WORLD, d->rank_x, d->rank_y, &p->row_comm) !=
+          MPI_SUCCESS ||
+      MPI_Comm_split(MPI_COMM_WORLD, d->rank_y, d->rank_x, &p->col_comm) !=
+          MPI_SUCCESS)
+    error("Failed to create the communicators of the pencil FFT.");
+  MPI_Type_contiguous(2, mesh_mpi_real, &p->complex_type);
+  MPI_Type_commit(&p->complex_type);
+
+  /* Plan the 1D transforms on temporary arrays of the right size */
+  mesh_real *rho = (mesh_real *)mesh_fftw(malloc)(
+      (p->local_real_size + 2) * sizeof(mesh_real));
+  mesh_complex *work = (mesh_complex *)mesh_fftw(malloc)(
+      (p->local_complex_size + 1) * sizeof(mesh_complex));
+  if (rho == NULL || work == NULL)
+    error("Error allocating memory to plan the pencil FFTs");
+
+  int n[1] = {N};
+  if (nx * ny > 0) {
+    p->forward_z = mesh_fftw(plan_many_dft_r2c)(
+        1, n, (int)(nx * ny), rho, NULL, 1, 2 * Nc, (mesh_complex *)rho, NULL,
+        1, Nc, flags);
+    p->inverse_z = mesh_fftw(plan_many_dft_c2r)(
+        1, n, (int)(nx * ny), (mesh_complex *)rho, NULL, 1, Nc, rho, NULL, 1,
+        2 * Nc, flags);
+    if (p->forward_z == NULL || p->inverse_z == NULL)
+      error("Failed to plan the pencil FFTs along z.");
+  }
+  if (nx * nkz > 0) {
+    p->forward_y = mesh_fftw(plan_many_dft)(1, n, (int)(nx * nkz), work, NULL,
+                                            1, N, work, NULL, 1, N,
+                                            FFTW_FORWARD, flags);
+    p->inverse_y = mesh_fftw(plan_many_dft)(1, n, (int)(nx * nkz), work, NULL,
+                                            1, N, work, NULL, 1, N,
+                                            FFTW_BACKWARD, flags);
+    if (p->forward_y == NULL || p->inverse_y == NULL)
+      error("Failed to plan the pencil FFTs along y.");
+  }
+  if (nky * nkz > 0) {
+    p->forward_x = mesh_fftw(plan_many_dft)(1, n, (int)(nky * nkz), work,
+                                            NULL, 1, N, work, NULL, 1, N,
+                                            FFTW_FORWARD, flags);
+    p->inverse_x = mesh_fftw(plan_many_dft)(1, n, (int)(nky * nkz), work,
+                                            NULL, 1, N, work, NULL, 1, N,
+                                            FFTW_BACKWARD, flags);
+    if (p->forward_x == NULL || p->inverse_x == NULL)
+      error("Failed to plan the pencil FFTs along x.");
+  }
+
+  mesh_fftw(free)(rho);
+  mesh_fftw(free)(work);
+}
+
+/**
+ * @brief Free the plans, communicators and tables of a #pm_mesh_pencils.
+ *
+ * @param p The #pm_mesh_pencils.
+ */
+void pm_mesh_pencils_clean(struct pm_mesh_pencils *p) {
+
+  mesh_plan plans[6] = {p->forward_z, p->forward_y, p->forward_x,
+                        p->inverse_z, p->inverse_y, p->inverse_x};
+  for (int i = 0; i < 6; i++)
+    if (plans[i] != NULL) mesh_fftw(destroy_plan)(plans[i]);
+
+  MPI_Comm_free(&p->row_comm);
+  MPI_Comm_free(&p->col_comm);
+  MPI_Type_free(&p->complex_type);
+
+  free(p->ky_offsets);
+  free(p->ky_widths);
+  free(p->kz_offsets);
+  free(p->kz_widths);
+  pm_mesh_decomposition_clean(&p->decomp);
+  bzero(p, sizeof(struct pm_mesh_pencils));
+}
+
+/**
+ * @brief Exchange the blocks of a transpose between the ranks of a row or
+ * column of the grid of ranks.
+ *
+ * @param p The #pm_mesh_pencils.
+ * @param sendbuf The blocks to send, ordered by destination.
+ * @param send_counts The number of values to send to each rank.
+ * @param recvbuf The blocks received, ordered by origin.
+ * @param recv_counts The number of values to receive from each rank.
+ * @param comm The communicator of the row or column.
+ */
+static void pm_mesh_pencils_exchange(const struct pm_mesh_pencils *p,
+                                     mesh_complex *sendbuf,
+                                     const size_t *send_counts,
+                                     mesh_complex *recvbuf,
+                                     const size_t *recv_counts,
+                                     MPI_Comm comm) {
+
+  int nr_peers;
+  MPI_Comm_size(comm, &nr_peers);
+
+  int *counts = (int *)malloc(4 * nr_peers * sizeof(int));
+  if (counts == NULL) error("Failed to allocate the pencil transpose counts.");
+  int *send_displs = counts + nr_peers;
+  int *recv_counts_int = counts + 2 * nr_peers;
+  int *recv_displs = counts + 3 * nr_peers;
+
+  size_t send_offset = 0, recv_offset = 0;
+  for (int q = 0; q < nr_peers; q++) {
+    if (send_offset + send_counts[q] > INT_MAX ||
+        recv_offset + recv_counts[q] > INT_MAX)
+      error(
+          "Pencil transpose too large for a single MPI call. Use more MPI "
+          "ranks for this mesh size.");
+    counts[q] = (int)send_counts[q];
+    send_displs[q] = (int)send_offset;
+    recv_counts_int[q] = (int)recv_counts[q];
+    recv_displs[q] = (int)recv_offset;
+    send_offset += send_counts[q];
+    recv_offset += recv_counts[q];
+  }
+
+  if (MPI_Alltoallv(sendbuf, counts, send_displs, p->complex_type, recvbuf,
+                    recv_counts_int, recv_displs, p->complex_type,
+                    comm) != MPI_SUCCESS)
+    error("Failed to exchange the blocks of the pencil transpose.");
+
+  free(counts);
+}
+
+/**
+ * @brief Forward transform of the local pencil of a distributed mesh.
+ *
+ * @param p The #pm_mesh_pencils.
+ * @param rho The local real-space pencil, [x][y][z] with z padded to
+ * 2*(N/2+1) (local_real_size values). Overwritten.
+ * @param frho The local Fourier-space modes, [ky][kz][kx]
+ * (local_complex_size values).
+ */
+void pm_mesh_pencils_forward(const struct pm_mesh_pencils *p, mesh_real *rho,
+                             mesh_complex *frho) {
+
+  const struct pm_mesh_decomposition *d = &p->decomp;
+  const int N = d->N;
+  const int Nc = N / 2 + 1;
+  const size_t nx = p->nx, ny = p->ny;
+  const size_t nky = p->ky_width, nkz = p->kz_width;
+  mesh_complex *a = (mesh_complex *)rho;
+
+  mesh_complex *work1 = (mesh_complex *)mesh_fftw(malloc)(
+      (p->local_complex_size + 1) * sizeof(mesh_complex));
+  mesh_complex *work2 = (mesh_complex *)mesh_fftw(malloc)(
+      (p->local_complex_size + 1) * sizeof(mesh_complex));
+  const int nr_peers = d->nr_x > d->nr_y ? d->nr_x : d->nr_y;
+  size_t *send_counts = (size_t *)malloc(2 * nr_peers * sizeof(size_t));
+  if (work1 == NULL || work2 == NULL || send_counts == NULL)
+    error("Failed to allocate the pencil transpose buffers.");
+  size_t *recv_counts = send_counts + nr_peers;
+
+  /* Transform along z: [x][y][kz] */
+  if (p->forward_z != NULL)
+    mesh_fftw(execute_dft_r2c)(p->forward_z, rho, a);
+
+  /* Send its kz block to each rank of our row */
+  size_t n = 0;
+  for (int q = 0; q < d->nr_y; q++) {
+    send_counts[q] = nx * ny * p->kz_widths[q];
+    recv_counts[q] = nx * d->y_width[q] * nkz;
+    for (size_t x = 0; x < nx; x++) {
+      for (size_t y = 0; y < ny; y++) {
+        memcpy(&work1[n], &a[(x * ny + y) * Nc + p->kz_offsets[q]],
+               p->kz_widths[q] * sizeof(mesh_complex));
+        n += p->kz_widths[q];
+      }
+    }
+  }
+  pm_mesh_pencils_exchange(p, work1, send_counts, work2, recv_counts,
+                           p->row_comm);
+
+  /* Gather the whole y axis: [x][kz][y] */
+  n = 0;
+  for (int q = 0; q < d->nr_y; q++) {
+    for (size_t x = 0; x < nx; x++) {
+      for (int y = d->y_offset[q]; y < d->y_offset[q] + d->y_width[q]; y++) {
+        for (size_t kz = 0; kz < nkz; kz++) {
+          const size_t index = (x * nkz + kz) * N + y;
+          work1[index][0] = work2[n][0];
+          work1[index][1] = work2[n][1];
+          n++;
+        }
+      }
+    }
+  }
+
+  /* Transform along y: [x][kz][ky] */
+  if (p->forward_y != NULL)
+    mesh_fftw(execute_dft)(p->forward_y, work1, work1);
+
+  /* Send its ky block to each rank of our column */
+  n = 0;
+  for (int q = 0; q < d->nr_x; q++) {
+    send_counts[q] = nx * nkz * p->ky_widths[q];
+    recv_counts[q] = d->x_width[q] * nkz * nky;
+    for (size_t x = 0; x < nx; x++) {
+      for (size_t kz = 0; kz < nkz; kz++) {
+        memcpy(&work2[n], &work1[(x * nkz + kz) * N + p->ky_offsets[q]],
+               p->ky_widths[q] * sizeof(mesh_complex));
+        n += p->ky_widths[q];
+      }
+    }
+  }
+  pm_mesh_pencils_exchange(p, work2, send_counts, work1, recv_counts,
+                           p->col_comm);
+
+  /* Gather the whole x axis: [ky][kz][x] */
+  n = 0;
+  for (int q = 0; q < d->nr_x; q++) {
+    for (int x = d->x_offset[q]; x < d->x_offset[q] + d->x_width[q]; x++) {
+      for (size_t kz = 0; kz < nkz; kz++) {
+        for (size_t ky = 0; ky < nky; ky++) {
+          const size_t index = (ky * nkz + kz) * N + x;
+          frho[index][0] = work1[n][0];
+          frho[index][1] = work1[n][1];
+          n++;
+        }
+      }
+    }
+  }
+
+  /* Transform along x: [ky][kz][kx] */
+  if (p->forward_x != NULL)
+    mesh_fftw(execute_dft)(p->forward_x, frho, frho);
+
+  free(send_counts);
+  mesh_fftw(free)(work1);
+  mesh_fftw(free)(work2);
+}
+
+/**
+ * @brief Inverse transform of the local modes of a distributed mesh.
+ *
+ * As with FFTW, the result is not normalised.
+ *
+ * @param p The #pm_mesh_pencils.
+ * @param frho The local Fourier-space modes, [ky][kz][kx]. Overwritten.
+ * @param rho The local real-space pencil, [x][y][z] with z padded to
+ * 2*(N/2+1).
+ */
+void pm_mesh_pencils_inverse(const struct pm_mesh_pencils *p,
+                             mesh_complex *frho, mesh_real *rho) {
+
+  const struct pm_mesh_decomposition *d = &p->decomp;
+  const int N = d->N;
+  const int Nc = N / 2 + 1;
+  const size_t nx = p->nx, ny = p->ny;
+  const size_t nky = p->ky_width, nkz = p->kz_width;
+  mesh_complex *a = (mesh_complex *)rho;
+
+  mesh_complex *work1 = (mesh_complex *)mesh_fftw(malloc)(
+      (p->local_complex_size + 1) * sizeof(mesh_complex));
+  mesh_complex *work2 = (mesh_complex *)mesh_fftw(malloc)(
+      (p->local_complex_size + 1) * sizeof(mesh_complex));
+  const int nr_peers = d->nr_x > d->nr_y ? d->nr_x : d->nr_y;
+  size_t *send_counts = (size_t *)malloc(2 * nr_peers * sizeof(size_t));
+  if (work1 == NULL || work2 == NULL || send_counts == NULL)
+    error("Failed to allocate the pencil transpose buffers.");
+  size_t *recv_counts = send_counts + nr_peers;
+
+  /* Transform along x: [ky][kz][x] */
+  if (p->inverse_x != NULL)
+    mesh_fftw(execute_dft)(p->inverse_x, frho, frho);
+
+  /* Send its x block to each rank of our column */
+  size_t n = 0;
+  for (int q = 0; q < d->nr_x; q++) {
+    send_counts[q] = nky * nkz * d->x_width[q];
+    recv_counts[q] = p->ky_widths[q] * nkz * nx;
+    for (size_t ky = 0; ky < nky; ky++) {
+      for (size_t kz = 0; kz < nkz; kz++) {
+        memcpy(&work1[n], &frho[(ky * nkz + kz) * N + d->x_offset[q]],
+               d->x_width[q] * sizeof(mesh_complex));
+        n += d->x_width[q];
+      }
+    }
+  }
+  pm_mesh_pencils_exchange(p, work1, send_counts, work2, recv_counts,
+                           p->col_comm);
+
+  /* Gather the whole ky axis: [x][kz][ky] */
+  n = 0;
+  for (int q = 0; q < d->nr_x; q++) {
+    for (int ky = p->ky_offsets[q]; ky < p->ky_offsets[q] + p->ky_widths[q];
+         ky++) {
+      for (size_t kz = 0; kz < nkz; kz++) {
+        for (size_t x = 0; x < nx; x++) {
+          const size_t index = (x * nkz + kz) * N + ky;
+          work1[index][0] = work2[n][0];
+          work1[index][1] = work2[n][1];
+          n++;
+        }
+      }
+    }
+  }
+
+  /* Transform along y: [x][kz][y] */
+  if (p->inverse_y != NULL)
+    mesh_fftw(execute_dft)(p->inverse_y, work1, work1);
+
+  /* Send its y block to each rank of our row */
+  n = 0;
+  for (int q = 0; q < d->nr_y; q++) {
+    send_counts[q] = nx * nkz * d->y_width[q];
+    recv_counts[q] = nx * p->kz_widths[q] * ny;
+    for (size_t x = 0; x < nx; x++) {
+      for (size_t kz = 0; kz < nkz; kz++) {
+        memcpy(&work2[n], &work1[(x * nkz + kz) * N + d->y_offset[q]],
+               d->y_width[q] * sizeof(mesh_complex));
+        n += d->y_width[q];
+      }
+    }
+  }
+  pm_mesh_pencils_exchange(p, work2, send_counts, work1, recv_counts,
+                           p->row_comm);
+
+  /* Gather the whole kz axis: [x][y][kz] */
+  n = 0;
+  for (int q = 0; q < d->nr_y; q++) {
+    for (size_t x = 0; x < nx; x++) {
+      for (int kz = p->kz_offsets[q]; kz < p->kz_offsets[q] + p->kz_widths[q];
+           kz++) {
+        for (size_t y = 0; y < ny; y++) {
+          const size_t index = (x * ny + y) * Nc + kz;
+          a[index][0] = work1[n][0];
+          a[index][1] = work1[n][1];
+          n++;
+        }
+      }
+    }
+  }
+
+  /* Transform along z: [x][y][z] */
+  if (p->inverse_z != NULL)
+    mesh_fftw(execute_dft_c2r)(p->inverse_z, a, rho);
+
+  free(send_counts);
+  mesh_fftw(free)(work1);
+  mesh_fftw(free)(work2);
+}
+
+#endif /* WITH_MPI && HAVE_FFTW */
@@ -0,0 +1,195 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_MESH_GRAVITY_PENCIL_H
+#define SWIFT_MESH_GRAVITY_PENCIL_H
+
+/* Config parameters. */
+#include <config.h>
+
+/* Standard includes */
+#include <stddef.h>
+
+#ifdef WITH_MPI
+#include <mpi.h>
+#endif
+
+/* Local headers. */
+#include "error.h"
+#include "inline.h"
+#include "mesh_gravity_real.h"
+
+/**
+ * @brief Distribution of the real-space mesh over the MPI ranks.
+ *
+ * The ranks form a nr_x x nr_y grid, rank = rank_x * nr_y + rank_y, and each
+ * of them holds a block of the x and y axes of the mesh and the whole
+ * (padded) z axis. The local mesh is stored in row-major order as
+ * [x - x_offset][y - y_offset][z] with the z axis padded to 2*(N/2+1).
+ *
+ * The slabs of the FFTW MPI library are the case nr_y = 1.
+ */
+struct pm_mesh_decomposition {
+
+  /*! Side-length of the mesh */
+  int N;
+
+  /*! Number of blocks along the x and y axes */
+  int nr_x, nr_y;
+
+  /*! Position of this rank in the grid of blocks */
+  int rank_x, rank_y;
+
+  /*! First coordinate and width of each block along x (size nr_x) */
+  int *x_offset, *x_width;
+
+  /*! First coordinate and width of each block along y (size nr_y) */
+  int *y_offset, *y_width;
+
+  /*! Block containing each x and each y coordinate (size N) */
+  int *x_owner, *y_owner;
+};
+
+/**
+ * @brief Rank holding a given (x, y) column of the mesh.
+ *
+ * @param d The #pm_mesh_decomposition.
+ * @param x The x coordinate in the global mesh.
+ * @param y The y coordinate in the global mesh.
+ */
+__attribute__((always_inline)) INLINE static int pm_mesh_decomposition_rank(
+    const struct pm_mesh_decomposition *d, const int x, const int y) {
+  return d->x_owner[x] * d->nr_y + d->y_owner[y];
+}
+
+/**
+ * @brief Rank holding a given cell of the mesh.
+ *
+ * @param d The #pm_mesh_decomposition.
+ * @param key Index of the cell in the padded N*N*2*(N/2+1) global array.
+ */
+__attribute__((always_inline)) INLINE static int
+pm_mesh_decomposition_rank_from_key(const struct pm_mesh_decomposition *d,
+                                    const size_t key) {
+
+  const size_t N = d->N;
+  const size_t Nk = 2 * (N / 2 + 1);
+  const size_t xy = key / Nk;
+  return pm_mesh_decomposition_rank(d, (int)(xy / N), (int)(xy % N));
+}
+
+/**
+ * @brief Index of a cell of the mesh in the local array of this rank.
+ *
+ * @param d The #pm_mesh_decomposition.
+ * @param key Index of the cell in the padded N*N*2*(N/2+1) global array.
+ */
+__attribute__((always_inline)) INLINE static size_t
+pm_mesh_decomposition_local_index(const struct pm_mesh_decomposition *d,
+                                  const size_t key) {
+
+  const size_t N = d->N;
+  const size_t Nk = 2 * (N / 2 + 1);
+  const size_t z = key % Nk;
+  const size_t xy = key / Nk;
+  const size_t x = xy / N - d->x_offset[d->rank_x];
+  const size_t y = xy % N - d->y_offset[d->rank_y];
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (x >= (size_t)d->x_width[d->rank_x] ||
+      y >= (size_t)d->y_width[d->rank_y])
+    error("Mesh cell is not in the local block (x=%zd y=%zd)", xy / N,
+          xy % N);
+#endif
+
+  return (x * d->y_width[d->rank_y] + y) * Nk + z;
+}
+
+#if defined(WITH_MPI) && defined(HAVE_FFTW)
+
+/**
+ * @brief Pencil-decomposed parallel FFT of the mesh.
+ *
+ * In real space, each rank holds a pencil of the mesh that spans the whole z
+ * axis (see #pm_mesh_decomposition). The forward transform is done one axis
+ * at a time with the serial FFTW:
+ *
+ *  - r2c along z on the local pencils, [x][y][kz],
+ *  - transpose within the rows of the grid of ranks to [x][kz][y] and
+ *    transform along y,
+ *  - transpose within the columns to [ky][kz][x] and transform along x.
+ *
+ * In Fourier space each rank hence holds the modes ky in
+ * [ky_offset, ky_offset + ky_width[, kz in [kz_offset, kz_offset + kz_width[
+ * and all the kx. The inverse transform goes through the same steps in
+ * reverse. Compared to the slabs of the FFTW MPI library, the mesh can be
+ * split over up to N x (N/2+1) ranks and each transpose only involves the
+ * ranks of a row or of a column of the grid.
+ */
+struct pm_mesh_pencils {
+
+  /*! Distribution of the real-space mesh */
+  struct pm_mesh_decomposition decomp;
+
+  /*! Ranks sharing our x block (row) and our y block (column) */
+  MPI_Comm row_comm, col_comm;
+
+  /*! MPI type of a #mesh_complex */
+  MPI_Datatype complex_type;
+
+  /*! Local block sizes in real space */
+  int nx, ny;
+
+  /*! Modes held by this rank in Fourier space */
+  int ky_offset, ky_width, kz_offset, kz_width;
+
+  /*! First kz and width of the kz blocks of each rank of our row */
+  int *kz_offsets, *kz_widths;
+
+  /*! First ky and width of the ky blocks of each rank of our column */
+  int *ky_offsets, *ky_widths;
+
+  /*! Number of #mesh_real in the local real-space array */
+  size_t local_real_size;
+
+  /*! Number of #mesh_complex in the local Fourier-space array and in each of
+   * the work arrays of the transposes */
+  size_t local_complex_size;
+
+  /*! Plans of the 1D transforms along each axis (NULL for empty blocks) */
+  mesh_plan forward_z, forward_y, forward_x;
+  mesh_plan inverse_z, inverse_y, inverse_x;
+};
+
+void pm_mesh_pencils_init(struct pm_mesh_pencils *p, const int N,
+                          const unsigned int flags);
+void pm_mesh_pencils_clean(struct pm_mesh_pencils *p);
+void pm_mesh_pencils_forward(const struct pm_mesh_pencils *p, mesh_real *rho,
+                             mesh_complex *frho);
+void pm_mesh_pencils_inverse(const struct pm_mesh_pencils *p,
+                             mesh_complex *frho, mesh_real *rho);
+
+#endif /* WITH_MPI && HAVE_FFTW */
+
+#ifdef WITH_MPI
+void pm_mesh_decomposition_init_slabs(struct pm_mesh_decomposition *d,
+                                      const int N, const int local_n0);
+#endif
+void pm_mesh_decomposition_clean(struct pm_mesh_decomposition *d);
+
+#endif /* SWIFT_MESH_GRAVITY_PENCIL_H */
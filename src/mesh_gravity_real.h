@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (c) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+#ifndef SWIFT_MESH_GRAVITY_REAL_H
+#define SWIFT_MESH_GRAVITY_REAL_H
+
+/* Config parameters. */
+#include <config.h>
+
+#ifdef HAVE_FFTW
+#include <fftw3.h>
+#if defined(WITH_MPI) && defined(HAVE_MPI_FFTW)
+#include <fftw3-mpi.h>
+#endif
+#endif
+
+#ifdef WITH_MPI
+#include <mpi.h>
+#endif
+
+/* Local headers. */
+#include "atomic.h"
+
+/**
+ * Precision of the values stored on the long-range gravity mesh.
+ *
+ * The mesh is in double precision unless SWIFT is configured with
+ * --enable-mesh-single-precision, in which case the mesh, its patches, the
+ * FFTs (via fftwf) and the MPI reduction of the replicated mesh use floats.
+ * The CIC weights, the accumulation of the forces on the particles and the
+ * key-value tuples exchanged by the distributed mesh remain in double
+ * precision.
+ *
+ * mesh_fftw(name) gives the FFTW function or type of the matching precision,
+ * e.g. mesh_fftw(complex) or mesh_fftw(plan_dft_r2c_3d).
+ */
+#ifdef MESH_GRAVITY_SINGLE_PRECISION
+
+typedef float mesh_real;
+#define mesh_fftw(name) fftwf_##name
+#define atomic_add_mesh(address, y) atomic_add_f(address, y)
+#ifdef WITH_MPI
+#define mesh_mpi_real MPI_FLOAT
+#endif
+
+#else
+
+typedef double mesh_real;
+#define mesh_fftw(name) fftw_##name
+#define atomic_add_mesh(address, y) atomic_add_d(address, y)
+#ifdef WITH_MPI
+#define mesh_mpi_real MPI_DOUBLE
+#endif
+
+#endif /* MESH_GRAVITY_SINGLE_PRECISION */
+
+#ifdef HAVE_FFTW
+typedef mesh_fftw(complex) mesh_complex;
+typedef mesh_fftw(plan) mesh_plan;
+#endif
+
+#endif /* SWIFT_MESH_GRAVITY_REAL_H */
@@ -27,20 +27,24 @@
 #include "align.h"
 #include "atomic.h"
 #include "error.h"
+#include "mesh_gravity_pencil.h"
 #include "row_major_id.h"
 #include "threadpool.h"
 
 struct mapper_extra_data {
 
-  /* Mesh size */
+  /* Number of buckets */
   int N;
 
+  /* Distribution of the mesh over the ranks */
+  const struct pm_mesh_decomposition *decomp;
+
   /* Buckets */
   size_t *bucket_counts;
 };
 
 /**
- * @param Count how may mesh cells will end up in each x-coord bucket.
+ * @param Count how may mesh cells will end up in each rank's bucket.
  */
 void bucket_sort_mesh_key_value_rho_count_mapper(void *map_data, int nr_parts,
                                                  void *extra_data) {
@@ -50,6 +54,7 @@ void bucket_sort_mesh_key_value_rho_count_mapper(void *map_data, int nr_parts,
       (const struct mesh_key_value_rho *)map_data;
   struct mapper_extra_data *data = (struct mapper_extra_data *)extra_data;
   const int N = data->N;
+  const struct pm_mesh_decomposition *decomp = data->decomp;
   size_t *global_bucket_counts = data->bucket_counts;
 
   /* Local buckets */
@@ -60,18 +65,17 @@ void bucket_sort_mesh_key_value_rho_count_mapper(void *map_data, int nr_parts,
 
     const size_t key = array_in[i].key;
 
-    /* Get the x coordinate of this mesh cell in the global mesh
-     * Note: we don't need to sort more precisely than just
-     * the x coordinate */
-    const int mesh_x = get_xcoord_from_padded_row_major_id(key, N);
+    /* Get the rank holding this mesh cell
+     * Note: we don't need to sort more precisely than that */
+    const int dest = pm_mesh_decomposition_rank_from_key(decomp, key);
 
 #ifdef SWIFT_DEBUG_CHECKS
-    if (mesh_x < 0) error("Invalid mesh cell x-coordinate (too small)");
-    if (mesh_x >= N) error("Invalid mesh cell x-coordinate (too large)");
+    if (dest < 0) error("Invalid mesh cell destination (too small)");
+    if (dest >= N) error("Invalid mesh cell destination (too large)");
 #endif
 
     /* Add a contribution to the bucket count */
-    local_bucket_counts[mesh_x]++;
+    local_bucket_counts[dest]++;
   }
 
   /* Now write back to memory */
@@ -84,7 +88,7 @@ void bucket_sort_mesh_key_value_rho_count_mapper(void *map_data, int nr_parts,
 }
 
 /**
- * @param Count how may mesh cells will end up in each x-coord bucket.
+ * @param Count how may mesh cells will end up in each rank's bucket.
  */
 void bucket_sort_mesh_key_value_pot_count_mapper(void *map_data, int nr_parts,
                                                  void *extra_data) {
@@ -94,6 +98,7 @@ void bucket_sort_mesh_key_value_pot_count_mapper(void *map_data, int nr_parts,
       (const struct mesh_key_value_pot *)map_data;
   struct mapper_extra_data *data = (struct mapper_extra_data *)extra_data;
   const int N = data->N;
+  const struct pm_mesh_decomposition *decomp = data->decomp;
   size_t *global_bucket_counts = data->bucket_counts;
 
   /* Local buckets */
@@ -104,18 +109,17 @@ void bucket_sort_mesh_key_value_pot_count_mapper(void *map_data, int nr_parts,
 
     const size_t key = array_in[i].key;
 
-    /* Get the x coordinate of this mesh cell in the global mesh
-     * Note: we don't need to sort more precisely than just
-     * the x coordinate */
-    const int mesh_x = get_xcoord_from_padded_row_major_id(key, N);
+    /* Get the rank holding this mesh cell
+     * Note: we don't need to sort more precisely than that */
+    const int dest = pm_mesh_decomposition_rank_from_key(decomp, key);
 
 #ifdef SWIFT_DEBUG_CHECKS
-    if (mesh_x < 0) error("Invalid mesh cell x-coordinate (too small)");
-    if (mesh_x >= N) error("Invalid mesh cell x-coordinate (too large)");
+    if (dest < 0) error("Invalid mesh cell destination (too small)");
+    if (dest >= N) error("Invalid mesh cell destination (too large)");
 #endif
 
     /* Add a contribution to the bucket count */
-    local_bucket_counts[mesh_x]++;
+    local_bucket_counts[dest]++;
   }
 
   /* Now write back to memory */
@@ -171,24 +175,27 @@ void bucket_sort_mesh_key_value_pot_index_count_mapper(void *map_data,
 }
 
 /**
- * @brief Bucket sort of the array of mesh cells based on their x-coord.
+ * @brief Bucket sort of the array of mesh cells based on the rank holding
+ * them.
  *
  * Note the two mesh_key_value_rho arrays must be aligned on
  * SWIFT_CACHE_ALIGNMENT.
  *
  * @param array_in The unsorted array of mesh-key value pairs.
  * @param count The number of elements in the mesh-key value pair arrays.
- * @param N The size of the mesh. (i.e. the number of possible x-axis values)
+ * @param decomp The distribution of the mesh over the ranks.
  * @param tp The #threadpool object.
  * @param array_out The sorted array of mesh-key value pairs (to be filled).
- * @param bucket_offsets The offsets in the sorted array where we change x-coord
- * (to be filled).
+ * @param bucket_offsets The offsets in the sorted array where we change rank
+ * (one per rank, to be filled).
  */
-void bucket_sort_mesh_key_value_rho(const struct mesh_key_value_rho *array_in,
-                                    const size_t count, const int N,
-                                    struct threadpool *tp,
-                                    struct mesh_key_value_rho *array_out,
-                                    size_t *bucket_offsets) {
+void bucket_sort_mesh_key_value_rho(
+    const struct mesh_key_value_rho *array_in, const size_t count,
+    const struct pm_mesh_decomposition *decomp, struct threadpool *tp,
+    struct mesh_key_value_rho *array_out, size_t *bucket_offsets) {
+
+  /* One bucket per rank */
+  const int N = decomp->nr_x * decomp->nr_y;
 
   /* Create an array of bucket counts and one of offsets */
   size_t *bucket_counts = (size_t *)malloc(N * sizeof(size_t));
@@ -196,6 +203,7 @@ void bucket_sort_mesh_key_value_rho(const struct mesh_key_value_rho *array_in,
 
   struct mapper_extra_data extra_data;
   extra_data.N = N;
+  extra_data.decomp = decomp;
   extra_data.bucket_counts = bucket_counts;
 
   /* Collect the number of items that will end up in each bucket */
@@ -225,29 +233,26 @@ void bucket_sort_mesh_key_value_rho(const struct mesh_key_value_rho *array_in,
   for (size_t i = 0; i < count; ++i) {
 
     const size_t key = array_in_aligned[i].key;
-    const int mesh_x = get_xcoord_from_padded_row_major_id(key, N);
+    const int dest = pm_mesh_decomposition_rank_from_key(decomp, key);
 
     /* Where does this element land? */
-    const size_t index = bucket_offsets[mesh_x];
+    const size_t index = bucket_offsets[dest];
 
     /* Copy the element to its correct position */
     memcpy(&array_out_aligned[index], &array_in_aligned[i],
            sizeof(struct mesh_key_value_rho));
 
     /* Move the start of this bucket by one */
-    bucket_offsets[mesh_x]++;
+    bucket_offsets[dest]++;
   }
 
 #ifdef SWIFT_DEBUG_CHECKS
   /* Verify that things have indeed been sorted */
-  int last_mesh_x =
-      get_xcoord_from_padded_row_major_id(array_out_aligned[0].key, N);
-  ;
   for (size_t i = 1; i < count; ++i) {
-    const size_t key = array_out_aligned[i].key;
-    const int mesh_x = get_xcoord_from_padded_row_major_id(key, N);
-    if (mesh_x < last_mesh_x) error("Unsorted array!");
-    last_mesh_x = mesh_x;
+    if (pm_mesh_decomposition_rank_from_key(decomp, array_out_aligned[i].key) <
+        pm_mesh_decomposition_rank_from_key(decomp,
+                                            array_out_aligned[i - 1].key))
+      error("Unsorted array!");
   }
 #endif
 
@@ -261,24 +266,27 @@ void bucket_sort_mesh_key_value_rho(const struct mesh_key_value_rho *array_in,
 }
 
 /**
- * @brief Bucket sort of the array of mesh cells based on their x-coord.
+ * @brief Bucket sort of the array of mesh cells based on the rank holding
+ * them.
  *
  * Note the two mesh_key_value_pot arrays must be aligned on
  * SWIFT_CACHE_ALIGNMENT.
  *
  * @param array_in The unsorted array of mesh-key value pairs.
  * @param count The number of elements in the mesh-key value pair arrays.
- * @param N The size of the mesh. (i.e. the number of possible x-axis values)
+ * @param decomp The distribution of the mesh over the ranks.
  * @param tp The #threadpool object.
  * @param array_out The sorted array of mesh-key value pairs (to be filled).
- * @param bucket_offsets The offsets in the sorted array where we change x-coord
- * (to be filled).
+ * @param bucket_offsets The offsets in the sorted array where we change rank
+ * (one per rank, to be filled).
  */
-void bucket_sort_mesh_key_value_pot(const struct mesh_key_value_pot *array_in,
-                                    const size_t count, const int N,
-                                    struct threadpool *tp,
-                                    struct mesh_key_value_pot *array_out,
-                                    size_t *bucket_offsets) {
+void bucket_sort_mesh_key_value_pot(
+    const struct mesh_key_value_pot *array_in, const size_t count,
+    const struct pm_mesh_decomposition *decomp, struct threadpool *tp,
+    struct mesh_key_value_pot *array_out, size_t *bucket_offsets) {
+
+  /* One bucket per rank */
+  const int N = decomp->nr_x * decomp->nr_y;
 
   /* Create an array of bucket counts and one of offsets */
   size_t *bucket_counts = (size_t *)malloc(N * sizeof(size_t));
@@ -286,6 +294,7 @@ void bucket_sort_mesh_key_value_pot(const struct mesh_key_value_pot *array_in,
 
   struct mapper_extra_data extra_data;
   extra_data.N = N;
+  extra_data.decomp = decomp;
   extra_data.bucket_counts = bucket_counts;
 
   /* Collect the number of items that will end up in each bucket */
@@ -315,29 +324,26 @@ void bucket_sort_mesh_key_value_pot(const struct mesh_key_value_pot *array_in,
   for (size_t i = 0; i < count; ++i) {
 
     const size_t key = array_in_aligned[i].key;
-    const int mesh_x = get_xcoord_from_padded_row_major_id(key, N);
+    const int dest = pm_mesh_decomposition_rank_from_key(decomp, key);
 
     /* Where does this element land? */
-    const size_t index = bucket_offsets[mesh_x];
+    const size_t index = bucket_offsets[dest];
 
     /* Copy the element to its correct position */
     memcpy(&array_out_aligned[index], &array_in_aligned[i],
            sizeof(struct mesh_key_value_pot));
 
     /* Move the start of this bucket by one */
-    bucket_offsets[mesh_x]++;
+    bucket_offsets[dest]++;
   }
 
 #ifdef SWIFT_DEBUG_CHECKS
   /* Verify that things have indeed been sorted */
-  int last_mesh_x =
-      get_xcoord_from_padded_row_major_id(array_out_aligned[0].key, N);
-
   for (size_t i = 1; i < count; ++i) {
-    const size_t key = array_out_aligned[i].key;
-    const int mesh_x = get_xcoord_from_padded_row_major_id(key, N);
-    if (mesh_x < last_mesh_x) error("Unsorted array!");
-    last_mesh_x = mesh_x;
+    if (pm_mesh_decomposition_rank_from_key(decomp, array_out_aligned[i].key) <
+        pm_mesh_decomposition_rank_from_key(decomp,
+                                            array_out_aligned[i - 1].key))
+      error("Unsorted array!");
   }
 #endif
 
@@ -373,6 +379,7 @@ void bucket_sort_mesh_key_value_pot_index(
 
   struct mapper_extra_data extra_data;
   extra_data.N = N;
+  extra_data.decomp = NULL;
   extra_data.bucket_counts = bucket_counts;
 
   /* Collect the number of items that will end up in each bucket */
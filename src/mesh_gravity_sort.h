@@ -27,9 +27,13 @@
 #include <string.h>
 
 struct threadpool;
+struct pm_mesh_decomposition;
 
 /**
  * @brief Store contributions to the mesh as (index, mass) pairs
+ *
+ * The value stays a double in single-precision mesh mode: next to the 64-bit
+ * key, a float would only be padded and the messages would not shrink.
  */
 struct mesh_key_value_rho {
   size_t key;
@@ -45,17 +49,15 @@ struct mesh_key_value_pot {
   double value;
 };
 
-void bucket_sort_mesh_key_value_rho(const struct mesh_key_value_rho *array_in,
-                                    const size_t count, const int N,
-                                    struct threadpool *tp,
-                                    struct mesh_key_value_rho *array_out,
-                                    size_t *bucket_offsets);
+void bucket_sort_mesh_key_value_rho(
+    const struct mesh_key_value_rho *array_in, const size_t count,
+    const struct pm_mesh_decomposition *decomp, struct threadpool *tp,
+    struct mesh_key_value_rho *array_out, size_t *bucket_offsets);
 
-void bucket_sort_mesh_key_value_pot(const struct mesh_key_value_pot *array_in,
-                                    const size_t count, const int N,
-                                    struct threadpool *tp,
-                                    struct mesh_key_value_pot *array_out,
-                                    size_t *bucket_offsets);
+void bucket_sort_mesh_key_value_pot(
+    const struct mesh_key_value_pot *array_in, const size_t count,
+    const struct pm_mesh_decomposition *decomp, struct threadpool *tp,
+    struct mesh_key_value_pot *array_out, size_t *bucket_offsets);
 
 void bucket_sort_mesh_key_value_pot_index(
     const struct mesh_key_value_pot *array_in, const size_t count, const int N,
@@ -91,6 +91,9 @@ struct mpiuse_log_entry {
 
   /* The tag. */
   int tag;
+
+  /* Number of tasks whose data the request carries. */
+  int ntasks;
 };
 
 /* The log of activations and handoffs. All volatile as accessed from threads
@@ -100,6 +103,12 @@ static volatile size_t mpiuse_log_size = 0;
 static volatile size_t mpiuse_log_count = 0;
 static volatile size_t mpiuse_log_done = 0;
 
+/* Delays between the arrival of the recv data, as seen by the MPI progress
+ * thread, and the start of the tasks processing it. */
+static volatile size_t mpiuse_latency_count = 0;
+static volatile unsigned long long mpiuse_latency_sum = 0;
+static volatile long long mpiuse_latency_max = 0;
+
 /**
  * @brief reallocate the entries log if space is needed.
  */
@@ -139,7 +148,7 @@ static void mpiuse_log_reallocate(size_t ind) {
 }
 
 /**
- * @brief Log an MPI request or handoff.
+ * @brief Record an MPI request or handoff in the log.
  *
  * @param type the task type (send or recv).
  * @param subtype the task subtype.
@@ -150,9 +159,11 @@ static void mpiuse_log_reallocate(size_t ind) {
  *             0 for a deactivation.
  * @param otherrank other rank associated with the transfer.
  * @param tag the MPI tag.
+ * @param ntasks the number of tasks whose data the request carries.
  */
-void mpiuse_log_allocation(int type, int subtype, void *ptr, int activation,
-                           size_t size, int otherrank, int tag) {
+static void mpiuse_log_record(int type, int subtype, void *ptr, int activation,
+                              size_t size, int otherrank, int tag,
+                              int ntasks) {
 
   size_t ind = atomic_inc(&mpiuse_log_count);
 
@@ -176,9 +187,56 @@ void mpiuse_log_allocation(int type, int subtype, void *ptr, int activation,
   mpiuse_log[ind].tic = getticks();
   mpiuse_log[ind].acttic = 0;
   mpiuse_log[ind].active = 1;
+  mpiuse_log[ind].ntasks = ntasks;
   atomic_inc(&mpiuse_log_done);
 }
 
+/**
+ * @brief Log an MPI request or handoff.
+ *
+ * @param type the task type (send or recv).
+ * @param subtype the task subtype.
+ * @param ptr pointer to the MPI request.
+ * @param activation if not is a successful MPI_Test, not MPI_Isend or
+ *        MPI_Irecv.
+ * @param size the size in bytes of memory to be transfered or received.
+ *             0 for a deactivation.
+ * @param otherrank other rank associated with the transfer.
+ * @param tag the MPI tag.
+ */
+void mpiuse_log_allocation(int type, int subtype, void *ptr, int activation,
+                           size_t size, int otherrank, int tag) {
+  mpiuse_log_record(type, subtype, ptr, activation, size, otherrank, tag, 1);
+}
+
+/**
+ * @brief Log an MPI request carrying the coalesced data of several tasks.
+ *
+ * @param type the task type (send or recv).
+ * @param subtype the task subtype.
+ * @param ptr pointer to the MPI request.
+ * @param size the size in bytes of memory to be transfered or received.
+ * @param otherrank other rank associated with the transfer.
+ * @param tag the MPI tag.
+ * @param ntasks the number of tasks whose data the request carries.
+ */
+void mpiuse_log_aggregate(int type, int subtype, void *ptr, size_t size,
+                          int otherrank, int tag, int ntasks) {
+  mpiuse_log_record(type, subtype, ptr, 1, size, otherrank, tag, ntasks);
+}
+
+/**
+ * @brief Log the delay between the arrival of the data of a recv task and
+ * the start of its processing.
+ *
+ * @param latency the delay in ticks.
+ */
+void mpiuse_log_latency(ticks latency) {
+  atomic_inc(&mpiuse_latency_count);
+  atomic_add(&mpiuse_latency_sum, (unsigned long long)latency);
+  atomic_max_ll(&mpiuse_latency_max, (long long)latency);
+}
+
 /**
  * @brief dump the log to a file and reset, if anything to dump.
  *
@@ -218,6 +276,9 @@ void mpiuse_log_dump(const char *filename, ticks stepticks) {
   size_t mpiuse_max = 0;
   double mpiuse_sum = 0;
   size_t mpiuse_actcount = 0;
+  size_t mpiuse_aggcount = 0;
+  size_t mpiuse_aggtasks = 0;
+  double mpiuse_aggsum = 0;
   for (size_t k = 0; k < log_count; k++) {
 
     /* Check if this address has already been recorded. */
@@ -300,6 +361,11 @@ void mpiuse_log_dump(const char *filename, ticks stepticks) {
       if (mpiuse_log[k].size > mpiuse_max) mpiuse_max = mpiuse_log[k].size;
       mpiuse_sum += (double)mpiuse_log[k].size;
       mpiuse_actcount++;
+      if (mpiuse_log[k].ntasks > 1) {
+        mpiuse_aggsum += (double)mpiuse_log[k].size;
+        mpiuse_aggtasks += mpiuse_log[k].ntasks;
+        mpiuse_aggcount++;
+      }
     }
 
     /* And output. */
@@ -325,6 +391,22 @@ void mpiuse_log_dump(const char *filename, ticks stepticks) {
   fprintf(fd, "## Sum of all requests: %.4f (MB)\n", mpiuse_sum / MEGABYTE);
   fprintf(fd, "## Mean of all requests: %.4f (MB)\n",
           mpiuse_sum / (double)mpiuse_actcount / MEGABYTE);
+  if (mpiuse_aggcount > 0) {
+    fprintf(fd, "## Number of coalesced requests: %zd\n", mpiuse_aggcount);
+    fprintf(fd, "## Number of task messages coalesced: %zd\n",
+            mpiuse_aggtasks);
+    fprintf(fd, "## Sum of coalesced requests: %.4f (MB)\n",
+            mpiuse_aggsum / MEGABYTE);
+  }
+  if (mpiuse_latency_count > 0) {
+    fprintf(fd, "## Number of recvs queued by the progress thread: %zd\n",
+            mpiuse_latency_count);
+    fprintf(fd, "## Mean arrival to processing latency: %.4f (%s)\n",
+            clocks_from_ticks(mpiuse_latency_sum / mpiuse_latency_count),
+            clocks_getunit());
+    fprintf(fd, "## Maximum arrival to processing latency: %.4f (%s)\n",
+            clocks_from_ticks(mpiuse_latency_max), clocks_getunit());
+  }
   fprintf(fd, "##\n");
 
   /* Now check any still active logs, these are errors all should match. */
@@ -344,6 +426,9 @@ void mpiuse_log_dump(const char *filename, ticks stepticks) {
   /* Clear the log. We expect this to clear step to step, unlike memory. */
   mpiuse_log_count = 0;
   mpiuse_log_done = 0;
+  mpiuse_latency_count = 0;
+  mpiuse_latency_sum = 0;
+  mpiuse_latency_max = 0;
 
   /* Close the file. */
   fflush(fd);
@@ -33,13 +33,23 @@
 void mpiuse_log_dump(const char *filename, ticks stepticks);
 void mpiuse_log_allocation(int type, int subtype, void *ptr, int activation,
                            size_t size, int otherrank, int tag);
+void mpiuse_log_aggregate(int type, int subtype, void *ptr, size_t size,
+                          int otherrank, int tag, int ntasks);
+void mpiuse_log_latency(ticks latency);
 void mpiuse_log_dump_error(int rank);
 #else
 
 /* No-op when not reporting. */
 #define mpiuse_log_allocation(type, subtype, ptr, activation, size, otherrank, \
                               tag)                                             \
-  ;
+  do {                                                                         \
+  } while (0)
+#define mpiuse_log_aggregate(type, subtype, ptr, size, otherrank, tag, ntasks) \
+  do {                                                                         \
+  } while (0)
+#define mpiuse_log_latency(latency) \
+  do {                              \
+  } while (0)
 #endif /* defined(SWIFT_MPIUSE_REPORTS) && defined(WITH_MPI) */
 
 #endif /* SWIFT_MPIUSE_H */
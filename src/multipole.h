@@ -889,7 +889,9 @@ __attribute__((nonnull)) INLINE static int gravity_multipole_equal(
 __attribute__((nonnull)) INLINE static void gravity_multipole_compute_power(
     struct multipole *m) {
 
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
   double power[SELF_GRAVITY_MULTIPOLE_ORDER + 1] = {0.};
+#endif
 
   /* 0th order terms */
   m->power[0] = m->M_000;
@@ -1093,9 +1095,11 @@ __attribute__((nonnull)) INLINE static void gravity_P2M(
     min_delta_vel[1] = min(gparts[k].v_full[1], min_delta_vel[1]);
     min_delta_vel[2] = min(gparts[k].v_full[2], min_delta_vel[2]);
 
-#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
     const double m = gparts[k].mass;
+#endif
 
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
     /* 1st order terms */
     /* M_100 += -m * X_100(dx); */
     /* M_010 += -m * X_010(dx); */
@@ -1299,10 +1303,12 @@ __attribute__((nonnull)) INLINE static void gravity_M2M(
   /* Shift 0th order term */
   m_a->M_000 = m_b->M_000;
 
-#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 1
   const double dx[3] = {pos_a[0] - pos_b[0], pos_a[1] - pos_b[1],
                         pos_a[2] - pos_b[2]};
+#endif
 
+#if SELF_GRAVITY_MULTIPOLE_ORDER > 0
   /* Shift 1st order term (all 0 (after add) since we expand around CoM) */
   // m_a->M_100 = m_b->M_100 + X_100(dx) * m_b->M_000;
   // m_a->M_010 = m_b->M_010 + X_010(dx) * m_b->M_000;
@@ -408,10 +408,10 @@ struct neutrino_response_tp_data {
 
   /* Mesh properties */
   int N;
-  fftw_complex *frho;
+  mesh_complex *frho;
   double boxlen;
-  int slice_offset;
-  int slice_width;
+  int offset[3];
+  int width[3];
 
   /* Interpolation properties */
   double inv_delta_log_k;
@@ -428,7 +428,7 @@ struct neutrino_response_tp_data {
  * @brief Mapper function for the application of the linear neutrino response.
  *
  * @param map_data The array of the density field Fourier transform.
- * @param num The number of elements to iterate on (along the x-axis).
+ * @param num The number of elements to iterate on (along the first axis).
  * @param extra The properties of the neutrino mesh.
  */
 void neutrino_response_apply_neutrino_response_mapper(void *map_data,
@@ -439,7 +439,7 @@ void neutrino_response_apply_neutrino_response_mapper(void *map_data,
       (struct neutrino_response_tp_data *)extra;
 
   /* Unpack the mesh properties */
-  fftw_complex *const frho = data->frho;
+  mesh_complex *const frho = data->frho;
   const int N = data->N;
   const int N_half = N / 2;
   const double delta_k = 2.0 * M_PI / data->boxlen;
@@ -455,17 +455,18 @@ void neutrino_response_apply_neutrino_response_mapper(void *map_data,
   const double bg_density_ratio = data->bg_density_ratio;
   const double *pt_density_ratio = data->pt_density_ratio;
 
-  /* Find what slice of the full mesh is stored on this MPI rank */
-  const int slice_offset = data->slice_offset;
+  /* Find what block of the full mesh is stored on this MPI rank */
+  const int offset[3] = {data->offset[0], data->offset[1], data->offset[2]};
+  const int width[3] = {data->width[0], data->width[1], data->width[2]};
 
-  /* Range of x coordinates in the full mesh handled by this call */
-  const int x_start = ((fftw_complex *)map_data - frho) + slice_offset;
+  /* Range of coordinates along the first axis handled by this call */
+  const int x_start = ((mesh_complex *)map_data - frho) + offset[0];
   const int x_end = x_start + num;
 
-  /* Loop over the x range corresponding to this thread */
+  /* Loop over the range of the first axis corresponding to this thread */
   for (int x = x_start; x < x_end; x++) {
-    for (int y = 0; y < N; y++) {
-      for (int z = 0; z < N_half + 1; z++) {
+    for (int y = offset[1]; y < offset[1] + width[1]; y++) {
+      for (int z = offset[2]; z < offset[2] + width[2]; z++) {
 
         /* Compute the wavevector (U_L^-1) */
         const double k_x = (x > N_half) ? (x - N) * delta_k : x * delta_k;
@@ -502,8 +503,9 @@ void neutrino_response_apply_neutrino_response_mapper(void *map_data,
 #endif
 
         /* Apply to the mesh */
-        const int index =
-            N * (N_half + 1) * (x - slice_offset) + (N_half + 1) * y + z;
+        const size_t index =
+            ((size_t)(x - offset[0]) * width[1] + (y - offset[1])) * width[2] +
+            (z - offset[2]);
         frho[index][0] *= correction;
         frho[index][1] *= correction;
       }
@@ -518,16 +520,15 @@ void neutrino_response_apply_neutrino_response_mapper(void *map_data,
  * @param s The current #space
  * @param mesh The #pm_mesh used to store the potential
  * @param tp The #threadpool object used for parallelisation
- * @param frho The NxNx(N/2) complex array of the Fourier transform of the
- * density field
- * @param slice_offset The x coordinate of the start of the slice on this MPI
- * rank
- * @param slice_width The width of the local slice on this MPI rank
+ * @param frho The local block of the complex array of the Fourier transform
+ * of the density field (see mesh_apply_Green_function())
+ * @param offset The first index along each axis of the block on this MPI rank
+ * @param width The width along each axis of the block on this MPI rank
  * @param verbose Are we talkative?
  */
 void neutrino_response_compute(const struct space *s, struct pm_mesh *mesh,
-                               struct threadpool *tp, fftw_complex *frho,
-                               const int slice_offset, const int slice_width,
+                               struct threadpool *tp, mesh_complex *frho,
+                               const int offset[3], const int width[3],
                                int verbose) {
 #ifdef HAVE_FFTW
 
@@ -571,8 +572,10 @@ void neutrino_response_compute(const struct space *s, struct pm_mesh *mesh,
   data.frho = frho;
   data.N = N;
   data.boxlen = boxlen;
-  data.slice_offset = slice_offset;
-  data.slice_width = slice_width;
+  for (int i = 0; i < 3; i++) {
+    data.offset[i] = offset[i];
+    data.width[i] = width[i];
+  }
   data.inv_delta_log_k = inv_delta_log_k;
   data.log_k_min = log_k_min;
   data.a_index = a_index;
@@ -581,14 +584,15 @@ void neutrino_response_compute(const struct space *s, struct pm_mesh *mesh,
   data.pt_density_ratio = numesh->pt_density_ratio;
 
   /* Parallelize the neutrino linear response application using the threadpool
-     to split the x-axis loop over the threads. The array is N x N x (N/2).
-     We use the thread to each deal with a range [i_min, i_max[ x N x (N/2) */
+     to split the loop over the first axis over the threads. We use the thread
+     to each deal with a range [i_min, i_max[ x width[1] x width[2] */
   threadpool_map(tp, neutrino_response_apply_neutrino_response_mapper, frho,
-                 slice_width, sizeof(fftw_complex), threadpool_auto_chunk_size,
+                 width[0], sizeof(mesh_complex), threadpool_auto_chunk_size,
                  &data);
 
   /* Correct singularity at (0,0,0) */
-  if (slice_offset == 0 && slice_width > 0) {
+  if (offset[0] == 0 && offset[1] == 0 && offset[2] == 0 && width[0] > 0 &&
+      width[1] > 0 && width[2] > 0) {
     frho[0][0] = 0.;
     frho[0][1] = 0.;
   }
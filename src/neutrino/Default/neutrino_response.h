@@ -20,11 +20,8 @@
 #ifndef SWIFT_DEFAULT_NEUTRINO_RESPONSE_H
 #define SWIFT_DEFAULT_NEUTRINO_RESPONSE_H
 
-#ifdef HAVE_FFTW
-#include <fftw3.h>
-#endif
-
 #include "cosmology.h"
+#include "mesh_gravity_real.h"
 #include "neutrino_properties.h"
 #include "physical_constants.h"
 #include "units.h"
@@ -73,8 +70,8 @@ void neutrino_response_clean(struct neutrino_response *numesh);
 
 #ifdef HAVE_FFTW
 void neutrino_response_compute(const struct space *s, struct pm_mesh *mesh,
-                               struct threadpool *tp, fftw_complex *frho,
-                               const int slice_offset, const int slice_width,
+                               struct threadpool *tp, mesh_complex *frho,
+                               const int offset[3], const int width[3],
                                int verbose);
 #endif /* HAVE_FFTW */
 
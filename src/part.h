@@ -138,6 +138,51 @@ struct threadpool;
 #error "Invalid choice of sink particle"
 #endif
 
+/* Declare a field of a #part payload with the type of the #part member it
+ * carries. */
+#define PART_PAYLOAD_DECLARE_FIELD(name, member) \
+  __typeof__(((struct part *)NULL)->member) name;
+
+#ifdef hydro_mpi_rho_fields
+/**
+ * @brief The fields of a #part sent by the rho communications, as declared
+ * by the hydro scheme.
+ */
+struct part_rho_payload {
+  hydro_mpi_rho_fields(PART_PAYLOAD_DECLARE_FIELD)
+};
+#endif
+
+#ifdef hydro_mpi_gradient_fields
+/**
+ * @brief The fields of a #part sent by the gradient communications, as
+ * declared by the hydro scheme.
+ */
+struct part_gradient_payload {
+  hydro_mpi_gradient_fields(PART_PAYLOAD_DECLARE_FIELD)
+};
+#endif
+
+/* Declare a field of a #gpart payload with the type of the #gpart member it
+ * carries. */
+#define GPART_PAYLOAD_DECLARE_FIELD(name, member) \
+  __typeof__(((struct gpart *)NULL)->member) name;
+
+/**
+ * @brief The data of a #gpart sent by the encoded gpart communications.
+ *
+ * The position is sent in single precision relative to the centre of the
+ * cell, which is about as precise as the gravity caches, followed by the
+ * fields declared by the gravity scheme.
+ */
+struct gpart_foreign_payload {
+  float dx[3];
+  gravity_mpi_pp_fields(GPART_PAYLOAD_DECLARE_FIELD)
+#ifdef SWIFT_DEBUG_CHECKS
+  integertime_t ti_drift;
+#endif
+};
+
 void part_relink_gparts_to_parts(struct part *parts, const size_t N,
                                  const ptrdiff_t offset);
 void part_relink_gparts_to_sparts(struct spart *sparts, const size_t N,
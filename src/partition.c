@@ -85,6 +85,7 @@ static int check_complete(struct space *s, int verbose, int nregions);
  */
 #if defined(WITH_MPI) && (defined(HAVE_METIS) || defined(HAVE_PARMETIS))
 static double repartition_costs[task_type_count][task_subtype_count];
+static int repartition_have_fixed_costs = 0;
 #endif
 #if defined(WITH_MPI)
 static int repart_init_fixed_costs(void);
@@ -1363,6 +1364,7 @@ struct weights_mapper_data {
   int nr_cells;
   int use_ticks;
   struct cell *cells;
+  const struct cost_model *cost_model;
 };
 
 #ifdef SWIFT_DEBUG_CHECKS
@@ -1406,10 +1408,15 @@ void partition_gather_weights(void *map_data, int num_elements,
         t->type == task_type_csds || t->implicit || t->ci == NULL)
       continue;
 
-    /* Get weight for this task. Either based on fixed costs or task timings. */
+    /* Get weight for this task. Either based on task timings or fixed costs,
+     * replaced by the learned ones when none were compiled in. */
     double w = 0.0;
     if (use_ticks) {
       w = (double)t->toc - (double)t->tic;
+    } else if (!repartition_have_fixed_costs &&
+               cost_model_is_trained(mydata->cost_model)) {
+      w = cost_model_cost(mydata->cost_model, t->type, t->subtype,
+                          scheduler_task_cost_estimate(t, nodeID));
     } else {
       w = repartition_costs[t->type][t->subtype];
     }
@@ -1597,6 +1604,7 @@ static void repart_edge_metis(int vweights, int eweights, int timebins,
   weights_data.weights_e = weights_e;
   weights_data.weights_v = weights_v;
   weights_data.use_ticks = repartition->use_ticks;
+  weights_data.cost_model = &s->e->sched.cost_model;
 
   ticks tic = getticks();
 
@@ -2204,7 +2212,12 @@ void partition_init(struct partition *partition,
   /* Check if this is true or required and initialise them. */
   if (repartition->use_fixed_costs || repartition->trigger > 1) {
     if (!repart_init_fixed_costs()) {
-      if (repartition->trigger <= 1) {
+      if (parser_get_opt_param_int(params, "Scheduler:cost_model", 1)) {
+        if (engine_rank == 0)
+          message(
+              "No compiled fixed costs, using the costs learned by the"
+              " scheduler instead.");
+      } else if (repartition->trigger <= 1) {
         if (engine_rank == 0)
           message(
               "WARNING: fixed cost repartitioning was requested but is"
@@ -2262,6 +2275,7 @@ static int repart_init_fixed_costs(void) {
   }
 
 #include <partition_fixed_costs.h>
+  repartition_have_fixed_costs = HAVE_FIXED_COSTS;
   return HAVE_FIXED_COSTS;
 #endif
 
@@ -2357,10 +2371,15 @@ static void check_weights(struct task *tasks, int nr_tasks,
         t->type == task_type_csds || t->implicit || t->ci == NULL)
       continue;
 
-    /* Get weight for this task. Either based on fixed costs or task timings. */
+    /* Get weight for this task. Either based on task timings or fixed costs,
+     * replaced by the learned ones when none were compiled in. */
     double w = 0.0;
     if (use_ticks) {
       w = (double)t->toc - (double)t->tic;
+    } else if (!repartition_have_fixed_costs &&
+               cost_model_is_trained(mydata->cost_model)) {
+      w = cost_model_cost(mydata->cost_model, t->type, t->subtype,
+                          scheduler_task_cost_estimate(t, nodeID));
     } else {
       w = repartition_costs[t->type][t->subtype];
     }
@@ -102,6 +102,158 @@ int queue_sift_down(struct queue *q, int ind) {
   return ind;
 }
 
+/**
+ * @brief Comparison function for sorting #queue_entry by increasing weight.
+ */
+int queue_entry_cmp(const void *a, const void *b) {
+  const struct queue_entry *ea = (const struct queue_entry *)a;
+  const struct queue_entry *eb = (const struct queue_entry *)b;
+  return (ea->weight > eb->weight) - (ea->weight < eb->weight);
+}
+
+/**
+ * @brief Replace the buffer of the work-stealing deque by one twice as large.
+ *
+ * The old buffer is kept alive as thieves may still be reading from it.
+ *
+ * @param q The #queue, assumed to be locked.
+ * @param top The current top of the deque.
+ * @param bottom The current bottom of the deque.
+ *
+ * @return The new buffer.
+ */
+struct queue_deque_buffer *queue_deque_grow(struct queue *q, long long top,
+                                            long long bottom) {
+
+  struct queue_deque_buffer *old = q->deque;
+  const long long size = old->size * queue_sizegrow;
+
+  struct queue_deque_buffer *buff = (struct queue_deque_buffer *)malloc(
+      sizeof(struct queue_deque_buffer) + sizeof(int) * size);
+  if (buff == NULL) error("Failed to grow the queue deque.");
+  buff->size = size;
+  buff->prev = old;
+
+  /* Copy over the live entries, they keep the same logical index. */
+  for (long long k = top; k < bottom; k++)
+    buff->tids[k & (size - 1)] = old->tids[k & (old->size - 1)];
+
+  /* Make sure the copy is visible before the new buffer is. */
+  __sync_synchronize();
+  q->deque = buff;
+
+  return buff;
+}
+
+/**
+ * @brief Push a task at the bottom (owner end) of the work-stealing deque.
+ *
+ * @param q The #queue, assumed to be locked.
+ * @param tid The offset of the task in the task list.
+ */
+void queue_deque_push(struct queue *q, int tid) {
+
+  const long long bottom = q->deque_bottom;
+  const long long top = q->deque_top;
+  struct queue_deque_buffer *buff = q->deque;
+
+  /* Does the deque need to be grown? */
+  if (bottom - top >= buff->size) buff = queue_deque_grow(q, top, bottom);
+
+  buff->tids[bottom & (buff->size - 1)] = tid;
+
+  /* Publish the entry before moving the bottom. */
+  __sync_synchronize();
+  q->deque_bottom = bottom + 1;
+}
+
+/**
+ * @brief Pop a task from the bottom (owner end) of the work-stealing deque.
+ *
+ * @param q The #queue, assumed to be locked.
+ *
+ * @return The offset of the task in the task list or -1 if the deque is
+ * empty (or the last entry was stolen under our feet).
+ */
+int queue_deque_pop(struct queue *q) {
+
+  const long long bottom = q->deque_bottom - 1;
+  q->deque_bottom = bottom;
+  __sync_synchronize();
+  const long long top = q->deque_top;
+
+  /* Empty deque? */
+  if (top > bottom) {
+    q->deque_bottom = bottom + 1;
+    return -1;
+  }
+
+  struct queue_deque_buffer *buff = q->deque;
+  int tid = buff->tids[bottom & (buff->size - 1)];
+
+  /* Last entry, race the thieves for it. */
+  if (top == bottom) {
+    if (atomic_cas(&q->deque_top, top, top + 1) != top) tid = -1;
+    q->deque_bottom = bottom + 1;
+  }
+
+  return tid;
+}
+
+/**
+ * @brief Move all tasks in the incoming DEQ to the work-stealing deque.
+ *
+ * This is the weight-aware layer of the deque: each batch of incoming tasks
+ * is pushed in order of increasing weight, such that the owner pops the
+ * heaviest tasks first whilst thieves take the lightest of the oldest ones.
+ *
+ * @param q The #queue, assumed to be locked.
+ */
+void queue_deque_get_incoming(struct queue *q) {
+
+  struct queue_entry *entries = q->entries;
+  int count = 0;
+
+  /* Loop over the incoming DEQ. */
+  while (1) {
+
+    /* Is there a next element? */
+    const int ind = q->first_incoming % queue_incoming_size;
+    if (q->tid_incoming[ind] < 0) break;
+
+    /* Get the next offset off the DEQ. */
+    const int offset = atomic_swap(&q->tid_incoming[ind], -1);
+    atomic_inc(&q->first_incoming);
+
+    /* Does the batch need to be grown? */
+    if (count == q->size) {
+      struct queue_entry *temp;
+      q->size *= queue_sizegrow;
+      if ((temp = (struct queue_entry *)malloc(sizeof(struct queue_entry) *
+                                               q->size)) == NULL)
+        error("Failed to allocate new indices.");
+      memcpy(temp, entries, sizeof(struct queue_entry) * count);
+      free(entries);
+      q->entries = entries = temp;
+    }
+
+    entries[count].tid = offset;
+    entries[count].weight = q->tasks[offset].weight;
+    count += 1;
+  }
+
+  if (count == 0) return;
+
+  /* Lightest first, so that the heaviest end up at the owner's end. */
+  if (count > 1)
+    qsort(entries, count, sizeof(struct queue_entry), queue_entry_cmp);
+
+  for (int k = 0; k < count; k++) {
+    queue_deque_push(q, entries[k].tid);
+    atomic_dec(&q->count_incoming);
+  }
+}
+
 /**
  * @brief Enqueue all tasks in the incoming DEQ.
  *
@@ -109,6 +261,11 @@ int queue_sift_down(struct queue *q, int ind) {
  */
 void queue_get_incoming(struct queue *q) {
 
+  if (q->use_deque) {
+    queue_deque_get_incoming(q);
+    return;
+  }
+
   struct queue_entry *entries = q->entries;
 
   /* Loop over the incoming DEQ. */
@@ -188,8 +345,9 @@ void queue_insert(struct queue *q, struct task *t) {
  *
  * @param q The #queue.
  * @param tasks List of tasks to which the queue indices refer to.
+ * @param use_deque Use a work-stealing deque rather than a binary heap?
  */
-void queue_init(struct queue *q, struct task *tasks) {
+void queue_init(struct queue *q, struct task *tasks, int use_deque) {
 
   /* Allocate the task list if needed. */
   q->size = queue_sizeinit;
@@ -216,6 +374,100 @@ void queue_init(struct queue *q, struct task *tasks) {
   q->first_incoming = 0;
   q->last_incoming = 0;
   q->count_incoming = 0;
+
+  /* Init the work-stealing deque. */
+  q->use_deque = use_deque;
+  q->deque = NULL;
+  q->deque_top = 0;
+  q->deque_bottom = 0;
+  if (use_deque) {
+    if ((q->deque = (struct queue_deque_buffer *)malloc(
+             sizeof(struct queue_deque_buffer) +
+             sizeof(int) * queue_deque_sizeinit)) == NULL)
+      error("Failed to allocate queue deque.");
+    q->deque->size = queue_deque_sizeinit;
+    q->deque->prev = NULL;
+  }
+}
+
+/**
+ * @brief Get a task from the owner end of the work-stealing deque.
+ *
+ * Tasks that cannot be locked are put back once we found one we can run.
+ *
+ * @param q The task #queue, assumed to be locked.
+ */
+struct task *queue_deque_gettask(struct queue *q) {
+
+  struct task *qtasks = q->tasks;
+  struct task *res = NULL;
+  int failed[queue_search_window];
+  int nr_failed = 0;
+
+  /* Fill any tasks from the incoming DEQ. */
+  queue_get_incoming(q);
+
+  while (nr_failed < queue_search_window) {
+    const int tid = queue_deque_pop(q);
+    if (tid < 0) break;
+
+    /* Try to lock the task. */
+    if (task_lock(&qtasks[tid])) {
+      res = &qtasks[tid];
+      break;
+    }
+    failed[nr_failed++] = tid;
+  }
+
+  /* Put back the tasks we could not lock, in their original order. */
+  for (int k = nr_failed - 1; k >= 0; k--) queue_deque_push(q, failed[k]);
+
+  return res;
+}
+
+/**
+ * @brief Steal a task free of dependencies and conflicts from the given queue.
+ *
+ * With a work-stealing deque this is lock-free unless the queue's incoming
+ * DEQ needs flushing. Stolen tasks that cannot be locked are handed back to
+ * the owner through the incoming DEQ. With a binary heap this is just a
+ * non-blocking #queue_gettask().
+ *
+ * @param q The task #queue to steal from.
+ */
+struct task *queue_steal(struct queue *q) {
+
+  if (!q->use_deque) return queue_gettask(q, NULL, 0);
+
+  for (int tries = 0; tries < queue_search_window; tries++) {
+
+    const long long top = q->deque_top;
+    __sync_synchronize();
+    const long long bottom = q->deque_bottom;
+
+    /* Nothing in the deque, flush the incoming DEQ if nobody else is. */
+    if (top >= bottom) {
+      if (q->count_incoming == 0 || lock_trylock(&q->lock) != 0) return NULL;
+      queue_get_incoming(q);
+      if (lock_unlock(&q->lock) != 0) error("Unlocking the qlock failed.\n");
+      if (q->deque_bottom <= q->deque_top) return NULL;
+      continue;
+    }
+
+    struct queue_deque_buffer *buff = q->deque;
+    const int tid = buff->tids[top & (buff->size - 1)];
+
+    /* Lost the race against the owner or another thief? */
+    if (atomic_cas(&q->deque_top, top, top + 1) != top) continue;
+
+    struct task *res = &q->tasks[tid];
+    if (task_lock(res)) return res;
+
+    /* Conflict, give it back. */
+    queue_insert(q, res);
+  }
+
+  return NULL;
 }
 
 /**
@@ -238,6 +490,13 @@ struct task *queue_gettask(struct queue *q, const struct task *prev,
     if (lock_trylock(qlock) != 0) return NULL;
   }
 
+  /* Work-stealing deque? */
+  if (q->use_deque) {
+    res = queue_deque_gettask(q);
+    if (lock_unlock(qlock) != 0) error("Unlocking the qlock failed.\n");
+    return res;
+  }
+
   /* Fill any tasks from the incoming DEQ. */
   queue_get_incoming(q);
 
@@ -312,6 +571,13 @@ void queue_clean(struct queue *q) {
 
   free(q->entries);
   free(q->tid_incoming);
+
+  struct queue_deque_buffer *buff = q->deque;
+  while (buff != NULL) {
+    struct queue_deque_buffer *prev = buff->prev;
+    free(buff);
+    buff = prev;
+  }
 }
 
 /**
@@ -340,6 +606,18 @@ void queue_dump(int nodeID, int index, FILE *file, struct queue *q) {
             taskID_names[t->type], subtaskID_names[t->subtype], t->weight);
   }
 
+  /* And over the deque entries, from the owner end. */
+  if (q->use_deque) {
+    struct queue_deque_buffer *buff = q->deque;
+    int k = 0;
+    for (long long i = q->deque_bottom - 1; i >= q->deque_top; i--, k++) {
+      struct task *t = &q->tasks[buff->tids[i & (buff->size - 1)]];
+
+      fprintf(file, "%d %d %d %s %s %.2f\n", nodeID, index, k,
+              taskID_names[t->type], subtaskID_names[t->subtype], t->weight);
+    }
+  }
+
   /* Release the task lock. */
   if (lock_unlock(qlock) != 0) error("Unlocking the qlock failed.\n");
 }
@@ -21,6 +21,7 @@
 
 /* Includes. */
 #include "cell.h"
+#include "inline.h"
 #include "lock.h"
 #include "task.h"
 
@@ -31,6 +32,7 @@
 #define queue_search_window 8
 #define queue_incoming_size 10240
 #define queue_struct_align 64
+#define queue_deque_sizeinit 1024
 
 /* Constants dealing with task de-priorization. */
 #define queue_lock_fail_reweight_factor 0.5
@@ -56,6 +58,21 @@ struct queue_entry {
   float weight;
 };
 
+/** Circular buffer backing the work-stealing deque of a #queue. Buffers are
+ * only ever replaced by larger ones, the old ones are kept alive until the
+ * queue is cleaned since thieves may still be reading from them. */
+struct queue_deque_buffer {
+
+  /* Number of slots, always a power of two. */
+  long long size;
+
+  /* The previous (smaller) buffer, if any. */
+  struct queue_deque_buffer *prev;
+
+  /* The task indices. */
+  int tids[];
+};
+
 /** The queue struct. */
 struct queue {
 
@@ -75,12 +92,38 @@ struct queue {
   int *tid_incoming;
   volatile unsigned int first_incoming, last_incoming, count_incoming;
 
+  /* Are we using the work-stealing deque rather than the binary heap? */
+  int use_deque;
+
+  /* Chase-Lev deque. The owner end (bottom) is only touched with the queue
+   * lock held, thieves only ever CAS the top. */
+  struct queue_deque_buffer *volatile deque;
+  volatile long long deque_top
+      __attribute__((aligned(queue_struct_align)));
+  volatile long long deque_bottom
+      __attribute__((aligned(queue_struct_align)));
+
 } __attribute__((aligned(queue_struct_align)));
 
+/**
+ * @brief Approximate number of tasks held in a #queue.
+ *
+ * This is not exact as the queue may be modified concurrently, it is only
+ * meant as a hint for where to look for work.
+ *
+ * @param q The #queue.
+ */
+__attribute__((always_inline)) INLINE static int queue_count(
+    const struct queue *q) {
+  return q->count + (int)q->count_incoming +
+         (int)(q->deque_bottom - q->deque_top);
+}
+
 /* Function prototypes. */
 struct task *queue_gettask(struct queue *q, const struct task *prev,
                            int blocking);
-void queue_init(struct queue *q, struct task *tasks);
+struct task *queue_steal(struct queue *q);
+void queue_init(struct queue *q, struct task *tasks, int use_deque);
 void queue_insert(struct queue *q, struct task *t);
 void queue_clean(struct queue *q);
 
@@ -28,17 +28,25 @@
 /* Standard headers. */
 #include "engine.h"
 #include "error.h"
+#include "memuse.h"
 #include "restart.h"
 #include "version.h"
 
 #include <errno.h>
 #include <glob.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 /* The signature for restart files. */
 #define SWIFT_RESTART_SIGNATURE "SWIFT-restart-file"
 #define SWIFT_RESTART_END_SIGNATURE "SWIFT-restart-file:end"
@@ -46,12 +54,83 @@
 #define FNAMELEN 200
 #define LABLEN 20
 
+/* Label of the block that starts a compressed restart file. */
+#define SWIFT_RESTART_COMPRESSED_LABEL "compressed"
+
+/* Label of the blocks padding the large arrays to aligned offsets. */
+#define SWIFT_RESTART_PADDING_LABEL "padding"
+
+/* Size of the chunks used to stage and compress asynchronous dumps. */
+#define RESTART_CHUNK_SIZE (64 * 1024 * 1024)
+
+/* File alignment of the large arrays, a multiple of the usual page sizes. */
+#define RESTART_ALIGN 65536
+
+/* Maximum number of arrays mapped from a restart file. */
+#define RESTART_MAX_MAPPED 8
+
+/* Size of the reads done by the prefetch thread. */
+#define RESTART_PREFETCH_SIZE (4 * 1024 * 1024)
+
 /* Structure for a dumped header. */
 struct header {
   size_t len;             /* Total length of data in bytes. */
   char label[LABLEN + 1]; /* A label for data */
 };
 
+/* Description of the compression used by a compressed restart file. The
+ * rest of the file is a sequence of chunks, each a pair of uint64_t giving
+ * the uncompressed and compressed sizes followed by the compressed data. */
+struct restart_compression_info {
+  int method;        /* Compression method, only zlib (1) for now. */
+  size_t chunk_size; /* Maximal uncompressed size of a chunk. */
+  size_t total_size; /* Total uncompressed size of the restart data. */
+};
+
+/* A chunk of restart data staged in memory. */
+struct restart_chunk {
+  size_t size;
+  char *data;
+  struct restart_chunk *next;
+};
+
+/* State of the asynchronous restart writer. Only one dump can be in flight
+ * at any time. */
+static struct {
+  pthread_t thread;
+  int running;
+  struct restart_chunk *first;
+  struct restart_chunk *last;
+  size_t total_size;
+  int compression;
+  int verbose;
+  char tmpname[FNAMELEN];
+  char filename[FNAMELEN];
+  ticks tic;
+} restart_async;
+
+/* A range of a restart file mapped into memory. */
+struct restart_range {
+  off_t offset;
+  size_t size;
+};
+
+/* State of the restart file being read, when the large arrays are mapped
+ * rather than read. */
+static struct {
+  int enabled;
+  FILE *stream;
+  int nr_ranges;
+  struct restart_range ranges[RESTART_MAX_MAPPED];
+} restart_map;
+
+/* Work of the thread prefetching the mapped arrays. */
+struct restart_prefetch {
+  int fd;
+  int nr_ranges;
+  struct restart_range ranges[RESTART_MAX_MAPPED];
+};
+
 /**
  * @brief generate a name for a restart file.
  *
@@ -120,9 +199,177 @@ void restart_locate_free(int nfiles, char **files) {
   free(files);
 }
 
+/**
+ * @brief Write function of the stream used to stage asynchronous dumps.
+ *
+ * Appends the data to the list of chunks of the asynchronous writer.
+ */
+static ssize_t restart_staging_write(void *cookie, const char *buf,
+                                     size_t size) {
+
+  size_t done = 0;
+  while (done < size) {
+
+    /* Need a new chunk? */
+    struct restart_chunk *chunk = restart_async.last;
+    if (chunk == NULL || chunk->size == RESTART_CHUNK_SIZE) {
+      chunk = (struct restart_chunk *)malloc(sizeof(struct restart_chunk));
+      if (chunk == NULL) return done > 0 ? (ssize_t)done : -1;
+      chunk->data = (char *)malloc(RESTART_CHUNK_SIZE);
+      if (chunk->data == NULL) {
+        free(chunk);
+        return done > 0 ? (ssize_t)done : -1;
+      }
+      chunk->size = 0;
+      chunk->next = NULL;
+      if (restart_async.last == NULL)
+        restart_async.first = chunk;
+      else
+        restart_async.last->next = chunk;
+      restart_async.last = chunk;
+    }
+
+    const size_t count = min(size - done, RESTART_CHUNK_SIZE - chunk->size);
+    memcpy(&chunk->data[chunk->size], &buf[done], count);
+    chunk->size += count;
+    done += count;
+  }
+
+  restart_async.total_size += size;
+  return size;
+}
+
+/**
+ * @brief Seek function of the stream used to stage asynchronous dumps.
+ *
+ * Only reports the current position, which is all ftell() needs.
+ */
+static int restart_staging_seek(void *cookie, off64_t *offset, int whence) {
+
+  const off64_t pos = restart_async.total_size;
+  if ((whence == SEEK_CUR && *offset == 0) ||
+      (whence == SEEK_SET && *offset == pos)) {
+    *offset = pos;
+    return 0;
+  }
+  return -1;
+}
+
+/**
+ * @brief Write a chunk of restart data, compressing it if requested.
+ *
+ * @param chunk the #restart_chunk.
+ * @param stream the file stream.
+ * @param buffer a buffer for the compressed data, large enough for any chunk.
+ * @param buffer_size the size of the buffer.
+ */
+static void restart_write_chunk(const struct restart_chunk *chunk, FILE *stream,
+                                char *buffer, size_t buffer_size) {
+
+  if (restart_async.compression == 0) {
+    if (fwrite(chunk->data, 1, chunk->size, stream) != chunk->size)
+      error("Failed to write restart file %s (%s)", restart_async.tmpname,
+            strerror(errno));
+    return;
+  }
+
+#ifdef HAVE_ZLIB
+  uLongf comp_size = buffer_size;
+  const int res = compress2((Bytef *)buffer, &comp_size,
+                            (const Bytef *)chunk->data, chunk->size,
+                            restart_async.compression);
+  if (res != Z_OK)
+    error("Failed to compress restart data (zlib error %d)", res);
+
+  const uint64_t sizes[2] = {chunk->size, comp_size};
+  if (fwrite(sizes, sizeof(uint64_t), 2, stream) != 2 ||
+      fwrite(buffer, 1, comp_size, stream) != comp_size)
+    error("Failed to write restart file %s (%s)", restart_async.tmpname,
+          strerror(errno));
+#else
+  error("SWIFT was not compiled with zlib, cannot compress restart files.");
+#endif
+}
+
+/**
+ * @brief Body of the thread writing the staged restart data to disk.
+ */
+static void *restart_write_thread(void *arg) {
+
+  FILE *stream = fopen(restart_async.tmpname, "w");
+  if (stream == NULL)
+    error("Failed to open restart file: %s (%s)", restart_async.tmpname,
+          strerror(errno));
+
+  /* Compressed files start with a block describing the compression. */
+  char *buffer = NULL;
+  size_t buffer_size = 0;
+  if (restart_async.compression > 0) {
+#ifdef HAVE_ZLIB
+    struct restart_compression_info info;
+    bzero(&info, sizeof(struct restart_compression_info));
+    info.method = 1;
+    info.chunk_size = RESTART_CHUNK_SIZE;
+    info.total_size = restart_async.total_size;
+    restart_write_blocks(&info, sizeof(struct restart_compression_info), 1,
+                         stream, SWIFT_RESTART_COMPRESSED_LABEL,
+                         "compression information");
+
+    buffer_size = compressBound(RESTART_CHUNK_SIZE);
+    buffer = (char *)malloc(buffer_size);
+    if (buffer == NULL) error("Failed to allocate restart compression buffer");
+#endif
+  }
+
+  struct restart_chunk *chunk = restart_async.first;
+  while (chunk != NULL) {
+    restart_write_chunk(chunk, stream, buffer, buffer_size);
+
+    struct restart_chunk *next = chunk->next;
+    free(chunk->data);
+    free(chunk);
+    chunk = next;
+  }
+  restart_async.first = restart_async.last = NULL;
+  free(buffer);
+
+  if (fclose(stream) != 0)
+    error("Failed to close restart file %s (%s)", restart_async.tmpname,
+          strerror(errno));
+
+  /* Only now does the file take its final name. */
+  if (rename(restart_async.tmpname, restart_async.filename) != 0)
+    error("Failed to rename restart file '%s' to '%s' (%s)",
+          restart_async.tmpname, restart_async.filename, strerror(errno));
+
+  if (restart_async.verbose)
+    message("Writing restart file in the background took %.3f %s.",
+            clocks_from_ticks(getticks() - restart_async.tic),
+            clocks_getunit());
+
+  return NULL;
+}
+
+/**
+ * @brief Wait for any restart file still being written in the background to
+ *        be complete. Does nothing if there is none.
+ */
+void restart_write_wait(void) {
+
+  if (!restart_async.running) return;
+
+  if (pthread_join(restart_async.thread, NULL) != 0)
+    error("Failed to join the restart writer thread.");
+  restart_async.running = 0;
+}
+
 /**
  * @brief Write a restart file for the state of the given engine struct.
  *
+ * When asynchronous dumps are requested, the state is only copied to a
+ * staging area in memory and the file is compressed and written by a
+ * background thread. Use restart_write_wait() to wait for its completion.
+ *
  * @param e the engine with our state information.
  * @param filename name of the file to write the restart data to.
  */
@@ -130,9 +377,23 @@ void restart_write(struct engine *e, const char *filename) {
 
   ticks tic = getticks();
 
+  /* Only one dump at a time. */
+  restart_write_wait();
+
   /* Save a backup the existing restart file, if requested. */
   if (e->restart_save) restart_save_previous(filename);
 
+  /* Asynchronous dumps are written to a temporary file that is only renamed
+   * once complete, so that it cannot be mistaken for a valid restart file. */
+  const char *outname = filename;
+  if (e->restart_async) {
+    if (snprintf(restart_async.tmpname, FNAMELEN, "%s.tmp", filename) >=
+            FNAMELEN ||
+        snprintf(restart_async.filename, FNAMELEN, "%s", filename) >= FNAMELEN)
+      error("Restart file name too long: %s", filename);
+    outname = restart_async.tmpname;
+  }
+
   /* Use a single Lustre stripe with a rank-based OST offset? */
   if (e->restart_lustre_OST_count != 0) {
 
@@ -145,16 +406,26 @@ void restart_write(struct engine *e, const char *filename) {
 #endif
     char string[1200];
     sprintf(string, "lfs setstripe -c 1 -i %d %s",
-            ((e->nodeID + offset) % e->restart_lustre_OST_count), filename);
+            ((e->nodeID + offset) % e->restart_lustre_OST_count), outname);
     const int result = system(string);
     if (result != 0) {
       message("lfs setstripe command returned error code %d", result);
     }
   }
 
-  FILE *stream = fopen(filename, "w");
-  if (stream == NULL)
-    error("Failed to open restart file: %s (%s)", filename, strerror(errno));
+  FILE *stream;
+  if (e->restart_async) {
+    cookie_io_functions_t staging = {NULL, restart_staging_write,
+                                     restart_staging_seek, NULL};
+    restart_async.total_size = 0;
+    stream = fopencookie(NULL, "w", staging);
+    if (stream == NULL)
+      error("Failed to open restart staging stream (%s)", strerror(errno));
+  } else {
+    stream = fopen(outname, "w");
+    if (stream == NULL)
+      error("Failed to open restart file: %s (%s)", outname, strerror(errno));
+  }
 
   /* Dump our signature and version. */
   restart_write_blocks((void *)SWIFT_RESTART_SIGNATURE,
@@ -170,26 +441,236 @@ void restart_write(struct engine *e, const char *filename) {
                        strlen(SWIFT_RESTART_END_SIGNATURE), 1, stream,
                        "endsignature", "SWIFT end signature");
 
-  fclose(stream);
+  if (fclose(stream) != 0)
+    error("Failed to close restart file %s (%s)", outname, strerror(errno));
+
+  /* Hand the staged data over to the writer thread. */
+  if (e->restart_async) {
+    restart_async.compression = e->restart_compression;
+    restart_async.verbose = e->verbose;
+    restart_async.tic = tic;
+    if (pthread_create(&restart_async.thread, NULL, restart_write_thread,
+                       NULL) != 0)
+      error("Failed to create the restart writer thread.");
+    restart_async.running = 1;
+  }
 
   if (e->verbose)
     message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
             clocks_getunit());
 }
 
+#ifdef HAVE_ZLIB
+/* State of a stream decompressing a compressed restart file. */
+struct restart_inflate {
+  FILE *file;
+  char *raw;
+  size_t raw_size;
+  size_t pos;
+  char *comp;
+  size_t comp_alloc;
+};
+
+/**
+ * @brief Read function of the stream decompressing restart files.
+ *
+ * Serves the data of the current chunk, reading and decompressing the
+ * next one when exhausted.
+ */
+static ssize_t restart_inflate_read(void *cookie, char *buf, size_t size) {
+
+  struct restart_inflate *inf = (struct restart_inflate *)cookie;
+
+  size_t done = 0;
+  while (done < size) {
+
+    /* Next chunk needed? */
+    if (inf->pos == inf->raw_size) {
+      uint64_t sizes[2];
+      if (fread(sizes, sizeof(uint64_t), 2, inf->file) != 2) break;
+
+      if (sizes[1] > inf->comp_alloc) {
+        free(inf->comp);
+        inf->comp_alloc = sizes[1];
+        inf->comp = (char *)malloc(inf->comp_alloc);
+        if (inf->comp == NULL) return -1;
+      }
+      if (fread(inf->comp, 1, sizes[1], inf->file) != sizes[1]) return -1;
+
+      uLongf raw_size = sizes[0];
+      if (uncompress((Bytef *)inf->raw, &raw_size, (const Bytef *)inf->comp,
+                     sizes[1]) != Z_OK ||
+          raw_size != sizes[0])
+        return -1;
+      inf->raw_size = raw_size;
+      inf->pos = 0;
+    }
+
+    const size_t count = min(size - done, inf->raw_size - inf->pos);
+    memcpy(&buf[done], &inf->raw[inf->pos], count);
+    inf->pos += count;
+    done += count;
+  }
+  return done;
+}
+
+/**
+ * @brief Close function of the stream decompressing restart files.
+ */
+static int restart_inflate_close(void *cookie) {
+
+  struct restart_inflate *inf = (struct restart_inflate *)cookie;
+  const int res = fclose(inf->file);
+  free(inf->raw);
+  free(inf->comp);
+  free(inf);
+  return res;
+}
+#endif
+
+/**
+ * @brief Open a restart file for reading, decompressing it on the fly if it
+ *        was written compressed. Legacy files are returned as is.
+ *
+ * @param filename name of the restart file.
+ *
+ * @result the stream to read the restart data from.
+ */
+static FILE *restart_open(const char *filename) {
+
+  FILE *stream = fopen(filename, "r");
+  if (stream == NULL)
+    error("Failed to open restart file: %s (%s)", filename, strerror(errno));
+
+  /* Compressed files start with a block describing the compression, legacy
+   * ones directly with the signature. */
+  struct header head;
+  if (fread(&head, sizeof(struct header), 1, stream) != 1)
+    error("Failed to read the first header from restart file %s (%s)",
+          filename, strerror(errno));
+  head.label[LABLEN] = '\0';
+  if (strcmp(head.label, SWIFT_RESTART_COMPRESSED_LABEL) != 0 ||
+      head.len != sizeof(struct restart_compression_info)) {
+    rewind(stream);
+    return stream;
+  }
+
+  struct restart_compression_info info;
+  if (fread(&info, sizeof(struct restart_compression_info), 1, stream) != 1)
+    error("Failed to read the compression information of restart file %s",
+          filename);
+
+#ifdef HAVE_ZLIB
+  if (info.method != 1)
+    error("Unknown compression method %d in restart file %s", info.method,
+          filename);
+
+  struct restart_inflate *inf =
+      (struct restart_inflate *)calloc(1, sizeof(struct restart_inflate));
+  if (inf == NULL) error("Failed to allocate restart decompression state");
+  inf->file = stream;
+  inf->raw = (char *)malloc(info.chunk_size);
+  if (inf->raw == NULL)
+    error("Failed to allocate restart decompression buffer");
+
+  cookie_io_functions_t inflate = {restart_inflate_read, NULL, NULL,
+                                   restart_inflate_close};
+  FILE *decompressed = fopencookie(inf, "r", inflate);
+  if (decompressed == NULL)
+    error("Failed to open decompression stream for restart file %s (%s)",
+          filename, strerror(errno));
+  return decompressed;
+#else
+  error(
+      "Restart file %s is compressed but SWIFT was not compiled with zlib "
+      "(compression method %d).",
+      filename, info.method);
+  return NULL;
+#endif
+}
+
+/**
+ * @brief Body of the thread reading the mapped arrays of a restart file
+ *        into the page cache ahead of their use.
+ */
+static void *restart_prefetch_thread(void *arg) {
+
+  struct restart_prefetch *pf = (struct restart_prefetch *)arg;
+
+  char *buffer = (char *)malloc(RESTART_PREFETCH_SIZE);
+  for (int k = 0; k < pf->nr_ranges && buffer != NULL; k++) {
+    off_t offset = pf->ranges[k].offset;
+    const off_t end = offset + pf->ranges[k].size;
+    while (offset < end) {
+      const ssize_t nread =
+          pread(pf->fd, buffer, RESTART_PREFETCH_SIZE, offset);
+      if (nread <= 0) break;
+      offset += nread;
+    }
+  }
+
+  /* Only a hint, so failures are of no consequence. */
+  free(buffer);
+  close(pf->fd);
+  free(pf);
+  return NULL;
+}
+
+/**
+ * @brief Start a thread prefetching the arrays mapped from a restart file.
+ *
+ * @param stream the restart file stream.
+ */
+static void restart_prefetch_start(FILE *stream) {
+
+  if (restart_map.nr_ranges == 0) return;
+
+  struct restart_prefetch *pf =
+      (struct restart_prefetch *)malloc(sizeof(struct restart_prefetch));
+  if (pf == NULL) error("Failed to allocate restart prefetch work.");
+
+  /* The thread needs its own descriptor as the stream is closed soon. */
+  pf->fd = dup(fileno(stream));
+  if (pf->fd < 0) error("Failed to duplicate restart file descriptor.");
+  pf->nr_ranges = restart_map.nr_ranges;
+  memcpy(pf->ranges, restart_map.ranges,
+         restart_map.nr_ranges * sizeof(struct restart_range));
+
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, restart_prefetch_thread, pf) != 0)
+    error("Failed to create the restart prefetch thread.");
+  pthread_detach(thread);
+}
+
 /**
  * @brief Read a restart file to construct a saved engine struct state.
  *
  * @param e the engine to recover from the saved state.
  * @param filename name of the file containing the staved state.
+ * @param mapped whether to map the large particle arrays into memory rather
+ *               than reading them, only possible for uncompressed files.
+ * @param prefetch whether to start a thread reading the mapped arrays in the
+ *                 background.
  */
-void restart_read(struct engine *e, const char *filename) {
+void restart_read(struct engine *e, const char *filename, int mapped,
+                  int prefetch) {
 
   const ticks tic = getticks();
 
-  FILE *stream = fopen(filename, "r");
-  if (stream == NULL)
-    error("Failed to open restart file: %s (%s)", filename, strerror(errno));
+  FILE *stream = restart_open(filename);
+
+  /* Arrays can only be mapped from the file itself. */
+  restart_map.enabled = 0;
+  restart_map.stream = stream;
+  restart_map.nr_ranges = 0;
+  if (mapped) {
+    struct stat buf;
+    if (fstat(fileno(stream), &buf) == 0 && S_ISREG(buf.st_mode))
+      restart_map.enabled = 1;
+    else
+      message("Cannot map arrays from restart file %s, reading them instead.",
+              filename);
+  }
 
   /* Get our version and signature back. These should match. */
   char signature[strlen(SWIFT_RESTART_SIGNATURE) + 1];
@@ -216,6 +697,13 @@ void restart_read(struct engine *e, const char *filename) {
         package_version(), version);
 
   engine_struct_restore(e, stream);
+
+  if (e->verbose && restart_map.enabled)
+    message("Mapped %d arrays from the restart file.", restart_map.nr_ranges);
+  if (prefetch && restart_map.enabled) restart_prefetch_start(stream);
+  restart_map.enabled = 0;
+  restart_map.stream = NULL;
+
   fclose(stream);
 
   if (e->verbose)
@@ -223,6 +711,37 @@ void restart_read(struct engine *e, const char *filename) {
             clocks_getunit());
 }
 
+/**
+ * @brief Read the next header from a restart file stream, skipping any
+ *        padding blocks.
+ *
+ * @param head the #header to fill.
+ * @param stream the file stream
+ * @param errstr a context string to qualify any errors.
+ */
+static void restart_read_header(struct header *head, FILE *stream,
+                                const char *errstr) {
+  while (1) {
+    size_t nread = fread(head, sizeof(struct header), 1, stream);
+    if (nread != 1)
+      error("Failed to read the %s header from restart file (%s)", errstr,
+            strerror(errno));
+
+    head->label[LABLEN] = '\0';
+    if (strcmp(head->label, SWIFT_RESTART_PADDING_LABEL) != 0) return;
+
+    /* Skip the padding, by reading it as the stream may not seek. */
+    char padding[1024];
+    size_t left = head->len;
+    while (left > 0) {
+      const size_t count = min(left, sizeof(padding));
+      if (fread(padding, 1, count, stream) != count)
+        error("Failed to skip padding before %s in restart file", errstr);
+      left -= count;
+    }
+  }
+}
+
 /**
  * @brief Read blocks of memory from a file stream into a memory location.
  *        Exits the application if the read fails and does nothing if the
@@ -240,10 +759,7 @@ void restart_read_blocks(void *ptr, size_t size, size_t nblocks, FILE *stream,
                          char *label, const char *errstr) {
   if (size > 0) {
     struct header head;
-    size_t nread = fread(&head, sizeof(struct header), 1, stream);
-    if (nread != 1)
-      error("Failed to read the %s header from restart file (%s)", errstr,
-            strerror(errno));
+    restart_read_header(&head, stream, errstr);
 
     /* Check that the stored length is the same as the expected one. */
     if (head.len != nblocks * size)
@@ -251,18 +767,87 @@ void restart_read_blocks(void *ptr, size_t size, size_t nblocks, FILE *stream,
             errstr, head.len, nblocks * size);
 
     /* Return label, if required. */
-    if (label != NULL) {
-      head.label[LABLEN] = '\0';
-      strncpy(label, head.label, LABLEN + 1);
-    }
+    if (label != NULL) strncpy(label, head.label, LABLEN + 1);
 
-    nread = fread(ptr, size, nblocks, stream);
+    size_t nread = fread(ptr, size, nblocks, stream);
     if (nread != nblocks)
       error("Failed to restore %s from restart file (%s)", errstr,
             ferror(stream) ? strerror(errno) : "unexpected end of file");
   }
 }
 
+/**
+ * @brief Allocate an array and read its content from a file stream. The
+ *        array must have been written using restart_write_blocks_aligned().
+ *
+ *        When requested in restart_read(), the content is mapped from the
+ *        file rather than read, so that pages are only loaded when first
+ *        touched. The memory must always be released with swift_free().
+ *
+ * @param memlabel the label of the memory allocation, i.e. "parts".
+ * @param ptr pointer to the array, allocated by this function.
+ * @param alignment alignment boundary of the array.
+ * @param size size of a block
+ * @param nblocks number of blocks to read
+ * @param nalloc number of blocks to allocate, at least nblocks.
+ * @param stream the file stream
+ * @param errstr a context string to qualify any errors.
+ */
+void restart_read_blocks_aligned(const char *memlabel, void **ptr,
+                                 size_t alignment, size_t size, size_t nblocks,
+                                 size_t nalloc, FILE *stream,
+                                 const char *errstr) {
+
+  struct header head;
+  restart_read_header(&head, stream, errstr);
+
+  /* Check that the stored length is the same as the expected one. */
+  const size_t nbytes = nblocks * size;
+  if (head.len != nbytes)
+    error("Mismatched data length in restart file for %s (%zu != %zu)",
+          errstr, head.len, nbytes);
+
+  /* Can we map the data? It must start on a page boundary. */
+  const size_t page = sysconf(_SC_PAGESIZE);
+  const off_t offset = restart_map.enabled ? ftello(stream) : -1;
+  if (stream == restart_map.stream && offset >= 0 && offset % page == 0 &&
+      restart_map.nr_ranges < RESTART_MAX_MAPPED && alignment <= page) {
+
+    /* Reserve the whole array and map the file over its start. */
+    const size_t alloc_size = ((nalloc * size + page - 1) / page) * page;
+    const size_t map_size = ((nbytes + page - 1) / page) * page;
+    char *region = (char *)mmap(NULL, alloc_size, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                                -1, 0);
+    if (region == MAP_FAILED)
+      error("Failed to reserve memory for %s (%s)", errstr, strerror(errno));
+    if (mmap(region, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+             fileno(stream), offset) == MAP_FAILED)
+      error("Failed to map %s from restart file (%s)", errstr,
+            strerror(errno));
+
+    /* Move past the data. */
+    if (fseeko(stream, nbytes, SEEK_CUR) != 0)
+      error("Failed to skip %s in restart file (%s)", errstr, strerror(errno));
+
+    memuse_mapped_register(region, alloc_size);
+    memuse_log_allocation(memlabel, region, 1, alloc_size);
+    restart_map.ranges[restart_map.nr_ranges].offset = offset;
+    restart_map.ranges[restart_map.nr_ranges].size = nbytes;
+    restart_map.nr_ranges++;
+    *ptr = region;
+    return;
+  }
+
+  if (swift_memalign(memlabel, ptr, alignment, nalloc * size) != 0)
+    error("Failed to allocate restore %s array.", errstr);
+
+  size_t nread = fread(*ptr, size, nblocks, stream);
+  if (nread != nblocks)
+    error("Failed to restore %s from restart file (%s)", errstr,
+          ferror(stream) ? strerror(errno) : "unexpected end of file");
+}
+
 /**
  * @brief Write blocks of memory to a file stream from a memory location.
  *        Exits the application if the write fails and does nothing
@@ -297,6 +882,52 @@ void restart_write_blocks(void *ptr, size_t size, size_t nblocks, FILE *stream,
   }
 }
 
+/**
+ * @brief Write blocks of memory to a file stream, preceded by padding so that
+ *        the data starts at an offset that is a multiple of the page size.
+ *        Such arrays can be mapped back into memory by
+ *        restart_read_blocks_aligned().
+ *
+ * @param ptr pointer to the memory
+ * @param size the blocks
+ * @param nblocks number of blocks to write
+ * @param stream the file stream
+ * @param label a label for the content, can only be 20 characters.
+ * @param errstr a context string to qualify any errors.
+ */
+void restart_write_blocks_aligned(void *ptr, size_t size, size_t nblocks,
+                                  FILE *stream, const char *label,
+                                  const char *errstr) {
+  if (size == 0 || nblocks == 0) return;
+
+  const off_t pos = ftello(stream);
+  if (pos < 0)
+    error("Failed to get position in restart file (%s)", strerror(errno));
+
+  /* Add a padding block unless the data would already be aligned. */
+  const size_t hsize = sizeof(struct header);
+  if ((pos + hsize) % RESTART_ALIGN != 0) {
+    struct header head;
+    bzero(&head, sizeof(struct header));
+    head.len = (RESTART_ALIGN - (pos + 2 * hsize) % RESTART_ALIGN) %
+               RESTART_ALIGN;
+    strncpy(head.label, SWIFT_RESTART_PADDING_LABEL, LABLEN);
+
+    const char zeros[1024] = {0};
+    if (fwrite(&head, hsize, 1, stream) != 1)
+      error("Failed to save padding to restart file (%s)", strerror(errno));
+    size_t left = head.len;
+    while (left > 0) {
+      const size_t count = min(left, sizeof(zeros));
+      if (fwrite(zeros, 1, count, stream) != count)
+        error("Failed to save padding to restart file (%s)", strerror(errno));
+      left -= count;
+    }
+  }
+
+  restart_write_blocks(ptr, size, nblocks, stream, label, errstr);
+}
+
 /**
  * @brief check if the stop file exists in the given directory and optionally
  *        remove it if found.
@@ -24,7 +24,9 @@
 struct engine;
 
 void restart_write(struct engine *e, const char *filename);
-void restart_read(struct engine *e, const char *filename);
+void restart_read(struct engine *e, const char *filename, int mapped,
+                  int prefetch);
+void restart_write_wait(void);
 
 char **restart_locate(const char *dir, const char *basename, int *nfiles);
 void restart_locate_free(int nfiles, char **files);
@@ -35,6 +37,13 @@ void restart_read_blocks(void *ptr, size_t size, size_t nblocks, FILE *stream,
                          char *label, const char *errstr);
 void restart_write_blocks(void *ptr, size_t size, size_t nblocks, FILE *stream,
                           const char *label, const char *errstr);
+void restart_read_blocks_aligned(const char *memlabel, void **ptr,
+                                 size_t alignment, size_t size, size_t nblocks,
+                                 size_t nalloc, FILE *stream,
+                                 const char *errstr);
+void restart_write_blocks_aligned(void *ptr, size_t size, size_t nblocks,
+                                  FILE *stream, const char *label,
+                                  const char *errstr);
 
 int restart_stop_now(const char *dir, int cleanup);
 
@@ -29,9 +29,12 @@
 /* Local headers. */
 #include "cache.h"
 #include "gravity_cache.h"
+#include "gravity_m2l_cache.h"
 
 struct cell;
 struct engine;
+struct gpart_foreign_payload;
+struct sort_entry;
 struct task;
 
 /* Unique identifier of loop types */
@@ -72,6 +75,9 @@ struct runner {
   /*! The particle gravity_cache of cell cj. */
   struct gravity_cache cj_gravity_cache;
 
+  /*! The list of multipoles interacting with a field tensor (M2L). */
+  struct gravity_m2l_cache m2l_cache;
+
   /*! Time this runner was active during the last engine_launch. */
   ticks active_time;
 
@@ -103,6 +109,10 @@ void runner_do_hydro_sort(struct runner *r, struct cell *c, int flag,
                           int cleanup, int rt_requests_sort, int clock);
 void runner_do_stars_sort(struct runner *r, struct cell *c, int flag,
                           int cleanup, int clock);
+void runner_do_sort_ascending(struct sort_entry *sort, int N);
+void runner_do_sort_ascending_quicksort(struct sort_entry *sort, int N);
+void runner_do_sort_ascending_radix(struct sort_entry *sort, int N);
+int runner_do_sort_ascending_incremental(struct sort_entry *sort, int N);
 void runner_do_all_hydro_sort(struct runner *r, struct cell *c);
 void runner_do_all_stars_sort(struct runner *r, struct cell *c);
 void runner_do_drift_part(struct runner *r, struct cell *c, int timer);
@@ -144,7 +154,8 @@ void runner_do_star_formation_sink(struct runner *r, struct cell *c, int timer);
 void runner_do_sink_formation(struct runner *r, struct cell *c);
 void runner_do_stars_resort(struct runner *r, struct cell *c, const int timer);
 
-void runner_do_recv_gpart(struct runner *r, struct cell *c, int timer);
+void runner_do_recv_gpart(struct runner *r, struct cell *c,
+                          const struct gpart_foreign_payload *data, int timer);
 void runner_do_recv_part(struct runner *r, struct cell *c, int clear_sorts,
                          int timer);
 void runner_do_recv_spart(struct runner *r, struct cell *c, int clear_sorts,
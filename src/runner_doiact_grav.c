@@ -27,6 +27,7 @@
 #include "cell.h"
 #include "gravity.h"
 #include "gravity_cache.h"
+#include "gravity_m2l_cache.h"
 #include "gravity_iact.h"
 #include "inline.h"
 #include "part.h"
@@ -623,6 +624,10 @@ static INLINE void runner_dopair_grav_pp_full(
     swift_assume_size(gcount_padded_j, VEC_SIZE);
 
     /* Loop over every particle in the other cell. */
+#if defined(GRAVITY_PP_SIMD_LANES) && !defined(SWIFT_DEBUG_CHECKS) && \
+    !defined(SWIFT_GRAVITY_FORCE_CHECKS) && _OPENMP >= 201307
+#pragma omp simd simdlen(GRAVITY_PP_SIMD_LANES) reduction(+ : a_x, a_y, a_z, pot)
+#endif
     for (int pjd = 0; pjd < gcount_padded_j; pjd++) {
 
       /* Get info about j */
@@ -790,6 +795,10 @@ static INLINE void runner_dopair_grav_pp_truncated(
     swift_assume_size(gcount_padded_j, VEC_SIZE);
 
     /* Loop over every particle in the other cell. */
+#if defined(GRAVITY_PP_SIMD_LANES) && !defined(SWIFT_DEBUG_CHECKS) && \
+    !defined(SWIFT_GRAVITY_FORCE_CHECKS) && _OPENMP >= 201307
+#pragma omp simd simdlen(GRAVITY_PP_SIMD_LANES) reduction(+ : a_x, a_y, a_z, pot)
+#endif
     for (int pjd = 0; pjd < gcount_padded_j; pjd++) {
 
       /* Get info about j */
@@ -1520,6 +1529,10 @@ static INLINE void runner_doself_grav_pp_full(
     swift_assume_size(gcount_padded, VEC_SIZE);
 
     /* Loop over every other particle in the cell. */
+#if defined(GRAVITY_PP_SIMD_LANES) && !defined(SWIFT_DEBUG_CHECKS) && \
+    !defined(SWIFT_GRAVITY_FORCE_CHECKS) && _OPENMP >= 201307
+#pragma omp simd simdlen(GRAVITY_PP_SIMD_LANES) reduction(+ : a_x, a_y, a_z, pot)
+#endif
     for (int pjd = 0; pjd < gcount_padded; pjd++) {
 
       /* No self interaction */
@@ -1668,6 +1681,10 @@ static INLINE void runner_doself_grav_pp_truncated(
     swift_assume_size(gcount_padded, VEC_SIZE);
 
     /* Loop over every other particle in the cell. */
+#if defined(GRAVITY_PP_SIMD_LANES) && !defined(SWIFT_DEBUG_CHECKS) && \
+    !defined(SWIFT_GRAVITY_FORCE_CHECKS) && _OPENMP >= 201307
+#pragma omp simd simdlen(GRAVITY_PP_SIMD_LANES) reduction(+ : a_x, a_y, a_z, pot)
+#endif
     for (int pjd = 0; pjd < gcount_padded; pjd++) {
 
       /* No self interaction */
@@ -2044,6 +2061,96 @@ static INLINE void runner_dopair_grav_mm(struct runner *r,
     runner_dopair_grav_mm_nonsym(r, cj, ci);
 }
 
+/**
+ * @brief Computes the interaction of the field tensor in a cell with all the
+ * multipoles collected in the runner's #gravity_m2l_cache.
+ *
+ * The multipoles in the list must have been drifted to the current time.
+ * They are only read here, so only the multipole of ci needs to be locked.
+ *
+ * @param r The #runner.
+ * @param ci The #cell with field tensor to interact.
+ */
+static INLINE void runner_dopair_grav_mm_batch(struct runner *r,
+                                               struct cell *restrict ci) {
+
+  /* Some constants */
+  const struct engine *e = r->e;
+  const int periodic = e->mesh->periodic;
+  const float r_s_inv = e->mesh->r_s_inv;
+  struct gravity_m2l_cache *const m2l_cache = &r->m2l_cache;
+
+  TIMER_TIC;
+
+  /* Anything to do here? */
+  if (m2l_cache->nr_mpoles == 0) return;
+  if (!cell_is_active_gravity_mm(ci, e) || ci->nodeID != engine_rank) return;
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (ci->grav.multipole->pot.ti_init != e->ti_current)
+    error("ci->grav tensor not initialised.");
+#endif
+
+#ifndef SWIFT_TASKS_WITHOUT_ATOMICS
+  /* Lock the field tensor */
+  lock_lock(&ci->grav.mlock);
+#endif
+
+  /* Let's interact at this level with all the multipoles at once */
+  gravity_M2L_batch(&ci->grav.multipole->pot, m2l_cache, periodic, r_s_inv);
+
+#ifndef SWIFT_TASKS_WITHOUT_ATOMICS
+  /* Unlock the field tensor */
+  if (lock_unlock(&ci->grav.mlock) != 0) error("Failed to unlock multipole");
+#endif
+
+  TIMER_TOC(timer_dopair_grav_mm);
+}
+
+/**
+ * @brief Adds the multipole of a cell to the list of multipoles interacting
+ * with the field tensor of another cell.
+ *
+ * If the list is full, the interactions collected so far are applied first.
+ *
+ * @param r The #runner.
+ * @param ci The #cell with field tensor to interact.
+ * @param cj The #cell with the multipole.
+ */
+static INLINE void runner_dopair_grav_mm_add(struct runner *r,
+                                             struct cell *restrict ci,
+                                             const struct cell *restrict cj) {
+
+  const struct engine *e = r->e;
+  const int periodic = e->mesh->periodic;
+  const double dim[3] = {e->mesh->dim[0], e->mesh->dim[1], e->mesh->dim[2]};
+
+  /* Short-cut to the multipole */
+  const struct multipole *multi_j = &cj->grav.multipole->m_pole;
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (ci == cj) error("Interacting a cell with itself using M2L");
+
+  if (multi_j->num_gpart == 0)
+    error("Multipole does not seem to have been set.");
+
+  if (cj->grav.ti_old_multipole != e->ti_current)
+    error(
+        "Undrifted multipole cj->grav.ti_old_multipole=%lld cj->nodeID=%d "
+        "ci->nodeID=%d e->ti_current=%lld",
+        cj->grav.ti_old_multipole, cj->nodeID, ci->nodeID, e->ti_current);
+#endif
+
+  /* Make space in the list if need be */
+  if (gravity_m2l_cache_is_full(&r->m2l_cache)) {
+    runner_dopair_grav_mm_batch(r, ci);
+    gravity_m2l_cache_reset(&r->m2l_cache);
+  }
+
+  gravity_m2l_cache_add(&r->m2l_cache, multi_j, cj->grav.multipole->CoM,
+                        ci->grav.multipole->CoM, periodic, dim);
+}
+
 /**
  * @brief Computes all the M-M interactions between all the well-separated (at
  * rebuild) pairs of progenies of the two cells.
@@ -2064,7 +2171,7 @@ void runner_dopair_grav_mm_progenies(struct runner *r, const long long flags,
   runner_clear_grav_flags(ci, e);
   runner_clear_grav_flags(cj, e);
 
-  /* Loop over all pairs of progenies */
+  /* Drift all the progenies involved in an M-M interaction */
   for (int i = 0; i < 8; i++) {
     if (ci->progeny[i] != NULL) {
       for (int j = 0; j < 8; j++) {
@@ -2076,11 +2183,50 @@ void runner_dopair_grav_mm_progenies(struct runner *r, const long long flags,
           const int flag = i * 8 + j;
 
           /* Did we agree to use an M-M interaction here at the last rebuild? */
-          if (flags & (1ULL << flag)) runner_dopair_grav_mm(r, cpi, cpj);
+          if (flags & (1ULL << flag)) {
+            if (cpi->grav.ti_old_multipole < e->ti_current)
+              cell_drift_multipole(cpi, e);
+            if (cpj->grav.ti_old_multipole < e->ti_current)
+              cell_drift_multipole(cpj, e);
+          }
         }
       }
     }
   }
+
+  /* Interact each progeny of ci with the list of its partners in cj */
+  for (int i = 0; i < 8; i++) {
+    struct cell *cpi = ci->progeny[i];
+    if (cpi == NULL) continue;
+    if (!cell_is_active_gravity_mm(cpi, e) || cpi->nodeID != e->nodeID)
+      continue;
+
+    gravity_m2l_cache_reset(&r->m2l_cache);
+    for (int j = 0; j < 8; j++) {
+      struct cell *cpj = cj->progeny[j];
+      if (cpj != NULL && (flags & (1ULL << (i * 8 + j))))
+        runner_dopair_grav_mm_add(r, cpi, cpj);
+    }
+
+    runner_dopair_grav_mm_batch(r, cpi);
+  }
+
+  /* And now each progeny of cj with the list of its partners in ci */
+  for (int j = 0; j < 8; j++) {
+    struct cell *cpj = cj->progeny[j];
+    if (cpj == NULL) continue;
+    if (!cell_is_active_gravity_mm(cpj, e) || cpj->nodeID != e->nodeID)
+      continue;
+
+    gravity_m2l_cache_reset(&r->m2l_cache);
+    for (int i = 0; i < 8; i++) {
+      struct cell *cpi = ci->progeny[i];
+      if (cpi != NULL && (flags & (1ULL << (i * 8 + j))))
+        runner_dopair_grav_mm_add(r, cpj, cpi);
+    }
+
+    runner_dopair_grav_mm_batch(r, cpj);
+  }
 }
 
 void runner_dopair_recursive_grav_pm(struct runner *r, struct cell *ci,
@@ -2414,10 +2560,86 @@ void runner_doself_recursive_grav(struct runner *r, struct cell *c,
   if (gettimer) TIMER_TOC(timer_dosub_self_grav);
 }
 
+/**
+ * @brief Considers the M-M interaction between a cell and one of the
+ * top-level cells in the long-range gravity task.
+ *
+ * @param r The thread #runner.
+ * @param ci The #cell of interest.
+ * @param top The top-level (great-)parent of ci.
+ * @param cj The top-level #cell to interact with.
+ */
+static INLINE void runner_do_grav_long_range_pair(struct runner *r,
+                                                  struct cell *ci,
+                                                  const struct cell *top,
+                                                  const struct cell *cj) {
+
+  /* Some constants */
+  const struct engine *e = r->e;
+  const int periodic = e->mesh->periodic;
+  const double dim[3] = {e->mesh->dim[0], e->mesh->dim[1], e->mesh->dim[2]};
+  const double max_distance2 = e->mesh->r_cut_max * e->mesh->r_cut_max;
+
+  /* Get the multipoles information */
+  struct gravity_tensors *const multi_i = ci->grav.multipole;
+  const struct gravity_tensors *const multi_j = cj->grav.multipole;
+
+  /* Avoid self contributions */
+  if (top == cj) return;
+
+  /* Skip empty cells */
+  if (multi_j->m_pole.M_000 == 0.f) return;
+
+  /* Can we escape early in the periodic BC case? */
+  if (periodic) {
+
+    /* Minimal distance between any pair of particles */
+    const double min_radius2 = cell_min_dist2_same_size(top, cj, periodic, dim);
+
+    /* Are we beyond the distance where the truncated forces are 0 ?*/
+    if (min_radius2 > max_distance2) {
+
+#ifdef SWIFT_DEBUG_CHECKS
+      /* Need to account for the interactions we missed */
+      accumulate_add_ll(&multi_i->pot.num_interacted,
+                        multi_j->m_pole.num_gpart);
+#endif
+
+#ifdef SWIFT_GRAVITY_FORCE_CHECKS
+      /* Need to account for the interactions we missed */
+      accumulate_add_ll(&multi_i->pot.num_interacted_pm,
+                        multi_j->m_pole.num_gpart);
+#endif
+
+      /* Record that this multipole received a contribution */
+      multi_i->pot.interacted = 1;
+
+      /* We are done here. */
+      return;
+    }
+  }
+
+  if (cell_can_use_pair_mm(top, cj, e, e->s, /*use_rebuild_data=*/1,
+                           /*is_tree_walk=*/0)) {
+
+    /* Add the multipole to the list of interactions of ci */
+    runner_dopair_grav_mm_add(r, ci, cj);
+    // runner_dopair_recursive_grav_pm(r, ci, cj);
+
+    /* Record that this multipole received a contribution */
+    multi_i->pot.interacted = 1;
+
+  } /* We are in charge of this pair */
+}
+
 /**
  * @brief Performs all M-M interactions between a given top-level cell and all
  * the other top-levels that are far enough.
  *
+ * In the periodic case, only the top-level cells within the range of the
+ * truncated forces are visited, using the list of offsets constructed by
+ * space_regrid_gravity_offsets().
+ *
  * @param r The thread #runner.
  * @param ci The #cell of interest.
  * @param timer Are we timing this ?
@@ -2427,16 +2649,15 @@ void runner_do_grav_long_range(struct runner *r, struct cell *ci,
 
   /* Some constants */
   const struct engine *e = r->e;
+  const struct space *s = e->s;
   const int periodic = e->mesh->periodic;
-  const double dim[3] = {e->mesh->dim[0], e->mesh->dim[1], e->mesh->dim[2]};
-  const double max_distance2 = e->mesh->r_cut_max * e->mesh->r_cut_max;
 
   TIMER_TIC;
 
   /* Recover the list of top-level cells */
-  struct cell *cells = e->s->cells_top;
-  int *cells_with_particles = e->s->cells_with_particles_top;
-  const int nr_cells_with_particles = e->s->nr_cells_with_particles;
+  struct cell *cells = s->cells_top;
+  const int *cells_with_particles = s->cells_with_particles_top;
+  const int nr_cells_with_particles = s->nr_cells_with_particles;
 
   /* Anything to do here? */
   if (!cell_is_active_gravity(ci, e)) return;
@@ -2447,69 +2668,93 @@ void runner_do_grav_long_range(struct runner *r, struct cell *ci,
   /* Check multipole has been drifted */
   if (ci->grav.ti_old_multipole < e->ti_current) cell_drift_multipole(ci, e);
 
-  /* Get this cell's multipole information */
-  struct gravity_tensors *const multi_i = ci->grav.multipole;
-
   /* Find this cell's top-level (great-)parent */
   struct cell *top = ci;
   while (top->parent != NULL) top = top->parent;
 
-  /* Loop over all the top-level cells and go for a M-M interaction if
-   * well-separated */
-  for (int n = 0; n < nr_cells_with_particles; ++n) {
+  /* Start a fresh list of the multipoles interacting with ci */
+  gravity_m2l_cache_reset(&r->m2l_cache);
 
-    /* Handle on the top-level cell and it's gravity business*/
-    struct cell *cj = &cells[cells_with_particles[n]];
-    struct gravity_tensors *const multi_j = cj->grav.multipole;
+  if (periodic && s->grav_top_offsets != NULL) {
 
-    /* Avoid self contributions */
-    if (top == cj) continue;
+    const int cdim[3] = {s->cdim[0], s->cdim[1], s->cdim[2]};
 
-    /* Skip empty cells */
-    if (multi_j->m_pole.M_000 == 0.f) continue;
+    /* Integer indices of the top-level cell in the grid */
+    const int cid = top - cells;
+    const int i = cid / (cdim[1] * cdim[2]);
+    const int j = (cid / cdim[2]) % cdim[1];
+    const int k = cid % cdim[2];
 
-    /* Can we escape early in the periodic BC case? */
-    if (periodic) {
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+    /* Number of particles in the cells we visit */
+    long long num_gpart_in_range = top->grav.multipole->m_pole.num_gpart;
+#endif
 
-      /* Minimal distance between any pair of particles */
-      const double min_radius2 =
-          cell_min_dist2_same_size(top, cj, periodic, dim);
+    /* Loop over the top-level cells that can be within range */
+    for (int n = 0; n < s->nr_grav_top_offsets; ++n) {
 
-      /* Are we beyond the distance where the truncated forces are 0 ?*/
-      if (min_radius2 > max_distance2) {
+      /* Apply periodic BC */
+      const int ii = (i + s->grav_top_offsets[3 * n + 0] + cdim[0]) % cdim[0];
+      const int jj = (j + s->grav_top_offsets[3 * n + 1] + cdim[1]) % cdim[1];
+      const int kk = (k + s->grav_top_offsets[3 * n + 2] + cdim[2]) % cdim[2];
+
+      const struct cell *cj = &cells[cell_getid(cdim, ii, jj, kk)];
+
+      /* Skip empty cells. Foreign cells that are not gravity proxies have no
+       * particles on this rank, only their multipole, so don't use the
+       * counts here. */
+      if (cj->grav.multipole->m_pole.M_000 == 0.f) continue;
+
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+      if (cj != top && cj->grav.multipole->m_pole.M_000 != 0.f)
+        num_gpart_in_range += cj->grav.multipole->m_pole.num_gpart;
+#endif
+
+      runner_do_grav_long_range_pair(r, ci, top, cj);
+    }
+
+    /* All the cells not in the list are beyond the range of the forces */
+    if (s->nr_grav_top_offsets < s->nr_cells) {
+
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+      /* Need to account for the interactions we missed */
+      long long num_gpart_total = 0;
+      for (int n = 0; n < nr_cells_with_particles; ++n) {
+        const struct cell *cj = &cells[cells_with_particles[n]];
+        if (cj->grav.multipole->m_pole.M_000 != 0.f)
+          num_gpart_total += cj->grav.multipole->m_pole.num_gpart;
+      }
+#endif
 
 #ifdef SWIFT_DEBUG_CHECKS
-        /* Need to account for the interactions we missed */
-        accumulate_add_ll(&multi_i->pot.num_interacted,
-                          multi_j->m_pole.num_gpart);
+      accumulate_add_ll(&ci->grav.multipole->pot.num_interacted,
+                        num_gpart_total - num_gpart_in_range);
 #endif
 
 #ifdef SWIFT_GRAVITY_FORCE_CHECKS
-        /* Need to account for the interactions we missed */
-        accumulate_add_ll(&multi_i->pot.num_interacted_pm,
-                          multi_j->m_pole.num_gpart);
+      accumulate_add_ll(&ci->grav.multipole->pot.num_interacted_pm,
+                        num_gpart_total - num_gpart_in_range);
 #endif
 
-        /* Record that this multipole received a contribution */
-        multi_i->pot.interacted = 1;
-
-        /* We are done here. */
-        continue;
-      }
+      /* Record that this multipole received a contribution */
+      ci->grav.multipole->pot.interacted = 1;
     }
 
-    if (cell_can_use_pair_mm(top, cj, e, e->s, /*use_rebuild_data=*/1,
-                             /*is_tree_walk=*/0)) {
+  } else {
 
-      /* Call the PM interaction fucntion on the active sub-cells of ci */
-      runner_dopair_grav_mm_nonsym(r, ci, cj);
-      // runner_dopair_recursive_grav_pm(r, ci, cj);
+    /* Loop over all the top-level cells and go for a M-M interaction if
+     * well-separated */
+    for (int n = 0; n < nr_cells_with_particles; ++n) {
 
-      /* Record that this multipole received a contribution */
-      multi_i->pot.interacted = 1;
+      /* Handle on the top-level cell and it's gravity business*/
+      const struct cell *cj = &cells[cells_with_particles[n]];
+
+      runner_do_grav_long_range_pair(r, ci, top, cj);
+    } /* Loop over top-level cells */
+  }
 
-    } /* We are in charge of this pair */
-  } /* Loop over top-level cells */
+  /* Now apply all the M-M interactions in one go */
+  runner_dopair_grav_mm_batch(r, ci);
 
   if (timer) TIMER_TOC(timer_dograv_long_range);
 }
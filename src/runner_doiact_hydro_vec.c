@@ -23,10 +23,12 @@
 /* This object's header. */
 #include "runner_doiact_hydro_vec.h"
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
 
 static const vector kernel_gamma2_vec = FILL_VEC(kernel_gamma2);
 
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
+
 /**
  * @brief Compute the vector remainder interactions from the secondary cache.
  *
@@ -162,7 +164,7 @@ __attribute__((always_inline)) INLINE static void storeInteractions(
 
 /* Left-pack values needed into the secondary cache using the interaction mask.
  */
-#if defined(HAVE_AVX2) || defined(HAVE_AVX512_F)
+#ifdef VEC_HAVE_LEFT_PACK
   mask_t packed_mask;
   VEC_FORM_PACKED_MASK(mask, packed_mask);
 
@@ -199,7 +201,7 @@ __attribute__((always_inline)) INLINE static void storeInteractions(
     }
   }
 
-#endif /* defined(HAVE_AVX2) || defined(HAVE_AVX512_F) */
+#endif /* VEC_HAVE_LEFT_PACK */
 
   /* Flush the c2 cache if it has reached capacity. */
   if (*icount >= (C2_CACHE_SIZE - (NUM_VEC_PROC * VEC_SIZE))) {
@@ -231,6 +233,8 @@ __attribute__((always_inline)) INLINE static void storeInteractions(
   }
 }
 
+#endif /* WITH_HYDRO_DENSITY_VECTORIZATION */
+
 /**
  * @brief Populates the arrays max_index_i and max_index_j with the maximum
  * indices of
@@ -637,7 +641,7 @@ __attribute__((always_inline)) INLINE static int populate_max_index_subset(
   }
 }
 
-#endif /* WITH_VECTORIZATION && GADGET2_SPH */
+#endif /* WITH_HYDRO_FORCE_VECTORIZATION */
 
 /**
  * @brief Compute the cell self-interaction (non-symmetric) using vector
@@ -648,7 +652,7 @@ __attribute__((always_inline)) INLINE static int populate_max_index_subset(
  */
 void runner_doself1_density_vec(struct runner *r, struct cell *restrict c) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
 
   /* Get some local variables */
   const struct engine *e = r->e;
@@ -853,7 +857,11 @@ void runner_doself1_density_vec(struct runner *r, struct cell *restrict c) {
     VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
     VEC_HADD(v_wcountSum, pi->density.wcount);
     VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
+#ifdef SPHENIX_SPH
+    VEC_HADD(v_div_vSum, pi->viscosity.div_v);
+#else
     VEC_HADD(v_div_vSum, pi->density.div_v);
+#endif
     VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
     VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
     VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
@@ -866,9 +874,9 @@ void runner_doself1_density_vec(struct runner *r, struct cell *restrict c) {
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized hydro functions!");
 
-#endif /* WITH_VECTORIZATION */
+#endif /* WITH_HYDRO_DENSITY_VECTORIZATION */
 }
 
 /**
@@ -885,7 +893,7 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
                                       struct part *restrict parts,
                                       int *restrict ind, int pi_count) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
 
   const int count = c->hydro.count;
 
@@ -1087,7 +1095,11 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
     VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
     VEC_HADD(v_wcountSum, pi->density.wcount);
     VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
+#ifdef SPHENIX_SPH
+    VEC_HADD(v_div_vSum, pi->viscosity.div_v);
+#else
     VEC_HADD(v_div_vSum, pi->density.div_v);
+#endif
     VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
     VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
     VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
@@ -1100,9 +1112,9 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized hydro functions!");
 
-#endif /* WITH_VECTORIZATION */
+#endif /* WITH_HYDRO_DENSITY_VECTORIZATION */
 }
 
 /**
@@ -1114,7 +1126,7 @@ void runner_doself_subset_density_vec(struct runner *r, struct cell *restrict c,
  */
 void runner_doself2_force_vec(struct runner *r, struct cell *restrict c) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
 
   const struct engine *e = r->e;
   const struct cosmology *restrict cosmo = e->cosmology;
@@ -1163,15 +1175,8 @@ void runner_doself2_force_vec(struct runner *r, struct cell *restrict c) {
     const vector v_piy = vector_set1(cell_cache->y[pid]);
     const vector v_piz = vector_set1(cell_cache->z[pid]);
     const vector v_hi = vector_set1(cell_cache->h[pid]);
-    const vector v_vix = vector_set1(cell_cache->vx[pid]);
-    const vector v_viy = vector_set1(cell_cache->vy[pid]);
-    const vector v_viz = vector_set1(cell_cache->vz[pid]);
-
-    const vector v_rhoi = vector_set1(cell_cache->rho[pid]);
-    const vector v_grad_hi = vector_set1(cell_cache->grad_h[pid]);
-    const vector v_pOrhoi2 = vector_set1(cell_cache->pOrho2[pid]);
-    const vector v_balsara_i = vector_set1(cell_cache->balsara[pid]);
-    const vector v_ci = vector_set1(cell_cache->soundspeed[pid]);
+    struct hydro_vec_force_pi v_pi_force;
+    hydro_vec_force_read_pi(&v_pi_force, cell_cache, pid);
 
     /* Some useful powers of h */
     const float hi = cell_cache->h[pid];
@@ -1180,12 +1185,8 @@ void runner_doself2_force_vec(struct runner *r, struct cell *restrict c) {
     const vector v_hi_inv = vec_reciprocal(v_hi);
 
     /* Reset cumulative sums of update vectors. */
-    vector v_a_hydro_xSum = vector_setzero();
-    vector v_a_hydro_ySum = vector_setzero();
-    vector v_a_hydro_zSum = vector_setzero();
-    vector v_h_dtSum = vector_setzero();
-    vector v_sigSum = vector_set1(pi->force.v_sig);
-    vector v_entropy_dtSum = vector_setzero();
+    struct hydro_vec_force_sums v_sums;
+    hydro_vec_force_init_sums(&v_sums, pi);
 
     /* Find all of particle pi's interacions and store needed values in the
      * secondary cache.*/
@@ -1260,26 +1261,14 @@ void runner_doself2_force_vec(struct runner *r, struct cell *restrict c) {
          * operations sequence. */
         v_r2.v = vec_add(v_r2.v, vec_set1(FLT_MIN));
 
-        runner_iact_nonsym_1_vec_force(
-            &v_r2, &v_dx, &v_dy, &v_dz, v_vix, v_viy, v_viz, v_rhoi, v_grad_hi,
-            v_pOrhoi2, v_balsara_i, v_ci, &cell_cache->vx[pjd],
-            &cell_cache->vy[pjd], &cell_cache->vz[pjd], &cell_cache->rho[pjd],
-            &cell_cache->grad_h[pjd], &cell_cache->pOrho2[pjd],
-            &cell_cache->balsara[pjd], &cell_cache->soundspeed[pjd],
-            &cell_cache->m[pjd], v_hi_inv, v_hj_inv, a, H, &v_a_hydro_xSum,
-            &v_a_hydro_ySum, &v_a_hydro_zSum, &v_h_dtSum, &v_sigSum,
-            &v_entropy_dtSum, v_doi_mask);
+        runner_iact_nonsym_cache_vec_force(
+            &v_r2, &v_dx, &v_dy, &v_dz, &v_pi_force, cell_cache, pjd, v_hi_inv,
+            v_hj_inv, a, H, &v_sums, v_doi_mask);
       }
 
     } /* Loop over all other particles. */
 
-    VEC_HADD(v_a_hydro_xSum, pi->a_hydro[0]);
-    VEC_HADD(v_a_hydro_ySum, pi->a_hydro[1]);
-    VEC_HADD(v_a_hydro_zSum, pi->a_hydro[2]);
-    VEC_HADD(v_h_dtSum, pi->force.h_dt);
-    VEC_HADD(v_entropy_dtSum, pi->entropy_dt);
-
-    VEC_HMAX(v_sigSum, pi->force.v_sig);
+    hydro_vec_force_write_sums(&v_sums, pi);
 
   } /* loop over all particles. */
 
@@ -1287,9 +1276,9 @@ void runner_doself2_force_vec(struct runner *r, struct cell *restrict c) {
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized hydro functions!");
 
-#endif /* WITH_VECTORIZATION */
+#endif /* WITH_HYDRO_FORCE_VECTORIZATION */
 }
 
 /**
@@ -1306,7 +1295,7 @@ void runner_dopair1_density_vec(struct runner *r, struct cell *ci,
                                 struct cell *cj, const int sid,
                                 const double *shift) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
 
   const struct engine *restrict e = r->e;
   const timebin_t max_active_bin = e->max_active_bin;
@@ -1542,7 +1531,11 @@ void runner_dopair1_density_vec(struct runner *r, struct cell *ci,
       VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
       VEC_HADD(v_wcountSum, pi->density.wcount);
       VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
+#ifdef SPHENIX_SPH
+      VEC_HADD(v_div_vSum, pi->viscosity.div_v);
+#else
       VEC_HADD(v_div_vSum, pi->density.div_v);
+#endif
       VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
       VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
       VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
@@ -1683,7 +1676,11 @@ void runner_dopair1_density_vec(struct runner *r, struct cell *ci,
       VEC_HADD(v_rho_dhSum, pj->density.rho_dh);
       VEC_HADD(v_wcountSum, pj->density.wcount);
       VEC_HADD(v_wcount_dhSum, pj->density.wcount_dh);
+#ifdef SPHENIX_SPH
+      VEC_HADD(v_div_vSum, pj->viscosity.div_v);
+#else
       VEC_HADD(v_div_vSum, pj->density.div_v);
+#endif
       VEC_HADD(v_curlvxSum, pj->density.rot_v[0]);
       VEC_HADD(v_curlvySum, pj->density.rot_v[1]);
       VEC_HADD(v_curlvzSum, pj->density.rot_v[2]);
@@ -1695,9 +1692,9 @@ void runner_dopair1_density_vec(struct runner *r, struct cell *ci,
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized hydro functions!");
 
-#endif /* WITH_VECTORIZATION */
+#endif /* WITH_HYDRO_DENSITY_VECTORIZATION */
 }
 
 /**
@@ -1721,7 +1718,7 @@ void runner_dopair_subset_density_vec(struct runner *r,
                                       struct cell *restrict cj, const int sid,
                                       const int flipped, const double *shift) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_DENSITY_VECTORIZATION
 
   TIMER_TIC;
 
@@ -1886,7 +1883,11 @@ void runner_dopair_subset_density_vec(struct runner *r,
       VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
       VEC_HADD(v_wcountSum, pi->density.wcount);
       VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
+#ifdef SPHENIX_SPH
+      VEC_HADD(v_div_vSum, pi->viscosity.div_v);
+#else
       VEC_HADD(v_div_vSum, pi->density.div_v);
+#endif
       VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
       VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
       VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
@@ -2034,7 +2035,11 @@ void runner_dopair_subset_density_vec(struct runner *r,
       VEC_HADD(v_rho_dhSum, pi->density.rho_dh);
       VEC_HADD(v_wcountSum, pi->density.wcount);
       VEC_HADD(v_wcount_dhSum, pi->density.wcount_dh);
+#ifdef SPHENIX_SPH
+      VEC_HADD(v_div_vSum, pi->viscosity.div_v);
+#else
       VEC_HADD(v_div_vSum, pi->density.div_v);
+#endif
       VEC_HADD(v_curlvxSum, pi->density.rot_v[0]);
       VEC_HADD(v_curlvySum, pi->density.rot_v[1]);
       VEC_HADD(v_curlvzSum, pi->density.rot_v[2]);
@@ -2043,7 +2048,7 @@ void runner_dopair_subset_density_vec(struct runner *r,
   }
 
   TIMER_TOC(timer_dopair_subset);
-#endif /* WITH_VECTORIZATION */
+#endif /* WITH_HYDRO_DENSITY_VECTORIZATION */
 }
 
 /**
@@ -2060,7 +2065,7 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
                               struct cell *cj, const int sid,
                               const double *shift) {
 
-#if defined(WITH_VECTORIZATION) && defined(GADGET2_SPH)
+#ifdef WITH_HYDRO_FORCE_VECTORIZATION
 
   const struct engine *restrict e = r->e;
   const struct cosmology *restrict cosmo = e->cosmology;
@@ -2207,14 +2212,8 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
       const vector v_piy = vector_set1(ci_cache->y[ci_cache_idx]);
       const vector v_piz = vector_set1(ci_cache->z[ci_cache_idx]);
       const vector v_hi = vector_set1(hi);
-      const vector v_vix = vector_set1(ci_cache->vx[ci_cache_idx]);
-      const vector v_viy = vector_set1(ci_cache->vy[ci_cache_idx]);
-      const vector v_viz = vector_set1(ci_cache->vz[ci_cache_idx]);
-      const vector v_rhoi = vector_set1(ci_cache->rho[ci_cache_idx]);
-      const vector v_grad_hi = vector_set1(ci_cache->grad_h[ci_cache_idx]);
-      const vector v_pOrhoi2 = vector_set1(ci_cache->pOrho2[ci_cache_idx]);
-      const vector v_balsara_i = vector_set1(ci_cache->balsara[ci_cache_idx]);
-      const vector v_ci = vector_set1(ci_cache->soundspeed[ci_cache_idx]);
+      struct hydro_vec_force_pi v_pi_force;
+      hydro_vec_force_read_pi(&v_pi_force, ci_cache, ci_cache_idx);
 
       const float hig2 = hi * hi * kernel_gamma2;
       const vector v_hig2 = vector_set1(hig2);
@@ -2223,12 +2222,8 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
       vector v_hi_inv = vec_reciprocal(v_hi);
 
       /* Reset cumulative sums of update vectors. */
-      vector v_a_hydro_xSum = vector_setzero();
-      vector v_a_hydro_ySum = vector_setzero();
-      vector v_a_hydro_zSum = vector_setzero();
-      vector v_h_dtSum = vector_setzero();
-      vector v_sigSum = vector_set1(pi->force.v_sig);
-      vector v_entropy_dtSum = vector_setzero();
+      struct hydro_vec_force_sums v_sums;
+      hydro_vec_force_init_sums(&v_sums, pi);
 
       /* Loop over the parts in cj. Making sure to perform an iteration of the
        * loop even if exit_iteration_align is zero and there is only one
@@ -2302,28 +2297,15 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
         if (vec_is_mask_true(v_doi_mask)) {
           vector v_hj_inv = vec_reciprocal(v_hj);
 
-          runner_iact_nonsym_1_vec_force(
-              &v_r2, &v_dx, &v_dy, &v_dz, v_vix, v_viy, v_viz, v_rhoi,
-              v_grad_hi, v_pOrhoi2, v_balsara_i, v_ci,
-              &cj_cache->vx[cj_cache_idx], &cj_cache->vy[cj_cache_idx],
-              &cj_cache->vz[cj_cache_idx], &cj_cache->rho[cj_cache_idx],
-              &cj_cache->grad_h[cj_cache_idx], &cj_cache->pOrho2[cj_cache_idx],
-              &cj_cache->balsara[cj_cache_idx],
-              &cj_cache->soundspeed[cj_cache_idx], &cj_cache->m[cj_cache_idx],
-              v_hi_inv, v_hj_inv, a, H, &v_a_hydro_xSum, &v_a_hydro_ySum,
-              &v_a_hydro_zSum, &v_h_dtSum, &v_sigSum, &v_entropy_dtSum,
-              v_doi_mask);
+          runner_iact_nonsym_cache_vec_force(
+              &v_r2, &v_dx, &v_dy, &v_dz, &v_pi_force, cj_cache, cj_cache_idx,
+              v_hi_inv, v_hj_inv, a, H, &v_sums, v_doi_mask);
         }
 
       } /* loop over the parts in cj. */
 
       /* Perform horizontal adds on vector sums and store result in pi. */
-      VEC_HADD(v_a_hydro_xSum, pi->a_hydro[0]);
-      VEC_HADD(v_a_hydro_ySum, pi->a_hydro[1]);
-      VEC_HADD(v_a_hydro_zSum, pi->a_hydro[2]);
-      VEC_HADD(v_h_dtSum, pi->force.h_dt);
-      VEC_HMAX(v_sigSum, pi->force.v_sig);
-      VEC_HADD(v_entropy_dtSum, pi->entropy_dt);
+      hydro_vec_force_write_sums(&v_sums, pi);
 
     } /* loop over the parts in ci. */
   }
@@ -2354,14 +2336,8 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
       const vector v_pjy = vector_set1(cj_cache->y[cj_cache_idx]);
       const vector v_pjz = vector_set1(cj_cache->z[cj_cache_idx]);
       const vector v_hj = vector_set1(hj);
-      const vector v_vjx = vector_set1(cj_cache->vx[cj_cache_idx]);
-      const vector v_vjy = vector_set1(cj_cache->vy[cj_cache_idx]);
-      const vector v_vjz = vector_set1(cj_cache->vz[cj_cache_idx]);
-      const vector v_rhoj = vector_set1(cj_cache->rho[cj_cache_idx]);
-      const vector v_grad_hj = vector_set1(cj_cache->grad_h[cj_cache_idx]);
-      const vector v_pOrhoj2 = vector_set1(cj_cache->pOrho2[cj_cache_idx]);
-      const vector v_balsara_j = vector_set1(cj_cache->balsara[cj_cache_idx]);
-      const vector v_cj = vector_set1(cj_cache->soundspeed[cj_cache_idx]);
+      struct hydro_vec_force_pi v_pj_force;
+      hydro_vec_force_read_pi(&v_pj_force, cj_cache, cj_cache_idx);
 
       const float hjg2 = hj * hj * kernel_gamma2;
       const vector v_hjg2 = vector_set1(hjg2);
@@ -2370,12 +2346,8 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
       vector v_hj_inv = vec_reciprocal(v_hj);
 
       /* Reset cumulative sums of update vectors. */
-      vector v_a_hydro_xSum = vector_setzero();
-      vector v_a_hydro_ySum = vector_setzero();
-      vector v_a_hydro_zSum = vector_setzero();
-      vector v_h_dtSum = vector_setzero();
-      vector v_sigSum = vector_set1(pj->force.v_sig);
-      vector v_entropy_dtSum = vector_setzero();
+      struct hydro_vec_force_sums v_sums;
+      hydro_vec_force_init_sums(&v_sums, pj);
 
       /* Convert exit iteration to cache indices. */
       int exit_iteration_align = exit_iteration - first_pi;
@@ -2453,27 +2425,14 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
         if (vec_is_mask_true(v_doj_mask)) {
           vector v_hi_inv = vec_reciprocal(v_hi);
 
-          runner_iact_nonsym_1_vec_force(
-              &v_r2, &v_dx, &v_dy, &v_dz, v_vjx, v_vjy, v_vjz, v_rhoj,
-              v_grad_hj, v_pOrhoj2, v_balsara_j, v_cj,
-              &ci_cache->vx[ci_cache_idx], &ci_cache->vy[ci_cache_idx],
-              &ci_cache->vz[ci_cache_idx], &ci_cache->rho[ci_cache_idx],
-              &ci_cache->grad_h[ci_cache_idx], &ci_cache->pOrho2[ci_cache_idx],
-              &ci_cache->balsara[ci_cache_idx],
-              &ci_cache->soundspeed[ci_cache_idx], &ci_cache->m[ci_cache_idx],
-              v_hj_inv, v_hi_inv, a, H, &v_a_hydro_xSum, &v_a_hydro_ySum,
-              &v_a_hydro_zSum, &v_h_dtSum, &v_sigSum, &v_entropy_dtSum,
-              v_doj_mask);
+          runner_iact_nonsym_cache_vec_force(
+              &v_r2, &v_dx, &v_dy, &v_dz, &v_pj_force, ci_cache, ci_cache_idx,
+              v_hj_inv, v_hi_inv, a, H, &v_sums, v_doj_mask);
         }
       } /* loop over the parts in ci. */
 
       /* Perform horizontal adds on vector sums and store result in pj. */
-      VEC_HADD(v_a_hydro_xSum, pj->a_hydro[0]);
-      VEC_HADD(v_a_hydro_ySum, pj->a_hydro[1]);
-      VEC_HADD(v_a_hydro_zSum, pj->a_hydro[2]);
-      VEC_HADD(v_h_dtSum, pj->force.h_dt);
-      VEC_HMAX(v_sigSum, pj->force.v_sig);
-      VEC_HADD(v_entropy_dtSum, pj->entropy_dt);
+      hydro_vec_force_write_sums(&v_sums, pj);
 
     } /* loop over the parts in cj. */
 
@@ -2482,7 +2441,7 @@ void runner_dopair2_force_vec(struct runner *r, struct cell *ci,
 
 #else
 
-  error("Incorrectly calling vectorized Gadget-2 functions!");
+  error("Incorrectly calling vectorized hydro functions!");
 
-#endif /* WITH_VECTORIZATION */
+#endif /* WITH_HYDRO_FORCE_VECTORIZATION */
 }
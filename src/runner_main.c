@@ -33,6 +33,7 @@
 /* Local headers. */
 #include "engine.h"
 #include "feedback.h"
+#include "mpiuse.h"
 #include "runner_doiact_sinks.h"
 #include "scheduler.h"
 #include "space_getsid.h"
@@ -204,9 +205,14 @@ void *runner_main(void *data) {
             runner_doself2_branch_force(r, ci);
           else if (t->subtype == task_subtype_limiter)
             runner_doself1_branch_limiter(r, ci);
-          else if (t->subtype == task_subtype_grav)
+          else if (t->subtype == task_subtype_grav) {
+            /* The P-P caches are only re-used within this task */
+            gravity_cache_memoise_begin(&r->ci_gravity_cache);
+            gravity_cache_memoise_begin(&r->cj_gravity_cache);
             runner_doself_recursive_grav(r, ci, 1);
-          else if (t->subtype == task_subtype_external_grav)
+            gravity_cache_memoise_end(&r->ci_gravity_cache);
+            gravity_cache_memoise_end(&r->cj_gravity_cache);
+          } else if (t->subtype == task_subtype_external_grav)
             runner_do_grav_external(r, ci, 1);
           else if (t->subtype == task_subtype_stars_density)
             runner_doself_branch_stars_density(r, ci);
@@ -254,9 +260,14 @@ void *runner_main(void *data) {
             runner_dopair2_branch_force(r, ci, cj);
           else if (t->subtype == task_subtype_limiter)
             runner_dopair1_branch_limiter(r, ci, cj);
-          else if (t->subtype == task_subtype_grav)
+          else if (t->subtype == task_subtype_grav) {
+            /* The P-P caches are only re-used within this task */
+            gravity_cache_memoise_begin(&r->ci_gravity_cache);
+            gravity_cache_memoise_begin(&r->cj_gravity_cache);
             runner_dopair_recursive_grav(r, ci, cj, 1);
-          else if (t->subtype == task_subtype_stars_density)
+            gravity_cache_memoise_end(&r->ci_gravity_cache);
+            gravity_cache_memoise_end(&r->cj_gravity_cache);
+          } else if (t->subtype == task_subtype_stars_density)
             runner_dopair_branch_stars_density(r, ci, cj);
 #ifdef EXTRA_STAR_LOOPS
           else if (t->subtype == task_subtype_stars_prep1)
@@ -488,9 +499,23 @@ void *runner_main(void *data) {
             free(t->buff);
           } else if (t->subtype == task_subtype_limiter) {
             free(t->buff);
+          } else if (t->subtype == task_subtype_gpart && t->mpi_encoded) {
+            free(t->buff);
+#ifdef hydro_mpi_rho_fields
+          } else if (t->subtype == task_subtype_rho) {
+            free(t->buff);
+#endif
+#ifdef hydro_mpi_gradient_fields
+          } else if (t->subtype == task_subtype_gradient) {
+            free(t->buff);
+#endif
           }
           break;
         case task_type_recv:
+          if (t->mpi_arrived) {
+            mpiuse_log_latency(t->tic - t->mpi_arrived);
+          }
+          if (t->mpi_aggregate != NULL) scheduler_mpi_aggregate_unpack(t);
           if (t->subtype == task_subtype_tend) {
             cell_unpack_end_step(ci, (struct pcell_step *)t->buff);
             free(t->buff);
@@ -501,8 +526,17 @@ void *runner_main(void *data) {
           } else if (t->subtype == task_subtype_xv) {
             runner_do_recv_part(r, ci, 1, 1);
           } else if (t->subtype == task_subtype_rho) {
+#ifdef hydro_mpi_rho_fields
+            cell_unpack_part_rho(ci, (struct part_rho_payload *)t->buff);
+            free(t->buff);
+#endif
             runner_do_recv_part(r, ci, 0, 1);
           } else if (t->subtype == task_subtype_gradient) {
+#ifdef hydro_mpi_gradient_fields
+            cell_unpack_part_gradient(ci,
+                                      (struct part_gradient_payload *)t->buff);
+            free(t->buff);
+#endif
             runner_do_recv_part(r, ci, 0, 1);
           } else if (t->subtype == task_subtype_rt_gradient) {
             runner_do_recv_part(r, ci, 2, 1);
@@ -518,8 +552,12 @@ void *runner_main(void *data) {
             free(t->buff);
           } else if (t->subtype == task_subtype_limiter) {
             /* Nothing to do here. Unpacking done in a separate task */
+          } else if (t->subtype == task_subtype_gpart && t->mpi_encoded) {
+            runner_do_recv_gpart(r, ci,
+                                 (struct gpart_foreign_payload *)t->buff, 1);
+            free(t->buff);
           } else if (t->subtype == task_subtype_gpart) {
-            runner_do_recv_gpart(r, ci, 1);
+            runner_do_recv_gpart(r, ci, NULL, 1);
           } else if (t->subtype == task_subtype_spart_density) {
             runner_do_recv_spart(r, ci, 1, 1);
           } else if (t->subtype == task_subtype_part_prep1) {
@@ -146,18 +146,26 @@ void runner_do_recv_part(struct runner *r, struct cell *c, int clear_sorts,
  *
  * @param r The runner thread.
  * @param c The cell.
+ * @param data The encoded #gpart of the cell to decode first, NULL if the
+ * full particles were received.
  * @param timer Are we timing this ?
  */
-void runner_do_recv_gpart(struct runner *r, struct cell *c, int timer) {
+void runner_do_recv_gpart(struct runner *r, struct cell *c,
+                          const struct gpart_foreign_payload *data,
+                          int timer) {
 
 #ifdef WITH_MPI
 
+  TIMER_TIC;
+
+  /* Decode the particles of the whole cell, the progeny then find theirs
+   * in place. */
+  if (data != NULL) cell_unpack_gpart_foreign(c, data);
+
   const struct gpart *restrict gparts = c->grav.parts;
   const size_t nr_gparts = c->grav.count;
   const integertime_t ti_current = r->e->ti_current;
 
-  TIMER_TIC;
-
   integertime_t ti_gravity_end_min = max_nr_timesteps;
   timebin_t time_bin_min = num_time_bins;
   timebin_t time_bin_max = 0;
@@ -184,7 +192,7 @@ void runner_do_recv_gpart(struct runner *r, struct cell *c, int timer) {
   else {
     for (int k = 0; k < 8; k++) {
       if (c->progeny[k] != NULL && c->progeny[k]->grav.count > 0) {
-        runner_do_recv_gpart(r, c->progeny[k], 0);
+        runner_do_recv_gpart(r, c->progeny[k], NULL, 0);
         ti_gravity_end_min =
             min(ti_gravity_end_min, c->progeny[k]->grav.ti_end_min);
       }
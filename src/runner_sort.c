@@ -34,6 +34,20 @@
 /*! The size of the sorting stack used at the leaf level */
 const int sort_stack_size = 10;
 
+/*! Number of entries below which we use QuickSort rather than radix sort */
+#define sort_radix_min_size 24
+
+/*! Number of entries for which the sorting buffers live on the stack */
+#define sort_radix_stack_size 1024
+
+/*! Fraction (1 / x) of entries out of order with their predecessor above
+ * which the repair of an existing ordering is not attempted */
+#define sort_incremental_max_descents 4
+
+/*! Average number of moves per entry after which the repair of an existing
+ * ordering gives up and falls back to a full sort */
+#define sort_incremental_max_moves 2
+
 /**
  * @brief Sorts again all the stars in a given cell hierarchy.
  *
@@ -67,7 +81,7 @@ void runner_do_stars_resort(struct runner *r, struct cell *c, const int timer) {
  * @param sort The entries
  * @param N The number of entries.
  */
-void runner_do_sort_ascending(struct sort_entry *sort, int N) {
+void runner_do_sort_ascending_quicksort(struct sort_entry *sort, int N) {
 
   struct {
     short int lo, hi;
@@ -162,6 +176,258 @@ void runner_do_sort_ascending(struct sort_entry *sort, int N) {
   }
 }
 
+/**
+ * @brief Map a float onto an unsigned int with the same ordering.
+ *
+ * @param d The float.
+ */
+__attribute__((always_inline)) INLINE static uint32_t sort_radix_key(
+    const float d) {
+  uint32_t u;
+  memcpy(&u, &d, sizeof(uint32_t));
+  return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+/**
+ * @brief Sort the entries in ascending order using a LSD radix sort.
+ *
+ * The keys are sorted by bytes, skipping the passes for which all the keys
+ * share the same byte, which is typical of the high bytes of the distances
+ * of particles within a single cell.
+ *
+ * @param sort The entries
+ * @param N The number of entries.
+ */
+void runner_do_sort_ascending_radix(struct sort_entry *sort, int N) {
+
+  if (N < 2) return;
+
+  /* Get some space for the keys and the ping-pong buffer. */
+  uint32_t keys_stack[2][sort_radix_stack_size];
+  struct sort_entry temp_stack[sort_radix_stack_size];
+  uint32_t *keys_in = keys_stack[0], *keys_out = keys_stack[1];
+  struct sort_entry *temp = temp_stack;
+  if (N > sort_radix_stack_size) {
+    if ((keys_in = (uint32_t *)malloc(2 * N * sizeof(uint32_t))) == NULL ||
+        (temp = (struct sort_entry *)malloc(N * sizeof(struct sort_entry))) ==
+            NULL)
+      error("Failed to allocate radix sort buffers.");
+    keys_out = keys_in + N;
+  }
+
+  /* Extract the keys and build the histograms of all the bytes at once. */
+  int hist[4][256];
+  bzero(hist, sizeof(hist));
+  for (int k = 0; k < N; k++) {
+    const uint32_t key = sort_radix_key(sort[k].d);
+    keys_in[k] = key;
+    hist[0][key & 0xff]++;
+    hist[1][(key >> 8) & 0xff]++;
+    hist[2][(key >> 16) & 0xff]++;
+    hist[3][key >> 24]++;
+  }
+
+  struct sort_entry *in = sort, *out = temp;
+  for (int pass = 0; pass < 4; pass++) {
+
+    const int shift = 8 * pass;
+    int *h = hist[pass];
+
+    /* Nothing to do if all the keys share that byte. */
+    if (h[(keys_in[0] >> shift) & 0xff] == N) continue;
+
+    /* Turn the counts into offsets. */
+    int offset = 0;
+    for (int b = 0; b < 256; b++) {
+      const int c = h[b];
+      h[b] = offset;
+      offset += c;
+    }
+
+    /* Scatter. */
+    for (int k = 0; k < N; k++) {
+      const uint32_t key = keys_in[k];
+      const int ind = h[(key >> shift) & 0xff]++;
+      keys_out[ind] = key;
+      out[ind] = in[k];
+    }
+
+    /* Swap the buffers. */
+    uint32_t *keys_swap = keys_in;
+    keys_in = keys_out;
+    keys_out = keys_swap;
+    struct sort_entry *swap = in;
+    in = out;
+    out = swap;
+  }
+
+  /* Did we end up in the temporary buffer? */
+  if (in != sort) memcpy(sort, in, N * sizeof(struct sort_entry));
+
+  if (N > sort_radix_stack_size) {
+    free(keys_in < keys_out ? keys_in : keys_out);
+    free(temp);
+  }
+}
+
+/**
+ * @brief Sort the entries in ascending order.
+ *
+ * Uses QuickSort for the small arrays and radix sort for the larger ones,
+ * see tests/testSort.c for the cross-over point.
+ *
+ * @param sort The entries
+ * @param N The number of entries.
+ */
+void runner_do_sort_ascending(struct sort_entry *sort, int N) {
+
+  if (N < sort_radix_min_size)
+    runner_do_sort_ascending_quicksort(sort, N);
+  else
+    runner_do_sort_ascending_radix(sort, N);
+}
+
+/**
+ * @brief Sort the entries in ascending order, assuming they are already
+ * almost in that order.
+ *
+ * This is an insertion sort, which is linear in the number of entries plus
+ * the distance by which they are out of order. The disorder is estimated
+ * first by counting the entries smaller than their predecessor; if there are
+ * too many, or if the insertion ends up moving the entries too much, we do a
+ * full sort instead such that the cost never exceeds that of
+ * #runner_do_sort_ascending() by much.
+ *
+ * @param sort The entries
+ * @param N The number of entries.
+ * @return 1 if the ordering was repaired, 0 if we resorted to a full sort.
+ */
+int runner_do_sort_ascending_incremental(struct sort_entry *sort, int N) {
+
+  /* Count the descents. */
+  int num_descents = 0;
+  for (int k = 1; k < N; k++) num_descents += (sort[k].d < sort[k - 1].d);
+
+  if (num_descents > N / sort_incremental_max_descents) {
+    runner_do_sort_ascending(sort, N);
+    return 0;
+  }
+
+  const int max_moves = sort_incremental_max_moves * N;
+  int moves = 0;
+
+  for (int k = 1; k < N; k++) {
+
+    /* Nothing to do if this entry is already in place. */
+    if (sort[k].d >= sort[k - 1].d) continue;
+
+    /* Shift the larger entries up and insert this one below them. */
+    const struct sort_entry temp = sort[k];
+    int j = k;
+    while (j > 0 && sort[j - 1].d > temp.d) {
+      sort[j] = sort[j - 1];
+      j--;
+    }
+    sort[j] = temp;
+
+    /* Too much disorder after all? */
+    moves += k - j;
+    if (moves > max_moves) {
+      runner_do_sort_ascending(sort, N);
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+/**
+ * @brief Fill the sort entries of the flagged directions from a set of
+ * particle positions.
+ *
+ * The positions are first gathered in SoA form such that the projections
+ * along each of the 13 axes are then computed by simple loops the compiler
+ * can vectorize. This is kept out of line to not bloat the stack frames of
+ * the recursive sorting functions.
+ *
+ * @param x Pointer to the position of the first particle.
+ * @param stride The size in bytes of the particle structure.
+ * @param count The number of particles.
+ * @param flags The flagged directions.
+ * @param entries The sort arrays for the 13 directions.
+ */
+__attribute__((noinline)) static void runner_do_sort_fill_entries(
+    const double *x, const size_t stride, const int count, const int flags,
+    struct sort_entry *entries[13]) {
+
+  /* Get some space for the positions. */
+  double pos_stack[3 * sort_radix_stack_size];
+  double *pos = pos_stack;
+  if (count > sort_radix_stack_size &&
+      (pos = (double *)malloc(3 * count * sizeof(double))) == NULL)
+    error("Failed to allocate sort positions.");
+  double *restrict px = pos;
+  double *restrict py = pos + count;
+  double *restrict pz = pos + 2 * count;
+
+  /* Gather the positions. */
+  const char *ptr = (const char *)x;
+  for (int k = 0; k < count; k++) {
+    const double *xk = (const double *)(ptr + k * stride);
+    px[k] = xk[0];
+    py[k] = xk[1];
+    pz[k] = xk[2];
+  }
+
+  /* Project them along the flagged axes. */
+  for (int j = 0; j < 13; j++) {
+    if (!(flags & (1 << j))) continue;
+
+    const double sx = runner_shift[j][0];
+    const double sy = runner_shift[j][1];
+    const double sz = runner_shift[j][2];
+    struct sort_entry *restrict e = entries[j];
+
+    for (int k = 0; k < count; k++) {
+      e[k].d = px[k] * sx + py[k] * sy + pz[k] * sz;
+      e[k].i = k;
+    }
+  }
+
+  if (pos != pos_stack) free(pos);
+}
+
+/**
+ * @brief Update the keys of the sort entries of the flagged directions from
+ * a set of particle positions, keeping the entries in their current order.
+ *
+ * @param x Pointer to the position of the first particle.
+ * @param stride The size in bytes of the particle structure.
+ * @param count The number of particles.
+ * @param flags The flagged directions.
+ * @param entries The sort arrays for the 13 directions.
+ */
+__attribute__((noinline)) static void runner_do_sort_update_entries(
+    const double *x, const size_t stride, const int count, const int flags,
+    struct sort_entry *entries[13]) {
+
+  const char *ptr = (const char *)x;
+
+  for (int j = 0; j < 13; j++) {
+    if (!(flags & (1 << j))) continue;
+
+    const double sx = runner_shift[j][0];
+    const double sy = runner_shift[j][1];
+    const double sz = runner_shift[j][2];
+    struct sort_entry *restrict e = entries[j];
+
+    for (int k = 0; k < count; k++) {
+      const double *xk = (const double *)(ptr + e[k].i * stride);
+      e[k].d = xk[0] * sx + xk[1] * sy + xk[2] * sz;
+    }
+  }
+}
+
 #ifdef SWIFT_DEBUG_CHECKS
 /**
  * @brief Recursively checks that the flags are consistent in a cell hierarchy.
@@ -249,6 +515,11 @@ void runner_do_hydro_sort(struct runner *r, struct cell *c, int flags,
   if (c->hydro.sorted == 0) c->hydro.ti_sort = r->e->ti_current;
 #endif
 
+  /* The sort arrays allocated so far hold an ordering of the cell's
+   * particles, possibly a stale one. This is only true until the next
+   * rebuild, which frees them. */
+  const int flags_allocated = c->hydro.sort_allocated;
+
   /* Allocate memory for sorting. */
   cell_malloc_hydro_sorts(c, flags);
 
@@ -375,17 +646,20 @@ void runner_do_hydro_sort(struct runner *r, struct cell *c, int flags,
       c->hydro.dx_max_sort = 0.f;
     }
 
-    /* Fill the sort array. */
-    for (int k = 0; k < count; k++) {
-      const double px[3] = {parts[k].x[0], parts[k].x[1], parts[k].x[2]};
-      for (int j = 0; j < 13; j++)
-        if (flags & (1 << j)) {
-          struct sort_entry *entries = cell_get_hydro_sorts(c, j);
-          entries[k].i = k;
-          entries[k].d = px[0] * runner_shift[j][0] +
-                         px[1] * runner_shift[j][1] +
-                         px[2] * runner_shift[j][2];
-        }
+    /* Directions for which we can repair the previous ordering rather than
+     * sorting from scratch. */
+    const int flags_repair =
+        space_incremental_sorts ? (flags & flags_allocated) : 0;
+
+    /* Fill the sort arrays. */
+    struct sort_entry *sorts[13];
+    for (int j = 0; j < 13; j++)
+      sorts[j] = (flags & (1 << j)) ? cell_get_hydro_sorts(c, j) : NULL;
+    if (count > 0) {
+      runner_do_sort_fill_entries(parts[0].x, sizeof(struct part), count,
+                                  flags & ~flags_repair, sorts);
+      runner_do_sort_update_entries(parts[0].x, sizeof(struct part), count,
+                                    flags_repair, sorts);
     }
 
     /* Add the sentinel and sort. */
@@ -394,7 +668,10 @@ void runner_do_hydro_sort(struct runner *r, struct cell *c, int flags,
         struct sort_entry *entries = cell_get_hydro_sorts(c, j);
         entries[count].d = FLT_MAX;
         entries[count].i = 0;
-        runner_do_sort_ascending(entries, count);
+        if (flags_repair & (1 << j))
+          runner_do_sort_ascending_incremental(entries, count);
+        else
+          runner_do_sort_ascending(entries, count);
         atomic_or(&c->hydro.sorted, 1 << j);
       }
   }
@@ -606,18 +883,13 @@ void runner_do_stars_sort(struct runner *r, struct cell *c, int flags,
       c->stars.dx_max_sort = 0.f;
     }
 
-    /* Fill the sort array. */
-    for (int k = 0; k < count; k++) {
-      const double px[3] = {sparts[k].x[0], sparts[k].x[1], sparts[k].x[2]};
-      for (int j = 0; j < 13; j++)
-        if (flags & (1 << j)) {
-          struct sort_entry *entries = cell_get_stars_sorts(c, j);
-          entries[k].i = k;
-          entries[k].d = px[0] * runner_shift[j][0] +
-                         px[1] * runner_shift[j][1] +
-                         px[2] * runner_shift[j][2];
-        }
-    }
+    /* Fill the sort arrays. */
+    struct sort_entry *sorts[13];
+    for (int j = 0; j < 13; j++)
+      sorts[j] = (flags & (1 << j)) ? cell_get_stars_sorts(c, j) : NULL;
+    if (count > 0)
+      runner_do_sort_fill_entries(sparts[0].x, sizeof(struct spart), count,
+                                  flags, sorts);
 
     /* Add the sentinel and sort. */
     for (int j = 0; j < 13; j++)
@@ -36,6 +36,13 @@
 #include <mpi.h>
 #endif
 
+/* NUMA headers. */
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#include <numaif.h>
+#include <unistd.h>
+#endif
+
 /* This object's header. */
 #include "scheduler.h"
 
@@ -1744,6 +1751,11 @@ struct task *scheduler_addtask(struct scheduler *s, enum task_types type,
   t->activated_by_unskip = 0;
   t->activated_by_marktask = 0;
 #endif
+#ifdef WITH_MPI
+  t->mpi_aggregate = NULL;
+  t->mpi_rma = NULL;
+  t->mpi_encoded = 0;
+#endif
 
   if (ci != NULL) cell_set_flag(ci, cell_flag_has_tasks);
   if (cj != NULL) cell_set_flag(cj, cell_flag_has_tasks);
@@ -1918,6 +1930,12 @@ void scheduler_ranktasks(struct scheduler *s) {
  */
 void scheduler_reset(struct scheduler *s, int size) {
 
+#ifdef WITH_MPI
+  /* The tasks are about to be re-created, drop the coalesced messages. */
+  s->nr_mpi_aggregate_tasks = 0;
+  scheduler_mpi_aggregate_free(s);
+#endif
+
   /* Do we need to re-allocate? */
   if (size > s->size) {
     /* Free existing task lists if necessary. */
@@ -1952,396 +1970,493 @@ void scheduler_reset(struct scheduler *s, int size) {
 }
 
 /**
- * @brief Compute the task weights
+ * @brief Estimate the cost of a task from the number of particles it acts on.
  *
- * @param s The #scheduler.
- * @param verbose Are we talkative?
+ * @param t The #task.
+ * @param nodeID The rank of this node.
+ * @return The estimated cost, in arbitrary units.
  */
-void scheduler_reweight(struct scheduler *s, int verbose) {
-  const int nr_tasks = s->nr_tasks;
-  int *tid = s->tasks_ind;
-  struct task *tasks = s->tasks;
-  const int nodeID = s->nodeID;
-  const float wscale = 0.001f;
-  const ticks tic = getticks();
+float scheduler_task_cost_estimate(const struct task *t, const int nodeID) {
 
-  /* Run through the tasks backwards and set their weights. */
-  for (int k = nr_tasks - 1; k >= 0; k--) {
-    struct task *t = &tasks[tid[k]];
-    float cost = 0.f;
-    t->weight = 0.f;
+  const float wscale = 0.001f;
+  float cost = 0.f;
+
+  const float count_i = (t->ci != NULL) ? t->ci->hydro.count : 0.f;
+  const float count_j = (t->cj != NULL) ? t->cj->hydro.count : 0.f;
+  const float gcount_i = (t->ci != NULL) ? t->ci->grav.count : 0.f;
+  const float gcount_j = (t->cj != NULL) ? t->cj->grav.count : 0.f;
+  const float scount_i = (t->ci != NULL) ? t->ci->stars.count : 0.f;
+  const float scount_j = (t->cj != NULL) ? t->cj->stars.count : 0.f;
+  const float sink_count_i = (t->ci != NULL) ? t->ci->sinks.count : 0.f;
+  const float sink_count_j = (t->cj != NULL) ? t->cj->sinks.count : 0.f;
+  const float bcount_i = (t->ci != NULL) ? t->ci->black_holes.count : 0.f;
+  const float bcount_j = (t->cj != NULL) ? t->cj->black_holes.count : 0.f;
+
+  switch (t->type) {
+    case task_type_sort:
+    case task_type_rt_sort:
+      cost = wscale * intrinsics_popcount(t->flags) * count_i *
+             (sizeof(int) * 8 - (count_i ? intrinsics_clz(count_i) : 0));
+      break;
 
-    for (int j = 0; j < t->nr_unlock_tasks; j++)
-      t->weight += t->unlock_tasks[j]->weight;
-
-    const float count_i = (t->ci != NULL) ? t->ci->hydro.count : 0.f;
-    const float count_j = (t->cj != NULL) ? t->cj->hydro.count : 0.f;
-    const float gcount_i = (t->ci != NULL) ? t->ci->grav.count : 0.f;
-    const float gcount_j = (t->cj != NULL) ? t->cj->grav.count : 0.f;
-    const float scount_i = (t->ci != NULL) ? t->ci->stars.count : 0.f;
-    const float scount_j = (t->cj != NULL) ? t->cj->stars.count : 0.f;
-    const float sink_count_i = (t->ci != NULL) ? t->ci->sinks.count : 0.f;
-    const float sink_count_j = (t->cj != NULL) ? t->cj->sinks.count : 0.f;
-    const float bcount_i = (t->ci != NULL) ? t->ci->black_holes.count : 0.f;
-    const float bcount_j = (t->cj != NULL) ? t->cj->black_holes.count : 0.f;
+    case task_type_stars_sort:
+      cost = wscale * intrinsics_popcount(t->flags) * scount_i *
+             (sizeof(int) * 8 - (scount_i ? intrinsics_clz(scount_i) : 0));
+      break;
 
-    switch (t->type) {
-      case task_type_sort:
-      case task_type_rt_sort:
-        cost = wscale * intrinsics_popcount(t->flags) * count_i *
-               (sizeof(int) * 8 - (count_i ? intrinsics_clz(count_i) : 0));
-        break;
+    case task_type_stars_resort:
+      cost = wscale * intrinsics_popcount(t->flags) * scount_i *
+             (sizeof(int) * 8 - (scount_i ? intrinsics_clz(scount_i) : 0));
+      break;
 
-      case task_type_stars_sort:
-        cost = wscale * intrinsics_popcount(t->flags) * scount_i *
-               (sizeof(int) * 8 - (scount_i ? intrinsics_clz(scount_i) : 0));
-        break;
+    case task_type_self:
+      if (t->subtype == task_subtype_grav) {
+        cost = 1.f * (wscale * gcount_i) * gcount_i;
+      } else if (t->subtype == task_subtype_external_grav)
+        cost = 1.f * wscale * gcount_i;
+      else if (t->subtype == task_subtype_stars_density ||
+               t->subtype == task_subtype_stars_prep1 ||
+               t->subtype == task_subtype_stars_prep2 ||
+               t->subtype == task_subtype_stars_feedback)
+        cost = 1.f * wscale * scount_i * count_i;
+      else if (t->subtype == task_subtype_sink_swallow ||
+               t->subtype == task_subtype_sink_do_gas_swallow)
+        cost = 1.f * wscale * count_i * sink_count_i;
+      else if (t->subtype == task_subtype_sink_do_sink_swallow)
+        cost = 1.f * wscale * sink_count_i * sink_count_i;
+      else if (t->subtype == task_subtype_bh_density ||
+               t->subtype == task_subtype_bh_swallow ||
+               t->subtype == task_subtype_bh_feedback)
+        cost = 1.f * wscale * bcount_i * count_i;
+      else if (t->subtype == task_subtype_do_gas_swallow)
+        cost = 1.f * wscale * count_i;
+      else if (t->subtype == task_subtype_do_bh_swallow)
+        cost = 1.f * wscale * bcount_i;
+      else if (t->subtype == task_subtype_density ||
+               t->subtype == task_subtype_gradient ||
+               t->subtype == task_subtype_force ||
+               t->subtype == task_subtype_limiter)
+        cost = 1.f * (wscale * count_i) * count_i;
+      else if (t->subtype == task_subtype_rt_gradient)
+        cost = 1.f * wscale * count_i * count_i;
+      else if (t->subtype == task_subtype_rt_transport)
+        cost = 1.f * wscale * count_i * count_i;
+      else
+        error("Untreated sub-type for selfs: %s",
+              subtaskID_names[t->subtype]);
+      break;
 
-      case task_type_stars_resort:
-        cost = wscale * intrinsics_popcount(t->flags) * scount_i *
-               (sizeof(int) * 8 - (scount_i ? intrinsics_clz(scount_i) : 0));
-        break;
+    case task_type_pair:
+      if (t->subtype == task_subtype_grav) {
+        if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
+          cost = 3.f * (wscale * gcount_i) * gcount_j;
+        else
+          cost = 2.f * (wscale * gcount_i) * gcount_j;
 
-      case task_type_self:
-        if (t->subtype == task_subtype_grav) {
-          cost = 1.f * (wscale * gcount_i) * gcount_i;
-        } else if (t->subtype == task_subtype_external_grav)
-          cost = 1.f * wscale * gcount_i;
-        else if (t->subtype == task_subtype_stars_density ||
+      } else if (t->subtype == task_subtype_stars_density ||
                  t->subtype == task_subtype_stars_prep1 ||
                  t->subtype == task_subtype_stars_prep2 ||
-                 t->subtype == task_subtype_stars_feedback)
-          cost = 1.f * wscale * scount_i * count_i;
-        else if (t->subtype == task_subtype_sink_swallow ||
-                 t->subtype == task_subtype_sink_do_gas_swallow)
-          cost = 1.f * wscale * count_i * sink_count_i;
-        else if (t->subtype == task_subtype_sink_do_sink_swallow)
-          cost = 1.f * wscale * sink_count_i * sink_count_i;
-        else if (t->subtype == task_subtype_bh_density ||
+                 t->subtype == task_subtype_stars_feedback) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * count_i * scount_j * sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * scount_i * count_j * sid_scale[t->flags];
+        else
+          cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
+                 sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_sink_swallow ||
+                 t->subtype == task_subtype_sink_do_gas_swallow) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * count_i * sink_count_j * sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * sink_count_i * count_j * sid_scale[t->flags];
+        else
+          cost = 2.f * wscale *
+                 (sink_count_i * count_j + sink_count_j * count_i) *
+                 sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * sink_count_i * sink_count_j *
+                 sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * sink_count_i * sink_count_j *
+                 sid_scale[t->flags];
+        else
+          cost = 2.f * wscale *
+                 (sink_count_i * sink_count_j + sink_count_j * sink_count_i) *
+                 sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_bh_density ||
                  t->subtype == task_subtype_bh_swallow ||
-                 t->subtype == task_subtype_bh_feedback)
-          cost = 1.f * wscale * bcount_i * count_i;
-        else if (t->subtype == task_subtype_do_gas_swallow)
-          cost = 1.f * wscale * count_i;
-        else if (t->subtype == task_subtype_do_bh_swallow)
-          cost = 1.f * wscale * bcount_i;
-        else if (t->subtype == task_subtype_density ||
+                 t->subtype == task_subtype_bh_feedback) {
+        if (t->ci->nodeID != nodeID)
+          cost = 3.f * wscale * count_i * bcount_j * sid_scale[t->flags];
+        else if (t->cj->nodeID != nodeID)
+          cost = 3.f * wscale * bcount_i * count_j * sid_scale[t->flags];
+        else
+          cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
+                 sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_do_gas_swallow) {
+        cost = 1.f * wscale * (count_i + count_j);
+
+      } else if (t->subtype == task_subtype_do_bh_swallow) {
+        cost = 1.f * wscale * (bcount_i + bcount_j);
+
+      } else if (t->subtype == task_subtype_density ||
                  t->subtype == task_subtype_gradient ||
                  t->subtype == task_subtype_force ||
-                 t->subtype == task_subtype_limiter)
-          cost = 1.f * (wscale * count_i) * count_i;
-        else if (t->subtype == task_subtype_rt_gradient)
-          cost = 1.f * wscale * count_i * count_i;
-        else if (t->subtype == task_subtype_rt_transport)
-          cost = 1.f * wscale * count_i * count_i;
+                 t->subtype == task_subtype_limiter) {
+        if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
+          cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
         else
-          error("Untreated sub-type for selfs: %s",
-                subtaskID_names[t->subtype]);
-        break;
-
-      case task_type_pair:
-        if (t->subtype == task_subtype_grav) {
-          if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
-            cost = 3.f * (wscale * gcount_i) * gcount_j;
-          else
-            cost = 2.f * (wscale * gcount_i) * gcount_j;
-
-        } else if (t->subtype == task_subtype_stars_density ||
-                   t->subtype == task_subtype_stars_prep1 ||
-                   t->subtype == task_subtype_stars_prep2 ||
-                   t->subtype == task_subtype_stars_feedback) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * count_i * scount_j * sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * scount_i * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
-                   sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_sink_swallow ||
-                   t->subtype == task_subtype_sink_do_gas_swallow) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * count_i * sink_count_j * sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * sink_count_i * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * wscale *
-                   (sink_count_i * count_j + sink_count_j * count_i) *
-                   sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * sink_count_i * sink_count_j *
-                   sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * sink_count_i * sink_count_j *
-                   sid_scale[t->flags];
-          else
-            cost = 2.f * wscale *
-                   (sink_count_i * sink_count_j + sink_count_j * sink_count_i) *
-                   sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_bh_density ||
-                   t->subtype == task_subtype_bh_swallow ||
-                   t->subtype == task_subtype_bh_feedback) {
-          if (t->ci->nodeID != nodeID)
-            cost = 3.f * wscale * count_i * bcount_j * sid_scale[t->flags];
-          else if (t->cj->nodeID != nodeID)
-            cost = 3.f * wscale * bcount_i * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
-                   sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_do_gas_swallow) {
-          cost = 1.f * wscale * (count_i + count_j);
-
-        } else if (t->subtype == task_subtype_do_bh_swallow) {
-          cost = 1.f * wscale * (bcount_i + bcount_j);
-
-        } else if (t->subtype == task_subtype_density ||
-                   t->subtype == task_subtype_gradient ||
-                   t->subtype == task_subtype_force ||
-                   t->subtype == task_subtype_limiter) {
-          if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID)
-            cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-          else
-            cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-
-        } else if (t->subtype == task_subtype_rt_gradient) {
-          cost = 1.f * wscale * count_i * count_j;
-        } else if (t->subtype == task_subtype_rt_transport) {
-          cost = 1.f * wscale * count_i * count_j;
-        } else {
-          error("Untreated sub-type for pairs: %s",
-                subtaskID_names[t->subtype]);
-        }
-        break;
+          cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
+
+      } else if (t->subtype == task_subtype_rt_gradient) {
+        cost = 1.f * wscale * count_i * count_j;
+      } else if (t->subtype == task_subtype_rt_transport) {
+        cost = 1.f * wscale * count_i * count_j;
+      } else {
+        error("Untreated sub-type for pairs: %s", subtaskID_names[t->subtype]);
+      }
+      break;
 
-      case task_type_sub_pair:
+    case task_type_sub_pair:
 #ifdef SWIFT_DEBUG_CHECKS
-        if (t->flags < 0) error("Negative flag value!");
+      if (t->flags < 0) error("Negative flag value!");
 #endif
-        if (t->subtype == task_subtype_stars_density ||
-            t->subtype == task_subtype_stars_prep1 ||
-            t->subtype == task_subtype_stars_prep2 ||
-            t->subtype == task_subtype_stars_feedback) {
-          if (t->ci->nodeID != nodeID) {
-            cost = 3.f * (wscale * count_i) * scount_j * sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * scount_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
-                   sid_scale[t->flags];
-          }
+      if (t->subtype == task_subtype_stars_density ||
+          t->subtype == task_subtype_stars_prep1 ||
+          t->subtype == task_subtype_stars_prep2 ||
+          t->subtype == task_subtype_stars_feedback) {
+        if (t->ci->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * scount_j * sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * scount_i) * count_j * sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale * (scount_i * count_j + scount_j * count_i) *
+                 sid_scale[t->flags];
+        }
 
-        } else if (t->subtype == task_subtype_sink_swallow ||
-                   t->subtype == task_subtype_sink_do_gas_swallow) {
-          if (t->ci->nodeID != nodeID) {
-            cost =
-                3.f * (wscale * count_i) * sink_count_j * sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost =
-                3.f * (wscale * sink_count_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale *
-                   (sink_count_i * count_j + sink_count_j * count_i) *
-                   sid_scale[t->flags];
-          }
+      } else if (t->subtype == task_subtype_sink_swallow ||
+                 t->subtype == task_subtype_sink_do_gas_swallow) {
+        if (t->ci->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * sink_count_j * sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * sink_count_i) * count_j * sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale *
+                 (sink_count_i * count_j + sink_count_j * count_i) *
+                 sid_scale[t->flags];
+        }
 
-        } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
-          if (t->ci->nodeID != nodeID) {
-            cost = 3.f * (wscale * sink_count_i) * sink_count_j *
-                   sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * sink_count_i) * sink_count_j *
-                   sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale *
-                   (sink_count_i * sink_count_j + sink_count_j * sink_count_i) *
-                   sid_scale[t->flags];
-          }
-        } else if (t->subtype == task_subtype_bh_density ||
-                   t->subtype == task_subtype_bh_swallow ||
-                   t->subtype == task_subtype_bh_feedback) {
-          if (t->ci->nodeID != nodeID) {
-            cost = 3.f * (wscale * count_i) * bcount_j * sid_scale[t->flags];
-          } else if (t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * bcount_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
-                   sid_scale[t->flags];
-          }
+      } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
+        if (t->ci->nodeID != nodeID) {
+          cost = 3.f * (wscale * sink_count_i) * sink_count_j *
+                 sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * sink_count_i) * sink_count_j *
+                 sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale *
+                 (sink_count_i * sink_count_j + sink_count_j * sink_count_i) *
+                 sid_scale[t->flags];
+        }
+      } else if (t->subtype == task_subtype_bh_density ||
+                 t->subtype == task_subtype_bh_swallow ||
+                 t->subtype == task_subtype_bh_feedback) {
+        if (t->ci->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * bcount_j * sid_scale[t->flags];
+        } else if (t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * bcount_i) * count_j * sid_scale[t->flags];
+        } else {
+          cost = 2.f * wscale * (bcount_i * count_j + bcount_j * count_i) *
+                 sid_scale[t->flags];
+        }
 
-        } else if (t->subtype == task_subtype_do_gas_swallow) {
-          cost = 1.f * wscale * (count_i + count_j);
+      } else if (t->subtype == task_subtype_do_gas_swallow) {
+        cost = 1.f * wscale * (count_i + count_j);
 
-        } else if (t->subtype == task_subtype_do_bh_swallow) {
-          cost = 1.f * wscale * (bcount_i + bcount_j);
+      } else if (t->subtype == task_subtype_do_bh_swallow) {
+        cost = 1.f * wscale * (bcount_i + bcount_j);
 
-        } else if (t->subtype == task_subtype_density ||
-                   t->subtype == task_subtype_gradient ||
-                   t->subtype == task_subtype_force ||
-                   t->subtype == task_subtype_limiter) {
-          if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID) {
-            cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-          } else {
-            cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
-          }
-        } else if (t->subtype == task_subtype_rt_gradient) {
-          cost = 1.f * wscale * count_i * count_j;
-        } else if (t->subtype == task_subtype_rt_transport) {
-          cost = 1.f * wscale * count_i * count_j;
+      } else if (t->subtype == task_subtype_density ||
+                 t->subtype == task_subtype_gradient ||
+                 t->subtype == task_subtype_force ||
+                 t->subtype == task_subtype_limiter) {
+        if (t->ci->nodeID != nodeID || t->cj->nodeID != nodeID) {
+          cost = 3.f * (wscale * count_i) * count_j * sid_scale[t->flags];
         } else {
-          error("Untreated sub-type for sub-pairs: %s",
-                subtaskID_names[t->subtype]);
+          cost = 2.f * (wscale * count_i) * count_j * sid_scale[t->flags];
         }
-        break;
+      } else if (t->subtype == task_subtype_rt_gradient) {
+        cost = 1.f * wscale * count_i * count_j;
+      } else if (t->subtype == task_subtype_rt_transport) {
+        cost = 1.f * wscale * count_i * count_j;
+      } else {
+        error("Untreated sub-type for sub-pairs: %s",
+              subtaskID_names[t->subtype]);
+      }
+      break;
 
-      case task_type_sub_self:
-        if (t->subtype == task_subtype_stars_density ||
-            t->subtype == task_subtype_stars_prep1 ||
-            t->subtype == task_subtype_stars_prep2 ||
-            t->subtype == task_subtype_stars_feedback) {
-          cost = 1.f * (wscale * scount_i) * count_i;
-        } else if (t->subtype == task_subtype_sink_swallow ||
-                   t->subtype == task_subtype_sink_do_gas_swallow) {
-          cost = 1.f * (wscale * sink_count_i) * count_i;
-        } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
-          cost = 1.f * (wscale * sink_count_i) * sink_count_i;
-        } else if (t->subtype == task_subtype_bh_density ||
-                   t->subtype == task_subtype_bh_swallow ||
-                   t->subtype == task_subtype_bh_feedback) {
-          cost = 1.f * (wscale * bcount_i) * count_i;
-        } else if (t->subtype == task_subtype_do_gas_swallow) {
-          cost = 1.f * wscale * count_i;
-        } else if (t->subtype == task_subtype_do_bh_swallow) {
-          cost = 1.f * wscale * bcount_i;
-        } else if (t->subtype == task_subtype_density ||
-                   t->subtype == task_subtype_gradient ||
-                   t->subtype == task_subtype_force ||
-                   t->subtype == task_subtype_limiter) {
-          cost = 1.f * (wscale * count_i) * count_i;
-        } else if (t->subtype == task_subtype_rt_gradient) {
-          cost = 1.f * wscale * scount_i * count_i;
-        } else if (t->subtype == task_subtype_rt_transport) {
-          cost = 1.f * wscale * scount_i * count_i;
-        } else {
-          error("Untreated sub-type for sub-selfs: %s",
-                subtaskID_names[t->subtype]);
-        }
-        break;
-      case task_type_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
-        break;
-      case task_type_extra_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
-        break;
-      case task_type_stars_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * scount_i;
-        break;
-      case task_type_bh_density_ghost:
-        if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
-        break;
-      case task_type_bh_swallow_ghost2:
-        if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
-        break;
-      case task_type_drift_part:
-        cost = wscale * count_i;
-        break;
-      case task_type_drift_gpart:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_drift_spart:
-        cost = wscale * scount_i;
-        break;
-      case task_type_drift_sink:
-        cost = wscale * sink_count_i;
-        break;
-      case task_type_drift_bpart:
-        cost = wscale * bcount_i;
-        break;
-      case task_type_init_grav:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_grav_down:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_grav_long_range:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_grav_mm:
-        cost = wscale * (gcount_i + gcount_j);
-        break;
-      case task_type_end_hydro_force:
-        cost = wscale * count_i;
-        break;
-      case task_type_end_grav_force:
-        cost = wscale * gcount_i;
-        break;
-      case task_type_cooling:
-        cost = wscale * count_i;
-        break;
-      case task_type_star_formation:
-        cost = wscale * (count_i + scount_i);
-        break;
-      case task_type_star_formation_sink:
-        cost = wscale * (sink_count_i + scount_i);
-        break;
-      case task_type_sink_formation:
-        cost = wscale * (count_i + sink_count_i);
-        break;
-      case task_type_rt_ghost1:
-        cost = wscale * count_i;
-        break;
-      case task_type_rt_ghost2:
-        cost = wscale * count_i;
-        break;
-      case task_type_rt_tchem:
-        cost = wscale * count_i;
-        break;
-      case task_type_rt_advance_cell_time:
-      case task_type_rt_collect_times:
-        cost = wscale;
-        break;
-      case task_type_csds:
-        cost =
-            wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
-        break;
-      case task_type_kick1:
-        cost =
-            wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
-        break;
-      case task_type_kick2:
-        cost =
-            wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
-        break;
-      case task_type_timestep:
-        cost =
-            wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
-        break;
-      case task_type_timestep_limiter:
-        cost = wscale * count_i;
-        break;
-      case task_type_timestep_sync:
-        cost = wscale * count_i;
-        break;
-      case task_type_send:
-        if (count_i < 1e5)
-          cost = 10.f * (wscale * count_i) * count_i;
-        else
-          cost = 2e9;
-        break;
-      case task_type_recv:
-        if (count_i < 1e5)
-          cost = 5.f * (wscale * count_i) * count_i;
-        else
-          cost = 1e9;
-        break;
-      default:
-        cost = 0;
-        break;
+    case task_type_sub_self:
+      if (t->subtype == task_subtype_stars_density ||
+          t->subtype == task_subtype_stars_prep1 ||
+          t->subtype == task_subtype_stars_prep2 ||
+          t->subtype == task_subtype_stars_feedback) {
+        cost = 1.f * (wscale * scount_i) * count_i;
+      } else if (t->subtype == task_subtype_sink_swallow ||
+                 t->subtype == task_subtype_sink_do_gas_swallow) {
+        cost = 1.f * (wscale * sink_count_i) * count_i;
+      } else if (t->subtype == task_subtype_sink_do_sink_swallow) {
+        cost = 1.f * (wscale * sink_count_i) * sink_count_i;
+      } else if (t->subtype == task_subtype_bh_density ||
+                 t->subtype == task_subtype_bh_swallow ||
+                 t->subtype == task_subtype_bh_feedback) {
+        cost = 1.f * (wscale * bcount_i) * count_i;
+      } else if (t->subtype == task_subtype_do_gas_swallow) {
+        cost = 1.f * wscale * count_i;
+      } else if (t->subtype == task_subtype_do_bh_swallow) {
+        cost = 1.f * wscale * bcount_i;
+      } else if (t->subtype == task_subtype_density ||
+                 t->subtype == task_subtype_gradient ||
+                 t->subtype == task_subtype_force ||
+                 t->subtype == task_subtype_limiter) {
+        cost = 1.f * (wscale * count_i) * count_i;
+      } else if (t->subtype == task_subtype_rt_gradient) {
+        cost = 1.f * wscale * scount_i * count_i;
+      } else if (t->subtype == task_subtype_rt_transport) {
+        cost = 1.f * wscale * scount_i * count_i;
+      } else {
+        error("Untreated sub-type for sub-selfs: %s",
+              subtaskID_names[t->subtype]);
+      }
+      break;
+    case task_type_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
+      break;
+    case task_type_extra_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * count_i;
+      break;
+    case task_type_stars_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * scount_i;
+      break;
+    case task_type_bh_density_ghost:
+      if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
+      break;
+    case task_type_bh_swallow_ghost2:
+      if (t->ci == t->ci->hydro.super) cost = wscale * bcount_i;
+      break;
+    case task_type_drift_part:
+      cost = wscale * count_i;
+      break;
+    case task_type_drift_gpart:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_drift_spart:
+      cost = wscale * scount_i;
+      break;
+    case task_type_drift_sink:
+      cost = wscale * sink_count_i;
+      break;
+    case task_type_drift_bpart:
+      cost = wscale * bcount_i;
+      break;
+    case task_type_init_grav:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_grav_down:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_grav_long_range:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_grav_mm:
+      cost = wscale * (gcount_i + gcount_j);
+      break;
+    case task_type_end_hydro_force:
+      cost = wscale * count_i;
+      break;
+    case task_type_end_grav_force:
+      cost = wscale * gcount_i;
+      break;
+    case task_type_cooling:
+      cost = wscale * count_i;
+      break;
+    case task_type_star_formation:
+      cost = wscale * (count_i + scount_i);
+      break;
+    case task_type_star_formation_sink:
+      cost = wscale * (sink_count_i + scount_i);
+      break;
+    case task_type_sink_formation:
+      cost = wscale * (count_i + sink_count_i);
+      break;
+    case task_type_rt_ghost1:
+      cost = wscale * count_i;
+      break;
+    case task_type_rt_ghost2:
+      cost = wscale * count_i;
+      break;
+    case task_type_rt_tchem:
+      cost = wscale * count_i;
+      break;
+    case task_type_rt_advance_cell_time:
+    case task_type_rt_collect_times:
+      cost = wscale;
+      break;
+    case task_type_csds:
+      cost = wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
+      break;
+    case task_type_kick1:
+      cost = wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
+      break;
+    case task_type_kick2:
+      cost = wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
+      break;
+    case task_type_timestep:
+      cost = wscale * (count_i + gcount_i + scount_i + sink_count_i + bcount_i);
+      break;
+    case task_type_timestep_limiter:
+      cost = wscale * count_i;
+      break;
+    case task_type_timestep_sync:
+      cost = wscale * count_i;
+      break;
+    case task_type_send:
+      if (count_i < 1e5)
+        cost = 10.f * (wscale * count_i) * count_i;
+      else
+        cost = 2e9;
+      break;
+    case task_type_recv:
+      if (count_i < 1e5)
+        cost = 5.f * (wscale * count_i) * count_i;
+      else
+        cost = 1e9;
+      break;
+    default:
+      cost = 0;
+      break;
+  }
+
+  return cost;
+}
+
+/**
+ * @brief Size, in bytes, of the data moved by a send or recv task.
+ *
+ * @param t The #task.
+ */
+static size_t scheduler_task_comm_size(const struct task *t) {
+
+  const struct cell *c = t->ci;
+
+  switch (t->subtype) {
+#ifdef WITH_MPI
+    case task_subtype_tend:
+      return c->mpi.pcell_size * sizeof(struct pcell_step);
+    case task_subtype_sf_counts:
+      return c->mpi.pcell_size * sizeof(struct pcell_sf);
+#endif
+    case task_subtype_part_swallow:
+      return c->hydro.count * sizeof(struct black_holes_part_data);
+    case task_subtype_bpart_merger:
+      return c->black_holes.count * sizeof(struct black_holes_bpart_data);
+#ifdef hydro_mpi_rho_fields
+    case task_subtype_rho:
+      return c->hydro.count * sizeof(struct part_rho_payload);
+#endif
+#ifdef hydro_mpi_gradient_fields
+    case task_subtype_gradient:
+      return c->hydro.count * sizeof(struct part_gradient_payload);
+#endif
+    case task_subtype_xv:
+#ifndef hydro_mpi_rho_fields
+    case task_subtype_rho:
+#endif
+#ifndef hydro_mpi_gradient_fields
+    case task_subtype_gradient:
+#endif
+    case task_subtype_rt_gradient:
+    case task_subtype_rt_transport:
+    case task_subtype_part_prep1:
+      return c->hydro.count * sizeof(struct part);
+    case task_subtype_limiter:
+      return c->hydro.count * sizeof(timebin_t);
+    case task_subtype_gpart:
+#ifdef WITH_MPI
+      if (t->mpi_encoded)
+        return c->grav.count * sizeof(struct gpart_foreign_payload);
+#endif
+      return c->grav.count * sizeof(struct gpart);
+    case task_subtype_spart_density:
+    case task_subtype_spart_prep2:
+      return c->stars.count * sizeof(struct spart);
+    case task_subtype_bpart_rho:
+    case task_subtype_bpart_feedback:
+      return c->black_holes.count * sizeof(struct bpart);
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Estimate the time, in ticks, it takes for the data of a send or
+ * recv task to reach the other rank.
+ *
+ * @param s The #scheduler.
+ * @param t The #task.
+ */
+static float scheduler_task_comm_delay(const struct scheduler *s,
+                                       const struct task *t) {
+  return s->mpi_latency +
+         s->mpi_ticks_per_byte * (double)scheduler_task_comm_size(t);
+}
+
+/**
+ * @brief Compute the task weights as the length of the critical path
+ * starting at each task.
+ *
+ * The tasks are visited in reverse topological order and each gets its own
+ * cost plus the largest weight of the tasks it unlocks, including the
+ * implicit ones. Once the cost model is trained, the costs are in ticks and
+ * the send and recv tasks are given their estimated communication delay,
+ * such that the chains of tasks waiting on foreign data are started early.
+ * The queues then order the tasks by decreasing weight.
+ *
+ * @param s The #scheduler.
+ * @param verbose Are we talkative?
+ */
+void scheduler_reweight(struct scheduler *s, int verbose) {
+  const int nr_tasks = s->nr_tasks;
+  int *tid = s->tasks_ind;
+  struct task *tasks = s->tasks;
+  const int nodeID = s->nodeID;
+  const int use_comm_delays = cost_model_is_trained(&s->cost_model);
+  const ticks tic = getticks();
+
+  /* Run through the tasks backwards and set their weights. */
+  for (int k = nr_tasks - 1; k >= 0; k--) {
+    struct task *t = &tasks[tid[k]];
+
+    /* Length of the longest path after us. */
+    float weight = 0.f;
+    for (int j = 0; j < t->nr_unlock_tasks; j++)
+      weight = max(weight, t->unlock_tasks[j]->weight);
+
+    /* Our own cost, corrected by the measured costs if we have them. */
+    if (use_comm_delays &&
+        (t->type == task_type_send || t->type == task_type_recv)) {
+      weight += scheduler_task_comm_delay(s, t);
+    } else {
+      const float cost = scheduler_task_cost_estimate(t, nodeID);
+      weight += cost_model_cost(&s->cost_model, t->type, t->subtype, cost);
     }
-    t->weight += cost;
+
+    t->weight = weight;
   }
 
   if (verbose)
@@ -2357,6 +2472,45 @@ void scheduler_reweight(struct scheduler *s, int verbose) {
   message( "task weights are in [ %i , %i ]." , min , max ); */
 }
 
+/**
+ * @brief Add the measured run times of the tasks of the last step to the
+ * cost model.
+ *
+ * To keep this cheap on large task graphs, we only look at every n-th task,
+ * with n chosen so that at most cost_model.max_samples tasks are sampled,
+ * and move the starting point at every step.
+ *
+ * @param s The #scheduler.
+ * @param tic_start The time at which the tasks of the step were launched.
+ * @param step The current step.
+ */
+void scheduler_sample_task_costs(struct scheduler *s, const ticks tic_start,
+                                 const int step) {
+
+  struct cost_model *m = &s->cost_model;
+  const int nr_tasks = s->nr_tasks;
+  if (!m->enabled || nr_tasks == 0) return;
+
+  const int max_samples = max(1, m->max_samples);
+  const int stride = max(1, nr_tasks / max_samples);
+  cost_model_decay(m);
+
+  for (int k = step % stride; k < nr_tasks; k += stride) {
+    const struct task *t = &s->tasks[k];
+
+    /* Only consider the tasks that ran in this step. */
+    if (t->implicit || t->tic < tic_start || t->toc <= t->tic) continue;
+
+    /* The communications mostly wait on the network. */
+    if (t->type == task_type_send || t->type == task_type_recv) continue;
+
+    const float estimate = scheduler_task_cost_estimate(t, s->nodeID);
+    if (estimate <= 0.f) continue;
+
+    cost_model_add_sample(m, t->type, t->subtype, estimate, t->toc - t->tic);
+  }
+}
+
 /**
  * @brief #threadpool_map function which runs through the task
  *        graph and re-computes the task wait counters.
@@ -2375,6 +2529,14 @@ void scheduler_rewait_mapper(void *map_data, int num_elements,
     /* Increment the task's own wait counter for the enqueueing. */
     atomic_inc(&t->wait);
 
+#ifdef WITH_MPI
+    /* Pick the encoding of the foreign gparts for this launch, the other
+     * rank does the same. */
+    if (t->subtype == task_subtype_gpart &&
+        (t->type == task_type_send || t->type == task_type_recv))
+      t->mpi_encoded = s->mpi_gpart_encode && t->mpi_rma == NULL;
+#endif
+
 #ifdef SWIFT_DEBUG_CHECKS
     /* Check that we don't have more waits that what can be stored. */
     if (t->wait < 0)
@@ -2405,27 +2567,802 @@ void scheduler_enqueue_mapper(void *map_data, int num_elements,
   pthread_cond_broadcast(&s->sleep_cond);
 }
 
+#ifdef WITH_MPI
 /**
- * @brief Start the scheduler, i.e. fill the queues with ready tasks.
+ * @brief Can the messages of the send and recv tasks of a given subtype be
+ * coalesced?
  *
- * @param s The #scheduler.
+ * Only the halo exchanges whose sends wait for nothing but the recvs of
+ * earlier phases are coalesced, such that waiting for all the cells of a
+ * rank before sending cannot create a cycle between the ranks.
+ *
+ * @param subtype The #task_subtypes.
  */
-void scheduler_start(struct scheduler *s) {
+static int scheduler_mpi_aggregate_subtype(const enum task_subtypes subtype) {
+  return subtype == task_subtype_xv || subtype == task_subtype_rho ||
+         subtype == task_subtype_gradient || subtype == task_subtype_gpart;
+}
 
-  /* Re-wait the tasks. */
-  if (s->active_count > 1000) {
-    threadpool_map(s->threadpool, scheduler_rewait_mapper, s->tid_active,
-                   s->active_count, sizeof(int), threadpool_auto_chunk_size, s);
-  } else {
-    scheduler_rewait_mapper(s->tid_active, s->active_count, s);
-  }
+/**
+ * @brief The rank on the other side of a send or recv #task.
+ */
+static int scheduler_mpi_aggregate_rank(const struct task *t) {
+  return (t->type == task_type_send) ? t->cj->nodeID : t->ci->nodeID;
+}
 
-  /* Loop over the tasks and enqueue whoever is ready. */
-  if (s->active_count > 1000) {
-    threadpool_map(s->threadpool, scheduler_enqueue_mapper, s->tid_active,
-                   s->active_count, sizeof(int), threadpool_auto_chunk_size, s);
-  } else {
-    scheduler_enqueue_mapper(s->tid_active, s->active_count, s);
+/**
+ * @brief Do two send or recv tasks belong to the same coalesced message?
+ */
+static int scheduler_mpi_aggregate_same(const struct task *ta,
+                                        const struct task *tb) {
+  return ta->type == tb->type && ta->subtype == tb->subtype &&
+         scheduler_mpi_aggregate_rank(ta) == scheduler_mpi_aggregate_rank(tb);
+}
+
+/**
+ * @brief Sort the send and recv tasks by type, rank on the other side,
+ * subtype and tag.
+ */
+static int scheduler_mpi_aggregate_cmp(const void *a, const void *b) {
+  const struct task *ta = *(const struct task **)a;
+  const struct task *tb = *(const struct task **)b;
+  const int ra = scheduler_mpi_aggregate_rank(ta);
+  const int rb = scheduler_mpi_aggregate_rank(tb);
+  if (ta->type != tb->type) return ta->type - tb->type;
+  if (ra != rb) return ra - rb;
+  if (ta->subtype != tb->subtype) return ta->subtype - tb->subtype;
+  return (ta->flags > tb->flags) - (ta->flags < tb->flags);
+}
+
+/**
+ * @brief Free the coalesced messages of the last step and detach their
+ * tasks.
+ *
+ * @param s The #scheduler.
+ */
+void scheduler_mpi_aggregate_free(struct scheduler *s) {
+
+  for (int k = 0; k < s->nr_mpi_aggregate_tasks; k++)
+    s->mpi_aggregate_tasks[k]->mpi_aggregate = NULL;
+  s->nr_mpi_aggregate_tasks = 0;
+
+  for (int k = 0; k < s->nr_mpi_aggregates; k++)
+    free(s->mpi_aggregates[k].buffer);
+  s->nr_mpi_aggregates = 0;
+}
+
+/**
+ * @brief Group the active send and recv tasks of the halo exchanges by rank
+ * and subtype and post the recvs of the resulting coalesced messages.
+ *
+ * Both sides see the same active tasks for a given pair of ranks, so sorting
+ * them by tag gives the same layout of the messages on both sides. The tasks
+ * then only copy their data in and out of the buffers, see
+ * scheduler_mpi_aggregate_pack() and scheduler_mpi_aggregate_unpack().
+ *
+ * @param s The #scheduler.
+ */
+void scheduler_mpi_aggregate_prepare(struct scheduler *s) {
+
+  /* The tasks of the last step may not be active any more. */
+  scheduler_mpi_aggregate_free(s);
+
+  /* Collect the active communication tasks we can coalesce. */
+  if (s->size_mpi_aggregate_tasks < s->active_count) {
+    free(s->mpi_aggregate_tasks);
+    s->size_mpi_aggregate_tasks = s->active_count;
+    if ((s->mpi_aggregate_tasks = (struct task **)malloc(
+             sizeof(struct task *) * s->size_mpi_aggregate_tasks)) == NULL)
+      error("Failed to allocate the list of coalesced tasks.");
+  }
+  struct task **tasks = s->mpi_aggregate_tasks;
+  int count = 0;
+  for (int k = 0; k < s->active_count; k++) {
+    struct task *t = &s->tasks[s->tid_active[k]];
+    if (t->skip) continue;
+    if (t->type != task_type_send && t->type != task_type_recv) continue;
+    if (!scheduler_mpi_aggregate_subtype(t->subtype)) continue;
+    if (t->mpi_rma != NULL) continue;
+    tasks[count++] = t;
+  }
+  qsort(tasks, count, sizeof(struct task *), scheduler_mpi_aggregate_cmp);
+  s->nr_mpi_aggregate_tasks = count;
+
+  /* Count the messages, there is nothing to gain from a single task. */
+  int nr_aggregates = 0;
+  for (int first = 0, last; first < count; first = last) {
+    last = first + 1;
+    while (last < count &&
+           scheduler_mpi_aggregate_same(tasks[first], tasks[last]))
+      last++;
+    if (last - first > 1) nr_aggregates++;
+  }
+  if (s->size_mpi_aggregates < nr_aggregates) {
+    free(s->mpi_aggregates);
+    s->size_mpi_aggregates = nr_aggregates;
+    if ((s->mpi_aggregates = (struct mpi_aggregate *)malloc(
+             sizeof(struct mpi_aggregate) * nr_aggregates)) == NULL)
+      error("Failed to allocate the coalesced messages.");
+  }
+
+  /* Lay out the data of the tasks in their messages. */
+  for (int first = 0, last; first < count; first = last) {
+    last = first + 1;
+    while (last < count &&
+           scheduler_mpi_aggregate_same(tasks[first], tasks[last]))
+      last++;
+    if (last - first < 2) continue;
+
+    struct mpi_aggregate *a = &s->mpi_aggregates[s->nr_mpi_aggregates++];
+    a->type = tasks[first]->type;
+    a->subtype = tasks[first]->subtype;
+    a->otherrank = scheduler_mpi_aggregate_rank(tasks[first]);
+    a->count = last - first;
+    a->pending = a->count;
+    a->done = 0;
+    a->size = 0;
+    lock_init(&a->lock);
+    for (int k = first; k < last; k++) {
+      tasks[k]->mpi_aggregate = a;
+      tasks[k]->mpi_aggregate_offset = a->size;
+      a->size += scheduler_task_comm_size(tasks[k]);
+    }
+    if ((a->buffer = (char *)malloc(a->size)) == NULL)
+      error("Failed to allocate a coalesced message.");
+
+    /* Post the recvs right away, their tasks will find the data there. */
+    if (a->type == task_type_recv) {
+      const int err =
+          MPI_Irecv(a->buffer, a->size, MPI_BYTE, a->otherrank,
+                    scheduler_mpi_aggregate_tag, subtaskMPI_comms[a->subtype],
+                    &a->req);
+      if (err != MPI_SUCCESS)
+        mpi_error(err, "Failed to emit irecv for coalesced data.");
+      mpiuse_log_aggregate(a->type, a->subtype, &a->req, a->size, a->otherrank,
+                           scheduler_mpi_aggregate_tag, a->count);
+    }
+  }
+}
+
+/**
+ * @brief Copy the data of a send #task to its coalesced message and send the
+ * message once all the tasks have done so.
+ *
+ * The request of the message is held by the last task, the others are done
+ * as soon as their data is copied.
+ *
+ * @param t The send #task.
+ * @param buff The data to send.
+ * @param size The size, in bytes, of the data.
+ */
+void scheduler_mpi_aggregate_pack(struct task *t, const void *buff,
+                                  size_t size) {
+
+  struct mpi_aggregate *a = t->mpi_aggregate;
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (t->mpi_aggregate_offset + size > a->size)
+    error("Task data does not fit in its coalesced message (%s/%s).",
+          taskID_names[t->type], subtaskID_names[t->subtype]);
+#endif
+
+  memcpy(a->buffer + t->mpi_aggregate_offset, buff, size);
+  t->req = MPI_REQUEST_NULL;
+
+  if (atomic_dec(&a->pending) == 1) {
+    const int err =
+        MPI_Isend(a->buffer, a->size, MPI_BYTE, a->otherrank,
+                  scheduler_mpi_aggregate_tag, subtaskMPI_comms[a->subtype],
+                  &t->req);
+    if (err != MPI_SUCCESS)
+      mpi_error(err, "Failed to emit isend for coalesced data.");
+    mpiuse_log_aggregate(a->type, a->subtype, &t->req, a->size, a->otherrank,
+                         scheduler_mpi_aggregate_tag, a->count);
+  }
+}
+
+/**
+ * @brief Check whether the coalesced message of a send or recv #task has
+ * completed.
+ *
+ * @param t The #task.
+ *
+ * @return 1 if the task can run, 0 otherwise.
+ */
+int scheduler_mpi_aggregate_test(struct task *t) {
+
+  struct mpi_aggregate *a = t->mpi_aggregate;
+  int res = 0, err = MPI_SUCCESS;
+
+  /* Only the last send task holds the request of the message. */
+  if (t->type == task_type_send) {
+    if (t->req == MPI_REQUEST_NULL) return 1;
+    if ((err = MPI_Test(&t->req, &res, MPI_STATUS_IGNORE)) != MPI_SUCCESS)
+      mpi_error(err, "Failed to test coalesced send.");
+    if (res) {
+      mpiuse_log_allocation(t->type, t->subtype, &t->req, 0, 0, 0, 0);
+    }
+    return res;
+  }
+
+  /* All the recv tasks share the request of the message. */
+  if (a->done) return 1;
+  if (lock_trylock(&a->lock) != 0) return 0;
+  if (!a->done) {
+    if ((err = MPI_Test(&a->req, &res, MPI_STATUS_IGNORE)) != MPI_SUCCESS)
+      mpi_error(err, "Failed to test coalesced recv.");
+    if (res) {
+      mpiuse_log_allocation(a->type, a->subtype, &a->req, 0, 0, 0, 0);
+      a->done = 1;
+    }
+  }
+  res = a->done;
+  if (lock_unlock(&a->lock) != 0) error("Failed to unlock coalesced message.");
+  return res;
+}
+
+/**
+ * @brief Copy the data of a recv #task out of its completed coalesced
+ * message.
+ *
+ * Each task does so when it runs, such that the tasks depending on the
+ * cells received first do not wait for the whole message to be unpacked.
+ *
+ * @param t The recv #task.
+ */
+void scheduler_mpi_aggregate_unpack(struct task *t) {
+
+  const struct mpi_aggregate *a = t->mpi_aggregate;
+  memcpy(t->buff, a->buffer + t->mpi_aggregate_offset,
+         scheduler_task_comm_size(t));
+}
+
+/**
+ * @brief Can the data of the send and recv tasks of a given subtype go
+ * through the one-sided windows?
+ *
+ * Only the subtypes whose data goes straight from the cells of one rank to
+ * the foreign buffers of the other can.
+ *
+ * @param subtype The #task_subtypes.
+ */
+static int scheduler_mpi_rma_subtype(const enum task_subtypes subtype) {
+  return subtype == task_subtype_xv || subtype == task_subtype_gpart;
+}
+
+/**
+ * @brief A recv #task using the one-sided windows, as sent to the rank of its
+ * send task.
+ */
+struct mpi_rma_record {
+
+  /*! Tag and subtype of the task. */
+  long long tag;
+  int subtype;
+
+  /*! Notification flag of the task. */
+  int slot;
+
+  /*! Offset and size, in bytes, of the data in the foreign buffer. */
+  size_t offset;
+  size_t size;
+};
+
+/**
+ * @brief The window holding the data of a send or recv #task.
+ */
+static MPI_Win scheduler_mpi_rma_win(const struct task *t) {
+  return (t->subtype == task_subtype_xv) ? t->mpi_rma->parts_win
+                                         : t->mpi_rma->gparts_win;
+}
+
+/**
+ * @brief Read and clear one of the notification flags of this rank.
+ *
+ * @param r The #mpi_rma windows.
+ * @param slot The flag.
+ *
+ * @return The value of the flag.
+ */
+static int scheduler_mpi_rma_fetch(struct mpi_rma *r, int slot) {
+
+  const int zero = 0;
+  int flag = 0, err = MPI_SUCCESS;
+  if ((err = MPI_Fetch_and_op(&zero, &flag, MPI_INT, r->rank, slot,
+                              MPI_REPLACE, r->flags_win)) != MPI_SUCCESS)
+    mpi_error(err, "Failed to fetch a notification flag.");
+  if ((err = MPI_Win_flush(r->rank, r->flags_win)) != MPI_SUCCESS)
+    mpi_error(err, "Failed to flush a notification flag.");
+  return flag;
+}
+
+/**
+ * @brief Raise one of the notification flags of another rank.
+ *
+ * @param r The #mpi_rma windows.
+ * @param rank The other rank.
+ * @param slot The flag.
+ */
+static void scheduler_mpi_rma_notify(struct mpi_rma *r, int rank, int slot) {
+
+  const int one = 1;
+  int err = MPI_SUCCESS;
+  if ((err = MPI_Accumulate(&one, 1, MPI_INT, rank, slot, 1, MPI_INT,
+                            MPI_REPLACE, r->flags_win)) != MPI_SUCCESS)
+    mpi_error(err, "Failed to raise a notification flag.");
+  if ((err = MPI_Win_flush(rank, r->flags_win)) != MPI_SUCCESS)
+    mpi_error(err, "Failed to flush a notification flag.");
+}
+
+/**
+ * @brief Free the one-sided windows, if any, and detach their tasks.
+ *
+ * This is a collective call, to be made before the foreign buffers exposed
+ * in the windows are freed. The tasks then fall back to two-sided
+ * communications until the windows are registered again.
+ *
+ * @param s The #scheduler.
+ */
+void scheduler_mpi_rma_free(struct scheduler *s) {
+
+  struct mpi_rma *r = &s->mpi_rma_windows;
+  if (!r->registered) return;
+
+  for (int k = 0; k < s->nr_tasks; k++) s->tasks[k].mpi_rma = NULL;
+
+  MPI_Win *wins[3] = {&r->parts_win, &r->gparts_win, &r->flags_win};
+  for (int k = 0; k < 3; k++) {
+    int err = MPI_SUCCESS;
+    if ((err = MPI_Win_unlock_all(*wins[k])) != MPI_SUCCESS ||
+        (err = MPI_Win_free(wins[k])) != MPI_SUCCESS)
+      mpi_error(err, "Failed to free a one-sided window.");
+  }
+  free(r->flags);
+  r->flags = NULL;
+  r->registered = 0;
+}
+
+/**
+ * @brief Register the foreign #part and #gpart buffers in the one-sided
+ * windows and tell the send tasks where their data goes.
+ *
+ * This is a collective call, to be made every time the foreign buffers are
+ * (re-)allocated. Each rank sends the tag, subtype, notification flag and
+ * offset in the foreign buffers of its recv tasks to the rank of their send
+ * tasks, which replies with the notification flags of the send tasks. The
+ * tags are then never used again.
+ *
+ * @param s The #scheduler.
+ */
+void scheduler_mpi_rma_register(struct scheduler *s) {
+
+  struct mpi_rma *r = &s->mpi_rma_windows;
+  const struct space *sp = s->space;
+  int nr_nodes = 1, err = MPI_SUCCESS;
+  MPI_Comm_size(MPI_COMM_WORLD, &nr_nodes);
+
+  /* Start from scratch. */
+  scheduler_mpi_rma_free(s);
+  r->rank = s->nodeID;
+
+  /* Collect the send and recv tasks using the windows. */
+  int nr_send = 0, nr_recv = 0;
+  for (int k = 0; k < s->nr_tasks; k++) {
+    struct task *t = &s->tasks[k];
+    t->mpi_rma = NULL;
+    if (!scheduler_mpi_rma_subtype(t->subtype)) continue;
+    if (t->type == task_type_send) nr_send++;
+    if (t->type == task_type_recv) nr_recv++;
+  }
+  struct task **tasks =
+      (struct task **)malloc(sizeof(struct task *) * (nr_send + nr_recv + 1));
+  if (tasks == NULL) error("Failed to allocate the one-sided task list.");
+  int count = 0;
+  for (int k = 0; k < s->nr_tasks; k++) {
+    struct task *t = &s->tasks[k];
+    if (!scheduler_mpi_rma_subtype(t->subtype)) continue;
+    if (t->type == task_type_send || t->type == task_type_recv)
+      tasks[count++] = t;
+  }
+
+  /* Sends then recvs, each sorted by rank, subtype and tag. */
+  qsort(tasks, count, sizeof(struct task *), scheduler_mpi_aggregate_cmp);
+  struct task **sends = tasks;
+  struct task **recvs = &tasks[nr_send];
+
+  /* Expose the foreign buffers and the notification flags. */
+  if ((r->flags = (int *)calloc(nr_recv + nr_send + 1, sizeof(int))) == NULL)
+    error("Failed to allocate the notification flags.");
+  if ((err = MPI_Win_create(sp->parts_foreign,
+                            sp->size_parts_foreign * sizeof(struct part), 1,
+                            MPI_INFO_NULL, MPI_COMM_WORLD, &r->parts_win)) !=
+          MPI_SUCCESS ||
+      (err = MPI_Win_create(sp->gparts_foreign,
+                            sp->size_gparts_foreign * sizeof(struct gpart), 1,
+                            MPI_INFO_NULL, MPI_COMM_WORLD, &r->gparts_win)) !=
+          MPI_SUCCESS ||
+      (err = MPI_Win_create(r->flags, (nr_recv + nr_send) * sizeof(int),
+                            sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD,
+                            &r->flags_win)) != MPI_SUCCESS)
+    mpi_error(err, "Failed to create the one-sided windows.");
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, r->parts_win);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, r->gparts_win);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, r->flags_win);
+  r->registered = 1;
+
+  /* Describe our recv tasks to the ranks sending the data. */
+  int *counts = (int *)calloc(4 * nr_nodes, sizeof(int));
+  if (counts == NULL) error("Failed to allocate the one-sided counts.");
+  int *recv_counts = counts, *recv_offsets = &counts[nr_nodes];
+  int *send_counts = &counts[2 * nr_nodes];
+  int *send_offsets = &counts[3 * nr_nodes];
+  struct mpi_rma_record *records_out = (struct mpi_rma_record *)malloc(
+      sizeof(struct mpi_rma_record) * (nr_recv + 1));
+  struct mpi_rma_record *records_in = (struct mpi_rma_record *)malloc(
+      sizeof(struct mpi_rma_record) * (nr_send + 1));
+  if (records_out == NULL || records_in == NULL)
+    error("Failed to allocate the one-sided records.");
+  for (int k = 0; k < nr_recv; k++) {
+    struct task *t = recvs[k];
+    const struct cell *c = t->ci;
+    const char *data = (t->subtype == task_subtype_xv)
+                           ? (const char *)c->hydro.parts
+                           : (const char *)c->grav.parts;
+    const char *base = (t->subtype == task_subtype_xv)
+                           ? (const char *)sp->parts_foreign
+                           : (const char *)sp->gparts_foreign;
+    t->mpi_rma = r;
+    t->mpi_encoded = 0;
+    records_out[k].tag = t->flags;
+    records_out[k].subtype = t->subtype;
+    records_out[k].slot = k;
+    records_out[k].offset = (data != NULL) ? data - base : 0;
+    records_out[k].size = scheduler_task_comm_size(t);
+    recv_counts[c->nodeID]++;
+    t->mpi_rma_slot = k;
+  }
+  if ((err = MPI_Alltoall(recv_counts, 1, MPI_INT, send_counts, 1, MPI_INT,
+                          MPI_COMM_WORLD)) != MPI_SUCCESS)
+    mpi_error(err, "Failed to exchange the one-sided counts.");
+  int nr_in = 0;
+  for (int k = 0; k < nr_nodes; k++) {
+    recv_offsets[k] = (k > 0) ? recv_offsets[k - 1] + recv_counts[k - 1] : 0;
+    send_offsets[k] = nr_in;
+    nr_in += send_counts[k];
+  }
+  if (nr_in != nr_send)
+    error("Got %d one-sided records for %d send tasks.", nr_in, nr_send);
+
+  /* The records are exchanged as bytes. */
+  for (int k = 0; k < 4 * nr_nodes; k++)
+    counts[k] *= sizeof(struct mpi_rma_record);
+  if ((err = MPI_Alltoallv(records_out, recv_counts, recv_offsets, MPI_BYTE,
+                           records_in, send_counts, send_offsets, MPI_BYTE,
+                           MPI_COMM_WORLD)) != MPI_SUCCESS)
+    mpi_error(err, "Failed to exchange the one-sided records.");
+  for (int k = 0; k < 4 * nr_nodes; k++)
+    counts[k] /= sizeof(struct mpi_rma_record);
+
+  /* Match the records with our send tasks, which are sorted the same way
+   * within each rank. */
+  int *slots_out = (int *)malloc(sizeof(int) * (nr_send + 1));
+  int *slots_in = (int *)malloc(sizeof(int) * (nr_recv + 1));
+  if (slots_out == NULL || slots_in == NULL)
+    error("Failed to allocate the one-sided flags.");
+  for (int k = 0; k < nr_send; k++) {
+    const struct mpi_rma_record *rec = &records_in[k];
+    struct task *t = sends[k];
+    if (t->subtype != rec->subtype || t->flags != rec->tag)
+      error("No send task matches the one-sided record (%s, tag=%lld).",
+            subtaskID_names[rec->subtype], rec->tag);
+    t->mpi_rma = r;
+    t->mpi_encoded = 0;
+    if (scheduler_task_comm_size(t) != rec->size)
+      error("Size mismatch in one-sided exchange (%s, tag=%lld).",
+            subtaskID_names[rec->subtype], rec->tag);
+    t->mpi_rma_slot = nr_recv + k;
+    t->mpi_rma_remote_slot = rec->slot;
+    t->mpi_rma_offset = rec->offset;
+    slots_out[k] = t->mpi_rma_slot;
+  }
+
+  /* And tell the recv tasks which flags to raise when they are ready. */
+  if ((err = MPI_Alltoallv(slots_out, send_counts, send_offsets, MPI_INT,
+                           slots_in, recv_counts, recv_offsets, MPI_INT,
+                           MPI_COMM_WORLD)) != MPI_SUCCESS)
+    mpi_error(err, "Failed to exchange the one-sided flags.");
+  for (int k = 0; k < nr_recv; k++) recvs[k]->mpi_rma_remote_slot = slots_in[k];
+
+  free(slots_in);
+  free(slots_out);
+  free(records_in);
+  free(records_out);
+  free(counts);
+  free(tasks);
+}
+
+/**
+ * @brief Let the send #task on the other rank know that a recv #task is
+ * ready for its data.
+ *
+ * @param t The recv #task.
+ */
+void scheduler_mpi_rma_ready(struct task *t) {
+  scheduler_mpi_rma_notify(t->mpi_rma, t->ci->nodeID, t->mpi_rma_remote_slot);
+  mpiuse_log_allocation(t->type, t->subtype, &t->req, 1,
+                        scheduler_task_comm_size(t), t->ci->nodeID, t->flags);
+}
+
+/**
+ * @brief Check whether a send or recv #task using the one-sided windows can
+ * run.
+ *
+ * A send task puts its data in the foreign buffer of the other rank once
+ * the recv task is ready for it, then raises the flag of the recv task. A
+ * recv task is done once its flag is raised.
+ *
+ * @param t The send or recv #task.
+ *
+ * @return 1 if the task can run, 0 otherwise.
+ */
+int scheduler_mpi_rma_test(struct task *t) {
+
+  struct mpi_rma *r = t->mpi_rma;
+  const MPI_Win win = scheduler_mpi_rma_win(t);
+  int err = MPI_SUCCESS;
+
+  if (!scheduler_mpi_rma_fetch(r, t->mpi_rma_slot)) return 0;
+
+  if (t->type == task_type_recv) {
+
+    /* Make the data put by the other rank visible to us. */
+    if ((err = MPI_Win_sync(win)) != MPI_SUCCESS)
+      mpi_error(err, "Failed to synchronise a one-sided window.");
+
+  } else {
+
+    const int rank = t->cj->nodeID;
+    const size_t size = scheduler_task_comm_size(t);
+    if ((err = MPI_Put(t->buff, (int)size, MPI_BYTE, rank,
+                       (MPI_Aint)t->mpi_rma_offset, (int)size, MPI_BYTE,
+                       win)) != MPI_SUCCESS)
+      mpi_error(err, "Failed to put particle data.");
+    if ((err = MPI_Win_flush(rank, win)) != MPI_SUCCESS)
+      mpi_error(err, "Failed to flush particle data.");
+    scheduler_mpi_rma_notify(r, rank, t->mpi_rma_remote_slot);
+  }
+
+  mpiuse_log_allocation(t->type, t->subtype, &t->req, 0, 0, 0, 0);
+  return 1;
+}
+
+/**
+ * @brief Hand a send or recv #task with a posted request over to the MPI
+ * progress thread.
+ *
+ * @param s The #scheduler.
+ * @param t The #task.
+ * @param qid The queue the task goes to once its request has completed.
+ */
+static void scheduler_mpi_progress_add(struct scheduler *s, struct task *t,
+                                       int qid) {
+
+  struct mpi_progress *p = &s->mpi_progress;
+
+  pthread_mutex_lock(&p->mutex);
+  if (p->nr_incoming == p->size_incoming) {
+    p->size_incoming = p->size_incoming > 0 ? 2 * p->size_incoming : 256;
+    if ((p->incoming = (struct mpi_progress_entry *)realloc(
+             p->incoming,
+             p->size_incoming * sizeof(struct mpi_progress_entry))) == NULL)
+      error("Failed to grow the MPI progress thread's incoming tasks.");
+  }
+  p->incoming[p->nr_incoming].t = t;
+  p->incoming[p->nr_incoming].qid = qid;
+  p->nr_incoming += 1;
+  pthread_cond_signal(&p->cond);
+  pthread_mutex_unlock(&p->mutex);
+}
+
+/**
+ * @brief Main loop of the MPI progress thread.
+ *
+ * The thread tests all the outstanding requests in one MPI_Testsome() call
+ * and puts the tasks whose data has landed on their queue, such that the
+ * runners only ever get send and recv tasks that are ready to run. We poll
+ * rather than block in MPI_Waitsome() as new requests can be handed over by
+ * the scheduler at any time, but back off between unsuccessful tests by
+ * waiting on the hand-over condition so as not to take a core from the
+ * runners.
+ *
+ * @param data The #scheduler.
+ */
+static void *scheduler_mpi_progress_main(void *data) {
+
+  struct scheduler *s = (struct scheduler *)data;
+  struct mpi_progress *p = &s->mpi_progress;
+
+  /* Back-off between unsuccessful tests, in nanoseconds. */
+  const long backoff_min = 1000, backoff_max = 200000;
+  long backoff = backoff_min;
+
+  while (1) {
+
+    /* Pick up the new tasks, sleeping if there is nothing to follow. */
+    if (p->nr_incoming > 0 || p->count == 0) {
+      pthread_mutex_lock(&p->mutex);
+      while (p->nr_incoming == 0 && p->count == 0 && !p->stop)
+        pthread_cond_wait(&p->cond, &p->mutex);
+      if (p->stop) {
+        pthread_mutex_unlock(&p->mutex);
+        break;
+      }
+
+      if (p->count + p->nr_incoming > p->size) {
+        p->size = 2 * (p->count + p->nr_incoming);
+        if ((p->entries = (struct mpi_progress_entry *)realloc(
+                 p->entries, p->size * sizeof(struct mpi_progress_entry))) ==
+                NULL ||
+            (p->reqs = (MPI_Request *)realloc(
+                 p->reqs, p->size * sizeof(MPI_Request))) == NULL ||
+            (p->indices = (int *)realloc(p->indices, p->size * sizeof(int))) ==
+                NULL)
+          error("Failed to grow the MPI progress thread's requests.");
+      }
+
+      /* Tasks without a request have nothing to wait for, queue them
+       * straight away. */
+      int nr_queued = 0;
+      for (int k = 0; k < p->nr_incoming; k++) {
+        struct mpi_progress_entry *e = &p->incoming[k];
+        if (e->t->req == MPI_REQUEST_NULL) {
+          queue_insert(&s->queues[e->qid], e->t);
+          nr_queued += 1;
+          continue;
+        }
+        p->entries[p->count] = *e;
+        p->reqs[p->count] = e->t->req;
+        p->count += 1;
+      }
+      p->nr_incoming = 0;
+      pthread_mutex_unlock(&p->mutex);
+      backoff = backoff_min;
+
+      if (nr_queued > 0) {
+        pthread_mutex_lock(&s->sleep_mutex);
+        pthread_cond_broadcast(&s->sleep_cond);
+        pthread_mutex_unlock(&s->sleep_mutex);
+      }
+      if (p->count == 0) continue;
+    }
+
+    /* Test all the requests in one go. */
+    int nr_done = 0;
+    const int err = MPI_Testsome(p->count, p->reqs, &nr_done, p->indices,
+                                 MPI_STATUSES_IGNORE);
+    if (err != MPI_SUCCESS) mpi_error(err, "Failed to test MPI requests.");
+
+    /* Nothing yet, wait a bit unless new tasks are handed over. */
+    if (nr_done == MPI_UNDEFINED || nr_done == 0) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_nsec += backoff;
+      if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+      }
+      pthread_mutex_lock(&p->mutex);
+      if (p->nr_incoming == 0 && !p->stop)
+        pthread_cond_timedwait(&p->cond, &p->mutex, &deadline);
+      const int stop = p->stop;
+      pthread_mutex_unlock(&p->mutex);
+      if (stop) break;
+      backoff = min(2 * backoff, backoff_max);
+      continue;
+    }
+    backoff = backoff_min;
+
+    /* Queue the tasks whose request has completed. */
+    const ticks now = getticks();
+    for (int k = 0; k < nr_done; k++) {
+      struct mpi_progress_entry *e = &p->entries[p->indices[k]];
+      mpiuse_log_allocation(e->t->type, e->t->subtype, &e->t->req, 0, 0, 0,
+                            0);
+      e->t->mpi_arrived = now;
+      queue_insert(&s->queues[e->qid], e->t);
+    }
+
+    /* Wake up the runners waiting for work. */
+    pthread_mutex_lock(&s->sleep_mutex);
+    pthread_cond_broadcast(&s->sleep_cond);
+    pthread_mutex_unlock(&s->sleep_mutex);
+
+    /* Drop the completed requests, MPI has set them to MPI_REQUEST_NULL. */
+    int count = 0;
+    for (int k = 0; k < p->count; k++) {
+      if (p->reqs[k] == MPI_REQUEST_NULL) continue;
+      p->entries[count] = p->entries[k];
+      p->reqs[count] = p->reqs[k];
+      count += 1;
+    }
+    p->count = count;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Start the thread following the MPI requests of the send and recv
+ * tasks.
+ *
+ * @param s The #scheduler.
+ */
+void scheduler_mpi_progress_start(struct scheduler *s) {
+
+  struct mpi_progress *p = &s->mpi_progress;
+  bzero(p, sizeof(struct mpi_progress));
+
+  if (pthread_mutex_init(&p->mutex, NULL) != 0 ||
+      pthread_cond_init(&p->cond, NULL) != 0)
+    error("Failed to initialize the MPI progress thread's locks.");
+  if (pthread_create(&p->thread, NULL, &scheduler_mpi_progress_main, s) != 0)
+    error("Failed to create the MPI progress thread.");
+
+  s->mpi_progress_thread = 1;
+}
+
+/**
+ * @brief Stop the thread following the MPI requests and free its memory.
+ *
+ * @param s The #scheduler.
+ */
+void scheduler_mpi_progress_stop(struct scheduler *s) {
+
+  struct mpi_progress *p = &s->mpi_progress;
+
+  pthread_mutex_lock(&p->mutex);
+  p->stop = 1;
+  pthread_cond_signal(&p->cond);
+  pthread_mutex_unlock(&p->mutex);
+  if (pthread_join(p->thread, NULL) != 0)
+    error("Failed to join the MPI progress thread.");
+
+  pthread_mutex_destroy(&p->mutex);
+  pthread_cond_destroy(&p->cond);
+  free(p->incoming);
+  free(p->entries);
+  free(p->reqs);
+  free(p->indices);
+  s->mpi_progress_thread = 0;
+}
+#endif
+
+/**
+ * @brief Start the scheduler, i.e. fill the queues with ready tasks.
+ *
+ * @param s The #scheduler.
+ */
+void scheduler_start(struct scheduler *s) {
+
+  /* Re-wait the tasks. */
+  if (s->active_count > 1000) {
+    threadpool_map(s->threadpool, scheduler_rewait_mapper, s->tid_active,
+                   s->active_count, sizeof(int), threadpool_auto_chunk_size, s);
+  } else {
+    scheduler_rewait_mapper(s->tid_active, s->active_count, s);
+  }
+
+#ifdef WITH_MPI
+  /* Coalesce the halo exchanges with each rank. */
+  if (s->mpi_aggregate) scheduler_mpi_aggregate_prepare(s);
+#endif
+
+  /* Loop over the tasks and enqueue whoever is ready. */
+  if (s->active_count > 1000) {
+    threadpool_map(s->threadpool, scheduler_enqueue_mapper, s->tid_active,
+                   s->active_count, sizeof(int), threadpool_auto_chunk_size, s);
+  } else {
+    scheduler_enqueue_mapper(s->tid_active, s->active_count, s);
   }
 
   /* Clear the list of active tasks. */
@@ -2437,6 +3374,24 @@ void scheduler_start(struct scheduler *s) {
   pthread_mutex_unlock(&s->sleep_mutex);
 }
 
+/**
+ * @brief Get the NUMA node (local index) that is home to a #cell.
+ *
+ * @param s The #scheduler.
+ * @param c The #cell, can be NULL.
+ *
+ * @return The node or -1 if the scheduler is not NUMA-aware or the cell has
+ * no home.
+ */
+static int scheduler_numa_node_of_cell(const struct scheduler *s,
+                                       const struct cell *c) {
+
+  if (s->cell_numa_node == NULL || c == NULL) return -1;
+  const ptrdiff_t cid = c->top - s->space->cells_top;
+  if (cid < 0 || cid >= s->size_cell_numa_node) return -1;
+  return s->cell_numa_node[cid];
+}
+
 /**
  * @brief Put a task on one of the queues.
  *
@@ -2517,7 +3472,8 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
         owner = &t->ci->super->owner;
         if ((qid < 0) ||
             ((t->cj->super->owner > -1) &&
-             (s->queues[qid].count > s->queues[t->cj->super->owner].count))) {
+             (queue_count(&s->queues[qid]) >
+              queue_count(&s->queues[t->cj->super->owner])))) {
           qid = t->cj->super->owner;
           owner = &t->cj->super->owner;
         }
@@ -2546,6 +3502,21 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
               sizeof(struct black_holes_bpart_data) * t->ci->black_holes.count;
           buff = t->buff = malloc(count);
 
+#ifdef hydro_mpi_rho_fields
+        } else if (t->subtype == task_subtype_rho) {
+
+          count = size = t->ci->hydro.count * sizeof(struct part_rho_payload);
+          buff = t->buff = malloc(count);
+
+#endif
+#ifdef hydro_mpi_gradient_fields
+        } else if (t->subtype == task_subtype_gradient) {
+
+          count = size =
+              t->ci->hydro.count * sizeof(struct part_gradient_payload);
+          buff = t->buff = malloc(count);
+
+#endif
         } else if (t->subtype == task_subtype_xv ||
                    t->subtype == task_subtype_rho ||
                    t->subtype == task_subtype_gradient ||
@@ -2567,6 +3538,12 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
           t->buff = buff;
           task_get_unique_dependent(t)->buff = buff;
 
+        } else if (t->subtype == task_subtype_gpart && t->mpi_encoded) {
+
+          count = size =
+              t->ci->grav.count * sizeof(struct gpart_foreign_payload);
+          buff = t->buff = malloc(count);
+
         } else if (t->subtype == task_subtype_gpart) {
 
           count = t->ci->grav.count;
@@ -2599,16 +3576,30 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
           error("Unknown communication sub-type");
         }
 
-        err = MPI_Irecv(buff, count, type, t->ci->nodeID, t->flags,
-                        subtaskMPI_comms[t->subtype], &t->req);
+        if (t->mpi_rma != NULL) {
 
-        if (err != MPI_SUCCESS) {
-          mpi_error(err, "Failed to emit irecv for particle data.");
-        }
+          /* The data is put straight into the cell by the other rank. */
+          scheduler_mpi_rma_ready(t);
+
+        } else if (t->mpi_aggregate != NULL) {
+
+          /* The data comes with the coalesced message, we only need to
+           * remember where it goes. */
+          t->buff = buff;
+
+        } else {
 
-        /* And log, if logging enabled. */
-        mpiuse_log_allocation(t->type, t->subtype, &t->req, 1, size,
-                              t->ci->nodeID, t->flags);
+          err = MPI_Irecv(buff, count, type, t->ci->nodeID, t->flags,
+                          subtaskMPI_comms[t->subtype], &t->req);
+
+          if (err != MPI_SUCCESS) {
+            mpi_error(err, "Failed to emit irecv for particle data.");
+          }
+
+          /* And log, if logging enabled. */
+          mpiuse_log_allocation(t->type, t->subtype, &t->req, 1, size,
+                                t->ci->nodeID, t->flags);
+        }
 
         qid = 1 % s->nr_queues;
       }
@@ -2645,6 +3636,23 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
           cell_pack_bpart_swallow(t->ci,
                                   (struct black_holes_bpart_data *)t->buff);
 
+#ifdef hydro_mpi_rho_fields
+        } else if (t->subtype == task_subtype_rho) {
+
+          size = count = t->ci->hydro.count * sizeof(struct part_rho_payload);
+          buff = t->buff = malloc(size);
+          cell_pack_part_rho(t->ci, (struct part_rho_payload *)buff);
+
+#endif
+#ifdef hydro_mpi_gradient_fields
+        } else if (t->subtype == task_subtype_gradient) {
+
+          size = count =
+              t->ci->hydro.count * sizeof(struct part_gradient_payload);
+          buff = t->buff = malloc(size);
+          cell_pack_part_gradient(t->ci, (struct part_gradient_payload *)buff);
+
+#endif
         } else if (t->subtype == task_subtype_xv ||
                    t->subtype == task_subtype_rho ||
                    t->subtype == task_subtype_gradient ||
@@ -2663,6 +3671,13 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
           type = MPI_BYTE;
           buff = t->buff;
 
+        } else if (t->subtype == task_subtype_gpart && t->mpi_encoded) {
+
+          size = count =
+              t->ci->grav.count * sizeof(struct gpart_foreign_payload);
+          buff = t->buff = malloc(size);
+          cell_pack_gpart_foreign(t->ci, (struct gpart_foreign_payload *)buff);
+
         } else if (t->subtype == task_subtype_gpart) {
 
           count = t->ci->grav.count;
@@ -2696,21 +3711,36 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
           error("Unknown communication sub-type");
         }
 
-        if (size > s->mpi_message_limit) {
-          err = MPI_Isend(buff, count, type, t->cj->nodeID, t->flags,
-                          subtaskMPI_comms[t->subtype], &t->req);
+        if (t->mpi_rma != NULL) {
+
+          /* The data is put once the other rank is ready for it. */
+          t->buff = buff;
+          mpiuse_log_allocation(t->type, t->subtype, &t->req, 1, size,
+                                t->cj->nodeID, t->flags);
+
+        } else if (t->mpi_aggregate != NULL) {
+
+          /* Add the data to the coalesced message. */
+          scheduler_mpi_aggregate_pack(t, buff, size);
+
         } else {
-          err = MPI_Issend(buff, count, type, t->cj->nodeID, t->flags,
-                           subtaskMPI_comms[t->subtype], &t->req);
-        }
 
-        if (err != MPI_SUCCESS) {
-          mpi_error(err, "Failed to emit isend for particle data.");
-        }
+          if (size > s->mpi_message_limit) {
+            err = MPI_Isend(buff, count, type, t->cj->nodeID, t->flags,
+                            subtaskMPI_comms[t->subtype], &t->req);
+          } else {
+            err = MPI_Issend(buff, count, type, t->cj->nodeID, t->flags,
+                             subtaskMPI_comms[t->subtype], &t->req);
+          }
 
-        /* And log, if logging enabled. */
-        mpiuse_log_allocation(t->type, t->subtype, &t->req, 1, size,
-                              t->cj->nodeID, t->flags);
+          if (err != MPI_SUCCESS) {
+            mpi_error(err, "Failed to emit isend for particle data.");
+          }
+
+          /* And log, if logging enabled. */
+          mpiuse_log_allocation(t->type, t->subtype, &t->req, 1, size,
+                                t->cj->nodeID, t->flags);
+        }
 
         qid = 0;
       }
@@ -2724,8 +3754,18 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
 
     if (qid >= s->nr_queues) error("Bad computed qid.");
 
-    /* If no qid, pick a random queue. */
-    if (qid < 0) qid = rand() % s->nr_queues;
+    /* If no qid, pick a random queue, on the NUMA node of the cell if we
+     * know it. */
+    if (qid < 0) {
+      const int node = scheduler_numa_node_of_cell(s, t->ci);
+      if (node >= 0) {
+        const int offset = s->numa_queues_offset[node];
+        const int count = s->numa_queues_offset[node + 1] - offset;
+        qid = s->numa_queues[offset + rand() % count];
+      } else {
+        qid = rand() % s->nr_queues;
+      }
+    }
 
     /* Save qid as owner for next time a task accesses this cell. */
     if (owner != NULL) *owner = qid;
@@ -2733,6 +3773,20 @@ void scheduler_enqueue(struct scheduler *s, struct task *t) {
     /* Increase the waiting counter. */
     atomic_inc(&s->waiting);
 
+#ifdef WITH_MPI
+    /* Let the MPI progress thread queue the communications once their
+     * request has completed. Those without a request (e.g. empty messages)
+     * have nothing to wait for and go straight to their queue. */
+    if (t->type == task_type_send || t->type == task_type_recv) {
+      t->mpi_arrived = 0;
+      if (s->mpi_progress_thread && t->mpi_aggregate == NULL &&
+          t->mpi_rma == NULL && t->req != MPI_REQUEST_NULL) {
+        scheduler_mpi_progress_add(s, t, qid);
+        return;
+      }
+    }
+#endif
+
     /* Insert the task into that queue. */
     queue_insert(&s->queues[qid], t);
   }
@@ -2907,6 +3961,7 @@ struct task *scheduler_gettask(struct scheduler *s, int qid,
   struct task *res = NULL;
   const int nr_queues = s->nr_queues;
   unsigned int seed = qid;
+  int local_steal_fails = 0;
 
   /* Check qid. */
   if (qid >= nr_queues || qid < 0) error("Bad queue ID.");
@@ -2917,7 +3972,7 @@ struct task *scheduler_gettask(struct scheduler *s, int qid,
     for (int tries = 0; res == NULL && s->waiting && tries < scheduler_maxtries;
          tries++) {
       /* Try to get a task from the suggested queue. */
-      if (s->queues[qid].count > 0 || s->queues[qid].count_incoming > 0) {
+      if (queue_count(&s->queues[qid]) > 0) {
         TIMER_TIC
         res = queue_gettask(&s->queues[qid], prev, 0);
         TIMER_TOC(timer_qget);
@@ -2926,15 +3981,24 @@ struct task *scheduler_gettask(struct scheduler *s, int qid,
 
       /* If unsuccessful, try stealing from the other queues. */
       if (s->flags & scheduler_flag_steal) {
+
+        /* Stay on our own NUMA node until we have failed often enough. */
+        const int node =
+            (s->queue_numa_node != NULL &&
+             local_steal_fails < s->numa_max_local_steal_fails)
+                ? s->queue_numa_node[qid]
+                : -1;
+
         int count = 0, qids[nr_queues];
         for (int k = 0; k < nr_queues; k++)
-          if (s->queues[k].count > 0 || s->queues[k].count_incoming > 0) {
+          if (queue_count(&s->queues[k]) > 0 &&
+              (node < 0 || s->queue_numa_node[k] == node)) {
             qids[count++] = k;
           }
         for (int k = 0; k < scheduler_maxsteal && count > 0; k++) {
           const int ind = rand_r(&seed) % count;
           TIMER_TIC
-          res = queue_gettask(&s->queues[qids[ind]], prev, 0);
+          res = queue_steal(&s->queues[qids[ind]]);
           TIMER_TOC(timer_qsteal);
           if (res != NULL) {
             break;
@@ -2943,6 +4007,7 @@ struct task *scheduler_gettask(struct scheduler *s, int qid,
           }
         }
         if (res != NULL) break;
+        if (node >= 0) local_steal_fails++;
       }
     }
 
@@ -3000,7 +4065,8 @@ void scheduler_init(struct scheduler *s, struct space *space, int nr_tasks,
     error("Failed to allocate queues.");
 
   /* Initialize each queue. */
-  for (int k = 0; k < nr_queues; k++) queue_init(&s->queues[k], NULL);
+  for (int k = 0; k < nr_queues; k++)
+    queue_init(&s->queues[k], NULL, (flags & scheduler_flag_deque));
 
   /* Init the sleep mutex and cond. */
   if (pthread_cond_init(&s->sleep_cond, NULL) != 0 ||
@@ -3017,6 +4083,48 @@ void scheduler_init(struct scheduler *s, struct space *space, int nr_tasks,
   s->nr_unlocks = 0;
   s->size_unlocks = scheduler_init_nr_unlocks;
 
+  /* Not NUMA-aware until told otherwise. */
+  s->queue_numa_node = NULL;
+  s->nr_numa_nodes = 0;
+  s->numa_queues = NULL;
+  s->numa_queues_offset = NULL;
+  s->numa_node_ids = NULL;
+  s->cell_numa_node = NULL;
+  s->size_cell_numa_node = 0;
+  s->numa_max_local_steal_fails = 0;
+
+  /* Communication delays, until the engine sets them up. */
+  s->mpi_latency = 0.f;
+  s->mpi_ticks_per_byte = 0.f;
+
+  /* No coalesced messages until the engine asks for them. */
+  s->mpi_aggregate = 0;
+#ifdef WITH_MPI
+  s->mpi_aggregates = NULL;
+  s->nr_mpi_aggregates = 0;
+  s->size_mpi_aggregates = 0;
+  s->mpi_aggregate_tasks = NULL;
+  s->nr_mpi_aggregate_tasks = 0;
+  s->size_mpi_aggregate_tasks = 0;
+#endif
+
+  /* Full foreign gparts until the engine asks otherwise. */
+  s->mpi_gpart_encode = 0;
+
+  /* No one-sided communications until the engine asks for them. */
+  s->mpi_rma = 0;
+#ifdef WITH_MPI
+  s->mpi_rma_windows.registered = 0;
+  s->mpi_rma_windows.flags = NULL;
+#endif
+
+  /* No MPI progress thread until the engine starts it. */
+  s->mpi_progress_thread = 0;
+
+  /* No cost model until the engine sets it up. */
+  cost_model_init(&s->cost_model, /*enabled=*/0, /*max_samples=*/0,
+                  /*decay=*/1.f);
+
   /* Set the scheduler variables. */
   s->nr_queues = nr_queues;
   s->flags = flags;
@@ -3070,6 +4178,198 @@ void scheduler_clean(struct scheduler *s) {
   swift_free("unlock_ind", s->unlock_ind);
   for (int i = 0; i < s->nr_queues; ++i) queue_clean(&s->queues[i]);
   swift_free("queues", s->queues);
+#ifdef WITH_MPI
+  if (s->mpi_progress_thread) scheduler_mpi_progress_stop(s);
+  scheduler_mpi_rma_free(s);
+  s->nr_mpi_aggregate_tasks = 0;
+  scheduler_mpi_aggregate_free(s);
+  free(s->mpi_aggregates);
+  free(s->mpi_aggregate_tasks);
+#endif
+  if (s->queue_numa_node != NULL) {
+    free(s->queue_numa_node);
+    free(s->numa_queues);
+    free(s->numa_queues_offset);
+    free(s->numa_node_ids);
+    free(s->cell_numa_node);
+  }
+}
+
+/**
+ * @brief Make the #scheduler NUMA-aware.
+ *
+ * Queues are grouped by the NUMA node of the runners that own them. Runners
+ * then steal from queues on their own node first and top-level cells are
+ * given a home node, see scheduler_numa_bind_cells().
+ *
+ * @param s The #scheduler.
+ * @param queue_numa_node The NUMA node of each queue, -1 if unknown.
+ * @param max_local_steal_fails Number of failed stealing rounds on the local
+ * node before stealing from any queue.
+ * @param verbose Are we talkative?
+ */
+void scheduler_numa_init(struct scheduler *s, const int *queue_numa_node,
+                         int max_local_steal_fails, int verbose) {
+
+  const int nr_queues = s->nr_queues;
+
+  /* Relabel the nodes so that we only count the ones with queues. Queues
+   * without a known node are put together under the label -1. */
+  int *labels = (int *)malloc(nr_queues * sizeof(int));
+  int *nodes = (int *)malloc(nr_queues * sizeof(int));
+  if (labels == NULL || nodes == NULL)
+    error("Failed to allocate NUMA node labels.");
+  int nr_nodes = 0;
+  for (int k = 0; k < nr_queues; k++) {
+    int l;
+    for (l = 0; l < nr_nodes; l++)
+      if (labels[l] == queue_numa_node[k]) break;
+    if (l == nr_nodes) labels[nr_nodes++] = queue_numa_node[k];
+    nodes[k] = l;
+  }
+
+  /* A single node, nothing to be gained. */
+  if (nr_nodes < 2) {
+    if (verbose) message("Only one NUMA node in use, not NUMA-aware.");
+    free(labels);
+    free(nodes);
+    return;
+  }
+
+  /* Group the queues per node. */
+  int *offsets = (int *)calloc(nr_nodes + 1, sizeof(int));
+  int *queues = (int *)malloc(nr_queues * sizeof(int));
+  if (offsets == NULL || queues == NULL)
+    error("Failed to allocate NUMA queue lists.");
+  for (int k = 0; k < nr_queues; k++) offsets[nodes[k] + 1]++;
+  for (int l = 0; l < nr_nodes; l++) offsets[l + 1] += offsets[l];
+  int *counts = (int *)calloc(nr_nodes, sizeof(int));
+  if (counts == NULL) error("Failed to allocate NUMA queue counts.");
+  for (int k = 0; k < nr_queues; k++)
+    queues[offsets[nodes[k]] + counts[nodes[k]]++] = k;
+
+  if (verbose)
+    for (int l = 0; l < nr_nodes; l++)
+      message("NUMA node %d hosts %d queues.", labels[l],
+              offsets[l + 1] - offsets[l]);
+
+  s->queue_numa_node = nodes;
+  s->nr_numa_nodes = nr_nodes;
+  s->numa_queues = queues;
+  s->numa_queues_offset = offsets;
+  s->numa_node_ids = labels;
+  s->numa_max_local_steal_fails = max_local_steal_fails;
+  free(counts);
+}
+
+#if defined(HAVE_LIBNUMA) && defined(_GNU_SOURCE)
+/**
+ * @brief Move the pages fully contained in a memory range to a NUMA node.
+ *
+ * @param ptr The start of the range.
+ * @param size The size of the range in bytes.
+ * @param node The NUMA node.
+ */
+static void scheduler_numa_bind_range(void *ptr, size_t size, int node) {
+
+  static size_t page_size = 0;
+  if (page_size == 0) page_size = sysconf(_SC_PAGESIZE);
+
+  /* Only the pages that are not shared with the neighbouring cells. */
+  const uintptr_t start =
+      ((uintptr_t)ptr + page_size - 1) & ~(uintptr_t)(page_size - 1);
+  const uintptr_t end = ((uintptr_t)ptr + size) & ~(uintptr_t)(page_size - 1);
+  if (end <= start) return;
+
+  struct bitmask *nodemask = numa_allocate_nodemask();
+  numa_bitmask_setbit(nodemask, node);
+
+  /* Preferred rather than bound, we do not want to fail when the node is
+   * full. Failure to move is not fatal either. */
+  mbind((void *)start, end - start, MPOL_PREFERRED, nodemask->maskp,
+        nodemask->size + 1, MPOL_MF_MOVE);
+
+  numa_free_nodemask(nodemask);
+}
+#endif
+
+/**
+ * @brief Give each local top-level cell a home NUMA node and move its
+ * particles there.
+ *
+ * Cells are handed out in contiguous chunks of index, hence of particle
+ * memory, in proportion to the number of queues on each node. Tasks acting on
+ * a cell that has no owner yet are then enqueued on that node. Needs to be
+ * called after each rebuild of the #space.
+ *
+ * @param s The #scheduler.
+ * @param verbose Are we talkative?
+ */
+void scheduler_numa_bind_cells(struct scheduler *s, int verbose) {
+
+  if (s->queue_numa_node == NULL) return;
+
+  const ticks tic = getticks();
+
+  struct space *sp = s->space;
+  const int nr_cells = sp->nr_cells;
+  const int nr_nodes = s->nr_numa_nodes;
+
+  /* (Re-)allocate the map if needed. */
+  if (s->size_cell_numa_node < nr_cells) {
+    free(s->cell_numa_node);
+    if ((s->cell_numa_node = (int *)malloc(nr_cells * sizeof(int))) == NULL)
+      error("Failed to allocate cell NUMA nodes.");
+    s->size_cell_numa_node = nr_cells;
+  }
+  for (int k = 0; k < nr_cells; k++) s->cell_numa_node[k] = -1;
+
+  /* Total amount of work to share. */
+  double total = 0.;
+  for (int k = 0; k < sp->nr_local_cells; k++) {
+    const struct cell *c = &sp->cells_top[sp->local_cells_top[k]];
+    total += c->hydro.count + c->grav.count + 1;
+  }
+
+  double sum = 0.;
+  for (int k = 0; k < sp->nr_local_cells; k++) {
+    const int cid = sp->local_cells_top[k];
+    struct cell *c = &sp->cells_top[cid];
+
+    /* Find the node whose share of the queues covers the middle of this
+     * cell's work. */
+    const double w = c->hydro.count + c->grav.count + 1;
+    const double frac = (sum + 0.5 * w) / total;
+    sum += w;
+    int node = 0;
+    while (node < nr_nodes - 1 &&
+           s->numa_queues_offset[node + 1] < frac * s->nr_queues)
+      node++;
+    s->cell_numa_node[cid] = node;
+
+#if defined(HAVE_LIBNUMA) && defined(_GNU_SOURCE)
+    /* Move the particles, unless the node is unknown. */
+    const int numa_node = s->numa_node_ids[node];
+    if (numa_node >= 0) {
+      if (c->hydro.count > 0) {
+        scheduler_numa_bind_range(c->hydro.parts,
+                                  c->hydro.count * sizeof(struct part),
+                                  numa_node);
+        scheduler_numa_bind_range(c->hydro.xparts,
+                                  c->hydro.count * sizeof(struct xpart),
+                                  numa_node);
+      }
+      if (c->grav.count > 0)
+        scheduler_numa_bind_range(c->grav.parts,
+                                  c->grav.count * sizeof(struct gpart),
+                                  numa_node);
+    }
+#endif
+  }
+
+  if (verbose)
+    message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
+            clocks_getunit());
 }
 
 /**
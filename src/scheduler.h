@@ -33,6 +33,7 @@
 
 /* Includes. */
 #include "cell.h"
+#include "cost_model.h"
 #include "inline.h"
 #include "lock.h"
 #include "queue.h"
@@ -53,11 +54,115 @@
 /* Flags . */
 #define scheduler_flag_none 0
 #define scheduler_flag_steal (1 << 1)
+#define scheduler_flag_deque (1 << 2)
+
+/* Tag of the coalesced messages, beyond the range of the cell tags. */
+#define scheduler_mpi_aggregate_tag (cell_max_tag + 1)
 
 #ifdef SWIFT_DEBUG_CHECKS
 extern int activate_by_unskip;
 #endif
 
+#ifdef WITH_MPI
+/**
+ * @brief The data of the send or recv tasks of a given subtype to or from a
+ * given rank, coalesced into a single MPI message.
+ */
+struct mpi_aggregate {
+
+  /*! Type (send or recv) and subtype of the tasks. */
+  enum task_types type;
+  enum task_subtypes subtype;
+
+  /*! Rank on the other side of the communication. */
+  int otherrank;
+
+  /*! Number of tasks and total size, in bytes, of their data. */
+  int count;
+  size_t size;
+
+  /*! Number of send tasks whose data is not in the buffer yet. */
+  volatile int pending;
+
+  /*! Has the recv completed? */
+  volatile int done;
+
+  /*! The data of all the tasks, ordered by tag. */
+  char *buffer;
+
+  /*! MPI request of the recv. */
+  MPI_Request req;
+
+  /*! Lock serialising the tests of the recv request. */
+  swift_lock_type lock;
+};
+#endif
+
+#ifdef WITH_MPI
+/**
+ * @brief The MPI-3 windows through which the foreign particles are exchanged
+ * when using one-sided communications.
+ *
+ * Each rank exposes its foreign #part and #gpart buffers and an array of
+ * notification flags, one per send and recv #task using the windows. A recv
+ * task raises the flag of its send task on the other rank when it is ready
+ * for the data, the send task then puts the data straight into the foreign
+ * buffer and raises the flag of the recv task.
+ */
+struct mpi_rma {
+
+  /*! Windows over the foreign #part and #gpart buffers of this rank. */
+  MPI_Win parts_win, gparts_win;
+
+  /*! Window over the notification flags of this rank. */
+  MPI_Win flags_win;
+  int *flags;
+
+  /*! Rank of this node. */
+  int rank;
+
+  /*! Are the windows registered? */
+  int registered;
+};
+
+/**
+ * @brief A send or recv #task followed by the MPI progress thread and the
+ * queue it goes to once its request has completed.
+ */
+struct mpi_progress_entry {
+  struct task *t;
+  int qid;
+};
+
+/**
+ * @brief State of the thread following the outstanding MPI requests of the
+ * send and recv tasks.
+ */
+struct mpi_progress {
+
+  /*! The thread. */
+  pthread_t thread;
+
+  /*! Tasks handed over by the scheduler and not followed yet. */
+  struct mpi_progress_entry *incoming;
+  volatile int nr_incoming;
+  int size_incoming;
+
+  /*! Tasks followed by the thread and their requests. */
+  struct mpi_progress_entry *entries;
+  MPI_Request *reqs;
+  int *indices;
+  int count, size;
+
+  /*! Protects the incoming tasks and lets the thread sleep when idle. */
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+
+  /*! Should the thread stop? */
+  volatile int stop;
+};
+#endif
+
 /* Data of a scheduler. */
 struct scheduler {
   /* Scheduler flags. */
@@ -110,6 +215,36 @@ struct scheduler {
    * MPI. */
   size_t mpi_message_limit;
 
+  /* Coalesce the messages of the halo exchanges to and from each rank? */
+  int mpi_aggregate;
+
+#ifdef WITH_MPI
+  /* The coalesced messages of this step and the tasks they carry. */
+  struct mpi_aggregate *mpi_aggregates;
+  int nr_mpi_aggregates, size_mpi_aggregates;
+  struct task **mpi_aggregate_tasks;
+  int nr_mpi_aggregate_tasks, size_mpi_aggregate_tasks;
+#endif
+
+  /* Send the foreign gparts in a compact encoding? */
+  int mpi_gpart_encode;
+
+  /* Exchange the foreign particles with one-sided communications? */
+  int mpi_rma;
+
+#ifdef WITH_MPI
+  /* The windows of the one-sided communications. */
+  struct mpi_rma mpi_rma_windows;
+#endif
+
+  /* Follow the MPI requests with a dedicated thread? */
+  int mpi_progress_thread;
+
+#ifdef WITH_MPI
+  /* The MPI progress thread. */
+  struct mpi_progress mpi_progress;
+#endif
+
   /* Total ticks spent running the tasks */
   ticks total_ticks;
 
@@ -121,6 +256,33 @@ struct scheduler {
     ticks active_ticks;
   } deadtime;
 
+  /* NUMA node (local index) of each queue, NULL if the scheduler is not
+   * NUMA-aware. */
+  int *queue_numa_node;
+
+  /* Number of NUMA nodes hosting queues, their system IDs and the queues on
+   * each of them, grouped per node with the given offsets. */
+  int nr_numa_nodes;
+  int *numa_node_ids;
+  int *numa_queues;
+  int *numa_queues_offset;
+
+  /* NUMA node (local index) of each top-level cell. */
+  int *cell_numa_node;
+  int size_cell_numa_node;
+
+  /* Number of failed stealing rounds on the local NUMA node before we steal
+   * from queues on any node. */
+  int numa_max_local_steal_fails;
+
+  /* Task costs learned from the measured run times. */
+  struct cost_model cost_model;
+
+  /* Estimated latency, in ticks, and inverse bandwidth, in ticks per byte, of
+   * the MPI communications. */
+  float mpi_latency;
+  float mpi_ticks_per_byte;
+
   /* Frequency of the dependency graph dumping. */
   int frequency_dependency;
 
@@ -299,10 +461,30 @@ void scheduler_init(struct scheduler *s, struct space *space, int nr_tasks,
 struct task *scheduler_gettask(struct scheduler *s, int qid,
                                const struct task *prev);
 void scheduler_enqueue(struct scheduler *s, struct task *t);
+void scheduler_numa_init(struct scheduler *s, const int *queue_numa_node,
+                         int max_local_steal_fails, int verbose);
+void scheduler_numa_bind_cells(struct scheduler *s, int verbose);
 void scheduler_start(struct scheduler *s);
+#ifdef WITH_MPI
+void scheduler_mpi_aggregate_prepare(struct scheduler *s);
+void scheduler_mpi_aggregate_pack(struct task *t, const void *buff,
+                                  size_t size);
+int scheduler_mpi_aggregate_test(struct task *t);
+void scheduler_mpi_aggregate_unpack(struct task *t);
+void scheduler_mpi_aggregate_free(struct scheduler *s);
+void scheduler_mpi_rma_register(struct scheduler *s);
+void scheduler_mpi_rma_free(struct scheduler *s);
+void scheduler_mpi_rma_ready(struct task *t);
+int scheduler_mpi_rma_test(struct task *t);
+void scheduler_mpi_progress_start(struct scheduler *s);
+void scheduler_mpi_progress_stop(struct scheduler *s);
+#endif
 void scheduler_reset(struct scheduler *s, int nr_tasks);
 void scheduler_ranktasks(struct scheduler *s);
 void scheduler_reweight(struct scheduler *s, int verbose);
+float scheduler_task_cost_estimate(const struct task *t, const int nodeID);
+void scheduler_sample_task_costs(struct scheduler *s, const ticks tic_start,
+                                 const int step);
 struct task *scheduler_addtask(struct scheduler *s, enum task_types type,
                                enum task_subtypes subtype, long long flags,
                                int implicit, struct cell *ci, struct cell *cj);
@@ -88,6 +88,9 @@ int space_extra_gparts = space_extra_gparts_default;
 /*! Number of extra #sink we allocate memory for per top-level cell */
 int space_extra_sinks = space_extra_sinks_default;
 
+/*! Repair the existing sort arrays of the leaf cells instead of re-sorting */
+int space_incremental_sorts = space_incremental_sorts_default;
+
 /*! Maximum number of particles per ghost */
 int engine_max_parts_per_ghost = engine_max_parts_per_ghost_default;
 int engine_max_sparts_per_ghost = engine_max_sparts_per_ghost_default;
@@ -129,6 +132,9 @@ struct qstack {
 void space_free_foreign_parts(struct space *s, const int clear_cell_pointers) {
 
 #ifdef WITH_MPI
+  /* No one-sided window may outlive the buffers it exposes. */
+  scheduler_mpi_rma_free(&s->e->sched);
+
   if (s->parts_foreign != NULL) {
     swift_free("parts_foreign", s->parts_foreign);
     s->size_parts_foreign = 0;
@@ -1259,6 +1265,8 @@ void space_init(struct space *s, struct swift_params *params,
       params, "Scheduler:cell_extra_bparts", space_extra_bparts_default);
   space_extra_sinks = parser_get_opt_param_int(
       params, "Scheduler:cell_extra_sinks", space_extra_sinks_default);
+  space_incremental_sorts = parser_get_opt_param_int(
+      params, "Scheduler:incremental_sorts", space_incremental_sorts_default);
 
   engine_max_parts_per_ghost =
       parser_get_opt_param_int(params, "Scheduler:engine_max_parts_per_ghost",
@@ -2423,6 +2431,7 @@ void space_clean(struct space *s) {
   swift_free("cells_with_particles_top", s->cells_with_particles_top);
   swift_free("local_cells_with_particles_top",
              s->local_cells_with_particles_top);
+  swift_free("grav_top_offsets", s->grav_top_offsets);
   swift_free("parts", s->parts);
   swift_free("xparts", s->xparts);
   swift_free("gparts", s->gparts);
@@ -2483,6 +2492,8 @@ void space_struct_dump(struct space *s, FILE *stream) {
                        "space_extra_sparts", "space_extra_sparts");
   restart_write_blocks(&space_extra_bparts, sizeof(int), 1, stream,
                        "space_extra_bparts", "space_extra_bparts");
+  restart_write_blocks(&space_incremental_sorts, sizeof(int), 1, stream,
+                       "space_incremental_sorts", "space_incremental_sorts");
   restart_write_blocks(&space_expected_max_nr_strays, sizeof(int), 1, stream,
                        "space_expected_max_nr_strays",
                        "space_expected_max_nr_strays");
@@ -2505,27 +2516,28 @@ void space_struct_dump(struct space *s, FILE *stream) {
                        "engine_foreign_alloc_margin",
                        "engine_foreign_alloc_margin");
 
-  /* More things to write. */
+  /* More things to write. The large arrays are aligned in the file so that
+   * they can be mapped back into memory. */
   if (s->nr_parts > 0) {
-    restart_write_blocks(s->parts, s->nr_parts, sizeof(struct part), stream,
-                         "parts", "parts");
-    restart_write_blocks(s->xparts, s->nr_parts, sizeof(struct xpart), stream,
-                         "xparts", "xparts");
+    restart_write_blocks_aligned(s->parts, s->nr_parts, sizeof(struct part),
+                                 stream, "parts", "parts");
+    restart_write_blocks_aligned(s->xparts, s->nr_parts, sizeof(struct xpart),
+                                 stream, "xparts", "xparts");
   }
   if (s->nr_gparts > 0)
-    restart_write_blocks(s->gparts, s->nr_gparts, sizeof(struct gpart), stream,
-                         "gparts", "gparts");
+    restart_write_blocks_aligned(s->gparts, s->nr_gparts, sizeof(struct gpart),
+                                 stream, "gparts", "gparts");
 
   if (s->nr_sinks > 0)
-    restart_write_blocks(s->sinks, s->nr_sinks, sizeof(struct sink), stream,
-                         "sinks", "sinks");
+    restart_write_blocks_aligned(s->sinks, s->nr_sinks, sizeof(struct sink),
+                                 stream, "sinks", "sinks");
 
   if (s->nr_sparts > 0)
-    restart_write_blocks(s->sparts, s->nr_sparts, sizeof(struct spart), stream,
-                         "sparts", "sparts");
+    restart_write_blocks_aligned(s->sparts, s->nr_sparts, sizeof(struct spart),
+                                 stream, "sparts", "sparts");
   if (s->nr_bparts > 0)
-    restart_write_blocks(s->bparts, s->nr_bparts, sizeof(struct bpart), stream,
-                         "bparts", "bparts");
+    restart_write_blocks_aligned(s->bparts, s->nr_bparts, sizeof(struct bpart),
+                                 stream, "bparts", "bparts");
 }
 
 /**
@@ -2568,6 +2580,8 @@ void space_struct_restore(struct space *s, FILE *stream) {
                       "space_extra_sparts");
   restart_read_blocks(&space_extra_bparts, sizeof(int), 1, stream, NULL,
                       "space_extra_bparts");
+  restart_read_blocks(&space_incremental_sorts, sizeof(int), 1, stream, NULL,
+                      "space_incremental_sorts");
   restart_read_blocks(&space_expected_max_nr_strays, sizeof(int), 1, stream,
                       NULL, "space_expected_max_nr_strays");
   restart_read_blocks(&engine_max_parts_per_ghost, sizeof(int), 1, stream, NULL,
@@ -2592,6 +2606,8 @@ void space_struct_restore(struct space *s, FILE *stream) {
   s->local_cells_with_tasks_top = NULL;
   s->cells_with_particles_top = NULL;
   s->local_cells_with_particles_top = NULL;
+  s->grav_top_offsets = NULL;
+  s->nr_grav_top_offsets = 0;
   s->nr_local_cells_with_tasks = 0;
   s->nr_cells_with_particles = 0;
 #ifdef WITH_MPI
@@ -2609,59 +2625,35 @@ void space_struct_restore(struct space *s, FILE *stream) {
   s->parts = NULL;
   s->xparts = NULL;
   if (s->nr_parts > 0) {
-
-    /* Need the memory for these. */
-    if (swift_memalign("parts", (void **)&s->parts, part_align,
-                       s->size_parts * sizeof(struct part)) != 0)
-      error("Failed to allocate restore part array.");
-
-    if (swift_memalign("xparts", (void **)&s->xparts, xpart_align,
-                       s->size_parts * sizeof(struct xpart)) != 0)
-      error("Failed to allocate restore xpart array.");
-
-    restart_read_blocks(s->parts, s->nr_parts, sizeof(struct part), stream,
-                        NULL, "parts");
-    restart_read_blocks(s->xparts, s->nr_parts, sizeof(struct xpart), stream,
-                        NULL, "xparts");
+    restart_read_blocks_aligned("parts", (void **)&s->parts, part_align,
+                                sizeof(struct part), s->nr_parts,
+                                s->size_parts, stream, "parts");
+    restart_read_blocks_aligned("xparts", (void **)&s->xparts, xpart_align,
+                                sizeof(struct xpart), s->nr_parts,
+                                s->size_parts, stream, "xparts");
   }
   s->gparts = NULL;
-  if (s->nr_gparts > 0) {
-    if (swift_memalign("gparts", (void **)&s->gparts, gpart_align,
-                       s->size_gparts * sizeof(struct gpart)) != 0)
-      error("Failed to allocate restore gpart array.");
-
-    restart_read_blocks(s->gparts, s->nr_gparts, sizeof(struct gpart), stream,
-                        NULL, "gparts");
-  }
+  if (s->nr_gparts > 0)
+    restart_read_blocks_aligned("gparts", (void **)&s->gparts, gpart_align,
+                                sizeof(struct gpart), s->nr_gparts,
+                                s->size_gparts, stream, "gparts");
 
   s->sinks = NULL;
-  if (s->nr_sinks > 0) {
-    if (swift_memalign("sinks", (void **)&s->sinks, sink_align,
-                       s->size_sinks * sizeof(struct sink)) != 0)
-      error("Failed to allocate restore sink array.");
-
-    restart_read_blocks(s->sinks, s->nr_sinks, sizeof(struct sink), stream,
-                        NULL, "sinks");
-  }
+  if (s->nr_sinks > 0)
+    restart_read_blocks_aligned("sinks", (void **)&s->sinks, sink_align,
+                                sizeof(struct sink), s->nr_sinks,
+                                s->size_sinks, stream, "sinks");
 
   s->sparts = NULL;
-  if (s->nr_sparts > 0) {
-    if (swift_memalign("sparts", (void **)&s->sparts, spart_align,
-                       s->size_sparts * sizeof(struct spart)) != 0)
-      error("Failed to allocate restore spart array.");
-
-    restart_read_blocks(s->sparts, s->nr_sparts, sizeof(struct spart), stream,
-                        NULL, "sparts");
-  }
+  if (s->nr_sparts > 0)
+    restart_read_blocks_aligned("sparts", (void **)&s->sparts, spart_align,
+                                sizeof(struct spart), s->nr_sparts,
+                                s->size_sparts, stream, "sparts");
   s->bparts = NULL;
-  if (s->nr_bparts > 0) {
-    if (swift_memalign("bparts", (void **)&s->bparts, bpart_align,
-                       s->size_bparts * sizeof(struct bpart)) != 0)
-      error("Failed to allocate restore bpart array.");
-
-    restart_read_blocks(s->bparts, s->nr_bparts, sizeof(struct bpart), stream,
-                        NULL, "bparts");
-  }
+  if (s->nr_bparts > 0)
+    restart_read_blocks_aligned("bparts", (void **)&s->bparts, bpart_align,
+                                sizeof(struct bpart), s->nr_bparts,
+                                s->size_bparts, stream, "bparts");
 
   /* Need to reconnect the gravity parts to their hydro, star and BH particles.
    * Note that we can't use the threadpool here as we have not restored it yet.
@@ -62,6 +62,7 @@ struct hydro_props;
 #define space_subsize_self_grav_default 32000
 #define space_subdepth_diff_grav_default 4
 #define space_max_top_level_cells_default 12
+#define space_incremental_sorts_default 0
 #define space_stretch 1.10f
 #define space_maxreldx 0.1f
 
@@ -84,6 +85,7 @@ extern int space_extra_gparts;
 extern int space_extra_sparts;
 extern int space_extra_bparts;
 extern int space_extra_sinks;
+extern int space_incremental_sorts;
 extern double engine_redistribute_alloc_margin;
 extern double engine_foreign_alloc_margin;
 
@@ -179,6 +181,13 @@ struct space {
   /*! The indices of the top-level cells that have >0 particles (of any kind) */
   int *local_cells_with_particles_top;
 
+  /*! The integer offsets (3 per entry) of the top-level cells that can be
+   * within the range of the truncated long-range gravity forces */
+  int *grav_top_offsets;
+
+  /*! Number of entries in grav_top_offsets */
+  int nr_grav_top_offsets;
+
   /*! The total number of #part in the space. */
   size_t nr_parts;
 
@@ -394,6 +403,8 @@ void space_recycle_list(struct space *s, struct cell *cell_list_begin,
                         struct gravity_tensors *multipole_list_begin,
                         struct gravity_tensors *multipole_list_end);
 void space_regrid(struct space *s, int verbose);
+void space_regrid_gravity_offsets(struct space *s, const double r_cut_max,
+                                  int verbose);
 void space_allocate_extras(struct space *s, int verbose);
 void space_split(struct space *s, int verbose);
 void space_reorder_extras(struct space *s, int verbose);
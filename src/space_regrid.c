@@ -22,6 +22,9 @@
 /* Config parameters. */
 #include <config.h>
 
+/* Some standard headers. */
+#include <stdlib.h>
+
 /* This object's header. */
 #include "space.h"
 
@@ -210,6 +213,13 @@ void space_regrid(struct space *s, int verbose) {
       swift_free("multipoles_top", s->multipoles_top);
     }
 
+    /* The list of top-level cells within gravity range changes with the
+     * cell size. It will be re-created in the next call to
+     * space_regrid_gravity_offsets(). */
+    swift_free("grav_top_offsets", s->grav_top_offsets);
+    s->grav_top_offsets = NULL;
+    s->nr_grav_top_offsets = 0;
+
     /* Also free the task arrays, these will be regenerated and we can use the
      * memory while copying the particle arrays. */
     if (s->e != NULL) scheduler_free_tasks(&s->e->sched);
@@ -399,3 +409,80 @@ void space_regrid(struct space *s, int verbose) {
     message("took %.3f %s.", clocks_from_ticks(getticks() - tic),
             clocks_getunit());
 }
+
+/**
+ * @brief Construct the list of integer offsets between top-level cells that
+ * can be within the range of the truncated long-range gravity forces.
+ *
+ * The top-level grid is uniform, so this list is the same for every cell and
+ * only needs re-computing when the cell size changes, i.e. after
+ * space_regrid() changed the grid. Cells whose minimal distance is beyond
+ * r_cut_max do not need to be looked at by the long-range gravity task.
+ *
+ * Does nothing for non-periodic spaces or if the list already exists.
+ *
+ * @param s The #space.
+ * @param r_cut_max The distance beyond which the truncated forces are 0.
+ * @param verbose Print messages to stdout or not.
+ */
+void space_regrid_gravity_offsets(struct space *s, const double r_cut_max,
+                                  int verbose) {
+
+  if (!s->periodic || s->grav_top_offsets != NULL) return;
+
+  const ticks tic = getticks();
+  const int cdim[3] = {s->cdim[0], s->cdim[1], s->cdim[2]};
+
+  /* Distance criterion, slightly enlarged such that round-off can never
+   * exclude a cell that the exact test in the task would keep. */
+  const double max_distance2 = r_cut_max * r_cut_max * (1. + 1e-6);
+
+  /* Range of offsets along each axis, taking each periodic image only once
+   * (see engine_make_self_gravity_tasks_mapper()) */
+  int delta_m[3], delta_p[3];
+  for (int k = 0; k < 3; ++k) {
+    const int delta = (int)(r_cut_max * s->iwidth[k]) + 2;
+    delta_m[k] = delta;
+    delta_p[k] = delta;
+    if (delta >= cdim[k] / 2) {
+      delta_m[k] = cdim[k] / 2;
+      delta_p[k] = (cdim[k] % 2 == 0) ? cdim[k] / 2 - 1 : cdim[k] / 2;
+    }
+  }
+
+  const int max_offsets = (delta_m[0] + delta_p[0] + 1) *
+                          (delta_m[1] + delta_p[1] + 1) *
+                          (delta_m[2] + delta_p[2] + 1);
+  if (swift_memalign("grav_top_offsets", (void **)&s->grav_top_offsets,
+                     SWIFT_STRUCT_ALIGNMENT, 3 * max_offsets * sizeof(int)) !=
+      0)
+    error("Failed to allocate the list of top-level gravity offsets.");
+
+  int count = 0;
+  for (int i = -delta_m[0]; i <= delta_p[0]; ++i) {
+    for (int j = -delta_m[1]; j <= delta_p[1]; ++j) {
+      for (int k = -delta_m[2]; k <= delta_p[2]; ++k) {
+
+        /* Minimal distance between any pair of particles in the two cells */
+        const double dx = max(abs(i) - 1, 0) * s->width[0];
+        const double dy = max(abs(j) - 1, 0) * s->width[1];
+        const double dz = max(abs(k) - 1, 0) * s->width[2];
+        const double min_radius2 = dx * dx + dy * dy + dz * dz;
+
+        /* Are we beyond the distance where the truncated forces are 0 ?*/
+        if (min_radius2 > max_distance2) continue;
+
+        s->grav_top_offsets[3 * count + 0] = i;
+        s->grav_top_offsets[3 * count + 1] = j;
+        s->grav_top_offsets[3 * count + 2] = k;
+        ++count;
+      }
+    }
+  }
+  s->nr_grav_top_offsets = count;
+
+  if (verbose)
+    message("%d of %d top-level cells within gravity range, took %.3f %s.",
+            count, s->nr_cells, clocks_from_ticks(getticks() - tic),
+            clocks_getunit());
+}
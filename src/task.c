@@ -726,6 +726,15 @@ int task_lock(struct task *t) {
     case task_type_recv:
     case task_type_send:
 #ifdef WITH_MPI
+      /* Coalesced messages are followed by the scheduler. */
+      if (t->mpi_aggregate != NULL) return scheduler_mpi_aggregate_test(t);
+
+      /* So is the data going through the one-sided windows. */
+      if (t->mpi_rma != NULL) return scheduler_mpi_rma_test(t);
+
+      /* The MPI progress thread only queues completed requests. */
+      if (t->mpi_arrived) return 1;
+
       /* Check the status of the MPI request. */
       if ((err = MPI_Test(&t->req, &res, &stat)) != MPI_SUCCESS) {
         char buff[MPI_MAX_ERROR_STRING];
@@ -1318,11 +1327,12 @@ void task_dump_all(struct engine *e, int step) {
         error("Could not open file '%s' for writing.", dumpfile);
 
       /* Add some information to help with the plots and conversion of ticks to
-       * seconds. */
-      fprintf(file_thread, " %03d 0 0 0 0 %lld %lld %lld %lld %lld 0 0 %lld\n",
+       * seconds. Also record the type of task queues in use. */
+      fprintf(file_thread, " %03d 0 0 0 0 %lld %lld %lld %lld %lld 0 %d %lld\n",
               engine_rank, (long long int)e->tic_step,
               (long long int)e->toc_step, e->updates, e->g_updates,
-              e->s_updates, cpufreq);
+              e->s_updates, (e->sched.flags & scheduler_flag_deque) ? 1 : 0,
+              cpufreq);
       for (int l = 0; l < e->sched.nr_tasks; l++) {
         if (!e->sched.tasks[l].implicit &&
             e->sched.tasks[l].tic > e->tic_step) {
@@ -1359,11 +1369,12 @@ void task_dump_all(struct engine *e, int step) {
   if (file_thread == NULL) error("Could not create file '%s'.", dumpfile);
 
   /* Add some information to help with the plots and conversion of ticks to
-   * seconds. */
+   * seconds. Also record the type of task queues in use. */
   fprintf(file_thread, " %d %d %d %d %lld %lld %lld %lld %lld %d %lld\n", -2,
           -1, -1, 1, (unsigned long long)e->tic_step,
           (unsigned long long)e->toc_step, e->updates, e->g_updates,
-          e->s_updates, 0, cpufreq);
+          e->s_updates, (e->sched.flags & scheduler_flag_deque) ? 1 : 0,
+          cpufreq);
   for (int l = 0; l < e->sched.nr_tasks; l++) {
     if (!e->sched.tasks[l].implicit && e->sched.tasks[l].tic > e->tic_step) {
       fprintf(
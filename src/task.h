@@ -227,6 +227,10 @@ extern const char *task_category_names[];
 extern MPI_Comm subtaskMPI_comms[task_subtype_count];
 #endif
 
+/* Forward declaration. */
+struct mpi_aggregate;
+struct mpi_rma;
+
 /**
  * @brief A task to be run by the #scheduler.
  */
@@ -249,6 +253,29 @@ struct task {
   /*! MPI request corresponding to this task */
   MPI_Request req;
 
+  /*! Coalesced message carrying this task's data, NULL if sent on its own */
+  struct mpi_aggregate *mpi_aggregate;
+
+  /*! Offset, in bytes, of this task's data in the coalesced message */
+  size_t mpi_aggregate_offset;
+
+  /*! One-sided windows carrying this task's data, NULL if sent with
+   * two-sided MPI */
+  struct mpi_rma *mpi_rma;
+
+  /*! Offset, in bytes, of this task's data in the window of the receiver */
+  size_t mpi_rma_offset;
+
+  /*! Notification flags of this task and of its partner on the other rank */
+  int mpi_rma_slot, mpi_rma_remote_slot;
+
+  /*! Is this task's data sent in the compact encoding of its subtype? */
+  char mpi_encoded;
+
+  /*! Time at which the MPI progress thread saw the request complete, 0 if
+   * it did not */
+  ticks mpi_arrived;
+
 #endif
 
   /*! Rank of a task in the order */
@@ -74,7 +74,7 @@
 #define vec_ftoi(a) _mm512_cvttps_epi32(a)
 #define vec_fmin(a, b) _mm512_min_ps(a, b)
 #define vec_fmax(a, b) _mm512_max_ps(a, b)
-#define vec_fabs(a) _mm512_andnot_ps(_mm512_set1_ps(-0.f), a)
+#define vec_fabs(a) _mm512_abs_ps(a)
 #define vec_floor(a) _mm512_floor_ps(a)
 #define vec_cmp_gt(a, b) _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ)
 #define vec_cmp_lt(a, b) _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ)
@@ -92,9 +92,14 @@
   ({ mask1 = vec_mask_and(mask1, mask2); })
 #define vec_pad_mask(mask, pad) ({ mask = mask >> (pad); })
 #define vec_blend(mask, a, b) _mm512_mask_blend_ps(mask, a, b)
-#define vec_todbl_lo(a) _mm512_cvtps_pd(_mm512_extract128_ps(a, 0))
-#define vec_todbl_hi(a) _mm512_cvtps_pd(_mm512_extract128_ps(a, 1))
-#define vec_dbl_tofloat(a, b) _mm512_insertf128(_mm512_castps128_ps512(a), b, 1)
+#define vec_todbl_lo(a) _mm512_cvtps_pd(_mm512_castps512_ps256(a))
+#define vec_todbl_hi(a) \
+  _mm512_cvtps_pd(      \
+      _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1)))
+#define vec_dbl_tofloat(a, b)                                          \
+  _mm512_castpd_ps(_mm512_insertf64x4(                                 \
+      _mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(a))), \
+      _mm256_castps_pd(_mm512_cvtpd_ps(b)), 1))
 #define vec_dbl_load(a) _mm512_load_pd(a)
 #define vec_dbl_set1(a) _mm512_set1_pd(a)
 #define vec_dbl_sqrt(a) _mm512_sqrt_pd(a)
@@ -134,23 +139,20 @@
    .f[15] = a}
 
 /* Performs a horizontal add on the vector and adds the result to a float. */
-#ifdef __ICC
 #define VEC_HADD(a, b) b += _mm512_reduce_add_ps(a.v)
-#else /* _mm512_reduce_add_ps not present in GCC compiler. \
-       TODO: Implement intrinsic version.*/
-#define VEC_HADD(a, b)                              \
-  {                                                 \
-    for (int i = 0; i < VEC_SIZE; i++) b += a.f[i]; \
-  }
-#endif
 
-/* Do nothing in the case of AVX-512 as there are already
- * instructions for left-packing.*/
+/* Do nothing in the case of AVX-512 as the mask registers can be used
+ * directly for left-packing.*/
+#define VEC_HAVE_LEFT_PACK
 #define VEC_FORM_PACKED_MASK(mask, packed_mask) packed_mask = mask
 
 /* Finds the horizontal maximum of vector b and returns a float. */
 #define VEC_HMAX(a, b) b = _mm512_reduce_max_ps(a.v)
 
+/* Performs a horizontal minimum on the vector and takes the minimum of the
+ * result with a float, b. */
+#define VEC_HMIN(a, b) b = min(b, _mm512_reduce_min_ps(a.v))
+
 /* Performs a left-pack on a vector based upon a mask and returns the result. */
 #define VEC_LEFT_PACK(a, mask, result) \
   _mm512_mask_compressstoreu_ps(result, mask, a)
@@ -238,6 +240,13 @@
     for (int k = 0; k < VEC_SIZE; k++) b = max(b, a.f[k]); \
   }
 
+/* Performs a horizontal minimum on the vector and takes the minimum of the
+ * result with a float, b. */
+#define VEC_HMIN(a, b)                                     \
+  {                                                        \
+    for (int k = 0; k < VEC_SIZE; k++) b = min(b, a.f[k]); \
+  }
+
 /* Returns the lower 128-bits of the 256-bit vector. */
 #define VEC_GET_LOW(a) _mm256_castps256_ps128(a)
 
@@ -250,6 +259,7 @@
 #define vec_fnma(a, b, c) _mm256_fnmadd_ps(a, b, c)
 
 /* Used in VEC_FORM_PACKED_MASK */
+#define VEC_HAVE_LEFT_PACK
 #define identity_indices 0x0706050403020100
 #define VEC_HAVE_GATHER
 #define vec_gather(base, offsets) _mm256_i32gather_ps(base, offsets.m, 1)
@@ -405,6 +415,13 @@
     for (int k = 0; k < VEC_SIZE; k++) b = max(b, a.f[k]); \
   }
 
+/* Performs a horizontal minimum on the vector and takes the minimum of the
+ * result with a float, b. */
+#define VEC_HMIN(a, b)                                     \
+  {                                                        \
+    for (int k = 0; k < VEC_SIZE; k++) b = min(b, a.f[k]); \
+  }
+
 /* Create an FMA using vec_add and vec_mul if AVX2 is not present. */
 #ifndef vec_fma
 #define vec_fma(a, b, c) vec_add(vec_mul(a, b), c)
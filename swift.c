@@ -976,8 +976,12 @@ int main(int argc, char *argv[]) {
     restart_locate_free(1, restart_files);
 #endif
 
-    /* Now read it. */
-    restart_read(&e, restart_file);
+    /* Now read it, possibly mapping the particles rather than reading them. */
+    const int restart_mmap =
+        parser_get_opt_param_int(params, "Restarts:mmap", 0);
+    const int restart_prefetch =
+        parser_get_opt_param_int(params, "Restarts:mmap_prefetch", 1);
+    restart_read(&e, restart_file, restart_mmap, restart_prefetch);
 
 #ifdef WITH_MPI
     integertime_t min_ti_current = e.ti_current;
@@ -1425,7 +1429,14 @@ int main(int argc, char *argv[]) {
     /* Initialise the long-range gravity mesh */
     if (with_self_gravity && periodic) {
 #ifdef HAVE_FFTW
-      pm_mesh_init(&mesh, &gravity_properties, s.dim, nr_threads);
+      /* The FFTW wisdom is kept with the restart files. */
+      char wisdom_file[PARSER_MAX_LINE_SIZE + 32];
+      if (snprintf(wisdom_file, sizeof(wisdom_file), "%s/%s_fftw_wisdom.dat",
+                   restart_dir, restart_name) >= (int)sizeof(wisdom_file))
+        error("FFTW wisdom file name too long: %s/%s_fftw_wisdom.dat",
+              restart_dir, restart_name);
+      pm_mesh_init(&mesh, &gravity_properties, s.dim, nr_threads,
+                   wisdom_file);
 #else
       /* Need the FFTW library if periodic and self gravity. */
       error(
@@ -1901,6 +1912,13 @@ int main(int argc, char *argv[]) {
 #endif
   }
 
+  /* Make sure restart files written in the background are complete on all
+   * ranks before exiting or resubmitting. */
+  restart_write_wait();
+#ifdef WITH_MPI
+  MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
   /* Remove the stop file if used. Do this anyway, we could have missed the
    * stop file if normal exit happened first. */
   if (myrank == 0) force_stop = restart_stop_now(restart_dir, 1);
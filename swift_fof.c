@@ -592,7 +592,8 @@ int main(int argc, char *argv[]) {
   /* Initialise the long-range gravity mesh */
   if (periodic) {
 #ifdef HAVE_FFTW
-    pm_mesh_init(&mesh, &gravity_properties, s.dim, nr_threads);
+    pm_mesh_init(&mesh, &gravity_properties, s.dim, nr_threads,
+                 /*wisdom_file=*/NULL);
 #else
     /* Need the FFTW library if periodic and self gravity. */
     error("No FFTW library found. Cannot compute periodic long-range forces.");
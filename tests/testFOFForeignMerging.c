@@ -0,0 +1,322 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (C) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include <config.h>
+
+/* Some standard headers. */
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local headers. */
+#include "swift.h"
+
+/*
+ * Check of the merging of the FOF group fragments spanning several ranks.
+ *
+ * Each rank holds a number of fragments, linked at random to fragments on
+ * other ranks. Some of the links are only known to one of the two ranks
+ * holding their ends, as happens when the separation is just under the
+ * linking length. The fragments are merged with the "allgather" and the
+ * "neighbours" strategies and both results are compared to a union-find
+ * over all the links on all the ranks.
+ *
+ * Run with e.g. mpirun -np 3 ./testFOFForeignMerging
+ */
+
+/* Our rank and the number of ranks. */
+static int rank = 0, nr_ranks = 1;
+
+#ifdef WITH_FOF
+
+/* Global index of the first particle of this rank, set by the FOF code. */
+extern size_t node_offset;
+
+/* Number of particles in a fragment. */
+#define fragment_length 4
+
+/**
+ * @brief Number of particles on a given rank.
+ */
+static size_t count_gparts(int r) { return 41 + 8 * r; }
+
+/**
+ * @brief Global index of the first particle of a given rank.
+ */
+static size_t first_gpart(int r) {
+  size_t first = 0;
+  for (int k = 0; k < r; k++) first += count_gparts(k);
+  return first;
+}
+
+/**
+ * @brief Number of particles in the fragment rooted at a given local
+ * particle.
+ */
+static size_t fragment_size(int r, size_t i) {
+  const size_t count = count_gparts(r);
+  return (i + fragment_length <= count) ? fragment_length : count - i;
+}
+
+/**
+ * @brief Same random numbers on all ranks.
+ */
+static unsigned int next_random(unsigned int *seed) {
+  *seed = *seed * 1103515245u + 12345u;
+  return (*seed >> 8) & 0xffffff;
+}
+
+/**
+ * @brief Find the root of a particle in a global union-find.
+ */
+static size_t find_root(size_t i, size_t *parent) {
+  while (parent[i] != i) i = parent[i] = parent[parent[i]];
+  return i;
+}
+
+/**
+ * @brief A link between fragments, and which of the ranks holding its ends
+ * found it.
+ */
+struct test_link {
+  size_t root_a, root_b;
+  int rank_a, rank_b;
+  int found_by_a, found_by_b;
+};
+
+/**
+ * @brief Reset the fragments of this rank and the links this rank found.
+ */
+static void setup(struct fof_props *props, const struct test_link *links,
+                  int nr_links) {
+
+  const size_t nr_gparts = count_gparts(rank);
+  for (size_t i = 0; i < nr_gparts; i++) {
+    const size_t root = i - i % fragment_length;
+    props->group_index[i] = node_offset + root;
+    props->group_size[i] = (i == root) ? fragment_size(rank, i) : 0;
+  }
+
+  props->group_link_count = 0;
+  props->group_links = (struct fof_mpi *)swift_malloc(
+      "fof_group_links", (nr_links + 1) * sizeof(struct fof_mpi));
+  if (props->group_links == NULL) error("Failed to allocate the links.");
+
+  for (int k = 0; k < nr_links; k++) {
+    const struct test_link *l = &links[k];
+    const int mine_a = (l->rank_a == rank && l->found_by_a);
+    const int mine_b = (l->rank_b == rank && l->found_by_b);
+    if (!mine_a && !mine_b) continue;
+
+    struct fof_mpi *link = &props->group_links[props->group_link_count++];
+    link->group_i = mine_a ? l->root_a : l->root_b;
+    link->group_j = mine_a ? l->root_b : l->root_a;
+    link->group_i_size = props->group_size[link->group_i - node_offset];
+    const int rank_j = mine_a ? l->rank_b : l->rank_a;
+    link->group_j_size =
+        fragment_size(rank_j, link->group_j - first_gpart(rank_j));
+  }
+}
+
+/**
+ * @brief Compare the fragments of all the ranks with the expected groups.
+ *
+ * The strategies may pick different roots for a group, so we only check that
+ * all the fragments of a group share the same root, that this root belongs
+ * to the group and that it holds the size of the whole group.
+ */
+static void check(const struct fof_props *props, size_t *parent,
+                  const size_t *expected_size, const char *name) {
+
+  const size_t nr_gparts = count_gparts(rank);
+  const size_t nr_total = first_gpart(nr_ranks);
+
+  /* The sizes, on the rank holding each fragment. */
+  for (size_t i = 0; i < nr_gparts; i += fragment_length) {
+    const size_t root = node_offset + i;
+    const size_t size =
+        (props->group_index[i] == root)
+            ? expected_size[find_root(root, parent)]
+            : 0;
+    if (props->group_size[i] != size)
+      error("%s: fragment %zu has size %zu instead of %zu.", name, root,
+            props->group_size[i], size);
+  }
+
+  /* The new roots of all the fragments, on all the ranks. */
+  size_t *new_root = (size_t *)malloc(nr_total * sizeof(size_t));
+  int *counts = (int *)malloc(nr_ranks * sizeof(int));
+  int *offsets = (int *)malloc(nr_ranks * sizeof(int));
+  if (new_root == NULL || counts == NULL || offsets == NULL)
+    error("Failed to allocate the new roots.");
+  for (int r = 0; r < nr_ranks; r++) {
+    counts[r] = count_gparts(r) * sizeof(size_t);
+    offsets[r] = first_gpart(r) * sizeof(size_t);
+  }
+  MPI_Allgatherv(props->group_index, counts[rank], MPI_BYTE, new_root, counts,
+                 offsets, MPI_BYTE, MPI_COMM_WORLD);
+
+  for (int r = 0; r < nr_ranks; r++) {
+    for (size_t i = 0; i < count_gparts(r); i += fragment_length) {
+      const size_t root = first_gpart(r) + i;
+      const size_t group = find_root(root, parent);
+      if (find_root(new_root[root], parent) != group)
+        error("%s: fragment %zu has root %zu outside of its group.", name,
+              root, new_root[root]);
+      if (new_root[root] != new_root[group])
+        error("%s: fragment %zu has root %zu but fragment %zu has %zu.", name,
+              root, new_root[root], group, new_root[group]);
+    }
+  }
+
+  free(offsets);
+  free(counts);
+  free(new_root);
+}
+
+/**
+ * @brief Merge a random set of links with both strategies and check the
+ * result.
+ */
+static void run_trial(unsigned int seed, int nr_links) {
+
+  /* The same links on all ranks. One in three is only found by the first
+   * rank, one in three only by the second. */
+  struct test_link *links =
+      (struct test_link *)malloc(nr_links * sizeof(struct test_link));
+  if (links == NULL) error("Failed to allocate the links.");
+  for (int k = 0; k < nr_links; k++) {
+    struct test_link *l = &links[k];
+    l->rank_a = next_random(&seed) % nr_ranks;
+    l->rank_b = (l->rank_a + 1 + next_random(&seed) % (nr_ranks - 1)) %
+                nr_ranks;
+    const size_t nr_a = count_gparts(l->rank_a);
+    const size_t nr_b = count_gparts(l->rank_b);
+    l->root_a = first_gpart(l->rank_a) +
+                fragment_length * (next_random(&seed) %
+                                   ((nr_a + fragment_length - 1) /
+                                    fragment_length));
+    l->root_b = first_gpart(l->rank_b) +
+                fragment_length * (next_random(&seed) %
+                                   ((nr_b + fragment_length - 1) /
+                                    fragment_length));
+    const int found = next_random(&seed) % 3;
+    l->found_by_a = (found != 0);
+    l->found_by_b = (found != 1);
+  }
+
+  /* The expected groups: the smallest root of each set of linked fragments
+   * and its total size. */
+  const size_t nr_total = first_gpart(nr_ranks);
+  size_t *parent = (size_t *)malloc(nr_total * sizeof(size_t));
+  size_t *expected_size = (size_t *)calloc(nr_total, sizeof(size_t));
+  if (parent == NULL || expected_size == NULL)
+    error("Failed to allocate the expected groups.");
+  for (size_t i = 0; i < nr_total; i++) parent[i] = i;
+  for (int k = 0; k < nr_links; k++) {
+    const size_t root_a = find_root(links[k].root_a, parent);
+    const size_t root_b = find_root(links[k].root_b, parent);
+    if (root_a < root_b)
+      parent[root_b] = root_a;
+    else if (root_b < root_a)
+      parent[root_a] = root_b;
+  }
+  for (int r = 0; r < nr_ranks; r++)
+    for (size_t i = 0; i < count_gparts(r); i += fragment_length)
+      expected_size[find_root(first_gpart(r) + i, parent)] +=
+          fragment_size(r, i);
+
+  /* Our fragments. */
+  struct engine e;
+  bzero(&e, sizeof(struct engine));
+  e.nodeID = rank;
+  e.nr_nodes = nr_ranks;
+  struct space s;
+  bzero(&s, sizeof(struct space));
+  s.e = &e;
+  s.nr_gparts = count_gparts(rank);
+  node_offset = first_gpart(rank);
+
+  struct fof_props props;
+  bzero(&props, sizeof(struct fof_props));
+  props.group_index = (size_t *)malloc(s.nr_gparts * sizeof(size_t));
+  props.group_size = (size_t *)malloc(s.nr_gparts * sizeof(size_t));
+  if (props.group_index == NULL || props.group_size == NULL)
+    error("Failed to allocate the fragments.");
+
+  /* Merge them with both strategies. */
+  props.foreign_merging = fof_foreign_merging_allgather;
+  setup(&props, links, nr_links);
+  fof_link_foreign_fragments(&props, &s);
+  check(&props, parent, expected_size, "allgather");
+
+  props.foreign_merging = fof_foreign_merging_neighbours;
+  setup(&props, links, nr_links);
+  fof_link_foreign_fragments(&props, &s);
+  check(&props, parent, expected_size, "neighbours");
+
+  free(props.group_index);
+  free(props.group_size);
+  free(expected_size);
+  free(parent);
+  free(links);
+}
+
+#endif /* WITH_FOF */
+
+int main(int argc, char *argv[]) {
+
+  int prov = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &prov);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nr_ranks);
+  engine_rank = rank;
+
+  /* Initialize CPU frequency, this also starts time. */
+  unsigned long long cpufreq = 0;
+  clocks_set_cpufreq(cpufreq);
+
+  if (nr_ranks < 2) {
+    if (rank == 0) message("Needs at least 2 ranks, nothing to do.");
+    MPI_Finalize();
+    return 0;
+  }
+
+#ifdef WITH_FOF
+  fof_create_mpi_types();
+
+  /* Sparse sets of links, where a link found by one side only is often the
+   * only path between two fragments, and denser ones. */
+  const int nr_trials = 8;
+  for (int k = 0; k < nr_trials; k++)
+    run_trial(/*seed=*/1234 + 17 * k, /*nr_links=*/(1 + 4 * k) * nr_ranks);
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  if (rank == 0)
+    message("Merged %d sets of links across %d ranks with both strategies.",
+            nr_trials, nr_ranks);
+#else
+  if (rank == 0) message("FOF not enabled, nothing to do.");
+#endif
+
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,237 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (C) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include <config.h>
+
+/* Some standard headers. */
+#include <fenv.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local headers. */
+#include "runner_doiact_grav.h"
+#include "swift.h"
+
+/*
+ * Check of the periodic long-range gravity task.
+ *
+ * A periodic grid of top-level cells is set up as on one rank of an MPI run:
+ * some cells are local, some are foreign and only hold the multipole they
+ * received from their rank (no particles, grav.count == 0), and some are
+ * empty. The field tensors of a few local cells are computed with
+ * runner_do_grav_long_range() using the list of top-level offsets within the
+ * range of the truncated forces, and compared to the ones obtained by
+ * visiting all the top-level cells with particles.
+ */
+
+/* Number of terms in the field tensors. */
+#define num_field_terms                                                  \
+  ((SELF_GRAVITY_MULTIPOLE_ORDER + 1) * (SELF_GRAVITY_MULTIPOLE_ORDER + 2) * \
+   (SELF_GRAVITY_MULTIPOLE_ORDER + 3) / 6)
+
+/* Number of top-level cells along each axis. */
+#define cdim_test 8
+
+/* Maximal difference between the two paths, relative to the terms. */
+const double tolerance = 1e-5;
+
+/**
+ * @brief Random number in [0, 1[.
+ */
+static double rand_uniform(void) { return rand() / ((double)RAND_MAX + 1.); }
+
+/**
+ * @brief Compute the long-range field tensor of a cell and return a copy.
+ */
+static void long_range(struct runner *r, struct cell *ci,
+                       struct grav_tensor *pot) {
+
+  gravity_field_tensors_init(&ci->grav.multipole->pot, r->e->ti_current);
+  runner_do_grav_long_range(r, ci, /*timer=*/0);
+  memcpy(pot, &ci->grav.multipole->pot, sizeof(struct grav_tensor));
+}
+
+int main(int argc, char *argv[]) {
+
+  /* Initialize CPU frequency, this also starts time. */
+  unsigned long long cpufreq = 0;
+  clocks_set_cpufreq(cpufreq);
+
+/* Choke on FPEs */
+#ifdef HAVE_FE_ENABLE_EXCEPT
+  feenableexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW);
+#endif
+
+  srand(42);
+
+  const int nr_cells = cdim_test * cdim_test * cdim_test;
+  const double width = 1.;
+  const double box_size = cdim_test * width;
+
+  struct engine e;
+  bzero(&e, sizeof(struct engine));
+  e.max_active_bin = num_time_bins;
+  e.ti_current = 8;
+  e.time_base = 1e-10;
+  e.nodeID = 0;
+  e.nr_nodes = 2;
+
+  /* Truncated forces reaching a few cells, such that most of the grid is
+   * beyond their range. */
+  struct pm_mesh mesh;
+  bzero(&mesh, sizeof(struct pm_mesh));
+  mesh.periodic = 1;
+  mesh.dim[0] = mesh.dim[1] = mesh.dim[2] = box_size;
+  mesh.r_s = 0.5;
+  mesh.r_s_inv = 1. / mesh.r_s;
+  mesh.r_cut_max = 4.5 * mesh.r_s;
+  mesh.r_cut_min = 0.1 * mesh.r_s;
+  e.mesh = &mesh;
+
+  struct gravity_props props;
+  bzero(&props, sizeof(struct gravity_props));
+  props.theta_crit = 0.7;
+  props.r_s_inv = mesh.r_s_inv;
+  e.gravity_properties = &props;
+
+  struct space s;
+  bzero(&s, sizeof(struct space));
+  s.periodic = 1;
+  s.e = &e;
+  s.nr_cells = nr_cells;
+  for (int k = 0; k < 3; k++) {
+    s.dim[k] = box_size;
+    s.cdim[k] = cdim_test;
+    s.width[k] = width;
+    s.iwidth[k] = 1. / width;
+  }
+  e.s = &s;
+
+  s.cells_top = (struct cell *)calloc(nr_cells, sizeof(struct cell));
+  s.multipoles_top = (struct gravity_tensors *)calloc(
+      nr_cells, sizeof(struct gravity_tensors));
+  s.cells_with_particles_top = (int *)malloc(nr_cells * sizeof(int));
+  if (s.cells_top == NULL || s.multipoles_top == NULL ||
+      s.cells_with_particles_top == NULL)
+    error("Failed to allocate the top-level cells.");
+
+  /* One cell in seven is empty, half of the others are foreign. */
+  int nr_foreign = 0;
+  for (int i = 0; i < cdim_test; i++) {
+    for (int j = 0; j < cdim_test; j++) {
+      for (int k = 0; k < cdim_test; k++) {
+        const int cid = cell_getid(s.cdim, i, j, k);
+        struct cell *c = &s.cells_top[cid];
+        struct gravity_tensors *m = &s.multipoles_top[cid];
+        c->loc[0] = i * width;
+        c->loc[1] = j * width;
+        c->loc[2] = k * width;
+        c->width[0] = c->width[1] = c->width[2] = width;
+        c->grav.multipole = m;
+        c->grav.ti_end_min = e.ti_current;
+        c->grav.ti_old_multipole = e.ti_current;
+
+        if (cid % 7 == 3) {
+          c->nodeID = 0;
+          continue;
+        }
+
+        const int foreign = (i + 2 * j + k) % 2;
+        c->nodeID = foreign;
+        c->grav.count = foreign ? 0 : 1;
+        nr_foreign += foreign;
+
+        m->m_pole.M_000 = 0.5 + rand_uniform();
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+        m->m_pole.num_gpart = 1 + cid % 5;
+#endif
+        m->m_pole.max_softening = 0.01f;
+        for (int d = 0; d < 3; d++) {
+          m->CoM[d] = c->loc[d] + 0.25 * width + 0.5 * width * rand_uniform();
+          m->CoM_rebuild[d] = m->CoM[d];
+        }
+        m->r_max = m->r_max_rebuild = 0.25 * width;
+      }
+    }
+  }
+
+  /* The cells with particles, as built by space_list_useful_top_level_cells()
+   * (foreign cells are in there through their multipole). */
+  for (int cid = 0; cid < nr_cells; cid++) {
+    const struct cell *c = &s.cells_top[cid];
+    if (c->grav.count > 0 || c->grav.multipole->m_pole.M_000 > 0.f)
+      s.cells_with_particles_top[s.nr_cells_with_particles++] = cid;
+  }
+
+  struct runner r;
+  bzero(&r, sizeof(struct runner));
+  r.e = &e;
+  gravity_m2l_cache_init(&r.m2l_cache, 256);
+
+  /* Some local cells, in the middle of the grid and by its edges. */
+  const int cells_i[4][3] = {{4, 3, 4}, {0, 0, 0}, {7, 1, 7}, {2, 7, 2}};
+  for (int n = 0; n < 4; n++) {
+
+    struct cell *ci = &s.cells_top[cell_getid(s.cdim, cells_i[n][0],
+                                              cells_i[n][1], cells_i[n][2])];
+    if (ci->nodeID != 0 || ci->grav.count == 0)
+      error("Test cell %d is not a local cell with particles.", n);
+
+    /* Only the top-level cells within range. */
+    space_regrid_gravity_offsets(&s, mesh.r_cut_max, /*verbose=*/0);
+    if (s.nr_grav_top_offsets >= nr_cells)
+      error("All the top-level cells are within range.");
+    struct grav_tensor pot_offsets;
+    long_range(&r, ci, &pot_offsets);
+
+    /* All the top-level cells. */
+    swift_free("grav_top_offsets", s.grav_top_offsets);
+    s.grav_top_offsets = NULL;
+    s.nr_grav_top_offsets = 0;
+    struct grav_tensor pot_all;
+    long_range(&r, ci, &pot_all);
+
+    if (!pot_all.interacted || pot_all.F_000 == 0.f)
+      error("Cell %d did not interact with any multipole.", n);
+
+    /* The terms of the field tensors are consecutive floats. */
+    const float *terms_offsets = &pot_offsets.F_000;
+    const float *terms_all = &pot_all.F_000;
+    for (int t = 0; t < num_field_terms; t++) {
+      const double a = terms_offsets[t], b = terms_all[t];
+      if (fabs(a - b) > tolerance * (fabs(a) + fabs(b)) &&
+          fabs(a - b) > tolerance * fabs(pot_all.F_000))
+        error("Cell %d: term %d is %e with the offsets and %e without.", n, t,
+              a, b);
+    }
+  }
+
+  message("Long-range task agrees with and without the offsets, %d foreign "
+          "cells.",
+          nr_foreign);
+
+  gravity_m2l_cache_clean(&r.m2l_cache);
+  free(s.cells_with_particles_top);
+  free(s.multipoles_top);
+  free(s.cells_top);
+  return 0;
+}
@@ -0,0 +1,403 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (C) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include <config.h>
+
+/* Some standard headers. */
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Local headers. */
+#include "swift.h"
+
+/*
+ * Check of the one-sided exchange of the foreign particles.
+ *
+ * Each rank sends a number of cells of #part and #gpart to every other rank
+ * through the send and recv tasks of a #scheduler, with the windows
+ * registered by scheduler_mpi_rma_register() and the data moved by
+ * scheduler_mpi_rma_ready() and scheduler_mpi_rma_test(), as done with
+ * Scheduler:mpi_rma. The windows are then freed and registered again over
+ * re-allocated foreign buffers, as done on every rebuild.
+ *
+ * With -b, the exchanges through the windows are timed and compared to the
+ * same exchanges done with tagged MPI_Isend/MPI_Irecv pairs, as done by
+ * default by the send and recv tasks.
+ *
+ * Run with e.g. mpirun -np 3 ./testHaloExchange -c 16 -n 3
+ * or mpirun -np 4 ./testHaloExchange -b -c 512 -n 20
+ */
+
+/* Our rank and the number of ranks. */
+static int rank = 0, nr_ranks = 1;
+
+/* Number of cells exchanged with each other rank. */
+static int nr_cells = 16;
+
+/**
+ * @brief Number of #part sent by a rank to another in a given cell.
+ *
+ * Every fifth cell is empty.
+ */
+static int count_parts(int from, int to, int c) {
+  return ((from + to + c) % 5 == 0) ? 0 : 1 + (from * 13 + to * 7 + c) % 17;
+}
+
+/**
+ * @brief Number of #gpart sent by a rank to another in a given cell.
+ */
+static int count_gparts(int from, int to, int c) {
+  return ((from + 2 * to + c) % 5 == 0) ? 0 : 1 + (from * 5 + to + c) % 23;
+}
+
+/**
+ * @brief Value identifying a particle sent in a given exchange.
+ */
+static double particle_value(int from, int to, int c, int i, int iter) {
+  return (((double)iter * nr_ranks + from) * nr_ranks + to) * 1e6 + c * 1e3 +
+         i;
+}
+
+/**
+ * @brief Fill the particles of the local cells for a given exchange.
+ */
+static void fill_cells(struct cell *local, int iter) {
+  for (int o = 0; o < nr_ranks; o++) {
+    for (int c = 0; c < nr_cells; c++) {
+      struct cell *ci = &local[o * nr_cells + c];
+      for (int i = 0; i < ci->hydro.count; i++) {
+        ci->hydro.parts[i].x[0] = particle_value(rank, o, c, i, iter);
+        ci->hydro.parts[i].id = iter;
+      }
+      for (int i = 0; i < ci->grav.count; i++) {
+        ci->grav.parts[i].x[0] = -particle_value(rank, o, c, i, iter);
+        ci->grav.parts[i].mass = (float)(c + i);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Check the particles received in the foreign cells in a given
+ * exchange.
+ */
+static void check_cells(const struct cell *foreign, int iter) {
+  for (int o = 0; o < nr_ranks; o++) {
+    for (int c = 0; c < nr_cells; c++) {
+      const struct cell *ci = &foreign[o * nr_cells + c];
+      for (int i = 0; i < ci->hydro.count; i++)
+        if (ci->hydro.parts[i].x[0] != particle_value(o, rank, c, i, iter) ||
+            ci->hydro.parts[i].id != iter)
+          error("Wrong part %d of cell %d from rank %d in exchange %d.", i, c,
+                o, iter);
+      for (int i = 0; i < ci->grav.count; i++)
+        if (ci->grav.parts[i].x[0] != -particle_value(o, rank, c, i, iter) ||
+            ci->grav.parts[i].mass != (float)(c + i))
+          error("Wrong gpart %d of cell %d from rank %d in exchange %d.", i, c,
+                o, iter);
+    }
+  }
+}
+
+/**
+ * @brief (Re-)allocate the foreign buffers and point the foreign cells at
+ * them.
+ *
+ * The buffers are given some extra room at the front, which changes with
+ * every call, such that the offsets of the cells in the windows change too.
+ */
+static void allocate_foreign(struct space *sp, struct cell *foreign,
+                             int shift) {
+
+  free(sp->parts_foreign);
+  free(sp->gparts_foreign);
+
+  size_t nr_parts = shift, nr_gparts = shift;
+  for (int k = 0; k < nr_ranks * nr_cells; k++) {
+    nr_parts += foreign[k].hydro.count;
+    nr_gparts += foreign[k].grav.count;
+  }
+  sp->size_parts_foreign = nr_parts;
+  sp->size_gparts_foreign = nr_gparts;
+  sp->parts_foreign = (struct part *)calloc(nr_parts, sizeof(struct part));
+  sp->gparts_foreign = (struct gpart *)calloc(nr_gparts, sizeof(struct gpart));
+  if (sp->parts_foreign == NULL || sp->gparts_foreign == NULL)
+    error("Failed to allocate the foreign buffers.");
+
+  struct part *parts = &sp->parts_foreign[shift];
+  struct gpart *gparts = &sp->gparts_foreign[shift];
+  for (int o = 0; o < nr_ranks; o++) {
+    for (int c = 0; c < nr_cells; c++) {
+      struct cell *ci = &foreign[o * nr_cells + c];
+      ci->hydro.parts = (ci->hydro.count > 0) ? parts : NULL;
+      ci->grav.parts = (ci->grav.count > 0) ? gparts : NULL;
+      parts += ci->hydro.count;
+      gparts += ci->grav.count;
+    }
+  }
+}
+
+/**
+ * @brief Address of the particles a send or recv task moves.
+ */
+static void *task_particles(const struct task *t) {
+  return (t->subtype == task_subtype_xv) ? (void *)t->ci->hydro.parts
+                                         : (void *)t->ci->grav.parts;
+}
+
+/**
+ * @brief Size in bytes of the particles a send or recv task moves.
+ */
+static size_t task_size(const struct task *t) {
+  return (t->subtype == task_subtype_xv)
+             ? t->ci->hydro.count * sizeof(struct part)
+             : t->ci->grav.count * sizeof(struct gpart);
+}
+
+/**
+ * @brief Run one exchange with tagged send/recv pairs.
+ */
+static void exchange_two_sided(struct scheduler *s, MPI_Request *reqs) {
+
+  int count = 0;
+  for (int k = 0; k < s->nr_tasks; k++) {
+    const struct task *t = &s->tasks[k];
+    const int tag = 2 * t->flags + (t->subtype == task_subtype_gpart);
+    const size_t size = task_size(t);
+    if (size == 0) continue;
+    if (t->type == task_type_recv)
+      MPI_Irecv(task_particles(t), size, MPI_BYTE, t->ci->nodeID, tag,
+                MPI_COMM_WORLD, &reqs[count++]);
+    else
+      MPI_Isend(task_particles(t), size, MPI_BYTE, t->cj->nodeID, tag,
+                MPI_COMM_WORLD, &reqs[count++]);
+  }
+  MPI_Waitall(count, reqs, MPI_STATUSES_IGNORE);
+}
+
+/**
+ * @brief Run one exchange through the one-sided windows.
+ */
+static void exchange(struct scheduler *s, char *done) {
+
+  /* Tell the other ranks we are ready for their data. */
+  for (int k = 0; k < s->nr_tasks; k++) {
+    struct task *t = &s->tasks[k];
+    if (t->mpi_rma == NULL) error("Task not registered in the windows.");
+    if (t->type == task_type_recv)
+      scheduler_mpi_rma_ready(t);
+    else
+      t->buff = task_particles(t);
+  }
+
+  /* Put our data and wait for theirs. */
+  for (int k = 0; k < s->nr_tasks; k++) done[k] = 0;
+  int pending = s->nr_tasks;
+  while (pending > 0) {
+    for (int k = 0; k < s->nr_tasks; k++) {
+      if (!done[k] && scheduler_mpi_rma_test(&s->tasks[k])) {
+        done[k] = 1;
+        pending--;
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+
+  int nr_iter = 3, benchmark = 0, opt;
+  int prov = 0;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &prov);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nr_ranks);
+  engine_rank = rank;
+
+  while ((opt = getopt(argc, argv, "bc:n:h")) != -1) {
+    switch (opt) {
+      case 'b':
+        benchmark = 1;
+        break;
+      case 'c':
+        nr_cells = atoi(optarg);
+        break;
+      case 'n':
+        nr_iter = atoi(optarg);
+        break;
+      case 'h':
+      case '?':
+        if (rank == 0)
+          printf(
+              "Usage: %s [OPTIONS...]\n"
+              "\nChecks the exchange of foreign particles through the "
+              "one-sided windows of the scheduler.\n\n"
+              "Options:\n"
+              "-b          -- Time the exchanges against send/recv pairs\n"
+              "-c NUMBER   -- Number of cells exchanged with each other rank\n"
+              "-n NUMBER   -- Number of exchanges per registration\n",
+              argv[0]);
+        MPI_Finalize();
+        return 0;
+    }
+  }
+
+  if (nr_ranks < 2) {
+    if (rank == 0) message("Needs at least 2 ranks, nothing to do.");
+    MPI_Finalize();
+    return 0;
+  }
+
+  /* The local cells sent to each rank, the foreign cells received from each
+   * rank and one cell standing for each rank on the other side of the send
+   * tasks. Nothing is sent to ourselves. */
+  const int nr_all = nr_ranks * nr_cells;
+  struct cell *local = (struct cell *)calloc(nr_all, sizeof(struct cell));
+  struct cell *foreign = (struct cell *)calloc(nr_all, sizeof(struct cell));
+  struct cell *others = (struct cell *)calloc(nr_ranks, sizeof(struct cell));
+  struct task *tasks = (struct task *)calloc(4 * nr_all, sizeof(struct task));
+  char *done = (char *)malloc(4 * nr_all);
+  MPI_Request *reqs = (MPI_Request *)malloc(4 * nr_all * sizeof(MPI_Request));
+  if (local == NULL || foreign == NULL || others == NULL || tasks == NULL ||
+      done == NULL || reqs == NULL)
+    error("Failed to allocate the cells and tasks.");
+  for (int o = 0; o < nr_ranks; o++) others[o].nodeID = o;
+
+  struct space sp;
+  bzero(&sp, sizeof(struct space));
+  struct scheduler s;
+  bzero(&s, sizeof(struct scheduler));
+  s.space = &sp;
+  s.nodeID = rank;
+  s.tasks = tasks;
+
+  /* One xv and one gpart send and recv per cell and other rank. */
+  for (int o = 0; o < nr_ranks; o++) {
+    if (o == rank) continue;
+    for (int c = 0; c < nr_cells; c++) {
+      struct cell *cl = &local[o * nr_cells + c];
+      struct cell *cf = &foreign[o * nr_cells + c];
+      cl->nodeID = rank;
+      cl->hydro.count = count_parts(rank, o, c);
+      cl->grav.count = count_gparts(rank, o, c);
+      cl->hydro.parts =
+          (struct part *)calloc(cl->hydro.count + 1, sizeof(struct part));
+      cl->grav.parts =
+          (struct gpart *)calloc(cl->grav.count + 1, sizeof(struct gpart));
+      if (cl->hydro.parts == NULL || cl->grav.parts == NULL)
+        error("Failed to allocate the local particles.");
+      cf->nodeID = o;
+      cf->hydro.count = count_parts(o, rank, c);
+      cf->grav.count = count_gparts(o, rank, c);
+
+      for (int k = 0; k < 4; k++) {
+        struct task *t = &s.tasks[s.nr_tasks++];
+        t->type = (k < 2) ? task_type_send : task_type_recv;
+        t->subtype = (k % 2 == 0) ? task_subtype_xv : task_subtype_gpart;
+        t->ci = (k < 2) ? cl : cf;
+        t->cj = (k < 2) ? &others[o] : NULL;
+        t->flags = c;
+        t->req = MPI_REQUEST_NULL;
+      }
+    }
+  }
+
+  /* Bytes we send in each exchange. */
+  size_t size = 0;
+  for (int k = 0; k < s.nr_tasks; k++)
+    if (s.tasks[k].type == task_type_send) size += task_size(&s.tasks[k]);
+
+  /* Time spent registering the windows and in the exchanges. */
+  double time_register = 0., time_one_sided = 0., time_two_sided = 0.;
+
+  /* Register, exchange a few times, and start again over new buffers. */
+  for (int reg = 0; reg < 2; reg++) {
+    allocate_foreign(&sp, foreign, /*shift=*/3 * reg);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double tic = MPI_Wtime();
+    scheduler_mpi_rma_register(&s);
+    time_register += MPI_Wtime() - tic;
+    if (!s.mpi_rma_windows.registered) error("Windows not registered.");
+
+    for (int iter = 0; iter < nr_iter; iter++) {
+      fill_cells(local, reg * nr_iter + iter);
+      if (benchmark) MPI_Barrier(MPI_COMM_WORLD);
+      tic = MPI_Wtime();
+      exchange(&s, done);
+      time_one_sided += MPI_Wtime() - tic;
+      check_cells(foreign, reg * nr_iter + iter);
+    }
+
+    /* The same exchanges with send/recv pairs, over the same buffers. */
+    for (int iter = 0; benchmark && iter < nr_iter; iter++) {
+      fill_cells(local, reg * nr_iter + iter);
+      MPI_Barrier(MPI_COMM_WORLD);
+      tic = MPI_Wtime();
+      exchange_two_sided(&s, reqs);
+      time_two_sided += MPI_Wtime() - tic;
+      check_cells(foreign, reg * nr_iter + iter);
+    }
+
+    scheduler_mpi_rma_free(&s);
+    if (s.mpi_rma_windows.registered) error("Windows not freed.");
+    for (int k = 0; k < s.nr_tasks; k++)
+      if (s.tasks[k].mpi_rma != NULL)
+        error("Task still attached to the freed windows.");
+  }
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  if (rank == 0)
+    message("Exchanged %d cells with each of %d ranks through the windows.",
+            nr_cells, nr_ranks - 1);
+
+  /* Report the slowest rank. */
+  if (benchmark) {
+    const int nr_exchanges = 2 * nr_iter;
+    double times[3] = {time_two_sided / nr_exchanges,
+                       time_one_sided / nr_exchanges, time_register / 2.};
+    double max_times[3];
+    MPI_Reduce(times, max_times, 3, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+      message("Sending %.3f MB per rank and exchange.", size / 1048576.0);
+      message("Two-sided send/recv: %10.3f ms per exchange (%.3f GB/s)",
+              max_times[0] * 1e3, size / max_times[0] / 1e9);
+      message("One-sided windows:   %10.3f ms per exchange (%.3f GB/s)",
+              max_times[1] * 1e3, size / max_times[1] / 1e9);
+      message("Window registration: %10.3f ms", max_times[2] * 1e3);
+    }
+  }
+
+  for (int k = 0; k < nr_all; k++) {
+    free(local[k].hydro.parts);
+    free(local[k].grav.parts);
+  }
+  free(sp.parts_foreign);
+  free(sp.gparts_foreign);
+  free(reqs);
+  free(done);
+  free(tasks);
+  free(others);
+  free(foreign);
+  free(local);
+
+  MPI_Finalize();
+  return 0;
+}
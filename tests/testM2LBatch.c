@@ -0,0 +1,197 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (C) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include <config.h>
+
+/* Build at the order given by the Makefile rather than the configured one.
+ * config.h is guarded, so this survives its inclusion by the other
+ * headers. */
+#ifdef SWIFT_TEST_MULTIPOLE_ORDER
+#undef SELF_GRAVITY_MULTIPOLE_ORDER
+#define SELF_GRAVITY_MULTIPOLE_ORDER SWIFT_TEST_MULTIPOLE_ORDER
+#endif
+
+/* Some standard headers. */
+#include <fenv.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local headers. */
+#include "gravity_m2l_cache.h"
+#include "swift.h"
+
+/* Make sure none of the headers went back to the configured order. */
+#if defined(SWIFT_TEST_MULTIPOLE_ORDER) && \
+    SELF_GRAVITY_MULTIPOLE_ORDER != SWIFT_TEST_MULTIPOLE_ORDER
+#error "testM2LBatch not built at the requested multipole order"
+#endif
+
+/*
+ * Check of the batched M2L kernel against the one-pair-at-a-time one.
+ *
+ * A list of random multipoles is applied to a field tensor with
+ * gravity_M2L_batch() and, one multipole at a time, with
+ * gravity_M2L_nonsym(). Lists shorter than, equal to and longer than the
+ * vector length are used, with and without periodic truncation and with
+ * some of the multipoles within their softening length.
+ *
+ * The test is built for every multipole order, not only the configured one,
+ * by setting SWIFT_TEST_MULTIPOLE_ORDER. It hence only uses the inline M2L
+ * functions and none of the library code depending on the order.
+ */
+
+/* Number of terms in the field tensors and in the multipoles (the first
+ * order terms of the multipoles are not stored). */
+#define num_field_terms                                                  \
+  ((SELF_GRAVITY_MULTIPOLE_ORDER + 1) * (SELF_GRAVITY_MULTIPOLE_ORDER + 2) * \
+   (SELF_GRAVITY_MULTIPOLE_ORDER + 3) / 6)
+#define num_mpole_terms \
+  (num_field_terms - (SELF_GRAVITY_MULTIPOLE_ORDER > 0 ? 3 : 0))
+
+/* Maximal number of multipoles in a list. */
+#define max_mpoles 64
+
+/* Maximal difference between the two kernels, relative to the sum of the
+ * absolute contributions of the multipoles to each term. The high-order terms
+ * sum many products of moments and derivatives, which differ by a few 1e-5
+ * between the two kernels in -ffast-math builds. */
+const double tolerance = 1e-4;
+
+/**
+ * @brief Random number in [0, 1[.
+ */
+static double rand_uniform(void) { return rand() / ((double)RAND_MAX + 1.); }
+
+/**
+ * @brief Apply a list of random multipoles to a field tensor with both
+ * kernels and compare the results.
+ *
+ * @param c The #gravity_m2l_cache.
+ * @param nr_mpoles The number of multipoles in the list.
+ * @param periodic Is the calculation periodic ?
+ */
+static void check_batch(struct gravity_m2l_cache *c, const int nr_mpoles,
+                        const int periodic) {
+
+  const double dim[3] = {1., 1., 1.};
+  const double pos_b[3] = {0.5, 0.5, 0.5};
+  const float rs_inv = 4.f;
+  struct gravity_props props;
+  bzero(&props, sizeof(struct gravity_props));
+
+  struct grav_tensor l_batch, l_nonsym, l_abs;
+  bzero(&l_batch, sizeof(struct grav_tensor));
+  bzero(&l_nonsym, sizeof(struct grav_tensor));
+  bzero(&l_abs, sizeof(struct grav_tensor));
+
+  gravity_m2l_cache_reset(c);
+
+  for (int k = 0; k < nr_mpoles; k++) {
+
+    /* A multipole at a random position, every fifth one softened. */
+    struct multipole m;
+    bzero(&m, sizeof(struct multipole));
+    float *m_terms = &m.M_000;
+    m_terms[0] = 0.5 + rand_uniform();
+    for (int i = 1; i < num_mpole_terms; i++)
+      m_terms[i] = 0.01 * (rand_uniform() - 0.5);
+    m.max_softening = (k % 5 == 0) ? 0.5f : 0.01f;
+#if defined(SWIFT_DEBUG_CHECKS) || defined(SWIFT_GRAVITY_FORCE_CHECKS)
+    m.num_gpart = 1;
+#endif
+    const double pos_a[3] = {rand_uniform(), rand_uniform(), rand_uniform()};
+
+    gravity_m2l_cache_add(c, &m, pos_a, pos_b, periodic, dim);
+
+    /* Its contribution alone, to get the scale of each term. */
+    struct grav_tensor l_k;
+    bzero(&l_k, sizeof(struct grav_tensor));
+    gravity_M2L_nonsym(&l_k, &m, pos_b, pos_a, &props, periodic, dim, rs_inv);
+    gravity_M2L_nonsym(&l_nonsym, &m, pos_b, pos_a, &props, periodic, dim,
+                       rs_inv);
+
+    const float *k_terms = &l_k.F_000;
+    float *abs_terms = &l_abs.F_000;
+    for (int i = 0; i < num_field_terms; i++)
+      abs_terms[i] += fabsf(k_terms[i]);
+  }
+
+  gravity_M2L_batch(&l_batch, c, periodic, rs_inv);
+
+  /* The terms of the field tensors are consecutive floats. */
+  const float *batch_terms = &l_batch.F_000;
+  const float *nonsym_terms = &l_nonsym.F_000;
+  const float *abs_terms = &l_abs.F_000;
+  for (int i = 0; i < num_field_terms; i++) {
+    if (fabsf(batch_terms[i] - nonsym_terms[i]) > tolerance * abs_terms[i])
+      error(
+          "Order %d, %d multipoles, periodic=%d: term %d is %e instead of %e "
+          "(scale %e).",
+          SELF_GRAVITY_MULTIPOLE_ORDER, nr_mpoles, periodic, i,
+          batch_terms[i], nonsym_terms[i], abs_terms[i]);
+  }
+
+#ifdef SWIFT_DEBUG_CHECKS
+  if (l_batch.num_interacted != l_nonsym.num_interacted)
+    error("Order %d: %lld interactions counted instead of %lld.",
+          SELF_GRAVITY_MULTIPOLE_ORDER, l_batch.num_interacted,
+          l_nonsym.num_interacted);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+
+  /* Initialize CPU frequency, this also starts time. */
+  unsigned long long cpufreq = 0;
+  clocks_set_cpufreq(cpufreq);
+
+/* Choke on FPEs */
+#ifdef HAVE_FE_ENABLE_EXCEPT
+  feenableexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW);
+#endif
+
+  /* The binaries are named after the order they test. */
+  const char *name = strstr(argv[0], "_order");
+  if (name != NULL &&
+      atoi(name + strlen("_order")) != SELF_GRAVITY_MULTIPOLE_ORDER)
+    error("%s built at multipole order %d.", argv[0],
+          SELF_GRAVITY_MULTIPOLE_ORDER);
+
+  srand(42);
+
+  struct gravity_m2l_cache c;
+  bzero(&c, sizeof(struct gravity_m2l_cache));
+  gravity_m2l_cache_init(&c, max_mpoles);
+
+  /* Lists around the vector length and a full one. */
+  const int sizes[6] = {1, VEC_SIZE - 1, VEC_SIZE, VEC_SIZE + 1, 37,
+                        max_mpoles};
+  for (int periodic = 0; periodic < 2; periodic++)
+    for (int k = 0; k < 6; k++)
+      if (sizes[k] > 0) check_batch(&c, sizes[k], periodic);
+
+  gravity_m2l_cache_clean(&c);
+
+  message("Batched M2L kernel agrees with gravity_M2L_nonsym() at order %d.",
+          SELF_GRAVITY_MULTIPOLE_ORDER);
+  return 0;
+}
@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (C) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include <config.h>
+
+#if !defined(WITH_MPI) || !defined(HAVE_FFTW)
+
+int main(int argc, char *argv[]) { return 0; }
+
+#else
+
+/* Some standard headers. */
+#include <math.h>
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local headers. */
+#include "mesh_gravity_pencil.h"
+#include "swift.h"
+
+/*
+ * Check of the pencil-decomposed FFT of the gravity mesh.
+ *
+ * A mesh is distributed over the ranks with pm_mesh_pencils_init(), moved to
+ * Fourier space with pm_mesh_pencils_forward() and back with
+ * pm_mesh_pencils_inverse(). The modes held by each rank are compared to a
+ * serial FFTW transform of the whole mesh, and the mesh transformed back to
+ * the original one times N^3. Meshes whose size is not a multiple of the
+ * number of ranks are included, such that the blocks have different widths.
+ *
+ * Run with e.g. mpirun -np 4 ./testMeshPencils
+ */
+
+/* Maximal difference to the serial transforms, relative to the largest
+ * value. */
+#ifdef MESH_GRAVITY_SINGLE_PRECISION
+const double tolerance = 1e-5;
+#else
+const double tolerance = 1e-12;
+#endif
+
+/**
+ * @brief Value of a cell of the test mesh.
+ */
+static double mesh_value(const int N, const int x, const int y, const int z) {
+  unsigned int seed = ((x * N) + y) * N + z + 1;
+  seed = seed * 1103515245u + 12345u;
+  seed = seed * 1103515245u + 12345u;
+  return ((seed >> 8) & 0xffff) / 65536. - 0.5 + 0.1 * x - 0.05 * z;
+}
+
+/**
+ * @brief Transform a mesh of side-length N with the pencils and compare the
+ * results with the serial FFTW ones.
+ */
+static void check_mesh(const int N, const int rank) {
+
+  const int Nc = N / 2 + 1;
+
+  /* The serial transform of the whole mesh, on all the ranks. */
+  mesh_real *rho_all =
+      (mesh_real *)mesh_fftw(malloc)((size_t)N * N * N * sizeof(mesh_real));
+  mesh_complex *frho_all = (mesh_complex *)mesh_fftw(malloc)(
+      (size_t)N * N * Nc * sizeof(mesh_complex));
+  if (rho_all == NULL || frho_all == NULL)
+    error("Failed to allocate the serial mesh.");
+  for (int x = 0; x < N; x++)
+    for (int y = 0; y < N; y++)
+      for (int z = 0; z < N; z++)
+        rho_all[((size_t)x * N + y) * N + z] = mesh_value(N, x, y, z);
+  mesh_plan forward = mesh_fftw(plan_dft_r2c_3d)(N, N, N, rho_all, frho_all,
+                                                 FFTW_ESTIMATE);
+  mesh_fftw(execute)(forward);
+  mesh_fftw(destroy_plan)(forward);
+
+  double max_mode = 0.;
+  for (size_t i = 0; i < (size_t)N * N * Nc; i++)
+    max_mode = max(max_mode, fabs(frho_all[i][0]) + fabs(frho_all[i][1]));
+
+  /* Our pencil of the same mesh. */
+  struct pm_mesh_pencils p;
+  pm_mesh_pencils_init(&p, N, FFTW_ESTIMATE);
+  const struct pm_mesh_decomposition *d = &p.decomp;
+
+  mesh_real *rho = (mesh_real *)mesh_fftw(malloc)(
+      (p.local_real_size + 2) * sizeof(mesh_real));
+  mesh_complex *frho = (mesh_complex *)mesh_fftw(malloc)(
+      (p.local_complex_size + 1) * sizeof(mesh_complex));
+  if (rho == NULL || frho == NULL) error("Failed to allocate the pencils.");
+
+  size_t nr_local = 0;
+  for (int x = 0; x < N; x++) {
+    for (int y = 0; y < N; y++) {
+      for (int z = 0; z < N; z++) {
+        const size_t key = ((size_t)x * N + y) * 2 * Nc + z;
+        if (pm_mesh_decomposition_rank_from_key(d, key) != rank) continue;
+        rho[pm_mesh_decomposition_local_index(d, key)] = mesh_value(N, x, y, z);
+        nr_local++;
+      }
+    }
+  }
+  if (nr_local != (size_t)p.nx * p.ny * N)
+    error("N=%d: %zu cells in our pencil instead of %d.", N, nr_local,
+          p.nx * p.ny * N);
+
+  /* Forward: our modes [ky][kz][kx] against the serial ones [kx][ky][kz]. */
+  pm_mesh_pencils_forward(&p, rho, frho);
+  for (int ky = p.ky_offset; ky < p.ky_offset + p.ky_width; ky++) {
+    for (int kz = p.kz_offset; kz < p.kz_offset + p.kz_width; kz++) {
+      for (int kx = 0; kx < N; kx++) {
+        const size_t i =
+            ((size_t)(ky - p.ky_offset) * p.kz_width + (kz - p.kz_offset)) *
+                N +
+            kx;
+        const size_t j = ((size_t)kx * N + ky) * Nc + kz;
+        const double diff = fabs(frho[i][0] - frho_all[j][0]) +
+                            fabs(frho[i][1] - frho_all[j][1]);
+        if (diff > tolerance * max_mode)
+          error(
+              "N=%d: mode (%d, %d, %d) is (%e, %e) instead of (%e, %e) on "
+              "rank %d.",
+              N, kx, ky, kz, frho[i][0], frho[i][1], frho_all[j][0],
+              frho_all[j][1], rank);
+      }
+    }
+  }
+
+  /* Inverse: back to N^3 times the original mesh. */
+  pm_mesh_pencils_inverse(&p, frho, rho);
+  const double norm = (double)N * N * N;
+  for (int x = d->x_offset[d->rank_x];
+       x < d->x_offset[d->rank_x] + d->x_width[d->rank_x]; x++) {
+    for (int y = d->y_offset[d->rank_y];
+         y < d->y_offset[d->rank_y] + d->y_width[d->rank_y]; y++) {
+      for (int z = 0; z < N; z++) {
+        const size_t key = ((size_t)x * N + y) * 2 * Nc + z;
+        const double value = rho[pm_mesh_decomposition_local_index(d, key)];
+        const double expected = norm * mesh_value(N, x, y, z);
+        if (fabs(value - expected) > tolerance * max_mode)
+          error("N=%d: cell (%d, %d, %d) is %e instead of %e on rank %d.", N,
+                x, y, z, value, expected, rank);
+      }
+    }
+  }
+
+  pm_mesh_pencils_clean(&p);
+  mesh_fftw(free)(rho);
+  mesh_fftw(free)(frho);
+  mesh_fftw(free)(rho_all);
+  mesh_fftw(free)(frho_all);
+}
+
+int main(int argc, char *argv[]) {
+
+  int prov = 0, rank = 0, nr_ranks = 1;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &prov);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nr_ranks);
+  engine_rank = rank;
+
+  /* Initialize CPU frequency, this also starts time. */
+  unsigned long long cpufreq = 0;
+  clocks_set_cpufreq(cpufreq);
+
+  /* Even and odd meshes, some not a multiple of the number of ranks. */
+  const int sizes[4] = {8, 12, 15, 16};
+  for (int k = 0; k < 4; k++) check_mesh(sizes[k], rank);
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  if (rank == 0)
+    message("Pencil FFTs agree with the serial ones on %d ranks.", nr_ranks);
+
+  MPI_Finalize();
+  return 0;
+}
+
+#endif
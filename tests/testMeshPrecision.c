@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (C) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include <config.h>
+
+#if !defined(HAVE_FFTW)
+
+int main(int argc, char *argv[]) { return 0; }
+
+#else
+
+/* Some standard headers. */
+#include <fenv.h>
+#include <fftw3.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local headers. */
+#include "kernel_long_gravity.h"
+#include "swift.h"
+
+/* Side-length of the mesh and number of particles. */
+const int N = 32;
+const int nr_gparts = 2000;
+
+/* Smoothing scale in units of the mesh cell size. */
+const double a_smooth = 1.25;
+
+/* Maximal difference between the mesh accelerations and the double-precision
+ * reference, relative to the r.m.s. acceleration. The single-precision mesh
+ * typically achieves a few 1e-5; the double-precision one agrees to the
+ * precision of the float accelerations stored in the particles. */
+#ifdef MESH_GRAVITY_SINGLE_PRECISION
+const double tolerance = 1e-3;
+#else
+const double tolerance = 1e-5;
+#endif
+
+/**
+ * @brief Index of a cell in a periodic mesh.
+ */
+static int mesh_id(const int i, const int j, const int k) {
+  return ((i + N) % N) * N * N + ((j + N) % N) * N + ((k + N) % N);
+}
+
+/**
+ * @brief Interpolate the 8 elements of a mesh around (i, j, k) using CIC.
+ */
+static double mesh_cic_get(const double *pot, const int i, const int j,
+                           const int k, const double d[3]) {
+
+  double temp = 0.;
+  for (int a = 0; a < 2; a++)
+    for (int b = 0; b < 2; b++)
+      for (int c = 0; c < 2; c++)
+        temp += pot[mesh_id(i + a, j + b, k + c)] *
+                (a ? d[0] : 1. - d[0]) * (b ? d[1] : 1. - d[1]) *
+                (c ? d[2] : 1. - d[2]);
+  return temp;
+}
+
+/**
+ * @brief Double-precision reference of the mesh accelerations.
+ *
+ * Deposits the particles with CIC, applies the Green function and the CIC
+ * deconvolution in Fourier space and differentiates the potential with the
+ * same 4th-order stencil as the mesh code.
+ */
+static void reference_accelerations(const struct gpart *gparts,
+                                    const double box_size, const double G,
+                                    double (*a_ref)[3]) {
+
+  const int N_half = N / 2;
+  const double fac = N / box_size;
+
+  double *rho = (double *)fftw_malloc(N * N * N * sizeof(double));
+  fftw_complex *frho =
+      (fftw_complex *)fftw_malloc(N * N * (N_half + 1) * sizeof(fftw_complex));
+  bzero(rho, N * N * N * sizeof(double));
+
+  /* CIC deposit */
+  for (int p = 0; p < nr_gparts; p++) {
+    int ind[3];
+    double d[3];
+    for (int k = 0; k < 3; k++) {
+      const double x = box_wrap(gparts[p].x[k], 0., box_size);
+      ind[k] = (int)(fac * x);
+      if (ind[k] >= N) ind[k] = N - 1;
+      d[k] = fac * x - ind[k];
+    }
+    for (int a = 0; a < 2; a++)
+      for (int b = 0; b < 2; b++)
+        for (int c = 0; c < 2; c++)
+          rho[mesh_id(ind[0] + a, ind[1] + b, ind[2] + c)] +=
+              gparts[p].mass * (a ? d[0] : 1. - d[0]) *
+              (b ? d[1] : 1. - d[1]) * (c ? d[2] : 1. - d[2]);
+  }
+
+  fftw_plan forward =
+      fftw_plan_dft_r2c_3d(N, N, N, rho, frho, FFTW_ESTIMATE);
+  fftw_plan inverse =
+      fftw_plan_dft_c2r_3d(N, N, N, frho, rho, FFTW_ESTIMATE);
+  fftw_execute(forward);
+
+  /* Green function and CIC deconvolution */
+  const double r_s = a_smooth * box_size / N;
+  const double green_fac = -1. / (M_PI * box_size);
+  const double a_smooth2 = 4. * M_PI * M_PI * r_s * r_s / (box_size * box_size);
+  const double k_fac = M_PI / N;
+  for (int i = 0; i < N; i++) {
+    for (int j = 0; j < N; j++) {
+      for (int k = 0; k < N_half + 1; k++) {
+        const int kv[3] = {i > N_half ? i - N : i, j > N_half ? j - N : j, k};
+        const double k2 = kv[0] * kv[0] + kv[1] * kv[1] + kv[2] * kv[2];
+        const int index = (N * i + j) * (N_half + 1) + k;
+        if (k2 == 0.) continue;
+
+        double W = 1.;
+        fourier_kernel_long_grav_eval(k2 * a_smooth2, &W);
+        double cic = 1.;
+        for (int d = 0; d < 3; d++) {
+          const double f = k_fac * kv[d];
+          if (kv[d] != 0) cic *= f / sin(f);
+        }
+        const double cor = green_fac * W / k2 * cic * cic * cic * cic;
+        frho[index][0] *= cor;
+        frho[index][1] *= cor;
+      }
+    }
+  }
+  fftw_execute(inverse);
+
+  /* 4th-order differentiation of the CIC-interpolated potential */
+  const double w[4] = {1. / 12., -2. / 3., 2. / 3., -1. / 12.};
+  const int s[4] = {2, 1, -1, -2};
+  for (int p = 0; p < nr_gparts; p++) {
+    int ind[3];
+    double d[3];
+    for (int k = 0; k < 3; k++) {
+      const double x = box_wrap(gparts[p].x[k], 0., box_size);
+      ind[k] = (int)(fac * x);
+      if (ind[k] >= N) ind[k] = N - 1;
+      d[k] = fac * x - ind[k];
+    }
+    for (int k = 0; k < 3; k++) {
+      double a = 0.;
+      for (int m = 0; m < 4; m++)
+        a += w[m] * mesh_cic_get(rho, ind[0] + (k == 0 ? s[m] : 0),
+                                 ind[1] + (k == 1 ? s[m] : 0),
+                                 ind[2] + (k == 2 ? s[m] : 0), d);
+      a_ref[p][k] = G * fac * a;
+    }
+  }
+
+  fftw_destroy_plan(forward);
+  fftw_destroy_plan(inverse);
+  fftw_free(rho);
+  fftw_free(frho);
+}
+
+int main(int argc, char *argv[]) {
+
+  /* Initialize CPU frequency, this also starts time. */
+  unsigned long long cpufreq = 0;
+  clocks_set_cpufreq(cpufreq);
+
+/* Choke on FPEs */
+#ifdef HAVE_FE_ENABLE_EXCEPT
+  feenableexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW);
+#endif
+
+  const double box_size = 1.;
+  const double dim[3] = {box_size, box_size, box_size};
+  const double G = 1.;
+
+  /* A clustered set of particles: half of them in a few clumps */
+  srand(42);
+  struct gpart *gparts = NULL;
+  if (posix_memalign((void **)&gparts, gpart_align,
+                     nr_gparts * sizeof(struct gpart)) != 0)
+    error("Impossible to allocate memory for gparts.");
+  bzero(gparts, nr_gparts * sizeof(struct gpart));
+  for (int p = 0; p < nr_gparts; p++) {
+    const int clump = (p % 2) ? rand() % 4 : -1;
+    for (int k = 0; k < 3; k++) {
+      const double r = rand() / ((double)RAND_MAX);
+      gparts[p].x[k] = clump < 0 ? r : 0.2 * clump + 0.05 * (k + 1) + 0.05 * r;
+    }
+    gparts[p].mass = 0.5f + rand() / ((float)RAND_MAX);
+    gparts[p].type = swift_type_dark_matter;
+    gparts[p].time_bin = 1;
+  }
+
+  /* The minimal infrastructure needed by the mesh */
+  struct gravity_props props;
+  bzero(&props, sizeof(struct gravity_props));
+  props.mesh_size = N;
+  props.a_smooth = a_smooth;
+  props.r_cut_max_ratio = 4.5;
+  props.r_cut_min_ratio = 0.1;
+  props.mesh_fftw_planning = 0;
+
+  struct phys_const phys_const;
+  bzero(&phys_const, sizeof(struct phys_const));
+  phys_const.const_newton_G = G;
+
+  struct neutrino_props neutrino_props;
+  bzero(&neutrino_props, sizeof(struct neutrino_props));
+
+  struct engine e;
+  bzero(&e, sizeof(struct engine));
+  e.physical_constants = &phys_const;
+  e.neutrino_properties = &neutrino_props;
+
+  struct space s;
+  bzero(&s, sizeof(struct space));
+  s.dim[0] = dim[0];
+  s.dim[1] = dim[1];
+  s.dim[2] = dim[2];
+  s.gparts = gparts;
+  s.nr_gparts = nr_gparts;
+  s.e = &e;
+
+  struct threadpool tp;
+  threadpool_init(&tp, 1);
+
+  /* Mesh accelerations in the precision SWIFT was configured with */
+  struct pm_mesh mesh;
+  bzero(&mesh, sizeof(struct pm_mesh));
+  pm_mesh_init(&mesh, &props, dim, /*nr_threads=*/1, /*wisdom_file=*/NULL);
+  pm_mesh_compute_potential(&mesh, &s, &tp, /*verbose=*/0);
+
+  /* Double-precision reference */
+  double(*a_ref)[3] = (double(*)[3])malloc(nr_gparts * sizeof(double[3]));
+  if (a_ref == NULL) error("Impossible to allocate reference accelerations.");
+  reference_accelerations(gparts, box_size, G, a_ref);
+
+  /* Compare */
+  double a2_sum = 0., max_err = 0.;
+  int max_p = 0;
+  for (int p = 0; p < nr_gparts; p++) {
+    double err2 = 0.;
+    for (int k = 0; k < 3; k++) {
+      const double diff = gparts[p].a_grav_mesh[k] - a_ref[p][k];
+      err2 += diff * diff;
+      a2_sum += a_ref[p][k] * a_ref[p][k];
+    }
+    if (err2 > max_err * max_err) {
+      max_err = sqrt(err2);
+      max_p = p;
+    }
+  }
+  const double a_rms = sqrt(a2_sum / nr_gparts);
+  const double rel_err = max_err / a_rms;
+
+  message("Mesh in %s precision: r.m.s. acceleration %e, max. error %e (%e)",
+          sizeof(mesh_real) == sizeof(float) ? "single" : "double", a_rms,
+          max_err, rel_err);
+
+  if (!(rel_err < tolerance))
+    error(
+        "Mesh accelerations differ from the double-precision reference: "
+        "particle %d a=[%e %e %e] ref=[%e %e %e], relative error %e > %e",
+        max_p, gparts[max_p].a_grav_mesh[0], gparts[max_p].a_grav_mesh[1],
+        gparts[max_p].a_grav_mesh[2], a_ref[max_p][0], a_ref[max_p][1],
+        a_ref[max_p][2], rel_err, tolerance);
+
+  pm_mesh_clean(&mesh);
+  threadpool_clean(&tp);
+  free(a_ref);
+  free(gparts);
+  return 0;
+}
+
+#endif /* HAVE_FFTW */
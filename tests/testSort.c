@@ -0,0 +1,243 @@
+/*******************************************************************************
+ * This file is part of SWIFT.
+ * Copyright (C) 2024 SWIFT collaboration
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+/* Config parameters. */
+#include <config.h>
+
+/* Some standard headers. */
+#include <fenv.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Local headers. */
+#include "swift.h"
+
+/* Sizes of the arrays to sort, typical of leaf cells. */
+const int sizes[] = {8, 16, 24, 32, 64, 128, 256, 400, 512, 1000, 4000};
+const int num_sizes = sizeof(sizes) / sizeof(int);
+
+/* Total number of entries sorted for each size, enough to check the sorts.
+ * Raised to time them with -b. */
+static int num_entries_total = 1 << 14;
+
+/* Are we timing the sorts? */
+static int benchmark = 0;
+
+/**
+ * @brief Fill the entries with the projected positions of particles in a
+ * unit cell.
+ */
+void fill_entries(struct sort_entry *sort, int N, int sid) {
+  for (int k = 0; k < N; k++) {
+    const double x[3] = {rand() / ((double)RAND_MAX),
+                         rand() / ((double)RAND_MAX),
+                         rand() / ((double)RAND_MAX)};
+    sort[k].d = x[0] * runner_shift[sid][0] + x[1] * runner_shift[sid][1] +
+                x[2] * runner_shift[sid][2];
+    sort[k].i = k;
+  }
+}
+
+/**
+ * @brief Check that the entries are sorted and are a permutation of the
+ * original ones.
+ */
+void check_entries(const struct sort_entry *sort,
+                   const struct sort_entry *orig, int N, const char *name) {
+
+  for (int k = 1; k < N; k++)
+    if (sort[k].d < sort[k - 1].d)
+      error("%s: entries not sorted at %d (N=%d)", name, k, N);
+
+  for (int k = 0; k < N; k++) {
+    const int i = sort[k].i;
+    if (i < 0 || i >= N || orig[i].d != sort[k].d)
+      error("%s: entry %d is not a permutation of the input (N=%d)", name, k,
+            N);
+  }
+}
+
+int main(int argc, char *argv[]) {
+
+  /* Initialize CPU frequency, this also starts time. */
+  unsigned long long cpufreq = 0;
+  clocks_set_cpufreq(cpufreq);
+
+  int c;
+  while ((c = getopt(argc, argv, "bh")) != -1) {
+    switch (c) {
+      case 'b':
+        benchmark = 1;
+        num_entries_total = 1 << 22;
+        break;
+      case 'h':
+      case '?':
+        printf(
+            "Usage: %s [OPTIONS...]\n"
+            "\nChecks the sorts of the cell entries.\n\n"
+            "Options:\n"
+            "-b          -- Also time the sorts on a large number of entries\n",
+            argv[0]);
+        return 0;
+    }
+  }
+
+/* Choke on FPEs */
+#ifdef HAVE_FE_ENABLE_EXCEPT
+  feenableexcept(FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW);
+#endif
+
+  /* Get some randomness going */
+  const int seed = time(NULL);
+  message("Seed = %d", seed);
+  srand(seed);
+
+  const int max_size = sizes[num_sizes - 1];
+  struct sort_entry *orig =
+      (struct sort_entry *)malloc(max_size * sizeof(struct sort_entry));
+  struct sort_entry *sort =
+      (struct sort_entry *)malloc(max_size * sizeof(struct sort_entry));
+  if (orig == NULL || sort == NULL) error("Failed to allocate entries.");
+
+  /* Check a few special cases first. */
+  for (int N = 0; N < 4; N++) {
+    fill_entries(orig, N, 0);
+    memcpy(sort, orig, N * sizeof(struct sort_entry));
+    runner_do_sort_ascending_radix(sort, N);
+    check_entries(sort, orig, N, "radix");
+  }
+
+  /* Negative and equal keys. */
+  for (int k = 0; k < max_size; k++) {
+    orig[k].d = (float)((k * 7919) % 101 - 50);
+    orig[k].i = k;
+  }
+  memcpy(sort, orig, max_size * sizeof(struct sort_entry));
+  runner_do_sort_ascending_radix(sort, max_size);
+  check_entries(sort, orig, max_size, "radix");
+
+  if (benchmark)
+    message("%6s %15s %15s %15s", "N", "quicksort [ns]", "radix [ns]",
+            "default [ns]");
+
+  for (int s = 0; s < num_sizes; s++) {
+
+    const int N = sizes[s];
+
+    /* The quicksort uses a fixed-size stack. */
+    const int with_quicksort = N < 1024;
+
+    const int num_runs = num_entries_total / N;
+    ticks time_quick = 0, time_radix = 0, time_default = 0;
+
+    for (int run = 0; run < num_runs; run++) {
+
+      fill_entries(orig, N, run % 13);
+
+      if (with_quicksort) {
+        memcpy(sort, orig, N * sizeof(struct sort_entry));
+        const ticks tic = getticks();
+        runner_do_sort_ascending_quicksort(sort, N);
+        time_quick += getticks() - tic;
+        check_entries(sort, orig, N, "quicksort");
+      }
+
+      memcpy(sort, orig, N * sizeof(struct sort_entry));
+      ticks tic = getticks();
+      runner_do_sort_ascending_radix(sort, N);
+      time_radix += getticks() - tic;
+      check_entries(sort, orig, N, "radix");
+
+      memcpy(sort, orig, N * sizeof(struct sort_entry));
+      tic = getticks();
+      runner_do_sort_ascending(sort, N);
+      time_default += getticks() - tic;
+      check_entries(sort, orig, N, "default");
+    }
+
+    if (!benchmark) continue;
+
+    const double norm = 1e6 / num_runs;
+    if (with_quicksort)
+      message("%6d %15.1f %15.1f %15.1f", N,
+              clocks_from_ticks(time_quick) * norm,
+              clocks_from_ticks(time_radix) * norm,
+              clocks_from_ticks(time_default) * norm);
+    else
+      message("%6d %15s %15.1f %15.1f", N, "-",
+              clocks_from_ticks(time_radix) * norm,
+              clocks_from_ticks(time_default) * norm);
+  }
+
+  /* Now the re-sorting of entries that have moved by a small fraction of
+   * the cell size since their last sort. */
+  const float shifts[] = {1e-4f, 1e-3f, 1e-2f, 1e-1f};
+  const int num_shifts = sizeof(shifts) / sizeof(float);
+  const int N = 400;
+
+  if (benchmark)
+    message("%10s %15s %15s %15s", "shift", "default [ns]", "repair [ns]",
+            "repaired [%]");
+
+  for (int s = 0; s < num_shifts; s++) {
+
+    const int num_runs = num_entries_total / N;
+    ticks time_default = 0, time_incremental = 0;
+    int num_repaired = 0;
+
+    for (int run = 0; run < num_runs; run++) {
+
+      /* Sorted entries of the previous step. */
+      fill_entries(orig, N, run % 13);
+      runner_do_sort_ascending(orig, N);
+
+      /* Move them a bit, keeping the order. */
+      for (int k = 0; k < N; k++) {
+        sort[k].d = orig[k].d + shifts[s] * (2.f * rand() / RAND_MAX - 1.f);
+        sort[k].i = k;
+      }
+      memcpy(orig, sort, N * sizeof(struct sort_entry));
+
+      ticks tic = getticks();
+      runner_do_sort_ascending(sort, N);
+      time_default += getticks() - tic;
+      check_entries(sort, orig, N, "default");
+
+      memcpy(sort, orig, N * sizeof(struct sort_entry));
+      tic = getticks();
+      num_repaired += runner_do_sort_ascending_incremental(sort, N);
+      time_incremental += getticks() - tic;
+      check_entries(sort, orig, N, "incremental");
+    }
+
+    if (!benchmark) continue;
+
+    const double norm = 1e6 / num_runs;
+    message("%10.0e %15.1f %15.1f %15.1f", shifts[s],
+            clocks_from_ticks(time_default) * norm,
+            clocks_from_ticks(time_incremental) * norm,
+            100. * num_repaired / num_runs);
+  }
+
+  free(orig);
+  free(sort);
+  return 0;
+}
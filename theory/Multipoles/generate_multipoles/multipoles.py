@@ -494,3 +494,206 @@ if order > 0:
 
 print("")
 print("-------------------------------------------------")
+
+print("gravity_m2l_cache: (arrays)")
+print("-------------------------------------------------\n")
+
+if order > 0:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d\n" % (order - 1))
+
+print("/*! %s order multipole and derivative terms */" % ordinal(order))
+
+# The 1st order multipole terms are all 0 since we expand around the CoM
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order and order != 1:
+                print("float *restrict M_%d%d%d;" % (i, j, k))
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order:
+                print("float *restrict D_%d%d%d;" % (i, j, k))
+
+if order > 0:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_m2l_cache_init():")
+print("-------------------------------------------------\n")
+
+if order > 0:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d" % (order - 1))
+
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order and order != 1:
+                print("c->M_%d%d%d = data + (n++) * padded_count;" % (i, j, k))
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order:
+                print("c->D_%d%d%d = data + (n++) * padded_count;" % (i, j, k))
+
+if order > 0:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_m2l_cache_add():")
+print("-------------------------------------------------\n")
+
+if order > 1:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d" % (order - 1))
+
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order and order != 1:
+                print("c->M_%d%d%d[n] = m_a->M_%d%d%d;" % (i, j, k, i, j, k))
+
+if order > 1:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_M2L_batch(): (padding)")
+print("-------------------------------------------------\n")
+
+if order > 1:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d" % (order - 1))
+
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order and order != 1:
+                print("c->M_%d%d%d[i] = 0.f;" % (i, j, k))
+
+if order > 1:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_M2L_batch(): (derivatives)")
+print("-------------------------------------------------\n")
+
+if order > 0:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d" % (order - 1))
+
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order:
+                print("c->D_%d%d%d[i] = pot.D_%d%d%d;" % (i, j, k, i, j, k))
+
+if order > 0:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_M2L_batch(): (accumulators)")
+print("-------------------------------------------------\n")
+
+if order > 0:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d" % (order - 1))
+
+print("float", end=" ")
+first = True
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order:
+                if first:
+                    first = False
+                else:
+                    print(",", end=" ")
+                print("F_%d%d%d = 0.f" % (i, j, k), end="")
+print(";")
+
+if order > 0:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_M2L_batch(): (loop)")
+print("-------------------------------------------------\n")
+
+if order > 0:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d\n" % (order - 1))
+
+# The terms of the multipole and derivatives of this order
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order and order != 1:
+                print("const float M_%d%d%d = c->M_%d%d%d[i];" % (i, j, k, i, j, k))
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order:
+                print("const float D_%d%d%d = c->D_%d%d%d[i];" % (i, j, k, i, j, k))
+print("")
+
+# Loop over LHS order, skipping the (zero) 1st order multipole terms
+for l in range(order + 1):
+    if order - l == 1:
+        continue
+    print(
+        "/* Compute %s order field tensor terms (addition to rank %d) */"
+        % (ordinal(order), l)
+    )
+
+    for i in range(l + 1):
+        for j in range(l + 1):
+            for k in range(l + 1):
+                if i + j + k == l:
+                    print("F_%d%d%d +=" % (i, j, k), end=" ")
+
+                    first = True
+                    for ii in range(order + 1):
+                        for jj in range(order + 1):
+                            for kk in range(order + 1):
+                                if ii + jj + kk == order - l:
+                                    if first:
+                                        first = False
+                                    else:
+                                        print("+", end=" ")
+                                    print(
+                                        "M_%d%d%d * D_%d%d%d"
+                                        % (ii, jj, kk, i + ii, j + jj, k + kk),
+                                        end=" ",
+                                    )
+                    print(";")
+    print("")
+
+if order > 0:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
+
+print("gravity_M2L_batch(): (storing)")
+print("-------------------------------------------------\n")
+
+if order > 0:
+    print("#if SELF_GRAVITY_MULTIPOLE_ORDER > %d" % (order - 1))
+
+for i in range(order + 1):
+    for j in range(order + 1):
+        for k in range(order + 1):
+            if i + j + k == order:
+                print("l_b->F_%d%d%d += F_%d%d%d;" % (i, j, k, i, j, k))
+
+if order > 0:
+    print("#endif")
+
+print("")
+print("-------------------------------------------------")
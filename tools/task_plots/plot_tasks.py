@@ -297,6 +297,23 @@ if args.verbose:
     for task in sorted(SUBCOLOURS.keys()):
         print("# " + task + ": " + SUBCOLOURS[task])
 
+
+def runner_ranges(runners):
+    """
+    Compact string of a set of runner IDs, e.g. "0-3,7".
+    """
+    ids = sorted(runners)
+    ranges = []
+    first = last = ids[0]
+    for i in ids[1:]:
+        if i != last + 1:
+            ranges.append(str(first) if first == last else "%d-%d" % (first, last))
+            first = i
+        last = i
+    ranges.append(str(first) if first == last else "%d-%d" % (first, last))
+    return ",".join(ranges)
+
+
 #  Read input.
 data = pl.loadtxt(infile)
 
@@ -330,6 +347,10 @@ CPU_CLOCK = float(full_step[-1]) / 1000.0
 if args.verbose:
     print("# CPU frequency:", CPU_CLOCK * 1000.0)
 
+#  Type of task queues used by the scheduler.
+QUEUE_TYPE = "deque" if int(full_step[-2]) == 1 else "heap"
+print("# Task queues:", QUEUE_TYPE)
+
 nthread = int(max(data[:, threadscol])) + 1
 print("# Number of threads:", nthread)
 
@@ -411,9 +432,13 @@ for rank in ranks:
         for i in range(nthread):
             ecounter.append(0)
 
+        # Runners that ran each type of task, for the legend.
+        typerunners = {}
+
         num_lines = pl.shape(data)[0]
         for line in range(num_lines):
             thread = int(data[line, threadscol])
+            runner = thread
 
             # Expand to cover extra lines if expanding.
             ethread = thread * expand + (ecounter[thread] % expand)
@@ -425,6 +450,12 @@ for rank in ranks:
             subtype = SUBTYPES[int(data[line, subtaskcol])]
             tasks[thread][-1]["type"] = tasktype
             tasks[thread][-1]["subtype"] = subtype
+            if subtype != "none":
+                qtask = tasktype + "/" + subtype
+            else:
+                qtask = tasktype
+            tasks[thread][-1]["qtask"] = qtask
+            typerunners.setdefault(qtask, set()).add(runner)
             tic = int(data[line, ticcol]) / CPU_CLOCK
             toc = int(data[line, toccol]) / CPU_CLOCK
             tasks[thread][-1]["tic"] = tic
@@ -464,13 +495,10 @@ for rank in ranks:
                 colours.append(task["colour"])
 
                 #  Legend support, collections don't add to this.
-                if task["subtype"] != "none":
-                    qtask = task["type"] + "/" + task["subtype"]
-                else:
-                    qtask = task["type"]
-
+                qtask = task["qtask"]
                 if qtask not in typesseen:
-                    pl.plot([], [], color=task["colour"], label=qtask)
+                    label = qtask + " [" + runner_ranges(typerunners[qtask]) + "]"
+                    pl.plot([], [], color=task["colour"], label=label)
                     typesseen.append(qtask)
 
             #  Now plot.
@@ -487,6 +515,7 @@ for rank in ranks:
             bbox_to_anchor=(0.0, 1.0, 1.0, 0.2),
             mode="expand",
             ncol=8,
+            title="Task type [runners] (" + QUEUE_TYPE + " task queues)",
         )
 
     # Start and end of time-step
@@ -497,16 +526,20 @@ for rank in ranks:
         ax.plot([real_start, real_start], [0, nethread + nrow + 1], "k--", linewidth=1)
     ax.plot([end_t, end_t], [0, nethread + nrow + 1], "k--", linewidth=1)
 
-    ax.set_xlabel("Wall clock time [ms]")
+    ax.set_xlabel("Wall clock time [ms] (" + QUEUE_TYPE + " task queues)")
 
-    if expand == 1:
-        ax.set_ylabel("Thread ID")
-    else:
-        ax.set_ylabel("Thread ID * " + str(expand))
+    #  Runner i is drawn on rows i * expand + 1 to (i + 1) * expand, label
+    #  its last row with its ID.
+    ax.set_ylabel("Runner (thread) ID")
     ax.set_yticks(pl.array(list(range(nethread))), minor=True)
 
     loc = plticker.MultipleLocator(base=expand)
     ax.yaxis.set_major_locator(loc)
+    ax.yaxis.set_major_formatter(
+        plticker.FuncFormatter(
+            lambda y, pos: str((int(round(y)) - 1) // expand) if y >= 1 else ""
+        )
+    )
     ax.grid(True, which="major", axis="y", linestyle="-")
 
     # pl.show()